@@ -101,6 +101,58 @@ private:
      SP b_{};
 };
 
+/**
+ * Buchberger algorithm with packed polynomials.
+ *
+ * Calculates the reduced Groebner basis, with leading coefficients
+ * equal to one, as Buchberger_improved does. Pairs are selected by
+ * the normal strategy and discarded by the criteria of
+ * \cite gebauer-moeller-1988.
+ *
+ * Polynomials over Field_Q are computed fraction-free with integer
+ * coefficients (Fraction_free_coefficients), polynomials over
+ * Ring_Zn with an odd prime modulus with Zp_coefficients and other
+ * polynomials with Element_coefficients. If the order is not
+ * lex_cmp(), grlex_cmp() or grevlex_cmp() or an exponent is greater
+ * than Packed_layout::max_exponent, Buchberger_improved is used.
+ */
+class Buchberger_packed {
+public:
+     using P = Polynomial;
+     using S = std::vector<P>;
+
+     void run(S const& f);
+     S const& g() { return g_; }
+
+private:
+     S g_{};
+};
+
+/**
+ * F4 algorithm.
+ *
+ * Calculates the reduced Groebner basis, with leading coefficients
+ * equal to one, as Buchberger_improved does. The pairs of the least
+ * degree of their lcm are reduced together by elimination in a
+ * sparse Macaulay matrix over \f$\mathbb{Z}_p\f$. The rows which
+ * are not pivots are reduced in \c nthreads threads, if it is 0,
+ * in number_of_threads() threads. See \cite faugere-1999.
+ *
+ * Polynomials over Ring_Zn with an odd prime modulus are computed
+ * with Zp_coefficients, other polynomials by Buchberger_packed.
+ */
+class F4 {
+public:
+     using P = Polynomial;
+     using S = std::vector<P>;
+
+     void run(S const& f, unsigned nthreads = 1);
+     S const& g() { return g_; }
+
+private:
+     S g_{};
+};
+
 /** \} */ /* end of group alggeom */
 
 /** \} */ /* end of group algebra */
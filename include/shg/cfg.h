@@ -6,9 +6,13 @@
 #ifndef SHG_CFG_H
 #define SHG_CFG_H
 
+#include <cstdint>
+#include <map>
 #include <stdexcept>
 #include <string>
 #include <set>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 #include <shg/tree.h>
 
@@ -138,10 +142,101 @@ private:
      std::string s_{};            // start symbol
 };
 
+/**
+ * CYK recognizer and parser for compiled grammars. The class accepts
+ * the same grammars as CYK and gives the same results, but the
+ * grammar is compiled in set_grammar(): nonterminals and terminals
+ * are mapped to consecutive integers, binary productions are indexed
+ * by the pair of their right-hand side symbols and each cell of the
+ * chart is a bitset of nonterminals. For each nonterminal B in the
+ * left cell, the set of right symbols C of productions A --> B C is
+ * intersected with the right cell and the set of left-hand sides A
+ * for each (B, C) found is added to the cell, both word by word.
+ *
+ * parse() only fills the chart. gen() extracts all the parse trees
+ * of the start symbol, which is the left-hand side of the first
+ * production, from the chart in the same order as CYK::gen().
+ *
+ * \note Unlike CYK, recognize() and parse() throw Unknown_terminal
+ * if the sentence contains a terminal not present in the grammar.
+ */
+class Bitset_CYK {
+public:
+     using Parse_node = CYK::Parse_node;
+     using Parse_tree = CYK::Parse_tree;
+
+     /**
+      * Compiles the grammar. The grammar is not copied and must
+      * outlive the object.
+      *
+      * \exception Invalid_grammar if the grammar is not in Chomsky
+      * normal form or the start symbol occurs on a right-hand side
+      */
+     void set_grammar(Vecprod const& cfg);
+     bool recognize(Sentence const& X);
+     void parse(Sentence const& X);
+     Parse_tree const& gen();
+
+private:
+     using Word = std::uint64_t;
+     static constexpr int word_bits = 64;
+
+     /** Productions A --> B C for fixed B and C. */
+     struct Pair {
+          int c;                    ///< right symbol C
+          std::size_t mask;         ///< offset of set of A in lmask_
+          std::size_t first, last;  ///< range in bprod_
+     };
+     /** Derivation of a symbol in a cell, see gen(). */
+     struct Derivation {
+          int sym;
+          Vecprod::size_type p;
+          int k;  ///< split, -1 for A --> a
+          int l;  ///< derivation in the left cell
+          int r;  ///< derivation in the right cell
+     };
+
+     Word* cell(int i, int j);
+     bool test(Word const* s, int a) const;
+     void set(Word* s, int a) const;
+     Pair const* find(int b, int c) const;
+     void fill(Sentence const& X);
+     void mark_useful();
+     void derive(int i, int j);
+     void add_node(int i, int j, Derivation const& d, Parse_tree& t);
+
+     Vecprod const* cfg_{nullptr};
+     int nv_{};                             // number of variables
+     int nw_{};                             // words per set
+     int start_{};                          // start symbol
+     std::map<std::string, int> vid_{};     // variable ids
+     std::map<std::string, int> tid_{};     // terminal ids
+     std::vector<int> plhs_{};              // lhs ids of productions
+     std::vector<Word> tmask_{};            // lhs sets for terminals
+     std::vector<std::vector<Vecprod::size_type>> tprod_{};
+     std::vector<std::vector<Pair>> pairs_{};  // indexed by B
+     std::vector<Word> rmask_{};               // sets of C for B
+     std::vector<Word> lmask_{};               // sets of A for (B, C)
+     std::vector<Vecprod::size_type> bprod_{};
+     // (B, C) for productions A --> B C indexed by A
+     std::vector<std::vector<std::pair<int, int>>> rhs_{};
+     int n_{};                       // sentence length
+     std::vector<int> x_{};          // terminal ids of sentence
+     std::vector<Word> chart_{};     // n_ * n_ cells
+     std::vector<Word> useful_{};    // symbols in parse trees
+     std::vector<std::vector<Derivation>> d_{};  // by cell
+     Parse_tree tree_{};
+};
+
 /**
  * The class to convert Vecprod to Chomsky Normal Form.
  * The implementation follows \cite chomsky-normal-form-2021
  * (<a href = "cnf.pdf">local copy</a>).
+ *
+ * Symbols are replaced by numbers at the beginning and productions
+ * are compared by hashing, so that the conversion takes time nearly
+ * linear in the size of the grammar, unless the elimination of unit
+ * productions produces many new ones.
  */
 class Conversion_to_CNF {
 public:
@@ -150,19 +245,33 @@ public:
      Vecprod const& cfg() const;
 
 private:
+     using Symbol = std::size_t;
+     struct Rule {
+          Symbol lhs{};
+          std::vector<Symbol> rhs{};
+          bool operator==(Rule const&) const = default;
+     };
+     struct Rule_hash {
+          std::size_t operator()(Rule const& r) const;
+     };
+
      static char const reserved_char_ = '_';
      Vecprod vp_{};                  // old Vecprod
      Vecprod cfg_{};                 // new Vecprod
-     Vecprod w_{};                   // work Vecprod
-     std::set<std::string> v_{};     // variables
-     std::set<std::string> t_{};     // terminals
-     std::string s_{};               // start symbol
-     std::set<std::string> null_{};  // nullable nonterminals
+     std::vector<Rule> w_{};         // work productions
+     std::vector<std::string> names_{};  // names of symbols
+     std::unordered_map<std::string, Symbol> ids_{};  // their numbers
+     std::vector<char> is_var_{};    // if a symbol is a variable
+     Symbol s_{};                    // start symbol
+     std::vector<char> null_{};      // if a variable is nullable
      int nnewv_{};  // number of newly added variables
 
-     void set_variables();
-     void set_terminals();
-     std::string newname();
+     // Numbers symbols and checks their names.
+     void set_symbols();
+     Symbol intern(std::string const& name, bool var);
+     Symbol newvar();
+     // Removes repeated productions, leaving the first ones.
+     static void remove_duplicates(std::vector<Rule>& v);
      // Eliminates the start symbol from right-hand sides.
      void start();
      // Eliminates rules with nonsolitary terminals.
@@ -178,7 +287,7 @@ private:
      // Determine nullable nonterminals.
      void nullable();
      // Expand production for del().
-     void expand(Production const& p);
+     void expand(Rule const& p, std::vector<Rule>& w) const;
      /**
       * Remove useless variables and productions.
       *
@@ -6,8 +6,10 @@
 #ifndef SHG_CSV_H
 #define SHG_CSV_H
 
+#include <deque>
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace SHG {
@@ -66,6 +68,111 @@ private:
      bool is_end_of_record();
 };
 
+/**
+ * Writes records in CSV format like CSV_writer, but collects them in
+ * a buffer and writes the buffer to the stream when it is full, on
+ * flush() and in the destructor.
+ *
+ * \ingroup miscellaneous_utilities
+ */
+class CSV_buffered_writer {
+public:
+     explicit CSV_buffered_writer(std::ostream& ostr = std::cout,
+                                  char field_separator = ',',
+                                  char quote_character = '\"',
+                                  std::size_t buffer_size = 1 << 20);
+     CSV_buffered_writer(CSV_buffered_writer const&) = delete;
+     CSV_buffered_writer& operator=(CSV_buffered_writer const&) =
+          delete;
+     /** Flushes the buffer ignoring errors. */
+     ~CSV_buffered_writer();
+     void write_record(std::vector<std::string> const& rec);
+     void write_record(std::vector<std::string_view> const& rec);
+     /**
+      * Writes numbers in the shortest form which reads back exactly
+      * by from_field().
+      */
+     void write_record(std::vector<double> const& rec);
+     /** Writes the buffer to the stream. */
+     void flush();
+
+private:
+     template <typename T>
+     void write(std::vector<T> const& rec);
+
+     char const field_separator_;
+     char const quote_character_;
+     std::string const special_;
+     std::ostream& ostr_;
+     std::size_t const buffer_size_;
+     std::string buf_{};
+};
+
+/**
+ * Reads records written in CSV format. The input is read in large
+ * blocks and the records are returned as views into the buffer;
+ * only the fields with quote characters are copied. The results are
+ * the same as from CSV_reader.
+ *
+ * \ingroup miscellaneous_utilities
+ */
+class CSV_buffered_reader {
+public:
+     explicit CSV_buffered_reader(std::istream& istr = std::cin,
+                                  char field_separator = ',',
+                                  char quote_character = '\"',
+                                  std::size_t buffer_size = 1 << 20);
+     /**
+      * Reads the next record. Returns false and leaves \a rec empty
+      * if there are no more records. The views are valid until the
+      * next call.
+      */
+     bool getrec(std::vector<std::string_view>& rec);
+     /** Reads the next record as CSV_reader::getrec() does. */
+     void getrec(std::vector<std::string>& rec);
+
+private:
+     struct Field {
+          std::size_t begin;  // relative to the record start
+          std::size_t end;
+          bool quoted;
+     };
+
+     bool fill(std::size_t& i, std::size_t& fs);
+     void add_field(std::size_t fs, std::size_t fe, bool quoted);
+
+     char const field_separator_;
+     char const quote_character_;
+     std::istream& istr_;
+     std::vector<char> buf_;
+     std::size_t rs_{};   // start of the current record
+     std::size_t end_{};  // end of data in buf_
+     bool special_[256]{};
+     std::vector<Field> fields_{};
+     std::deque<std::string> unquoted_{};
+     std::vector<std::string_view> views_{};
+};
+
+/**
+ * Converts a whole field to a number with \c std::from_chars.
+ *
+ * \exception std::invalid_argument if the field is not a number in
+ * the range of the type
+ */
+void from_field(std::string_view s, int& x);
+/** \copydoc from_field(std::string_view, int&) */
+void from_field(std::string_view s, long& x);
+/** \copydoc from_field(std::string_view, int&) */
+void from_field(std::string_view s, long long& x);
+/** \copydoc from_field(std::string_view, int&) */
+void from_field(std::string_view s, unsigned& x);
+/** \copydoc from_field(std::string_view, int&) */
+void from_field(std::string_view s, unsigned long& x);
+/** \copydoc from_field(std::string_view, int&) */
+void from_field(std::string_view s, unsigned long long& x);
+/** \copydoc from_field(std::string_view, int&) */
+void from_field(std::string_view s, double& x);
+
 }  // namespace SHG
 
 #endif
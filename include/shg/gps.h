@@ -7,8 +7,10 @@
 #define SHG_GPS_H
 
 #include <istream>
+#include <ostream>
 #include <string>
 #include <filesystem>
+#include <vector>
 #include <boost/date_time/posix_time/posix_time.hpp>
 #include <pugixml.hpp>
 
@@ -79,6 +81,15 @@ public:
      void parse(std::istream& f);
      /** Get data from named GPX file. */
      void parse(char const* fname);
+     /**
+      * Get data from GPX stream in one pass, without building the
+      * document tree. The stream is read sequentially, so it may be
+      * a decompressing stream. The markup is not validated; only
+      * the points of the first track segment of the first track
+      * are read. The results and errors are the same as for
+      * parse() on well-formed files.
+      */
+     void scan(std::istream& f);
      /** Distance in meters. */
      double distance() const;
      /** Distance in meters on ellipsoid. */
@@ -102,6 +113,10 @@ public:
 
 private:
      void parse(pugi::xml_document const& doc);
+     void start();
+     void add_point(char const* lat, char const* lon,
+                    char const* ele, char const* time);
+     void finish();
      void check_state() const;
 
      State state_{State::initialized};
@@ -111,6 +126,191 @@ private:
      double downhill_{};
      boost::posix_time::ptime start_time_{};
      boost::posix_time::ptime end_time_{};
+     unsigned ntrkpts_{};  // number of track points
+     double hp_{};         // previous elevation
+     Cart_coord ccp_{};    // previous point
+     Cart_coord ccep_{};   // previous point on ellipsoid
+};
+
+/**
+ * Track points stored by columns. Elements with the same index
+ * describe one point. Times are in seconds since 1970-01-01
+ * 00:00:00.
+ */
+struct Track {
+     std::vector<double> phi{};        ///< latitudes in degrees
+     std::vector<double> lambda{};     ///< longitudes in degrees
+     std::vector<double> h{};          ///< elevations in meters
+     std::vector<boost::int64_t> t{};  ///< times in seconds
+
+     /** Number of points. */
+     std::size_t size() const { return t.size(); }
+     /** Removes all points. */
+     void clear();
+     /** Appends a point. */
+     void push_back(Geogr_coord const& g, boost::int64_t time);
+     /**
+      * Replaces the points with the points of the first track
+      * segment of the first track in GPX stream. The stream is read
+      * as by GPX_data::scan().
+      *
+      * \exception std::runtime_error if the stream contains an
+      * invalid point, the times decrease or there is more than one
+      * track segment; then the track is empty
+      */
+     void read_gpx(std::istream& f);
+};
+
+/**
+ * Writes the track to a binary stream. Check f.fail() to check if
+ * the operation was successful.
+ */
+void write(Track const& tr, std::ostream& f);
+
+/**
+ * Reads the track from a binary stream. Check f.fail() to check if
+ * the operation was successful. If the operation fails, the track
+ * remains unchanged.
+ */
+void read(Track& tr, std::istream& f);
+
+/**
+ * Cartesian coordinates of track points stored by columns.
+ */
+struct Cart_track {
+     std::vector<double> x{};
+     std::vector<double> y{};
+     std::vector<double> z{};
+};
+
+/**
+ * Converts geographical coordinates of all points to Cartesian
+ * coordinates. If \a on_ellipsoid is true, elevations are taken as
+ * 0. The results are the same as from convert(Geogr_coord const&,
+ * Cart_coord&).
+ */
+void convert(Track const& tr, Cart_track& c,
+             bool on_ellipsoid = false);
+
+/**
+ * Computes distances by a straight line between consecutive points.
+ * On return, \a d.size() is one less than the number of points, or
+ * 0 if there are no points.
+ */
+void segment_distances(Cart_track const& c, std::vector<double>& d);
+
+/**
+ * Computes cumulative sums of segment distances \a d. On return,
+ * \a s.size() == d.size() + 1, \a s[0] == 0 and \a s[i] is the
+ * distance from the first point to the point \a i.
+ */
+void cumulative_distance(std::vector<double> const& d,
+                         std::vector<double>& s);
+
+/**
+ * Computes total elevation gain and loss ignoring changes smaller
+ * than \a threshold. The reference elevation is moved to the
+ * current one only when it differs from the reference by at least
+ * \a threshold. For \a threshold == 0 the results are the same as
+ * GPX_data::uphill() and GPX_data::downhill().
+ *
+ * \exception std::invalid_argument if \a threshold < 0
+ */
+void elevation_gain(std::vector<double> const& h, double threshold,
+                    double& uphill, double& downhill);
+
+/**
+ * Computes speeds in meters per second on segments with distances
+ * \a d and times of points \a t. On return, \a v.size() ==
+ * d.size(). If two consecutive times are equal, the speed is
+ * infinite or NaN.
+ *
+ * \exception std::invalid_argument if \a t.size() != d.size() + 1
+ * and not both \a t and \a d are empty
+ */
+void speeds(std::vector<double> const& d,
+            std::vector<boost::int64_t> const& t,
+            std::vector<double>& v);
+
+/**
+ * Spatial index of tracks. The segments between consecutive points
+ * of the tracks, in Cartesian coordinates, are stored in an R-tree
+ * bulk loaded with the sort-tile-recursive method \cite
+ * leutenegger-lopez-edgington-1997. A track with one point is
+ * stored as a segment of length 0. Distances are measured by a
+ * straight line, as by distance(Cart_coord const&, Cart_coord
+ * const&). Tracks are identified by their indices in the vector
+ * passed to build().
+ */
+class Track_index {
+public:
+     /** A track and its distance from the query. */
+     struct Neighbour {
+          std::size_t track;
+          double distance;
+     };
+
+     /** Builds the index of tracks. Empty tracks are ignored. */
+     void build(std::vector<Track> const& tracks);
+     /** Number of indexed segments. */
+     std::size_t size() const { return segs_.size(); }
+     /**
+      * Returns sorted indices of the tracks which pass within
+      * distance \a r of the point \a p.
+      */
+     std::vector<std::size_t> within(Cart_coord const& p,
+                                     double r) const;
+     /**
+      * Returns sorted indices of the tracks which pass within
+      * distance \a r of the segment \a ab.
+      */
+     std::vector<std::size_t> within(Cart_coord const& a,
+                                     Cart_coord const& b,
+                                     double r) const;
+     /**
+      * Returns at most \a k tracks nearest to the point \a p in
+      * order of increasing distance.
+      */
+     std::vector<Neighbour> nearest(Cart_coord const& p,
+                                    std::size_t k) const;
+     /**
+      * Calls within(p[i], r) for all \a i in \a nthreads threads.
+      * If \a nthreads is 0, number_of_threads() threads are used.
+      */
+     std::vector<std::vector<std::size_t>> within(
+          std::vector<Cart_coord> const& p, double r,
+          unsigned nthreads = 0) const;
+     /**
+      * Calls nearest(p[i], k) for all \a i in \a nthreads threads.
+      * If \a nthreads is 0, number_of_threads() threads are used.
+      */
+     std::vector<std::vector<Neighbour>> nearest(
+          std::vector<Cart_coord> const& p, std::size_t k,
+          unsigned nthreads = 0) const;
+
+private:
+     struct Box {
+          double lo[3];
+          double hi[3];
+     };
+     struct Segment {
+          Cart_coord a;
+          Cart_coord b;
+          std::size_t track;
+     };
+     struct Node {
+          Box box;
+          std::size_t first;  // first child or segment
+          std::size_t last;   // one past the last child or segment
+          bool leaf;
+     };
+     static constexpr std::size_t capacity = 16;
+
+     template <typename F>
+     void search(Box const& q, F f) const;
+
+     std::vector<Segment> segs_{};
+     std::vector<Node> nodes_{};  // the root is the last one
 };
 
 class Activity_statistics {
@@ -130,8 +330,18 @@ public:
           double speedkmh{0.0};
      };
 
-     /** Collect data from files in directory named path. */
+     /**
+      * Collect data from files in directory named path. The results
+      * are sorted by file name.
+      */
      void run(std::filesystem::path const& dir);
+     /**
+      * Collect data from files in directory named path in \a
+      * nthreads threads. If \a nthreads is 0, number_of_threads()
+      * threads are used. The files are read with GPX_data::scan().
+      * The results are sorted by file name, as in run(dir).
+      */
+     void run(std::filesystem::path const& dir, unsigned nthreads);
      /** Get vector of results. */
      std::vector<Result> const& results() const { return results_; }
      /** Clear results. */
@@ -12,6 +12,7 @@
 #include <boost/multiprecision/cpp_int.hpp>
 #include <shg/cfg.h>
 #include <shg/mzt.h>
+#include <shg/philox.h>
 
 namespace SHG::PLP {
 
@@ -33,6 +34,25 @@ public:
      void set_grammar(Vecprod const& vp);
      /** Generate \c count sentences each of length \c length. */
      Vecsent generate(int count, int length);
+     /**
+      * Generates \c count sentences each of length \c length from
+      * the same distribution as generate(). The numbers of strings
+      * are computed bottom-up for all lengths up to \c length and
+      * kept in flat tables of doubles. A production is chosen by
+      * binary search over cumulative counts. The sentences are
+      * generated in blocks of 64 in \c nthreads threads, 0 meaning
+      * number_of_threads(). In each call, a Philox generator is
+      * seeded from the generator of the class and the block \c b
+      * takes its substream \c b, so the blocks of one call use
+      * disjoint streams of random numbers. The result does not
+      * depend on \c nthreads. If the counts overflow double,
+      * generate() is called instead.
+      *
+      * \throws CFG_error if the grammar has a cycle of unit
+      * productions
+      */
+     Vecsent generate_fast(int count, int length,
+                           unsigned nthreads = 1);
 
 private:
      using Int = boost::multiprecision::cpp_int;
@@ -49,6 +69,29 @@ private:
 
      MZT mzt_{};  ///< random number generator
 
+     /**
+      * \name Tables for generate_fast().
+      * The tables are for lengths \f$0 \leq n \leq\f$ #tn_, which
+      * is -1 if they are not complete.
+      * \{
+      */
+     int tn_{-1};
+     int tw_{0};  ///< length of a row of #f_ and #fp_
+     /// Sum of f_f(i, n) at i * #tw_ + n.
+     std::vector<double> f_{};
+     /// Index of the suffix (i, j, 1) in #fp_.
+     std::vector<std::vector<int>> slot_{};
+     /**
+      * Sum of f_f_prim(i, j, k, n) at (#slot_[i][j] + k - 1) * #tw_
+      * + n.
+      */
+     std::vector<double> fp_{};
+     /// Cumulative sums over j of f_f(i, n) at #cbase_[i] + n s_[i].
+     std::vector<double> cum_{};
+     std::vector<int> cbase_{};
+     bool overflow_{false};  ///< if some count is not finite
+     /** \} */
+
      List f_f(int i, int n);
      Int sum(List const& list);
      List f_f_prim(int i, int j, int k, int n);
@@ -59,6 +102,12 @@ private:
 
      bool is_terminal(int k) const;
      int t_(int i, int j) const;
+
+     void build_tables(int length);
+     void count(int i, int n, std::vector<char>& state);
+     double f(int i, int n) const;
+     double fp(int i, int j, int k, int n) const;
+     void fast_g(int i, int n, Philox& g, Sentence& s) const;
 };
 
 inline bool McKenzie::is_terminal(int k) const {
@@ -69,6 +118,14 @@ inline int McKenzie::t_(int i, int j) const {
      return static_cast<int>(P_[i][j].size()) - 1;
 }
 
+inline double McKenzie::f(int i, int n) const {
+     return f_[i * tw_ + n];
+}
+
+inline double McKenzie::fp(int i, int j, int k, int n) const {
+     return fp_[(slot_[i][j] + k - 1) * tw_ + n];
+}
+
 /** \} */
 
 }  // namespace SHG::PLP
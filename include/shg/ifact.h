@@ -6,8 +6,13 @@
 #ifndef SHG_IFACT_H
 #define SHG_IFACT_H
 
+#include <algorithm>
+#include <cstdint>
 #include <limits>
+#include <type_traits>
 #include <vector>
+#include <boost/multiprecision/cpp_int.hpp>
+#include <shg/utils.h>
 
 namespace SHG {
 
@@ -53,8 +58,137 @@ private:
      }
 };
 
+/**
+ * Unsigned 128-bit integer.
+ */
+using Uint128 = boost::multiprecision::uint128_t;
+
+/**
+ * Returns true if and only if \c n is a prime number.
+ *
+ * \implementation Trial division by small primes is followed by the
+ * Miller-Rabin test to the bases 2, 325, 9375, 28178, 450775,
+ * 9780504, 1795265022, which is deterministic for \f$n < 2^{64}\f$
+ * \cite knuth-2002b, section 4.5.4, algorithm P. The arithmetic
+ * modulo \f$n\f$ uses Montgomery multiplication \cite
+ * montgomery-1985.
+ */
+bool is_prime64(std::uint64_t n);
+
+/**
+ * Returns true if \c n is a prime number. For \f$n < 2^{64}\f$
+ * calls is_prime64(). For \f$n < 3.3 \cdot 10^{24}\f$ the
+ * Miller-Rabin test to the 13 prime bases 2, 3, ..., 41 is
+ * deterministic. For larger \f$n\f$ the test to the 20 prime bases
+ * 2, 3, ..., 71 is used and the result true means that \c n is a
+ * strong probable prime.
+ */
+bool is_prime128(Uint128 const& n);
+
+/**
+ * Returns the prime factors of \c n in nondecreasing order, each
+ * prime repeated according to its multiplicity. If \f$n < 2\f$, the
+ * vector is empty.
+ *
+ * \implementation The factors of 2 are removed by shifting and the
+ * odd primes less than 1024 by division checked by multiplication by
+ * their inverses modulo \f$2^{64}\f$. The remaining cofactor is
+ * split with Brent's variant of Pollard's rho method \cite
+ * brent-1980 in Montgomery arithmetic until is_prime64() accepts
+ * all factors.
+ */
+std::vector<std::uint64_t> prime_factors64(std::uint64_t n);
+
+/**
+ * Returns the prime factors of \c n as prime_factors64() does. Prime
+ * factors are found by is_prime128(). Pollard's rho method needs
+ * about \f$\sqrt{p}\f$ steps to find a prime factor \f$p\f$, so
+ * numbers with two prime factors much greater than \f$2^{40}\f$ take
+ * long to factor.
+ */
+std::vector<Uint128> prime_factors128(Uint128 const& n);
+
+/**
+ * Returns true if \c n is a strong probable prime to the base \c a,
+ * where \f$n > 2\f$ is odd and \f$1 < a < n - 1\f$. The integer
+ * type \c T must hold \f$n^2\f$. See \cite knuth-2002b, section
+ * 4.5.4, algorithm P.
+ */
 template <class T>
-bool is_prime(T const& n) {
+bool miller_rabin(T const& n, T const& a) {
+     T const n1 = n - 1;
+     T d = n1;
+     int s = 0;
+     while (d % 2 == 0) {
+          d /= 2;
+          s++;
+     }
+     T x = 1, b = a;
+     for (T e = d; e > 0; e /= 2) {
+          if (e % 2 == 1)
+               x = x * b % n;
+          b = b * b % n;
+     }
+     if (x == 1 || x == n1)
+          return true;
+     for (int r = 1; r < s; r++) {
+          x = x * x % n;
+          if (x == n1)
+               return true;
+          if (x == 1)
+               return false;
+     }
+     return false;
+}
+
+/**
+ * Returns a divisor \f$d > 1\f$ of an odd composite \c n found by
+ * Brent's variant of Pollard's rho method with the polynomial
+ * \f$x^2 + c\f$ \cite brent-1980. If the method fails, returns
+ * \c n and another \c c should be tried. The integer type \c T must
+ * hold \f$n^2\f$.
+ */
+template <class T>
+T pollard_brent(T const& n, T const& c) {
+     auto const f = [&](T const& x) { return (x * x + c) % n; };
+     auto const gcd = [](T a, T b) {
+          while (b != 0) {
+               T const t = a % b;
+               a = b;
+               b = t;
+          }
+          return a;
+     };
+     constexpr int batch = 128;
+     T x, y = 2, ys, q = 1, g = 1;
+     for (long r = 1; g == 1; r *= 2) {
+          x = y;
+          for (long i = 0; i < r; i++)
+               y = f(y);
+          for (long k = 0; k < r && g == 1; k += batch) {
+               ys = y;
+               for (long i = 0; i < batch && i < r - k; i++) {
+                    y = f(y);
+                    q = q * (x > y ? x - y : y - x) % n;
+               }
+               g = gcd(q, n);
+          }
+     }
+     if (g == n) {
+          do {
+               ys = f(ys);
+               g = gcd(x > ys ? x - ys : ys - x, n);
+          } while (g == 1);
+     }
+     return g;
+}
+
+/**
+ * Returns true if and only if \c n is a prime number, checking
+ * divisibility by the divisors generated by Trial_divisors.
+ */
+template <class T>
+bool is_prime_trial(T const& n) {
      static_assert(std::numeric_limits<T>::is_integer);
 
      if (n < 2)
@@ -79,6 +213,48 @@ bool is_prime(T const& n) {
      }
 }
 
+/**
+ * Returns true if and only if \c n is a prime number.
+ *
+ * \implementation Built-in integers up to 64 bits are tested by
+ * is_prime64(). Integers of other bounded types of at most 128 bits,
+ * like Uint128, and of unbounded types like \c
+ * boost::multiprecision::cpp_int are tested by is_prime64() or
+ * is_prime128() if they fit in 64 or 128 bits. Larger integers of
+ * unbounded types are tested by miller_rabin() to the 20 prime bases
+ * 2, 3, ..., 71, so that true means a strong probable prime.
+ * Integers of other types are tested by trial division.
+ */
+template <class T>
+bool is_prime(T const& n) {
+     static_assert(std::numeric_limits<T>::is_integer);
+
+     if (n < 2)
+          return false;
+     if constexpr (std::is_integral_v<T> &&
+                   sizeof(T) <= sizeof(std::uint64_t)) {
+          return is_prime64(static_cast<std::uint64_t>(n));
+     } else if constexpr (!std::numeric_limits<T>::is_bounded) {
+          if (n >> 64 == 0)
+               return is_prime64(static_cast<std::uint64_t>(n));
+          if (n >> 128 == 0)
+               return is_prime128(static_cast<Uint128>(n));
+          for (int const a : {2,  3,  5,  7,  11, 13, 17, 19, 23, 29,
+                              31, 37, 41, 43, 47, 53, 59, 61, 67, 71})
+               if (n % a == 0 || !miller_rabin(n, T(a)))
+                    return false;
+          return true;
+     } else if constexpr (std::numeric_limits<T>::digits <= 64) {
+          return is_prime64(static_cast<std::uint64_t>(n));
+     } else if constexpr (std::numeric_limits<T>::digits <= 128) {
+          if (n >> 64 == 0)
+               return is_prime64(static_cast<std::uint64_t>(n));
+          return is_prime128(static_cast<Uint128>(n));
+     } else {
+          return is_prime_trial(n);
+     }
+}
+
 /**
  * Returns true if and only if \c n is a prime number.
  *
@@ -105,7 +281,16 @@ constexpr bool is_primec(int n) {
  * prime numbers \f$p_1 < p_2 < \ldots < p_k\f$ and positive exponents
  * \f$n_1, n_2, \ldots, n_k\f$ such that \f$n = p_1^{n_1} p_2^{n_2}
  * \ldots p_k^{n_k}\f$. If \f$n < 2\f$, \f$k = 0\f$.
- * \implementation See \cite knuth-2002b, section 4.5.4, algorithm A.
+ *
+ * \implementation Built-in integers up to 64 bits are factorized by
+ * prime_factors64(). Integers of other bounded types of at most 128
+ * bits, like Uint128, and of unbounded types like \c
+ * boost::multiprecision::cpp_int are factorized by prime_factors64()
+ * or prime_factors128() if they fit in 64 or 128 bits. Larger
+ * integers of unbounded types are factorized by trial division by
+ * numbers less than 1024 followed by pollard_brent() and is_prime().
+ * Integers of other types are factorized by trial division, see
+ * \cite knuth-2002b, section 4.5.4, algorithm A.
  */
 template <class T>
 class Integer_factorization {
@@ -121,8 +306,9 @@ public:
 
 private:
      void push(T const& f);
+     void factorize_unbounded(T n);
+     void factorize_trial(T n);
      std::vector<Factor> r_{};
-     typename std::vector<Factor>::iterator it_{r_.end()};
 };
 
 template <class T>
@@ -130,6 +316,76 @@ void Integer_factorization<T>::factorize(T n) {
      r_.clear();
      if (n < 2)
           return;
+     if constexpr (std::is_integral_v<T> &&
+                   sizeof(T) <= sizeof(std::uint64_t)) {
+          for (auto const p :
+               prime_factors64(static_cast<std::uint64_t>(n)))
+               push(static_cast<T>(p));
+     } else if constexpr (!std::numeric_limits<T>::is_bounded) {
+          factorize_unbounded(n);
+     } else if constexpr (std::numeric_limits<T>::digits <= 64) {
+          for (auto const p :
+               prime_factors64(static_cast<std::uint64_t>(n)))
+               push(static_cast<T>(p));
+     } else if constexpr (std::numeric_limits<T>::digits <= 128) {
+          if (n >> 64 == 0) {
+               for (auto const p :
+                    prime_factors64(static_cast<std::uint64_t>(n)))
+                    push(static_cast<T>(p));
+          } else {
+               for (auto const& p :
+                    prime_factors128(static_cast<Uint128>(n)))
+                    push(static_cast<T>(p));
+          }
+     } else {
+          factorize_trial(n);
+     }
+}
+
+template <class T>
+void Integer_factorization<T>::factorize_unbounded(T n) {
+     if (n >> 64 == 0) {
+          for (auto const p :
+               prime_factors64(static_cast<std::uint64_t>(n)))
+               push(T(p));
+          return;
+     }
+     if (n >> 128 == 0) {
+          for (auto const& p :
+               prime_factors128(static_cast<Uint128>(n)))
+               push(T(p));
+          return;
+     }
+     std::vector<T> f, s;
+     Trial_divisors<T> g;
+     for (T d = g(); d < 1024; d = g()) {
+          while (n % d == 0) {
+               f.push_back(d);
+               n /= d;
+          }
+     }
+     if (n > 1)
+          s.push_back(n);
+     while (!s.empty()) {
+          T const m = s.back();
+          s.pop_back();
+          if (is_prime(m)) {
+               f.push_back(m);
+               continue;
+          }
+          T d = m;
+          for (T c = 1; d == m; c++)
+               d = pollard_brent(m, c);
+          s.push_back(d);
+          s.push_back(m / d);
+     }
+     std::sort(f.begin(), f.end());
+     for (auto const& p : f)
+          push(p);
+}
+
+template <class T>
+void Integer_factorization<T>::factorize_trial(T n) {
      Trial_divisors<T> g;
      T q, r, d = g();
 
@@ -160,11 +416,32 @@ Integer_factorization<T>::repr() const {
 
 template <class T>
 void Integer_factorization<T>::push(T const& f) {
-     if (it_ == r_.end() || f != it_->p) {
+     if (r_.empty() || f != r_.back().p)
           r_.push_back({f, 1});
-          it_ = std::prev(r_.end());
-     } else
-          ++it_->n;
+     else
+          ++r_.back().n;
+}
+
+/**
+ * Factorizes the numbers \c n[i] in \c nthreads threads, if \c
+ * nthreads is 0 in number_of_threads() threads. The element \c i of
+ * the result is the factorization of \c n[i].
+ */
+template <class T>
+std::vector<Integer_factorization<T>> factorize(
+     std::vector<T> const& n, unsigned nthreads = 0) {
+     constexpr std::size_t chunk = 256;
+     std::vector<Integer_factorization<T>> f(n.size());
+     parallel_for(
+          (n.size() + chunk - 1) / chunk,
+          [&](std::size_t k) {
+               std::size_t const last =
+                    std::min(n.size(), (k + 1) * chunk);
+               for (std::size_t i = k * chunk; i < last; i++)
+                    f[i].factorize(n[i]);
+          },
+          nthreads);
+     return f;
 }
 
 /** \} */
@@ -6,6 +6,10 @@
 #ifndef SHG_IPART_INL_H
 #define SHG_IPART_INL_H
 
+#include <algorithm>
+#include <shg/except.h>
+#include <shg/utils.h>
+
 namespace SHG {
 
 template <typename F>
@@ -94,6 +98,151 @@ void Ordered_partitions_generator<F>::generate(int n, int k) {
           }
 }
 
+namespace IPART {
+
+/**
+ * Generates the partitions of r into non-decreasing parts not less
+ * than m, placed in a[k], a[k + 1], ...
+ */
+template <typename F>
+void partitions_from(int r, int m, int k, std::vector<int>& a,
+                     F& f) {
+     for (int i = m; 2 * i <= r; i++) {
+          a[k] = i;
+          partitions_from(r - i, i, k + 1, a, f);
+     }
+     if (r >= m) {
+          a[k] = r;
+          f(k + 1, a);
+     }
+}
+
+/**
+ * Generates the ordered partitions of r placed in a[k], a[k + 1],
+ * ...
+ */
+template <typename F>
+void ordered_partitions_from(int r, int k, std::vector<int>& a,
+                             F& f) {
+     for (int i = 1; i < r; i++) {
+          a[k] = i;
+          ordered_partitions_from(r - i, k + 1, a, f);
+     }
+     a[k] = r;
+     f(k + 1, a);
+}
+
+/**
+ * Returns n minus the sum of the prefix of the task after checking
+ * that it is positive.
+ */
+int rest(int n, Partition_task const& t);
+
+template <typename F, typename R, typename S, typename G>
+F parallel(int n, F const& f, R reduce, unsigned nthreads, S split,
+           G generate) {
+     if (n < 1)
+          SHG_THROW(std::invalid_argument, __func__);
+     std::vector<Partition_task> const tasks =
+          split(n, partition_tasks_per_thread *
+                        number_of_threads(nthreads));
+     std::vector<F> g(tasks.size(), f);
+     parallel_for(
+          tasks.size(),
+          [&](std::size_t i) { generate(n, tasks[i], g[i]); },
+          nthreads);
+     F r(f);
+     for (F const& x : g)
+          reduce(r, x);
+     return r;
+}
+
+}  // namespace IPART
+
+template <typename F>
+void generate_partitions(int n, Partition_task const& t, F& f) {
+     int const r = IPART::rest(n, t);
+     int const k = t.prefix.size();
+     int const m = k > 0 ? t.prefix.back() : 1;
+     std::vector<int> a(n);
+     std::copy(t.prefix.cbegin(), t.prefix.cend(), a.begin());
+     for (int i = std::max(m, t.first); i <= t.last && i <= r; i++) {
+          a[k] = i;
+          if (i == r)
+               f(k + 1, a);
+          else if (2 * i <= r)
+               IPART::partitions_from(r - i, i, k + 1, a, f);
+     }
+}
+
+template <typename F>
+void generate_ordered_partitions(int n, Partition_task const& t,
+                                 F& f) {
+     int const r = IPART::rest(n, t);
+     int const k = t.prefix.size();
+     std::vector<int> a(n);
+     std::copy(t.prefix.cbegin(), t.prefix.cend(), a.begin());
+     for (int i = std::max(1, t.first); i <= t.last && i <= r; i++) {
+          a[k] = i;
+          if (i == r)
+               f(k + 1, a);
+          else
+               IPART::ordered_partitions_from(r - i, k + 1, a, f);
+     }
+}
+
+template <typename F, typename R>
+F parallel_partitions(int n, F const& f, R reduce,
+                      unsigned nthreads) {
+     return IPART::parallel(
+          n, f, reduce, nthreads, split_partitions,
+          [](int n, Partition_task const& t, F& g) {
+               generate_partitions(n, t, g);
+          });
+}
+
+template <typename F, typename R>
+F parallel_ordered_partitions(int n, F const& f, R reduce,
+                              unsigned nthreads) {
+     return IPART::parallel(
+          n, f, reduce, nthreads, split_ordered_partitions,
+          [](int n, Partition_task const& t, F& g) {
+               generate_ordered_partitions(n, t, g);
+          });
+}
+
+template <typename T>
+std::vector<T> partition_numbers(int n) {
+     if (n < 0)
+          SHG_THROW(std::invalid_argument, __func__);
+     std::vector<T> p(n + 1);
+     p[0] = 1;
+     for (int m = 1; m <= n; m++) {
+          T s = 0;
+          for (int k = 1;; k++) {
+               int const j1 = m - k * (3 * k - 1) / 2;
+               if (j1 < 0)
+                    break;
+               int const j2 = j1 - k;
+               if (k % 2 == 1) {
+                    s += p[j1];
+                    if (j2 >= 0)
+                         s += p[j2];
+               } else {
+                    s -= p[j1];
+                    if (j2 >= 0)
+                         s -= p[j2];
+               }
+          }
+          // For m >= 2, p(m - 1) <= p(m) < 2p(m - 1), so the first
+          // wrap-around modulo a power of 2 makes p(m) < p(m - 1).
+          if (s < p[m - 1])
+               SHG_THROW(std::overflow_error, __func__);
+          p[m] = s;
+     }
+     return p;
+}
+
 }  // namespace SHG
 
 #endif
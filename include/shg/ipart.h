@@ -6,6 +6,7 @@
 #ifndef SHG_IPART_H
 #define SHG_IPART_H
 
+#include <cstddef>
 #include <stdexcept>
 #include <vector>
 
@@ -127,6 +128,113 @@ private:
      F& f_;
 };
 
+/**
+ * A subproblem of enumeration of partitions of \f$n\f$. It consists
+ * of the partitions which begin with the parts in \c prefix followed
+ * by a part \f$i\f$, \f$first \leq i \leq last\f$. The sum of the
+ * parts in \c prefix is less than \f$n\f$.
+ */
+struct Partition_task {
+     std::vector<int> prefix{};
+     int first{};
+     int last{};
+};
+
+/**
+ * Splits the partitions of \f$n\f$ generated by accel_asc() into
+ * subproblems of about equal size, at least \c ntasks of them if
+ * there are enough partitions. Subproblems cover the partitions in
+ * the order in which accel_asc() generates them. The prefix tree is
+ * cut where the number of partitions in a subtree, computed from the
+ * recurrence \f$q(r, m) = q(r, m + 1) + q(r - m, m)\f$ for the number
+ * of partitions of \f$r\f$ into parts not less than \f$m\f$, falls
+ * below the required size, and small adjacent subtrees are joined.
+ *
+ * \throws std::invalid_argument if \f$n < 1\f$ or \f$ntasks < 1\f$
+ */
+std::vector<Partition_task> split_partitions(int n,
+                                             std::size_t ntasks);
+
+/**
+ * Splits the ordered partitions of \f$n\f$ generated by
+ * Ordered_partitions_generator into subproblems as
+ * split_partitions() does. The subtree of the prefix with sum \f$n
+ * - r\f$ has \f$2^{r - 1}\f$ ordered partitions.
+ *
+ * \throws std::invalid_argument if \f$n < 1\f$ or \f$ntasks < 1\f$
+ */
+std::vector<Partition_task> split_ordered_partitions(
+     int n, std::size_t ntasks);
+
+/**
+ * Calls \c f(k, a) for the partitions of \f$n\f$ in the subproblem
+ * \c t in the order of accel_asc(). The parts are in \c a[0], ...,
+ * \c a[k - 1].
+ */
+template <typename F>
+void generate_partitions(int n, Partition_task const& t, F& f);
+
+/**
+ * Calls \c f(k, a) for the ordered partitions of \f$n\f$ in the
+ * subproblem \c t in the order of Ordered_partitions_generator.
+ */
+template <typename F>
+void generate_ordered_partitions(int n, Partition_task const& t,
+                                 F& f);
+
+/** Number of subproblems per thread in parallel_partitions(). */
+constexpr std::size_t partition_tasks_per_thread = 16;
+
+/**
+ * Enumerates the partitions of \f$n\f$ in \c nthreads threads, if \c
+ * nthreads is 0 in number_of_threads() threads. The partitions are
+ * split by split_partitions() into partition_tasks_per_thread
+ * subproblems per thread, which are taken by the threads from a
+ * common queue as they become free. Each subproblem is enumerated by
+ * generate_partitions() with its own copy of \c f, so that \c f need
+ * not be safe to call concurrently. Then, starting from a copy of \c
+ * f, \c reduce(r, g) is called for the copies \c g in the order of
+ * subproblems and \c r is returned. If \c f and \c reduce do not
+ * depend on the order of partitions, the result is the same as that
+ * of accel_asc() with \c f.
+ *
+ * \throws std::invalid_argument if \f$n < 1\f$
+ */
+template <typename F, typename R>
+F parallel_partitions(int n, F const& f, R reduce,
+                      unsigned nthreads = 0);
+
+/**
+ * Enumerates the ordered partitions of \f$n\f$ in parallel as
+ * parallel_partitions() does. Since the subproblems are reduced in
+ * the order of generation, if \c reduce(r, g) keeps the result of \c
+ * r in case of a tie, the result is the same as that of
+ * Ordered_partitions_generator with \c f.
+ *
+ * \throws std::invalid_argument if \f$n < 1\f$
+ */
+template <typename F, typename R>
+F parallel_ordered_partitions(int n, F const& f, R reduce,
+                              unsigned nthreads = 0);
+
+/**
+ * Returns the numbers of partitions \f$p(0), p(1), \ldots, p(n)\f$
+ * computed without enumeration from Euler's recurrence
+ * \f[
+ *  p(n) = \sum_{k \geq 1} (-1)^{k + 1} \left(p\left(n - \frac{k(3k
+ *  - 1)}{2}\right) + p\left(n - \frac{k(3k + 1)}{2}\right)\right),
+ * \f]
+ * where \f$p(m) = 0\f$ for \f$m < 0\f$, in \f$O(n^{3/2})\f$
+ * operations. \c T should be an unsigned integer type or
+ * boost::multiprecision::cpp_int. For unsigned types, \f$p(n)\f$
+ * fits in 64 bits for \f$n \leq 416\f$.
+ *
+ * \throws std::invalid_argument if \f$n < 0\f$
+ * \throws std::overflow_error if \f$p(n)\f$ does not fit in \c T
+ */
+template <typename T>
+std::vector<T> partition_numbers(int n);
+
 /** \} */ /* end of group partitions_of_integers */
 
 }  // namespace SHG
@@ -130,6 +130,43 @@ double median(SHG::Vecdouble const& x);
 double weighted_median(SHG::Vecdouble const& x,
                        SHG::Vecdouble const& w);
 
+/**
+ * %Sample median of unsorted data. Returns the same value as
+ * median(SHG::Vecdouble const&) for \a x sorted non-decreasingly.
+ *
+ * \exception std::invalid_argument if <tt>x.size() < 1</tt>
+ *
+ * \implementation A copy of \a x is partially ordered by
+ * std::nth_element, so the expected time is \f$O(n)\f$.
+ */
+double median_unsorted(SHG::Vecdouble const& x);
+
+/**
+ * Weighted median of unsorted data. Returns the same value as
+ * weighted_median(SHG::Vecdouble const&, SHG::Vecdouble const&) for
+ * the pairs \f$(x_i, w_i)\f$ sorted non-decreasingly by \f$x_i\f$.
+ *
+ * \exception std::invalid_argument if not <tt>x.size() == w.size() >
+ * 0</tt> or if not <tt>w[i] >= 0</tt> for all \c i or if sum of
+ * <tt>w[i]</tt> is not greater than 0
+ *
+ * \warning Weights are summed in a different order than in
+ * weighted_median(), so the two functions may differently recognize
+ * unique and non-unique minima.
+ *
+ * \implementation Let \f$W = \sum_{i = 1}^n w_i\f$. In the notation
+ * of weighted_median(), \f$x_{k - 1}\f$ is the smallest \f$x_j\f$
+ * such that \f$\sum_{i = 1}^j w_i \geq W / 2\f$. It is found by
+ * weighted selection: the range of candidates is halved by
+ * std::nth_element and the weight of the left half decides which
+ * half contains \f$x_{k - 1}\f$. If the sum is equal to \f$W /
+ * 2\f$, \f$x_{l - 1}\f$ is the smallest element with positive
+ * weight to the right of \f$x_{k - 1}\f$. The expected time is
+ * \f$O(n)\f$.
+ */
+double weighted_median_unsorted(SHG::Vecdouble const& x,
+                                SHG::Vecdouble const& w);
+
 /**
  * Univariate Laplace mixture models.
  *
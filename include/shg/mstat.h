@@ -336,6 +336,384 @@ private:
      static std::vector<double> srt(std::vector<double> const& v);
 };
 
+/**
+ * Returns the \a k-th smallest element of \a x, counting from 0.
+ * After return, \a x is partially ordered as by std::nth_element.
+ *
+ * \exception std::invalid_argument unless k < x.size()
+ *
+ * \implementation std::nth_element is used, so the expected time is
+ * \f$O(n)\f$.
+ */
+double order_statistic(std::vector<double>& x, std::size_t k);
+
+/**
+ * p-th quantile of unsorted data. Returns the same value as
+ * Sample(x).quantile(p) without sorting \a x. After return, \a x is
+ * partially ordered as by std::nth_element.
+ *
+ * \exception std::invalid_argument if x.size() == 0
+ * \exception SHG::Invalid_argument unless 0 < p < 1
+ *
+ * \implementation See order_statistic().
+ */
+double quantile(std::vector<double>& x, double p);
+
+/**
+ * Weighted order statistics over a fixed support. The class keeps a
+ * multiset of weighted observations, each of which must be equal to
+ * one of the points of the support given to the constructor.
+ * Observations may be inserted and erased in any order, so the class
+ * may be used to calculate rolling quantiles or to calculate
+ * repeatedly weighted quantiles for changing weights on the same
+ * support.
+ *
+ * Let \f$x_0 < x_1 < \ldots < x_{m - 1}\f$ be the support and let
+ * \f$w_i\f$ be the total weight of the observations equal to
+ * \f$x_i\f$.
+ *
+ * \implementation The weights are kept in a Fenwick tree
+ * \cite fenwick-1994, so insert(), erase(), cdf() and quantile()
+ * take \f$O(\log m)\f$ time.
+ */
+class Order_statistics {
+public:
+     /**
+      * Constructs an empty multiset on the support. The support is
+      * sorted and duplicates are removed.
+      *
+      * \exception std::invalid_argument if the support is empty
+      */
+     explicit Order_statistics(std::vector<double> const& support);
+
+     /**
+      * Inserts the observation \a x with the weight \a w.
+      *
+      * \exception std::invalid_argument if \a x does not belong to
+      * the support or w < 0
+      */
+     void insert(double x, double w = 1.0);
+
+     /**
+      * Erases the weight \a w of the observation \a x.
+      *
+      * \exception std::invalid_argument if \a x does not belong to
+      * the support or w < 0 or w is greater than the weight of \a x
+      */
+     void erase(double x, double w = 1.0);
+
+     /**
+      * Sets the weights of all points of the support. \a w[i] is
+      * the weight of the i-th smallest point.
+      *
+      * \exception std::invalid_argument if w.size() is not equal to
+      * the size of the support or any weight is negative
+      */
+     void assign(std::vector<double> const& w);
+
+     /**
+      * Returns the total weight \f$W = \sum_{i = 0}^{m - 1} w_i\f$.
+      */
+     double total() const;
+
+     /**
+      * Returns the sum of weights of observations not greater than \a
+      * x divided by total().
+      *
+      * \exception std::invalid_argument if total() is not positive
+      */
+     double cdf(double x) const;
+
+     /**
+      * p-th quantile. Returns the smallest \f$x_j\f$ such that
+      * \f$\sum_{i = 0}^j w_i \geq pW\f$. For unit weights this is
+      * the same as Sample::quantile().
+      *
+      * \exception std::invalid_argument if total() is not positive
+      * \exception SHG::Invalid_argument unless 0 < p < 1
+      */
+     double quantile(double p) const;
+
+     /**
+      * Weighted median. Returns the same value as
+      * weighted_median(SHG::Vecdouble const&, SHG::Vecdouble const&)
+      * called with the support and the weights.
+      *
+      * \exception std::invalid_argument if total() is not positive
+      */
+     double median() const;
+
+private:
+     /**
+      * Returns the index of \a x in the support.
+      */
+     std::size_t index(double x) const;
+
+     /**
+      * Adds \a w to the weight of the i-th point.
+      */
+     void add(std::size_t i, double w);
+
+     /**
+      * Returns the smallest j such that the sum of weights of points
+      * 0, ..., j is greater than (if \a strict) or not less than \a
+      * t.
+      */
+     std::size_t search(double t, bool strict) const;
+
+     std::vector<double> x_;  ///< sorted support
+     std::vector<double> w_;  ///< weights of points
+     std::vector<double> f_;  ///< Fenwick tree, 1-based
+     std::size_t mask_;       ///< highest power of 2 <= x_.size()
+};
+
+/**
+ * Streaming moments. The class accumulates the count, mean, central
+ * moments up to the fourth order, minimum and maximum of a sequence
+ * of observations in one pass without storing them. Accumulators
+ * for disjoint parts of the sequence, eg. calculated in different
+ * threads, may be combined by merge().
+ *
+ * \implementation The updating formulas of \cite knuth-2002b, p.
+ * 248, extended to higher moments and the pairwise formulas for
+ * merging are taken from \cite pebay-2008.
+ */
+class Moments {
+public:
+     /**
+      * Adds the observation \a x.
+      */
+     void add(double x);
+
+     /**
+      * Adds the observations accumulated in \a other.
+      */
+     void merge(Moments const& other);
+
+     /**
+      * Number of observations.
+      */
+     std::size_t n() const;
+
+     /**
+      * Mean.
+      *
+      * \exception std::invalid_argument if n() == 0
+      */
+     double mean() const;
+
+     /**
+      * Variance \f$\frac{1}{n} \sum_{i = 1}^n (x_i - m)^2\f$ as in
+      * mean_var().
+      *
+      * \exception std::invalid_argument if n() == 0
+      */
+     double var() const;
+
+     /**
+      * Unbiased variance \f$\frac{1}{n - 1} \sum_{i = 1}^n (x_i -
+      * m)^2\f$ as in mean_var1().
+      *
+      * \exception std::invalid_argument if n() < 2
+      */
+     double var1() const;
+
+     /**
+      * Standard deviation \f$\sqrt{\mathrm{var()}}\f$ as in
+      * stddev().
+      *
+      * \exception std::invalid_argument if n() == 0
+      */
+     double stddev() const;
+
+     /**
+      * Skewness \f$m_3 / m_2^{3/2}\f$, where \f$m_k = \frac{1}{n}
+      * \sum_{i = 1}^n (x_i - m)^k\f$.
+      *
+      * \exception std::invalid_argument if n() == 0
+      * \exception std::range_error if \f$m_2 = 0\f$
+      */
+     double skewness() const;
+
+     /**
+      * Excess kurtosis \f$m_4 / m_2^2 - 3\f$, where \f$m_k\f$ are as
+      * in skewness().
+      *
+      * \exception std::invalid_argument if n() == 0
+      * \exception std::range_error if \f$m_2 = 0\f$
+      */
+     double kurtosis() const;
+
+     /**
+      * Minimum.
+      *
+      * \exception std::invalid_argument if n() == 0
+      */
+     double min() const;
+
+     /**
+      * Maximum.
+      *
+      * \exception std::invalid_argument if n() == 0
+      */
+     double max() const;
+
+private:
+     std::size_t n_{0};
+     double mean_{0.0};
+     double m2_{0.0};  ///< sum of squared deviations from the mean
+     double m3_{0.0};  ///< sum of cubed deviations from the mean
+     double m4_{0.0};  ///< sum of fourth powers of deviations
+     double min_{0.0};
+     double max_{0.0};
+};
+
+/**
+ * Quantile sketch. The class estimates the distribution of a stream
+ * of weighted observations in bounded memory. The observations are
+ * summarized by a t-digest \cite dunning-ertl-2019, ie. by clusters
+ * (centroids) of a mean and a weight, which are small near the tails
+ * of the distribution and larger in the middle, so the relative
+ * error of quantile(p) is the smallest for p near 0 and 1. Sketches
+ * of disjoint parts of the stream, eg. calculated in different
+ * threads, may be combined by merge().
+ *
+ * The number of centroids is bounded by about \a compression, which
+ * is passed to the constructor, and the error of quantile(p) in
+ * terms of rank is roughly proportional to \f$\sqrt{p(1 - p)} /
+ * \mathrm{compression}\f$. The minimum and maximum are exact.
+ *
+ * The sketch cdf is the piecewise linear function passing through
+ * the points \f$(\min, 0)\f$, \f$(m_i, (W_i + w_i / 2) / W)\f$ and
+ * \f$(\max, 1)\f$, where \f$m_i\f$ and \f$w_i\f$ are the mean and
+ * the weight of the i-th centroid, \f$W_i\f$ is the weight of the
+ * centroids before it and \f$W\f$ is the total weight. quantile() is
+ * the inverse of cdf().
+ *
+ * The methods have the same meaning as in Sample. histogram()
+ * chooses the number of bars as Sample::histogram() does with
+ * total() in place of the sample size.
+ *
+ * \implementation New observations are collected in a buffer which
+ * is merged with the centroids when full and before each query,
+ * using the scale function \f$k_1\f$ of \cite dunning-ertl-2019.
+ *
+ * \warning As the const query methods, and merge() for its argument,
+ * may merge the buffer, a sketch must not be used concurrently by
+ * several threads, even by const methods, unless no observation has
+ * been added to it since the last query or merge().
+ */
+class Quantile_sketch {
+public:
+     /**
+      * Constructs an empty sketch.
+      *
+      * \exception SHG::Invalid_argument unless compression >= 10
+      */
+     explicit Quantile_sketch(double compression = 100.0);
+
+     /**
+      * Adds the observation \a x with the weight \a w.
+      *
+      * \exception SHG::Invalid_argument unless x is finite and w > 0
+      */
+     void add(double x, double w = 1.0);
+
+     /**
+      * Adds the observations summarized in \a other.
+      */
+     void merge(Quantile_sketch const& other);
+
+     /**
+      * Total weight of the observations.
+      */
+     double total() const;
+
+     /**
+      * Sketch cdf.
+      *
+      * \exception std::invalid_argument if total() == 0
+      */
+     double cdf(double x) const;
+
+     /**
+      * p-th quantile.
+      *
+      * \exception std::invalid_argument if total() == 0
+      * \exception SHG::Invalid_argument unless 0 < p < 1
+      */
+     double quantile(double p) const;
+
+     /**
+      * Range (max() - min()).
+      *
+      * \exception std::invalid_argument if total() == 0
+      */
+     double range() const;
+
+     /**
+      * Interquartile range (quantile(0.75) - quantile(0.25)).
+      *
+      * \exception std::invalid_argument if total() == 0
+      */
+     double iqr() const;
+
+     /**
+      * Minimum.
+      *
+      * \exception std::invalid_argument if total() == 0
+      */
+     double min() const;
+
+     /**
+      * Maximum.
+      *
+      * \exception std::invalid_argument if total() == 0
+      */
+     double max() const;
+
+     /**
+      * \exception std::invalid_argument if total() == 0
+      */
+     Sample::Histdata histogram() const;
+
+     /**
+      * \exception std::invalid_argument if total() == 0
+      */
+     Sample::Histdata histogram(int k) const;
+
+     /**
+      * Current number of centroids.
+      */
+     std::size_t size() const;
+
+private:
+     struct Centroid {
+          double mean;
+          double weight;
+     };
+
+     /**
+      * Merges the buffer into the centroids.
+      */
+     void compress() const;
+     void check_nonempty() const;
+
+     static double const eps;
+
+     double const compression_;
+     std::size_t const capacity_;  ///< capacity of the buffer
+     double total_{0.0};
+     double min_{0.0};
+     double max_{0.0};
+     /**
+      * Centroids sorted by mean. They are mutable as compress() is
+      * called lazily by the const query methods.
+      */
+     mutable std::vector<Centroid> centroids_{};
+     mutable std::vector<Centroid> buffer_{};
+};
+
 /**
  * Returns run length distribution.
  *
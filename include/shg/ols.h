@@ -8,12 +8,15 @@
 #define SHG_OLS_H
 
 #include <string>
+#include <vector>
 #include <shg/except.h>
 #include <shg/matrix.h>
 #include <shg/utils.h>
 
 namespace SHG {
 
+class OLS_accumulator;
+
 /**
  * Ordinary Least Squares. The class estimates a multiple regression
  * model by the least squares method and provides summary statistics.
@@ -84,6 +87,29 @@ public:
       */
      OLS(Matdouble const& X, Vecdouble const& y,
          bool add_intercept = true);
+
+     /**
+      * Constructs from observations collected by an accumulator.
+      * The matrix \f$X^TX\f$ and the vector \f$X^Ty\f$ are taken
+      * from \a a, so the observations themselves are not needed.
+      * The residual sum of squares is calculated as \f$w^TZ^TZw\f$,
+      * where \f$Z = [X \; y]\f$ and \f$w = [-\hat{\beta}^T \;
+      * 1]^T\f$.
+      *
+      * \warning As the observations are not available, fitted() and
+      * residuals() return empty vectors and dw() does nothing.
+      *
+      * \exception SHG::OLS::Invalid_argument if \f$n < 1\f$ or
+      * \f$n < k\f$
+      *
+      * \exception SHG::OLS::Singular_covariance_matrix if the matrix
+      * \f$X^TX\f$ is singular
+      *
+      * \exception SHG::OLS::Internal_error in case of an internal
+      * error
+      */
+     explicit OLS(OLS_accumulator const& a);
+
      OLS(OLS const&) = delete;
      OLS& operator=(OLS const&) = delete;
 
@@ -279,12 +305,13 @@ public:
       *
       * \implementation
       *
-      * First it is checked if the intercept and at least one
-      * regressor are included. Then it is checked if the number of
-      * observations is at least 6 and (n_ - (k_ - 1)) >= 5 (these two
-      * conditions are present in tables \cite savin-white-1977). Then
-      * it is checked if rss is greater than 0. If any of these
-      * condition is not met, the function returns and OLS::dw_d_,
+      * First it is checked if the residuals are available and if the
+      * intercept and at least one regressor are included. Then it is
+      * checked if the number of observations is at least 6 and (n_ -
+      * (k_ - 1)) >= 5 (these two conditions are present in tables
+      * \cite savin-white-1977). Then it is checked if rss is greater
+      * than 0. If any of these condition is not met, the function
+      * returns and OLS::dw_d_,
       * OLS::dw_pvalpos_ and OLS::dw_pvalneg_ are not changed. Then
       * the statistic d is calculated and assigned to OLS::dw_d_. Then
       * p-value for positive autocorrelation is calculated and
@@ -352,10 +379,21 @@ public:
      void print(std::ostream& f) const;
 
 private:
+     /**
+      * Initializes members for \a n observations and \a k
+      * parameters.
+      */
+     OLS(int n, int k, bool add_intercept);
+
      /**
       * Performs initial part of estimation.
       */
-     void estimate(Matdouble const& X, Vecdouble const& y);
+     void estimate(OLS_accumulator const& a);
+
+     /**
+      * Calculates summary statistics after rss_ has been set.
+      */
+     void summarize();
 
      /**
       * Returns stars to mark significance.
@@ -395,6 +433,263 @@ private:
      double dw_pvalneg_;         ///< p-value negative autocorrelation
 };
 
+/**
+ * Accumulator of observations for OLS. Observations are added one
+ * by one or in blocks of rows, and only the matrix \f$Z^TZ\f$, where
+ * \f$Z = [X \; y]\f$, is kept in memory. So the number of
+ * observations is not limited by the available memory. Accumulators
+ * filled with different parts of data, eg. in different threads or
+ * from different files, may be merged. Then an OLS object may be
+ * constructed from the accumulator.
+ *
+ * \implementation Each observation updates the upper triangle of
+ * \f$Z^TZ\f$ by a rank-one update. The update runs along rows of
+ * the row-major matrix, so access to memory is contiguous. The sums
+ * are formed in the same order as in OLS::OLS(Matdouble const&,
+ * Vecdouble const&, bool), so for a single accumulator the results
+ * are the same.
+ *
+ * \ingroup mathematical_statistics
+ */
+class OLS_accumulator {
+public:
+     /**
+      * Constructs an empty accumulator for observations with \a k
+      * independent variables. If \a add_intercept is true, a column
+      * of ones is prepended to each row of observations.
+      *
+      * \exception SHG::OLS::Invalid_argument if \a k < 0 or \a k ==
+      * 0 and \a add_intercept is false
+      */
+     explicit OLS_accumulator(int k, bool add_intercept = true);
+
+     /**
+      * Adds one observation. \a x points to the \a k values of
+      * independent variables.
+      */
+     void add(double const* x, double y);
+
+     /**
+      * Adds observations. Each row of \a X is one observation.
+      *
+      * \exception SHG::OLS::Invalid_argument if X.ncols() != \a k or
+      * X.nrows() != y.size()
+      */
+     void add(Matdouble const& X, Vecdouble const& y);
+
+     /**
+      * Adds observations collected by \a a to this accumulator.
+      *
+      * \exception SHG::OLS::Invalid_argument if the accumulators
+      * differ in the number of parameters or in the intercept
+      */
+     void merge(OLS_accumulator const& a);
+
+     /**
+      * Returns the number of observations added so far.
+      */
+     int nobs() const { return n_; }
+
+     /**
+      * Returns the number of parameters.
+      */
+     int nparams() const { return k_; }
+
+     /**
+      * Returns true if and only if the intercept is added.
+      */
+     bool intercept() const { return intercept_; }
+
+private:
+     friend class OLS;
+
+     /**
+      * Adds the row z_ of \f$Z\f$ to the accumulated sums.
+      */
+     void update();
+
+     int const k_;            ///< number of parameters
+     bool const intercept_;   ///< true if intercept is added
+     int n_{0};               ///< number of observations
+     Matdouble zz_;           ///< upper triangle of Z^T Z
+     Vecdouble z_;            ///< current row of Z
+     double mean_y_{0.0};     ///< mean of dependent variable
+     double m2_y_{0.0};       ///< sum of squared deviations of y
+     bool positive_y_{true};  ///< true if all y are positive
+};
+
+/**
+ * Rolling and expanding window least squares. The class estimates
+ * the model of OLS in consecutive windows of observations. In the
+ * rolling mode the window \f$j\f$ contains the observations \f$j,
+ * \ldots, j + w - 1\f$, in the expanding mode it contains the
+ * observations \f$0, \ldots, j + w - 1\f$, where \f$w\f$ is the
+ * window length and \f$j = 0, \ldots, n - w\f$.
+ *
+ * For each window the estimated parameters, their standard errors,
+ * the standard error of regression, the coefficient of determination,
+ * the \f$F\f$-statistic and the \f$p\f$-values of the \f$t\f$- and
+ * \f$F\f$-statistics are calculated as in OLS. The Durbin-Watson
+ * statistic is not calculated, as it needs the residuals. If
+ * \f$X^TX\f$ is singular in a window, all results for this window are
+ * set to NaN.
+ *
+ * \implementation The upper triangular Cholesky factor \f$R\f$ of
+ * \f$Z^TZ\f$, where \f$Z = [X \; y]\f$, is kept. When the window
+ * slides, the new observation is added to \f$R\f$ by a rank-one
+ * update with Givens rotations and the old one is removed by a
+ * rank-one downdate with hyperbolic rotations. If \f$R =
+ * \left[\begin{array}{cc} R_X & q \\ 0 & s \end{array}\right]\f$,
+ * then \f$R_X\hat{\beta} = q\f$, \f$\mathit{RSS} = s^2\f$ and the
+ * total sum of squares is \f$s^2 + \sum_i q_i^2\f$, where the sum
+ * runs over all parameters except the intercept. So each window
+ * costs \f$O(k^2)\f$ operations plus \f$O(k^3)\f$ for standard
+ * errors. To bound the accumulation of rounding errors, and when a
+ * downdate fails, the factor is computed from scratch from the
+ * observations in the window.
+ *
+ * \ingroup mathematical_statistics
+ */
+class Rolling_OLS {
+public:
+     /**
+      * Performs all computations.
+      *
+      * \param [in] X the matrix \f$X\f$
+      * \param [in] y the vector \f$y\f$
+      * \param [in] window the window length \f$w\f$
+      * \param [in] add_intercept if it is true, the intercept is
+      * added to the regression model
+      * \param [in] expanding if it is true, the windows are
+      * expanding, otherwise they are rolling
+      *
+      * \exception SHG::OLS::Invalid_argument if \f$k < 1\f$ or
+      * \f$w \leq k\f$ or \f$n < w\f$ or \f$X\f$ and \f$y\f$
+      * have different number of rows
+      */
+     Rolling_OLS(Matdouble const& X, Vecdouble const& y, int window,
+                 bool add_intercept = true, bool expanding = false);
+
+     /**
+      * Returns the number of windows \f$n - w + 1\f$.
+      */
+     int nwindows() const { return m_; }
+
+     /**
+      * Returns the number of parameters \f$k\f$.
+      */
+     int nparams() const { return k_; }
+
+     /**
+      * Returns the window length \f$w\f$.
+      */
+     int window() const { return w_; }
+
+     /**
+      * Returns estimated parameters. beta()(j, i) is the estimate of
+      * \f$\beta_{i + 1}\f$ in the window \f$j\f$.
+      */
+     Matdouble const& beta() const { return beta_; }
+
+     /**
+      * Returns standard errors of parameters, stored as beta().
+      */
+     Matdouble const& standard_err() const { return standard_err_; }
+
+     /**
+      * Returns standard errors of regression in consecutive windows.
+      */
+     Vecdouble const& ser() const { return ser_; }
+
+     /**
+      * Returns coefficients of determination in consecutive windows.
+      */
+     Vecdouble const& r2() const { return r2_; }
+
+     /**
+      * Returns \f$F\f$-statistics in consecutive windows. If the
+      * \f$F\f$-statistic cannot be calculated, it is set to -1, as
+      * in OLS::fstat().
+      */
+     Vecdouble const& fstat() const { return fstat_; }
+
+     /**
+      * Returns \f$p\f$-values for the \f$t\f$-statistics, stored as
+      * beta(). pvalt()(j, i) is calculated from beta()(j, i) and
+      * standard_err()(j, i) with the number of observations in the
+      * window \f$j\f$ as in OLS::pvalt().
+      */
+     Matdouble const& pvalt() const { return pvalt_; }
+
+     /**
+      * Returns \f$p\f$-values for the \f$F\f$-statistics in
+      * consecutive windows, calculated as in OLS::pvalf(). If the
+      * \f$F\f$-statistic cannot be calculated, the \f$p\f$-value is
+      * 0, as in OLS::pvalf().
+      */
+     Vecdouble const& pvalf() const { return pvalf_; }
+
+private:
+     /**
+      * Adds the row \a z to the Cholesky factor.
+      */
+     void update(double* z);
+
+     /**
+      * Removes the row \a z from the Cholesky factor. Returns false
+      * if the downdated matrix is not positive definite.
+      */
+     bool downdate(double* z);
+
+     /**
+      * Computes the Cholesky factor from the observations from \a
+      * first to \a last - 1.
+      */
+     void refactor(Matdouble const& X, Vecdouble const& y, int first,
+                   int last);
+
+     /**
+      * Loads the observation \a t into z_.
+      */
+     void load(Matdouble const& X, Vecdouble const& y, int t);
+
+     /**
+      * Calculates results for the window \a j from the Cholesky
+      * factor.
+      */
+     void solve(int j, int nobs);
+
+     int k_;                  ///< number of parameters
+     int w_;                  ///< window length
+     int m_;                  ///< number of windows
+     bool intercept_;         ///< true if intercept was added
+     Matdouble r_;            ///< Cholesky factor of Z^T Z
+     Vecdouble z_;            ///< current row of Z
+     Matdouble beta_;         ///< estimated parameters
+     Matdouble standard_err_;  ///< standard errors of parameters
+     Vecdouble ser_;          ///< standard errors of regression
+     Vecdouble r2_;           ///< coefficients of determination
+     Vecdouble fstat_;        ///< F statistics
+     Matdouble pvalt_;        ///< p-values for t statistics
+     Vecdouble pvalf_;        ///< p-values for F statistics
+};
+
+/**
+ * Runs Rolling_OLS for many independent series in parallel. The
+ * result \f$i\f$ is Rolling_OLS(X[i], y[i], window, add_intercept,
+ * expanding). If \a nthreads is 0, the number of hardware threads is
+ * used.
+ *
+ * \exception SHG::OLS::Invalid_argument if X.size() != y.size() or
+ * any series is invalid
+ */
+std::vector<Rolling_OLS> rolling_ols(std::vector<Matdouble> const& X,
+                                     std::vector<Vecdouble> const& y,
+                                     int window,
+                                     bool add_intercept = true,
+                                     bool expanding = false,
+                                     unsigned nthreads = 0);
+
 }  // namespace SHG
 
 #endif
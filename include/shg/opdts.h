@@ -14,6 +14,7 @@
 #include <numeric>
 #include <stdexcept>
 #include <vector>
+#include <shg/permentr.h>
 
 namespace SHG {
 
@@ -108,6 +109,13 @@ void OPDTS<T>::print(std::ostream& f) {
 
 template <class T>
 void OPDTS<T>::calc(T const x[], sztp imax, sztp d) {
+     if (d <= max_flat_pattern_length) {
+          auto const c = ordinal_pattern_counts(x, imax + d - 1, d);
+          for (sztp k = 0; k < c.size(); k++)
+               if (c[k] > 0)
+                    frequency[ordinal_pattern(k, d)] = c[k];
+          return;
+     }
      pattern p(d);
      for (sztp i = 0; i < imax; i++) {
           std::iota(p.begin(), p.end(), 0);
@@ -182,13 +182,15 @@ Rectangle min_rectangle(std::vector<Semiaxes> const& semiaxes,
  * "distance between rows".
  *
  * The method run() generates all possible arrangements (ordered
- * partitions).
+ * partitions) in \c nthreads threads, if \c nthreads is 0 in
+ * number_of_threads() threads, by parallel_ordered_partitions(). The
+ * result does not depend on the number of threads.
  */
 class Congruent_regular {
 public:
      Congruent_regular(std::size_t n, double a, double b);
      void operator()(int k, std::vector<int> const& a);
-     void run();
+     void run(unsigned nthreads = 0);
      std::size_t n() const;
      double a() const;
      double b() const;
@@ -0,0 +1,661 @@
+/**
+ * \file include/shg/packpoly.h
+ * Packed polynomials.
+ */
+
+#ifndef SHG_PACKPOLY_H
+#define SHG_PACKPOLY_H
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+#include <stdexcept>
+#include <vector>
+#include <shg/algebra.h>
+#include <shg/monomial.h>
+#include <shg/polynomial.h>
+#include <shg/term.h>
+
+namespace SHG::ALGEBRA {
+
+/**
+ * \addtogroup algebra
+ *
+ * \{
+ */
+
+/**
+ * Monomial orders supported by Packed_layout.
+ */
+enum class Packed_order { lex, grlex, grevlex };
+
+/**
+ * If \c cmp is lex_cmp(), grlex_cmp() or grevlex_cmp(), sets \c
+ * order to the corresponding order and returns true. Otherwise
+ * returns false and leaves \c order unchanged.
+ */
+bool packed_order(Monomial_cmp cmp, Packed_order& order);
+
+/**
+ * Returns lex_cmp(), grlex_cmp() or grevlex_cmp().
+ */
+Monomial_cmp monomial_cmp(Packed_order order);
+
+/**
+ * Layout of packed monomials.
+ *
+ * A packed monomial of \f$n\f$ variables is an array of \f$1 +
+ * \lceil n / 8 \rceil\f$ 64-bit words. The first word holds the
+ * total degree, the following words hold eight exponents each, one
+ * exponent per byte, beginning with the most significant byte. The
+ * most significant bit of each byte is kept clear, so that the
+ * exponents must not exceed 127, but then multiplication and the
+ * divisibility test work on whole words.
+ *
+ * For lex and grlex, the exponents are stored in the order \f$x_1,
+ * x_2, \ldots, x_n\f$ and the words are compared as unsigned
+ * integers. For grevlex, the exponents are stored in the order
+ * \f$x_n, x_{n - 1}, \ldots, x_1\f$ and the result of the comparison
+ * of the exponent words is reversed.
+ */
+class Packed_layout {
+public:
+     /** The greatest exponent which can be packed. */
+     static constexpr int max_exponent = 127;
+
+     Packed_layout() = default;
+     Packed_layout(int dim, Packed_order order);
+     int dim() const { return dim_; }
+     Packed_order order() const { return order_; }
+     /** Number of words of a packed monomial. */
+     int words() const { return words_; }
+     /**
+      * Packs \c m into \c w. Throws std::invalid_argument if \c m
+      * has a wrong dimension and std::overflow_error if an exponent
+      * is greater than max_exponent.
+      */
+     void pack(Monomial const& m, std::uint64_t* w) const;
+     Monomial unpack(std::uint64_t const* w) const;
+     int deg(std::uint64_t const* w) const;
+     /**
+      * Returns -1, 0 or 1 if \c x is less than, equal to or greater
+      * than \c y.
+      */
+     int compare(std::uint64_t const* x,
+                 std::uint64_t const* y) const;
+     /** Returns true if \c x divides \c y. */
+     bool divides(std::uint64_t const* x,
+                  std::uint64_t const* y) const;
+     /**
+      * Sets \c z to \c x times \c y. Throws std::overflow_error if
+      * an exponent of the product is greater than max_exponent.
+      */
+     void mul(std::uint64_t const* x, std::uint64_t const* y,
+              std::uint64_t* z) const;
+     /** Sets \c z to \c x divided by \c y. \c y must divide \c x. */
+     void div(std::uint64_t const* x, std::uint64_t const* y,
+              std::uint64_t* z) const;
+     /** Sets \c z to the least common multiple of \c x and \c y. */
+     void lcm(std::uint64_t const* x, std::uint64_t const* y,
+              std::uint64_t* z) const;
+
+private:
+     static constexpr std::uint64_t guard_ = 0x8080808080808080;
+     int dim_{1};
+     Packed_order order_{Packed_order::lex};
+     int words_{2};
+};
+
+/**
+ * Coefficients of packed polynomials taken from an algebraic
+ * structure. Other coefficient types must provide the same members.
+ *
+ * factors() returns \f$b \neq 0\f$ and \f$a\f$ such that \f$bx =
+ * ay\f$. normalize() divides the coefficients of a polynomial,
+ * beginning with the leading one, by a common factor, for a field
+ * by the leading coefficient.
+ */
+class Element_coefficients {
+public:
+     using Coef = Element;
+
+     explicit Element_coefficients(AS const* as) : as_(as) {}
+     AS const* as() const { return as_; }
+     Coef from_element(Element const& x) const { return x; }
+     Element to_element(Coef const& x) const { return x; }
+     Coef zero() const { return as_->zero(); }
+     bool is_zero(Coef const& x) const { return x == as_->zero(); }
+     bool is_one(Coef const& x) const { return x == as_->one(); }
+     Coef neg(Coef const& x) const { return as_->neg(x); }
+     Coef sub(Coef const& x, Coef const& y) const {
+          return as_->add(x, as_->neg(y));
+     }
+     Coef mul(Coef const& x, Coef const& y) const {
+          return as_->mul(x, y);
+     }
+     Coef div(Coef const& x, Coef const& y) const { return x / y; }
+     void factors(Coef const& x, Coef const& y, Coef& b,
+                  Coef& a) const;
+     void normalize(Coef* first, Coef* last) const;
+
+private:
+     AS const* as_;
+};
+
+/**
+ * Coefficients in \f$\mathbb{Z}_p\f$, where \f$p\f$ is an odd
+ * prime, kept in Montgomery form \f$xR \bmod p\f$, \f$R =
+ * 2^{32}\f$, so that multiplication needs no division. See
+ * \cite montgomery-1985.
+ */
+class Zp_coefficients {
+public:
+     using Coef = std::uint32_t;
+
+     /**
+      * Throws std::invalid_argument if \c as->n() is not an odd
+      * prime.
+      */
+     explicit Zp_coefficients(Ring_Zn const* as);
+     Ring_Zn const* as() const { return as_; }
+     std::uint32_t p() const { return p_; }
+     Coef from_element(Element const& x) const;
+     Element to_element(Coef const& x) const;
+     Coef zero() const { return 0; }
+     bool is_zero(Coef const& x) const { return x == 0; }
+     bool is_one(Coef const& x) const { return x == one_; }
+     Coef neg(Coef const& x) const { return x == 0 ? 0 : p_ - x; }
+     Coef sub(Coef const& x, Coef const& y) const {
+          return x >= y ? x - y : x + (p_ - y);
+     }
+     Coef mul(Coef const& x, Coef const& y) const {
+          return redc(static_cast<std::uint64_t>(x) * y);
+     }
+     Coef inv(Coef const& x) const;
+     Coef div(Coef const& x, Coef const& y) const {
+          return mul(x, inv(y));
+     }
+     void factors(Coef const& x, Coef const& y, Coef& b,
+                  Coef& a) const;
+     void normalize(Coef* first, Coef* last) const;
+
+private:
+     /** Returns \f$tR^{-1} \bmod p\f$ for \f$t < pR\f$. */
+     Coef redc(std::uint64_t t) const;
+
+     Ring_Zn const* as_;
+     std::uint32_t p_;
+     std::uint32_t pinv_;  // -p^{-1} mod R
+     std::uint32_t r2_;    // R^2 mod p
+     std::uint32_t one_;   // R mod p
+};
+
+/**
+ * Coefficients in \f$\mathbb{Q}\f$ for fraction-free computation.
+ * A polynomial over \f$\mathbb{Q}\f$ is represented by a
+ * polynomial with integer coefficients proportional to it, so that
+ * reductions need no rational arithmetic and normalize() divides by
+ * the content. from_element() accepts only integers, see
+ * clear_denominators().
+ */
+class Fraction_free_coefficients {
+public:
+     using Coef = boost::multiprecision::cpp_int;
+
+     explicit Fraction_free_coefficients(Field_Q const* as)
+          : as_(as) {}
+     Field_Q const* as() const { return as_; }
+     /** Throws std::invalid_argument if \c x is not an integer. */
+     Coef from_element(Element const& x) const;
+     Element to_element(Coef const& x) const;
+     Coef zero() const { return 0; }
+     bool is_zero(Coef const& x) const { return x.is_zero(); }
+     bool is_one(Coef const& x) const { return x == 1; }
+     Coef neg(Coef const& x) const { return -x; }
+     Coef sub(Coef const& x, Coef const& y) const { return x - y; }
+     Coef mul(Coef const& x, Coef const& y) const { return x * y; }
+     void factors(Coef const& x, Coef const& y, Coef& b,
+                  Coef& a) const;
+     void normalize(Coef* first, Coef* last) const;
+
+private:
+     Field_Q const* as_;
+};
+
+/**
+ * Returns the polynomial over \f$\mathbb{Q}\f$ multiplied by the
+ * least common multiple of the denominators of its coefficients.
+ */
+Polynomial clear_denominators(Polynomial const& p);
+
+/**
+ * %Polynomial with packed monomials.
+ *
+ * The terms are kept in two contiguous arrays, monomials and
+ * coefficients, sorted decreasingly with respect to the monomial
+ * order of the layout. Thus the leading term is the first one and
+ * it may be removed in constant time. \c F describes the
+ * coefficients, see Element_coefficients.
+ */
+template <typename F>
+class Packed_polynomial {
+public:
+     using Coef = typename F::Coef;
+
+     Packed_polynomial(Packed_layout const& layout, F const& field);
+     Packed_layout const& layout() const { return layout_; }
+     F const& field() const { return field_; }
+     std::size_t size() const { return c_.size() - first_; }
+     bool is_zero() const { return size() == 0; }
+     /** Returns the monomial of the i-th greatest term. */
+     std::uint64_t const* monomial(std::size_t i) const;
+     /** Returns the coefficient of the i-th greatest term. */
+     Coef const& coefficient(std::size_t i) const;
+     std::uint64_t const* leading_monomial() const;
+     Coef const& leading_coefficient() const;
+     void set_to_zero();
+     /**
+      * Appends a term. \c a must be non-zero and \c m must be less
+      * than the monomials of the polynomial.
+      */
+     void push_back(Coef const& a, std::uint64_t const* m);
+     /** Removes the leading term. */
+     void pop_front();
+     /**
+      * Subtracts \f$a u g\f$. Throws std::overflow_error, leaving
+      * the polynomial unchanged, if an exponent of \f$ug\f$ is
+      * greater than Packed_layout::max_exponent.
+      */
+     void sub_mul(Coef const& a, std::uint64_t const* u,
+                  Packed_polynomial const& g);
+     /**
+      * Sets the polynomial to \f$bf - a u g\f$, where \f$f\f$ is
+      * the polynomial. Throws as sub_mul().
+      */
+     void mul_sub(Coef const& b, Coef const& a,
+                  std::uint64_t const* u, Packed_polynomial const& g);
+     /** Multiplies the polynomial by the monomial \c u. */
+     void mul(std::uint64_t const* u);
+     /** Calls F::normalize() for the coefficients. */
+     void normalize();
+
+private:
+     void merge(Coef const* b, Coef const& a, std::uint64_t const* u,
+                Packed_polynomial const& g);
+     void append(Coef const& a, std::uint64_t const* m);
+
+     Packed_layout layout_;
+     F field_;
+     std::vector<std::uint64_t> m_{};
+     std::vector<Coef> c_{};
+     std::size_t first_{0};
+     std::vector<std::uint64_t> mt_{};
+     std::vector<Coef> ct_{};
+     std::vector<std::uint64_t> t_{};
+};
+
+/**
+ * Converts a polynomial to a packed polynomial. Throws
+ * std::overflow_error if an exponent is greater than
+ * Packed_layout::max_exponent.
+ */
+template <typename F>
+Packed_polynomial<F> to_packed(Polynomial const& p,
+                               Packed_layout const& layout,
+                               F const& field);
+
+/**
+ * Converts a packed polynomial to a polynomial over \c as with the
+ * order of the layout.
+ */
+template <typename F>
+Polynomial to_polynomial(Packed_polynomial<F> const& p,
+                         AS const* as);
+
+/**
+ * Division of packed polynomials. Calculates \c a and \c r as
+ * ALGGEOM::Polynomial_div does. The divisors must be non-zero and
+ * have the layout of \c f. Throws std::overflow_error if an
+ * exponent exceeds Packed_layout::max_exponent.
+ */
+template <typename F>
+void divide(Packed_polynomial<F> f,
+            std::vector<Packed_polynomial<F>> const& g,
+            std::vector<Packed_polynomial<F>>& a,
+            Packed_polynomial<F>& r);
+
+/**
+ * Reduces \c f with respect to \c g until no monomial of \c f is
+ * divisible by a leading monomial of \c g. The result is a
+ * non-zero multiple of the remainder of division of \c f by \c
+ * g. The divisors must be non-zero.
+ */
+template <typename F>
+void reduce(Packed_polynomial<F>& f,
+            std::vector<Packed_polynomial<F> const*> const& g);
+
+inline int Packed_layout::deg(std::uint64_t const* w) const {
+     return static_cast<int>(w[0]);
+}
+
+inline int Packed_layout::compare(std::uint64_t const* x,
+                                  std::uint64_t const* y) const {
+     if (order_ != Packed_order::lex && x[0] != y[0])
+          return x[0] < y[0] ? -1 : 1;
+     for (int i = 1; i < words_; i++)
+          if (x[i] != y[i]) {
+               bool const less = x[i] < y[i];
+               if (order_ == Packed_order::grevlex)
+                    return less ? 1 : -1;
+               return less ? -1 : 1;
+          }
+     return 0;
+}
+
+inline bool Packed_layout::divides(std::uint64_t const* x,
+                                   std::uint64_t const* y) const {
+     if (x[0] > y[0])
+          return false;
+     for (int i = 1; i < words_; i++)
+          if ((((y[i] | guard_) - x[i]) & guard_) != guard_)
+               return false;
+     return true;
+}
+
+inline void Packed_layout::mul(std::uint64_t const* x,
+                               std::uint64_t const* y,
+                               std::uint64_t* z) const {
+     std::uint64_t over = 0;
+     z[0] = x[0] + y[0];
+     for (int i = 1; i < words_; i++) {
+          z[i] = x[i] + y[i];
+          over |= z[i];
+     }
+     if (over & guard_)
+          throw std::overflow_error(
+               "packed monomial: exponent too large");
+}
+
+inline void Packed_layout::div(std::uint64_t const* x,
+                               std::uint64_t const* y,
+                               std::uint64_t* z) const {
+     for (int i = 0; i < words_; i++)
+          z[i] = x[i] - y[i];
+}
+
+inline void Packed_layout::lcm(std::uint64_t const* x,
+                               std::uint64_t const* y,
+                               std::uint64_t* z) const {
+     constexpr std::uint64_t lo = 0x00ff00ff00ff00ff;
+     constexpr std::uint64_t ones = 0x0001000100010001;
+     z[0] = 0;
+     for (int i = 1; i < words_; i++) {
+          // The high bit of a byte is set where x >= y.
+          std::uint64_t const ge = ((x[i] | guard_) - y[i]) & guard_;
+          std::uint64_t const mask = (ge >> 7) * 0xff;
+          z[i] = (x[i] & mask) | (y[i] & ~mask);
+          std::uint64_t const s = (z[i] & lo) + ((z[i] >> 8) & lo);
+          z[0] += (s * ones) >> 48;
+     }
+}
+
+template <typename F>
+Packed_polynomial<F>::Packed_polynomial(Packed_layout const& layout,
+                                        F const& field)
+     : layout_(layout), field_(field), t_(layout.words()) {}
+
+template <typename F>
+std::uint64_t const* Packed_polynomial<F>::monomial(
+     std::size_t i) const {
+     return m_.data() + (first_ + i) * layout_.words();
+}
+
+template <typename F>
+typename Packed_polynomial<F>::Coef const&
+Packed_polynomial<F>::coefficient(std::size_t i) const {
+     return c_[first_ + i];
+}
+
+template <typename F>
+std::uint64_t const* Packed_polynomial<F>::leading_monomial() const {
+     assert(!is_zero());
+     return monomial(0);
+}
+
+template <typename F>
+typename Packed_polynomial<F>::Coef const&
+Packed_polynomial<F>::leading_coefficient() const {
+     assert(!is_zero());
+     return c_[first_];
+}
+
+template <typename F>
+void Packed_polynomial<F>::set_to_zero() {
+     m_.clear();
+     c_.clear();
+     first_ = 0;
+}
+
+template <typename F>
+void Packed_polynomial<F>::push_back(Coef const& a,
+                                     std::uint64_t const* m) {
+     assert(!field_.is_zero(a));
+     assert(is_zero() ||
+            layout_.compare(monomial(size() - 1), m) > 0);
+     append(a, m);
+}
+
+template <typename F>
+void Packed_polynomial<F>::pop_front() {
+     assert(!is_zero());
+     if (++first_ == c_.size())
+          set_to_zero();
+}
+
+template <typename F>
+void Packed_polynomial<F>::sub_mul(Coef const& a,
+                                   std::uint64_t const* u,
+                                   Packed_polynomial const& g) {
+     merge(nullptr, a, u, g);
+}
+
+template <typename F>
+void Packed_polynomial<F>::mul_sub(Coef const& b, Coef const& a,
+                                   std::uint64_t const* u,
+                                   Packed_polynomial const& g) {
+     merge(field_.is_one(b) ? nullptr : &b, a, u, g);
+}
+
+template <typename F>
+void Packed_polynomial<F>::mul(std::uint64_t const* u) {
+     auto const w = layout_.words();
+     auto const n = size();
+     mt_.resize(n * w);
+     for (std::size_t i = 0; i < n; i++)
+          layout_.mul(u, monomial(i), mt_.data() + i * w);
+     m_.swap(mt_);
+     c_.erase(c_.begin(), c_.begin() + first_);
+     first_ = 0;
+}
+
+template <typename F>
+void Packed_polynomial<F>::normalize() {
+     if (!is_zero())
+          field_.normalize(c_.data() + first_, c_.data() + c_.size());
+}
+
+template <typename F>
+void Packed_polynomial<F>::merge(Coef const* b, Coef const& a,
+                                 std::uint64_t const* u,
+                                 Packed_polynomial const& g) {
+     auto const w = layout_.words();
+     std::size_t i = 0, j = 0;
+     std::size_t const n = size(), ng = g.size();
+     bool have_t = false;
+     mt_.clear();
+     ct_.clear();
+     while (i < n && j < ng) {
+          if (!have_t) {
+               layout_.mul(u, g.monomial(j), t_.data());
+               have_t = true;
+          }
+          auto const* const m = monomial(i);
+          int const c = layout_.compare(m, t_.data());
+          if (c > 0) {
+               mt_.insert(mt_.end(), m, m + w);
+               ct_.push_back(b == nullptr
+                                  ? coefficient(i)
+                                  : field_.mul(*b, coefficient(i)));
+               i++;
+          } else {
+               Coef const d = field_.mul(a, g.coefficient(j++));
+               if (c < 0) {
+                    mt_.insert(mt_.end(), t_.cbegin(), t_.cend());
+                    ct_.push_back(field_.neg(d));
+               } else {
+                    Coef const e =
+                         b == nullptr
+                              ? field_.sub(coefficient(i), d)
+                              : field_.sub(
+                                     field_.mul(*b, coefficient(i)),
+                                     d);
+                    i++;
+                    if (!field_.is_zero(e)) {
+                         mt_.insert(mt_.end(), t_.cbegin(),
+                                    t_.cend());
+                         ct_.push_back(e);
+                    }
+               }
+               have_t = false;
+          }
+     }
+     for (; j < ng; j++) {
+          layout_.mul(u, g.monomial(j), t_.data());
+          mt_.insert(mt_.end(), t_.cbegin(), t_.cend());
+          ct_.push_back(field_.neg(field_.mul(a, g.coefficient(j))));
+     }
+     if (i < n) {
+          mt_.insert(mt_.end(), monomial(i), monomial(n));
+          if (b == nullptr)
+               ct_.insert(ct_.end(), c_.cbegin() + first_ + i,
+                          c_.cend());
+          else
+               for (; i < n; i++)
+                    ct_.push_back(field_.mul(*b, coefficient(i)));
+     }
+     m_.swap(mt_);
+     c_.swap(ct_);
+     first_ = 0;
+}
+
+template <typename F>
+void Packed_polynomial<F>::append(Coef const& a,
+                                  std::uint64_t const* m) {
+     m_.insert(m_.end(), m, m + layout_.words());
+     c_.push_back(a);
+}
+
+template <typename F>
+Packed_polynomial<F> to_packed(Polynomial const& p,
+                               Packed_layout const& layout,
+                               F const& field) {
+     if (p.dim() != layout.dim())
+          throw std::invalid_argument(
+               "packed polynomial: bad number of variables");
+     auto const w = layout.words();
+     auto const n = p.terms().size();
+     std::vector<std::uint64_t> m(n * w);
+     std::vector<Element const*> c;
+     c.reserve(n);
+     for (auto const& [x, a] : p.terms()) {
+          layout.pack(x, m.data() + c.size() * w);
+          c.push_back(&a);
+     }
+     std::vector<std::size_t> idx(n);
+     std::iota(idx.begin(), idx.end(), 0);
+     std::sort(idx.begin(), idx.end(),
+               [&](std::size_t i, std::size_t j) {
+                    return layout.compare(m.data() + i * w,
+                                          m.data() + j * w) > 0;
+               });
+     Packed_polynomial<F> q(layout, field);
+     for (auto const i : idx)
+          q.push_back(field.from_element(*c[i]), m.data() + i * w);
+     return q;
+}
+
+template <typename F>
+Polynomial to_polynomial(Packed_polynomial<F> const& p,
+                         AS const* as) {
+     auto const& layout = p.layout();
+     Polynomial q(as, layout.dim());
+     q.order(monomial_cmp(layout.order()));
+     for (std::size_t i = 0; i < p.size(); i++)
+          q += Term(p.field().to_element(p.coefficient(i)),
+                    layout.unpack(p.monomial(i)));
+     return q;
+}
+
+template <typename F>
+void divide(Packed_polynomial<F> f,
+            std::vector<Packed_polynomial<F>> const& g,
+            std::vector<Packed_polynomial<F>>& a,
+            Packed_polynomial<F>& r) {
+     auto const& layout = f.layout();
+     auto const& field = f.field();
+     auto const s = g.size();
+     std::vector<std::uint64_t> w(layout.words());
+     a.assign(s, Packed_polynomial<F>(layout, field));
+     r = Packed_polynomial<F>(layout, field);
+     while (!f.is_zero()) {
+          auto const* const ltf = f.leading_monomial();
+          std::size_t i = 0;
+          while (i < s &&
+                 !layout.divides(g[i].leading_monomial(), ltf))
+               i++;
+          if (i < s) {
+               layout.div(ltf, g[i].leading_monomial(), w.data());
+               auto const c = field.div(f.leading_coefficient(),
+                                        g[i].leading_coefficient());
+               f.sub_mul(c, w.data(), g[i]);
+               a[i].push_back(c, w.data());
+          } else {
+               r.push_back(f.leading_coefficient(), ltf);
+               f.pop_front();
+          }
+     }
+}
+
+template <typename F>
+void reduce(Packed_polynomial<F>& f,
+            std::vector<Packed_polynomial<F> const*> const& g) {
+     auto const& layout = f.layout();
+     auto const& field = f.field();
+     auto const s = g.size();
+     std::vector<std::uint64_t> w(layout.words());
+     typename F::Coef a, b;
+     std::size_t k = 0;
+     while (k < f.size()) {
+          auto const* const m = f.monomial(k);
+          std::size_t i = 0;
+          while (i < s &&
+                 !layout.divides(g[i]->leading_monomial(), m))
+               i++;
+          if (i < s) {
+               layout.div(m, g[i]->leading_monomial(), w.data());
+               field.factors(f.coefficient(k),
+                             g[i]->leading_coefficient(), b, a);
+               f.mul_sub(b, a, w.data(), *g[i]);
+          } else {
+               k++;
+          }
+     }
+}
+
+/** \} */ /* end of group algebra */
+
+}  // namespace SHG::ALGEBRA
+
+#endif
@@ -55,6 +55,19 @@ std::ostream& operator<<(std::ostream& stream, Vecsprod const& vsp);
  * #terminal_names_. #nmap_ and #tmap_ map names to numbers. Binary
  * and unary productions are stored in #bp_ and #up_.
  *
+ * The charts #beta_, #alpha_, #delta_ and #psi_ are flat arrays
+ * indexed by span and then by nonterminal, see cell(). They are
+ * reused for consecutive sentences. Binary productions are also
+ * indexed by the left child in #by_left_ and by the left-hand side
+ * in #by_parent_, so that the inside and Viterbi passes combine only
+ * the nonterminals with nonzero inside probabilities, listed for
+ * each span in #nz_.
+ *
+ * In the log-space mode, set by set_log_space(), the charts hold
+ * logarithms of probabilities, so that long sentences do not
+ * underflow. The public functions return the same values in both
+ * modes, except that prob() and cyk() may return 0 where log_prob()
+ * and log_cyk() return a finite value.
  */
 class PCFG {
 public:
@@ -66,6 +79,15 @@ public:
           std::string to_string() const;
      };
      using Parse_tree = Tree<Parse_node>;
+     /**
+      * Search statistics of beam_cyk().
+      */
+     struct Beam_stats {
+          Index cells{};   ///< number of nonempty cells after pruning
+          Index edges{};   ///< number of considered edges
+          Index pruned{};  ///< number of pruned chart entries
+          bool fallback{false};  ///< if the exact parse was used
+     };
 
      PCFG() = default;
      PCFG(PCFG const& other);
@@ -100,6 +122,13 @@ public:
       */
      double log_prob(Vecsent const& vs);
 
+     /**
+      * Calculates logarithm of probability of the string \c w. In
+      * the log-space mode the result is finite even if prob(w)
+      * underflows.
+      */
+     double log_prob(Sentence const& w);
+
      /**
       * Calculates probability of the string \c w using outside
       * probabilities according to formulas
@@ -114,10 +143,56 @@ public:
       */
      void cyk(Sentence const& w, double& prob, Parse_tree& t);
 
+     /**
+      * Same as cyk(), but returns the logarithm of probability of
+      * the most probable parse.
+      */
+     void log_cyk(Sentence const& w, double& logprob, Parse_tree& t);
+
+     /**
+      * Approximate version of cyk(). After a cell of the chart is
+      * filled, the nonterminals whose Viterbi probability is less
+      * than \a threshold times the greatest one in the cell are
+      * removed, and then only \a beam most probable ones are kept.
+      * In the cell of the whole sentence only \f$N^0\f$ is kept and
+      * it is not pruned. If no parse survives the pruning, the exact
+      * cyk() is done and \a stats.fallback is set to true. With \a
+      * beam not less than the number of nonterminals and \a
+      * threshold equal to 0 the result is the same as that of cyk().
+      *
+      * \throws std::invalid_argument if \a beam is 0 or \a
+      * threshold is not in [0, 1)
+      */
+     void beam_cyk(Sentence const& w, Index beam, double threshold,
+                   double& prob, Parse_tree& t, Beam_stats& stats);
+
+     /**
+      * Switches the log-space mode on or off. It is off by default.
+      */
+     void set_log_space(bool on);
+     bool log_space() const;
+
      int inside_outside(Vecsent const& vs, double accuracy,
                         double tol, int max_iter, int& iter,
                         double& logp);
 
+     /**
+      * Same as the function above, but the sentences are divided
+      * among \a nthreads threads, 0 meaning number_of_threads().
+      * Each thread accumulates the expected numbers of uses of the
+      * productions \cite manning-schutze-2003, page 400, in its own
+      * buffer, and the buffers are added before the maximization
+      * step. The log-likelihood of the current grammar is obtained
+      * in the same pass. The tables #ftab_, #gtab_ and #htab_ are
+      * not used, so that memory does not grow with the number of
+      * sentences. The results differ from those of the function
+      * above only by rounding errors, which may also depend on \a
+      * nthreads.
+      */
+     int inside_outside(Vecsent const& vs, double accuracy,
+                        double tol, int max_iter, int& iter,
+                        double& logp, unsigned nthreads);
+
      /**
       * Removes productions with probabilities less than or equal to
       * \f$\varepsilon \in [0, 1)\f$.
@@ -131,14 +206,39 @@ public:
 private:
      using Binary = std::map<std::pair<Index, Index>, double>;
      using Unary = std::map<Index, double>;
-     using Prob_table = std::vector<std::vector<std::vector<double>>>;
+     using Prob_table = std::vector<double>;
      struct Backtrace {
           Index j;
           Index k;
           Index r;
      };
-     using Backtrace_table =
-          std::vector<std::vector<std::vector<Backtrace>>>;
+     using Backtrace_table = std::vector<Backtrace>;
+     /**
+      * Binary production \f$N^j \rightarrow N^r N^s\f$ in #by_left_
+      * (for \f$N^r\f$) or #by_parent_ (for \f$N^j\f$).
+      */
+     struct Rule {
+          Index a;       ///< \f$j\f$ or \f$r\f$, respectively
+          Index b;       ///< \f$s\f$
+          double prob;   ///< probability
+          double lprob;  ///< logarithm of probability
+     };
+     /**
+      * Expected numbers of uses of productions in a part of the
+      * corpus and its log-likelihood.
+      */
+     struct Counts {
+          /// For productions in #by_parent_.
+          std::vector<std::vector<double>> binary{};
+          /// For \f$N^j \rightarrow w^k\f$ at \f$jV + k\f$.
+          std::vector<double> unary{};
+          /// For each nonterminal, the sum of the above.
+          std::vector<double> total{};
+          double logp{};     ///< log-likelihood
+          bool ok{true};     ///< if logp is finite
+          bool small{false}; ///< if some probability is <= 1e-50
+     };
+     using Corpus = std::vector<std::vector<Index>>;
      using F_table = std::vector<std::vector<std::vector<
           std::vector<std::vector<std::vector<double>>>>>>;
      using GH_table =
@@ -159,6 +259,11 @@ private:
       * w_k) = \var{prob}\f$.
       */
      std::vector<Unary> up_{};
+     /// Binary productions indexed by the left child.
+     std::vector<std::vector<Rule>> by_left_{};
+     /// Binary productions indexed by the left-hand side.
+     std::vector<std::vector<Rule>> by_parent_{};
+     bool log_space_{false};
 
      /** Pointers to names of nonterminals. */
      std::vector<std::string const*> nonterminal_names_{};
@@ -174,16 +279,23 @@ private:
 
      /**
       * Table of inside probabilities \cite manning-schutze-2003,
-      * pages 392-393. \f$\var{beta\_}(j, p, q) = \beta_j(p, q), \quad
+      * pages 392-393. \f$\var{beta}(j, p, q) = \beta_j(p, q), \quad
       * 0 \leq j < n, \quad 0 \leq p \leq q < m\f$.
       */
      Prob_table beta_{};
      /**
       * Table of outside probabilities \cite manning-schutze-2003,
-      * pages 394-396. \f$\var{alpha\_}(j, p, q) = \alpha_j(p, q),
+      * pages 394-396. \f$\var{alpha}(j, p, q) = \alpha_j(p, q),
       * \quad 0 \leq j < n, \quad 0 \leq p \leq q < m\f$.
       */
      Prob_table alpha_{};
+     /**
+      * Nonterminals \f$j\f$ with nonzero \f$\beta_j(p, q)\f$ are
+      * nz_[i] for nz_begin_[c] <= i < nz_begin_[c + 1], where c =
+      * cell(p, q).
+      */
+     std::vector<Index> nz_{};
+     std::vector<Index> nz_begin_{};
 
      /**
       * \name Tables used in %CYK algorithm.
@@ -191,14 +303,14 @@ private:
       */
      /**
       * Table of the greatest inside probabilities
-      * \cite manning-schutze-2003, pages 396-398. \f$\var{delta\_}(i,
+      * \cite manning-schutze-2003, pages 396-398. \f$\var{delta}(i,
       * p, q) = \delta_i(p, q), \quad 0 \leq i < n, \quad 0 \leq p
       * \leq q < m\f$.
       */
      Prob_table delta_{};
      /**
       * Table of backtrace information for %CYK algorithm
-      * \cite manning-schutze-2003, pages 397-398. \f$\var{psi\_}(i,
+      * \cite manning-schutze-2003, pages 397-398. \f$\var{psi}(i,
       * p, q) = \psi_i(p, q), \quad 0 \leq i < n, \quad 0 \leq p \leq
       * q < m\f$.
       */
@@ -248,15 +360,47 @@ private:
 
      void add_node(Index i, Index p, Index q, Parse_tree& t);
 
+     /**
+      * Index of the span \f$(p, q)\f$ in the charts. Spans are
+      * ordered by length \f$q - p\f$, then by \f$p\f$.
+      */
+     Index cell(Index p, Index q) const;
+     double& beta(Index j, Index p, Index q);
+     double& alpha(Index j, Index p, Index q);
+     double& delta(Index j, Index p, Index q);
+     Backtrace& psi(Index j, Index p, Index q);
+
+     /**
+      * Fills #by_left_ and #by_parent_. Must be called whenever #bp_
+      * changes.
+      */
+     void index_rules();
+
+     /**
+      * Probability \f$x\f$ as stored in the charts, ie. \f$\log
+      * x\f$ in the log-space mode.
+      */
+     double to_chart(double x) const;
+     /// The value of zero probability in the charts.
+     double chart_zero() const;
+     /// Logarithm of \f$\beta_0(0, m - 1)\f$.
+     double sentence_log_prob();
+
      /**
       * Calculates \f$\beta_j(p, q)\f$ according to formulas
-      * \cite manning-schutze-2003, pages 392, 393.
+      * \cite manning-schutze-2003, pages 392, 393. For each split
+      * of the span, only the nonterminals with nonzero inside
+      * probabilities in the left part and productions having them as
+      * left children are considered.
       */
      void fill_beta();
 
      /**
       * Calculates \f$\alpha_j(p, q)\f$ according to formulas
-      * \cite manning-schutze-2003, pages 394 - 396.
+      * \cite manning-schutze-2003, pages 394 - 396. The outside
+      * probability of each span with nonzero \f$\alpha_j(p, q)\f$
+      * is propagated to its children, from the longest spans to the
+      * shortest.
       *
       * \todo What about rules \f$N^j \rightarrow N^j N^j\f$? Should
       * they be counted twice? Check this on grammar having such a
@@ -266,14 +410,50 @@ private:
 
      /**
       * Calculates \f$\delta_i(p, q)\f$ according to formulas
-      * \cite manning-schutze-2003, page 397.
+      * \cite manning-schutze-2003, page 397. Among the best
+      * productions and splits, the first one in the order of \f$(j,
+      * k, r)\f$ is chosen, as in the exhaustive search.
       */
      void fill_delta();
 
+     /**
+      * Calculates \f$\delta_i(p, q)\f$ and \f$\psi_i(p, q)\f$ for
+      * one cell from the nonterminals listed in #nz_ for shorter
+      * spans. Adds the number of considered edges to \a edges.
+      */
+     void viterbi_cell(Index p, Index q, Index& edges);
+
+     /**
+      * Fills #delta_ and #psi_ with pruning for beam_cyk(). The
+      * nonterminals kept in each cell are listed in #nz_.
+      */
+     void fill_delta_beam(Index beam, double threshold,
+                          Beam_stats& stats);
+
      void init_tables(Vecsent const& vs);
      void fill_names();
      int one_iteration(Vecsent const& vs);
 
+     /**
+      * Adds to \a c the counts for the sentences \a vs[i], \a
+      * begin <= i < \a end. If \a counts is false, only the
+      * log-likelihood is calculated.
+      */
+     void expected_counts(Corpus const& vs, Index begin, Index end,
+                          bool counts, Counts& c);
+     /**
+      * Calculates the counts of the whole corpus, dividing it among
+      * \a workers, which receive the current productions.
+      */
+     Counts expected_counts(Corpus const& vs,
+                            std::vector<PCFG>& workers, bool counts);
+     /**
+      * Replaces the probabilities of productions with their
+      * estimates from \a c. Returns 2 if some nonterminal is not
+      * used.
+      */
+     int maximize(Counts const& c);
+
      friend bool operator==(Backtrace const& a, Backtrace const& b);
      friend bool operator!=(Backtrace const& a, Backtrace const& b);
      friend bool operator==(PCFG const& a, PCFG const& b);
@@ -13,7 +13,9 @@
 #include <map>
 #include <numeric>
 #include <stdexcept>
+#include <type_traits>
 #include <vector>
+#include <shg/utils.h>
 
 namespace SHG {
 
@@ -51,34 +53,220 @@ namespace SHG {
 template <class T>
 double permutation_entropy(std::vector<T> const& x, std::size_t L);
 
+/**
+ * The maximum window size for which ordinal patterns are counted in
+ * a flat array of \f$L!\f$ counters.
+ */
+constexpr std::size_t max_flat_pattern_length = 10;
+
+/**
+ * Counts ordinal patterns in a time series.
+ *
+ * Let \f$r = (r_0, \ldots, r_{L - 1})\f$ be the ranks of the
+ * elements of a window \f$(x_i)_{i = n}^{n + L - 1}\f$ in the order
+ * \f$\prec\f$ defined in permutation_entropy(), ie. \f$r\f$ is the
+ * inverse of the permutation \f$\pi\f$. The window is encoded by the
+ * Lehmer code of \f$r\f$, \f[k = \sum_{i = 0}^{L - 2} c_i (L - 1 -
+ * i)!, \quad c_i = |\{j \colon i < j < L, x_{n + j} < x_{n + i}
+ * \}|,\f] which is a number in \f$\{0, \ldots, L! - 1\}\f$. The
+ * function returns the vector of size \f$L!\f$, whose \f$k\f$-th
+ * element is the number of windows of code \f$k\f$.
+ *
+ * \param[in] x time series
+ * \param[in] n length of the time series
+ * \param[in] L size of sliding window
+ *
+ * \exception std::invalid_argument if \f$L < 2\f$ or \f$L > n\f$
+ * or \f$L >\f$ max_flat_pattern_length
+ *
+ * \implementation When the window slides by one element, \f$c_i\f$
+ * of the remaining elements increase by one if the new element is
+ * smaller, and \f$c_i = 0\f$ for the new element. So each window
+ * costs \f$O(L)\f$ comparisons instead of sorting.
+ */
+template <class T>
+std::vector<std::size_t> ordinal_pattern_counts(T const x[],
+                                                std::size_t n,
+                                                std::size_t L);
+
+/**
+ * Returns the ordinal pattern \f$\pi\f$ of length \a L encoded by
+ * \a code as in ordinal_pattern_counts().
+ *
+ * \exception std::invalid_argument if \f$L < 1\f$ or \f$L >\f$
+ * max_flat_pattern_length or code \f$\geq L!\f$
+ */
+inline std::vector<std::size_t> ordinal_pattern(std::size_t code,
+                                                std::size_t L);
+
+/**
+ * Calculates permutation entropy of many time series in parallel.
+ * The \f$i\f$-th element of the result is permutation_entropy(x[i],
+ * L). If \a nthreads is 0, the number of hardware threads is used.
+ */
+template <class T>
+std::vector<double> permutation_entropy(
+     std::vector<std::vector<T>> const& x, std::size_t L,
+     unsigned nthreads = 0);
+
+/**
+ * Calculates multiscale permutation entropy of a time series. For
+ * the scale \f$s\f$ the series is coarse-grained to the means of
+ * consecutive non-overlapping blocks of length \f$s\f$ and its
+ * permutation entropy is calculated. The \f$(s - 1)\f$-th element of
+ * the result is the entropy for the scale \f$s = 1, \ldots,
+ * \mathrm{max\_scale}\f$. The scales are processed in parallel in
+ * \a nthreads threads; if \a nthreads is 0, the number of hardware
+ * threads is used. Conf. \cite costa-goldberger-peng-2005.
+ *
+ * \exception std::invalid_argument if \f$L < 2\f$ or max_scale <
+ * 1 or the series coarse-grained with max_scale is shorter than
+ * \f$L\f$
+ */
+template <class T>
+std::vector<double> multiscale_permutation_entropy(
+     std::vector<T> const& x, std::size_t L, std::size_t max_scale,
+     unsigned nthreads = 0);
+
 template <class T>
 double permutation_entropy(std::vector<T> const& x,
                            std::size_t const L) {
      if (L < 2 || L > x.size())
           throw std::invalid_argument(__func__);
-     typedef std::vector<std::size_t> Permutation;
      std::size_t const nl1 = x.size() - L + 1;
-     std::map<Permutation, std::size_t> c;
-     Permutation p(L), p0(L);
-     std::iota(p0.begin(), p0.end(), 0);
-     for (std::size_t n = 0; n < nl1; n++) {
-          p = p0;
-          std::stable_sort(p.begin(), p.end(),
-                           [n, &x](std::size_t i, std::size_t j) {
-                                return x[n + i] < x[n + j];
-                           });
-          c[p]++;
-     }
      double const NL1 = nl1;
      double s = 0.0;
-     for (auto const& x : c) {
-          double const p = x.second / NL1;
-          s -= p * std::log(p);
+     if (L <= max_flat_pattern_length) {
+          for (auto const k :
+               ordinal_pattern_counts(x.data(), x.size(), L))
+               if (k > 0) {
+                    double const p = k / NL1;
+                    s -= p * std::log(p);
+               }
+     } else {
+          typedef std::vector<std::size_t> Permutation;
+          std::map<Permutation, std::size_t> c;
+          Permutation p(L), p0(L);
+          std::iota(p0.begin(), p0.end(), 0);
+          for (std::size_t n = 0; n < nl1; n++) {
+               p = p0;
+               std::stable_sort(
+                    p.begin(), p.end(),
+                    [n, &x](std::size_t i, std::size_t j) {
+                         return x[n + i] < x[n + j];
+                    });
+               c[p]++;
+          }
+          for (auto const& x : c) {
+               double const p = x.second / NL1;
+               s -= p * std::log(p);
+          }
      }
      return 1.4426950408889634073599246810018921374266  // 1 / ln 2
             * s;
 }
 
+template <class T>
+std::vector<std::size_t> ordinal_pattern_counts(T const x[],
+                                                std::size_t n,
+                                                std::size_t L) {
+     if (L < 2 || L > n || L > max_flat_pattern_length)
+          throw std::invalid_argument(__func__);
+     std::vector<std::size_t> fact(L + 1);
+     fact[0] = 1;
+     for (std::size_t i = 1; i <= L; i++)
+          fact[i] = i * fact[i - 1];
+     std::vector<std::size_t> counts(fact[L], 0);
+     // c[i % L] is the number of later elements in the window smaller
+     // than x[i].
+     std::vector<std::size_t> c(L, 0);
+     for (std::size_t i = 0; i < L; i++)
+          for (std::size_t j = i + 1; j < L; j++)
+               if (x[j] < x[i])
+                    c[i]++;
+     for (std::size_t m = 0;; m++) {
+          std::size_t code = 0;
+          for (std::size_t k = 0, i = m % L; k < L - 1; k++) {
+               code += c[i] * fact[L - 1 - k];
+               if (++i == L)
+                    i = 0;
+          }
+          counts[code]++;
+          std::size_t const last = m + L;
+          if (last == n)
+               break;
+          T const& y = x[last];
+          for (std::size_t i = m + 1; i < last; i++)
+               if (y < x[i])
+                    c[i % L]++;
+          c[last % L] = 0;
+     }
+     return counts;
+}
+
+inline std::vector<std::size_t> ordinal_pattern(std::size_t code,
+                                                std::size_t L) {
+     if (L < 1 || L > max_flat_pattern_length)
+          throw std::invalid_argument(__func__);
+     std::vector<std::size_t> r(L), free(L), p(L);
+     std::size_t f = 1;
+     for (std::size_t i = 2; i < L; i++)
+          f *= i;
+     if (code >= f * L)
+          throw std::invalid_argument(__func__);
+     std::iota(free.begin(), free.end(), 0);
+     // Decode the ranks, then invert them.
+     for (std::size_t i = 0; i < L; i++) {
+          std::size_t const d = code / f;
+          code %= f;
+          r[i] = free[d];
+          free.erase(free.begin() + d);
+          if (i + 2 < L)
+               f /= L - 1 - i;
+     }
+     for (std::size_t i = 0; i < L; i++)
+          p[r[i]] = i;
+     return p;
+}
+
+template <class T>
+std::vector<double> permutation_entropy(
+     std::vector<std::vector<T>> const& x, std::size_t L,
+     unsigned nthreads) {
+     std::vector<double> h(x.size());
+     parallel_for(
+          x.size(),
+          [&](std::size_t i) { h[i] = permutation_entropy(x[i], L); },
+          nthreads);
+     return h;
+}
+
+template <class T>
+std::vector<double> multiscale_permutation_entropy(
+     std::vector<T> const& x, std::size_t L, std::size_t max_scale,
+     unsigned nthreads) {
+     static_assert(std::is_arithmetic<T>::value,
+                   "T must be an arithmetic type.");
+     if (L < 2 || max_scale < 1 || x.size() / max_scale < L)
+          throw std::invalid_argument(__func__);
+     std::vector<double> h(max_scale);
+     parallel_for(
+          max_scale,
+          [&](std::size_t i) {
+               std::size_t const s = i + 1;
+               std::vector<double> y(x.size() / s);
+               for (std::size_t j = 0, k = 0; j < y.size(); j++) {
+                    double sum = 0.0;
+                    for (std::size_t l = 0; l < s; l++)
+                         sum += x[k++];
+                    y[j] = sum / s;
+               }
+               h[i] = permutation_entropy(y, L);
+          },
+          nthreads);
+     return h;
+}
+
 /** \} */ /* end of group mathematical_statistics */
 
 }  // namespace SHG
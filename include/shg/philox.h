@@ -0,0 +1,126 @@
+/**
+ * \file include/shg/philox.h
+ * Philox counter-based random number generator.
+ */
+
+#ifndef SHG_PHILOX_H
+#define SHG_PHILOX_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
+#include <shg/rng.h>
+
+namespace SHG {
+
+/**
+ * Philox4x32-10 counter-based random number generator
+ * \cite salmon-moraes-dror-shaw-2011.
+ *
+ * The generator has no state other than a key and a counter. The
+ * n-th block of random bits is the value of a bijection of the
+ * 128-bit counter \f$n\f$ parametrized by the 64-bit key, which is
+ * computed independently of the other blocks. The key is the seed.
+ * The lower half of the counter is the position in a stream and the
+ * upper half is the stream identifier, so that there are \f$2^{64}\f$
+ * streams for each seed. Each block gives two 64-bit numbers and the
+ * position is a 64-bit count of numbers, so a stream has
+ * \f$2^{63}\f$ blocks. Since distinct counters are mapped to distinct
+ * blocks, streams with different identifiers never overlap, and each
+ * thread of a parallel computation may take its own stream, for
+ * example the stream with the number of its task. Skipping ahead
+ * costs \f$O(1)\f$.
+ *
+ * The bulk functions uniform(), normal() and exponential() fill
+ * arrays without a virtual call per number. They give the same
+ * numbers whatever the size of the arrays, but normal() and
+ * exponential() do not give the same numbers as the single-number
+ * functions of the base class.
+ *
+ * \ingroup random_number_generator
+ */
+class Philox : public RNG {
+public:
+     /** Counter of four 32-bit words, the first is the lowest. */
+     using Counter = std::array<std::uint32_t, 4>;
+     /** Key of two 32-bit words, the first is the lowest. */
+     using Key = std::array<std::uint32_t, 2>;
+
+     /**
+      * The bijection Philox4x32-10 of the counter \c c with the key
+      * \c k.
+      */
+     static Counter bijection(Counter c, Key k);
+
+     /**
+      * Constructs a generator at the beginning of the stream \c
+      * stream of the seed \c seed.
+      */
+     explicit Philox(std::uint64_t seed = 0,
+                     std::uint64_t stream = 0);
+     /**
+      * Returns the next random number uniformly distributed on [0,
+      * 1). The number is a multiple of \f$2^{-53}\f$.
+      */
+     double operator()() override;
+     /**
+      * Returns the next random 64-bit number.
+      */
+     std::uint64_t bits();
+     /**
+      * Returns a generator at the beginning of the stream \c stream
+      * with the same seed.
+      */
+     Philox substream(std::uint64_t stream) const;
+     /**
+      * Skips \c n 64-bit numbers.
+      */
+     void discard(std::uint64_t n);
+
+     std::uint64_t seed() const;
+     std::uint64_t stream() const;
+     /** Returns the number of 64-bit numbers generated so far. */
+     std::uint64_t position() const { return pos_; }
+
+     /**
+      * Fills \c x[0], ..., \c x[n - 1] with the numbers which n
+      * calls of operator() would return, uniformly distributed on
+      * [0, 1), one 64-bit number each.
+      */
+     void uniform(double* x, std::size_t n) override;
+     /**
+      * Fills \c x[0], ..., \c x[n - 1] with numbers normally
+      * distributed with mean 0 and variance 1 by the ziggurat
+      * method, about one 64-bit number each.
+      */
+     void normal(double* x, std::size_t n) override;
+     /**
+      * Fills \c x[0], ..., \c x[n - 1] with numbers exponentially
+      * distributed with mean 1 by the ziggurat method, about one
+      * 64-bit number each.
+      */
+     void exponential(double* x, std::size_t n) override;
+
+     using RNG::exponential;
+     using RNG::normal;
+
+     void write(std::ostream& f) const override;
+     void read(std::istream& f) override;
+
+private:
+     /** Returns the block with the lower counter half equal to i. */
+     Counter block(std::uint64_t i) const;
+     /** Calls f(u) for the next n 64-bit numbers u. */
+     template <typename F>
+     void generate(std::size_t n, F f);
+
+     Key key_;
+     std::uint64_t stream_;
+     std::uint64_t pos_{0};
+     Counter buf_{};  ///< block pos_ / 2 if pos_ is odd
+};
+
+}  // namespace SHG
+
+#endif
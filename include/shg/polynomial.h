@@ -64,6 +64,10 @@ public:
      static bool is_valid(Polynomial const& x, Polynomial const& y);
      static bool is_valid(Polynomial const& x, Term const& y);
 
+     friend Polynomial multiply(Polynomial const& x,
+                                Polynomial const& y,
+                                unsigned nthreads);
+
 private:
      /**
       * Returns iterator to the element with maximum monomial
@@ -109,6 +113,22 @@ std::istream& operator>>(std::istream& stream, Polynomial& x);
  */
 Polynomial one_var(std::vector<Element> const& a);
 
+/**
+ * Returns \f$xy\f$ with the order of \f$x\f$.
+ *
+ * The terms of the product are generated in decreasing lex order
+ * with a heap of the products of terms of \f$x\f$ and \f$y\f$
+ * (\cite johnson-1974, \cite monagan-pearce-2007), so that equal
+ * monomials are added before they are stored. If the product has
+ * many pairs of terms, \f$x\f$ is split into chunks which are
+ * multiplied by \f$y\f$ in \c nthreads threads, if \c nthreads
+ * is 0 in number_of_threads() threads, and the partial products are
+ * merged. Exponents greater than 127 are multiplied pairwise.
+ * Polynomial::operator*=() calls multiply(x, y, 1).
+ */
+Polynomial multiply(Polynomial const& x, Polynomial const& y,
+                    unsigned nthreads = 1);
+
 /**
  * %Polynomial ring over an algebraic structure.
  */
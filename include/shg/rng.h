@@ -7,7 +7,9 @@
 #ifndef SHG_RNG_H
 #define SHG_RNG_H
 
+#include <cstddef>
 #include <iostream>
+#include <vector>
 #include <shg/vector.h>
 
 namespace SHG {
@@ -66,6 +68,30 @@ public:
       */
      double exponential();
 
+     /**
+      * Random number exponentially distributed with mean 1 by the
+      * ziggurat method. Two uniform numbers are taken in about 99%
+      * of calls.
+      *
+      * \implementation See Ziggurat.
+      */
+     double ziggurat_exponential();
+
+     /**
+      * Fills x[0], ..., x[n - 1] with the numbers which n calls of
+      * operator() would return, so they are uniformly distributed on
+      * the same interval. The default implementation calls
+      * operator() n times.
+      */
+     virtual void uniform(double* x, std::size_t n);
+
+     /**
+      * Fills x[0], ..., x[n - 1] with random numbers exponentially
+      * distributed with mean 1. The default implementation calls
+      * ziggurat_exponential() n times.
+      */
+     virtual void exponential(double* x, std::size_t n);
+
      /**
       * Random point uniformly distributed on the surface of a
       * simplex. The simplex is defined as \f[ \{(x_1, \ldots, x_n)
@@ -101,6 +127,22 @@ public:
       */
      double normal();
 
+     /**
+      * Random number normally distributed with mean 0 and variance 1
+      * by the ziggurat method. Two uniform numbers are taken in about
+      * 99% of calls.
+      *
+      * \implementation See Ziggurat.
+      */
+     double ziggurat_normal();
+
+     /**
+      * Fills x[0], ..., x[n - 1] with random numbers normally
+      * distributed with mean 0 and variance 1. The default
+      * implementation calls ziggurat_normal() n times.
+      */
+     virtual void normal(double* x, std::size_t n);
+
      /**
       * Random sample of n from N numbers 0, 1,..., N - 1, 0 < n <= N.
       * Each subset of n elements is equally probable. Sample is
@@ -189,9 +231,9 @@ public:
       *
       * \exception SHG::Invalid_argument unless p >= 0.0 and p <= 1.0
       *
-      * \implementation See \cite knuth-2002b, p. 143. See also <a
-      * href = "http://www.gnu.org/software/gsl/">GNU Scientific
-      * Library</a>, version 1.15, file gsl-1.15/randist/binomial.c.
+      * \implementation If \f$n \min(p, 1 - p) < 10\f$, the
+      * inversion algorithm BINV, otherwise the algorithm BTPE
+      * \cite kachitvichyanukul-schmeiser-1988.
       */
      unsigned int binomial(double p, unsigned int n);
 
@@ -202,10 +244,13 @@ public:
       * the mean.
       *
       * \exception SHG::Invalid_argument unless mu > 0.0
+      * \exception std::overflow_error if the number generated is
+      * greater than the maximum unsigned int, which may happen for
+      * \f$\mu\f$ near this maximum or greater
       *
-      * \implementation See \cite knuth-2002b, p. 145-146. See also <a
-      * href = "http://www.gnu.org/software/gsl/">GNU Scientific
-      * Library</a>, version 1.15, file gsl-1.15/randist/poisson.c.
+      * \implementation If \f$\mu < 10\f$, the multiplication
+      * method \cite knuth-2002b, p. 137, otherwise the transformed
+      * rejection method PTRS \cite hormann-1993.
       */
      unsigned int poisson(double mu);
 
@@ -257,11 +302,44 @@ public:
      virtual ~RNG();
 
 private:
+     unsigned int binomial_btpe(double r, unsigned int n);
+     unsigned int poisson_ptrs(double mu);
      double gamma_int(unsigned int a);
      double gamma_large(double a);
      double gamma_frac(double a);
 };
 
+/**
+ * Alias table for sampling from a fixed discrete distribution in
+ * constant time \cite walker-1977, \cite vose-1991. Each of \f$n\f$
+ * cells holds a value \f$i\f$ with probability \f$q_i\f$ and its
+ * alias with probability \f$1 - q_i\f$. A cell and the choice
+ * between the value and the alias are both taken from one uniform
+ * number.
+ */
+class Alias_table {
+public:
+     /**
+      * Constructs the table for the distribution \f$\Pr(X = k) =
+      * w_k / \sum_i w_i\f$, \f$0 \leq k < n\f$, where \f$n\f$ =
+      * w.size(). The weights need not sum to 1.
+      *
+      * \exception SHG::Invalid_argument unless w.size() > 0, all
+      * weights are non-negative and finite and their sum is positive
+      */
+     explicit Alias_table(Vecdouble const& w);
+     /**
+      * Random number from the distribution.
+      */
+     int operator()(RNG& g) const;
+     /** Returns the number of values. */
+     std::size_t size() const { return q_.size(); }
+
+private:
+     std::vector<double> q_{};
+     std::vector<int> alias_{};
+};
+
 /** \} */ /* end of group random_number_generator */
 
 }  // namespace SHG
@@ -51,13 +51,16 @@
 #include <shg/ols.h>
 #include <shg/opdts.h>
 #include <shg/packellp.h>
+#include <shg/packpoly.h>
 #include <shg/pcfg.h>
 #include <shg/permentr.h>
+#include <shg/philox.h>
 #include <shg/polynomial.h>
 #include <shg/polynomial_ring.h>
 #include <shg/rng.h>
 #include <shg/runs.h>
 #include <shg/safeint.h>
+#include <shg/sieve.h>
 #include <shg/smc.h>
 #include <shg/specfunc.h>
 #include <shg/subdomain.h>
@@ -67,5 +70,6 @@
 #include <shg/utils.h>
 #include <shg/vector.h>
 #include <shg/version.h>
+#include <shg/ziggurat.h>
 
 #endif
@@ -0,0 +1,238 @@
+/**
+ * \file include/shg/sieve.h
+ * Segmented sieve of Eratosthenes.
+ */
+
+#ifndef SHG_SIEVE_H
+#define SHG_SIEVE_H
+
+#include <bit>
+#include <cstdint>
+#include <vector>
+#include <shg/utils.h>
+
+namespace SHG {
+
+/**
+ * \defgroup prime_sieve Prime sieve
+ *
+ * Segmented sieve of Eratosthenes with the wheel modulo 30.
+ *
+ * Numbers not divisible by 2, 3 and 5 are \f$30k + w\f$, where \f$w
+ * \in \{1, 7, 11, 13, 17, 19, 23, 29\}\f$, so that one byte holds the
+ * eight candidates of an interval \f$[30k, 30k + 30)\f$. For each
+ * prime \f$p \geq 7\f$ and each \f$w\f$, the multiples \f$p(30j +
+ * w)\f$ fall on the same bit of bytes \f$p\f$ apart, so sieving is
+ * done by eight strided loops per prime. The numbers are sieved in
+ * segments which fit in the cache, and the position of the next
+ * multiple of each prime is carried from segment to segment.
+ *
+ * \{
+ */
+
+/**
+ * Primes in \f$[lo, hi)\f$ stored as a bit array on the wheel modulo
+ * 30.
+ */
+class Prime_bits {
+public:
+     Prime_bits() = default;
+     /**
+      * Sieves \f$[lo, hi)\f$ in \c nthreads threads, if \c nthreads
+      * is 0 in number_of_threads() threads. Requires \f$lo \leq hi
+      * \leq\f$ Segmented_sieve::max_hi.
+      *
+      * \throws std::invalid_argument if the interval is invalid
+      */
+     Prime_bits(std::uint64_t lo, std::uint64_t hi,
+                unsigned nthreads = 1);
+     std::uint64_t lo() const { return lo_; }
+     std::uint64_t hi() const { return hi_; }
+     /**
+      * Returns true if and only if \c n is prime.
+      *
+      * \throws std::invalid_argument unless \f$lo \leq n < hi\f$
+      */
+     bool is_prime(std::uint64_t n) const;
+     /**
+      * Returns the number of primes in \f$[lo, hi)\f$.
+      */
+     std::uint64_t count() const;
+     /**
+      * Returns the primes in \f$[lo, hi)\f$ in increasing order.
+      */
+     std::vector<std::uint64_t> primes() const;
+     /**
+      * Calls \c f(p) for the primes \f$p \in [lo, hi)\f$ in
+      * increasing order.
+      */
+     template <typename F>
+     void for_each(F f) const;
+     /**
+      * Returns the bit array. Bit \f$i\f$ of byte \f$k\f$ stands for
+      * the number \f$30(\lfloor lo / 30 \rfloor + k) + w_i\f$, where
+      * \f$w\f$ = wheel. Bits of numbers outside \f$[lo, hi)\f$ are
+      * 0. The primes 2, 3 and 5 are not represented.
+      */
+     std::vector<std::uint8_t> const& bytes() const { return b_; }
+
+     /** Residues modulo 30 of the numbers represented by the bits. */
+     static constexpr std::uint8_t wheel[8]{1,  7,  11, 13,
+                                            17, 19, 23, 29};
+
+private:
+     friend class Segmented_sieve;
+     friend class Prime_generator;
+
+     std::uint64_t lo_{0};
+     std::uint64_t hi_{0};
+     std::uint64_t base_{0};  ///< lo_ rounded down to multiple of 30
+     std::vector<std::uint8_t> b_{};
+};
+
+template <typename F>
+void Prime_bits::for_each(F f) const {
+     for (std::uint64_t const p : {2, 3, 5})
+          if (lo_ <= p && p < hi_)
+               f(p);
+     for (std::size_t k = 0; k < b_.size(); k++) {
+          std::uint64_t const n = base_ + 30 * k;
+          for (unsigned x = b_[k]; x != 0; x &= x - 1)
+               f(n + wheel[std::countr_zero(x)]);
+     }
+}
+
+/**
+ * Sieves \f$[lo, hi)\f$ segment by segment. Memory used is a segment
+ * and the sieving primes up to \f$\sqrt{hi}\f$ with their positions.
+ */
+class Segmented_sieve {
+public:
+     /**
+      * Returns the size in bytes of a segment starting at \c x. It
+      * grows with \f$\sqrt{x}\f$ from \f$2^{16}\f$ to \f$2^{20}\f$,
+      * so that the cost of visiting all sieving primes in each
+      * segment stays small compared with crossing off.
+      */
+     static std::size_t segment_bytes(std::uint64_t x);
+     /**
+      * Upper bound of sieved intervals. The sieving primes up to
+      * \f$\sqrt{hi}\f$ take 37 bytes each.
+      */
+     static constexpr std::uint64_t max_hi = std::uint64_t{1} << 48;
+
+     /**
+      * Prepares sieving of \f$[lo, hi)\f$.
+      *
+      * \throws std::invalid_argument unless \f$lo \leq hi \leq\f$
+      * max_hi
+      */
+     Segmented_sieve(std::uint64_t lo, std::uint64_t hi);
+     /**
+      * Sieves the next segment into \c s and returns true. Returns
+      * false if there are no more segments. Consecutive segments
+      * cover \f$[lo, hi)\f$.
+      */
+     bool next(Prime_bits& s);
+
+private:
+     void extend(std::uint64_t limit);
+
+     std::uint64_t lo_;
+     std::uint64_t hi_;
+     std::uint64_t base_;
+     std::uint64_t nbytes_{0};
+     std::uint64_t pos_{0};    ///< first byte of the next segment
+     std::uint64_t limit_{6};  ///< all primes up to limit_ are in p_
+     std::vector<std::uint32_t> p_{};  ///< sieving primes from 7
+     std::vector<std::uint8_t> pi_{};  ///< index of p_[i] % 30
+     /**
+      * Offsets of the next multiples of the first active_ primes from
+      * the beginning of the next segment, 8 for each prime.
+      */
+     std::vector<std::uint32_t> off_{};
+     std::size_t active_{0};
+};
+
+/**
+ * Generates consecutive primes.
+ */
+class Prime_generator {
+public:
+     /**
+      * Prepares generation of primes not less than \c start.
+      *
+      * \throws std::invalid_argument if \c start is not less than
+      * Segmented_sieve::max_hi
+      */
+     explicit Prime_generator(std::uint64_t start = 0);
+     /**
+      * Returns the next prime.
+      *
+      * \throws std::overflow_error if the prime is not less than
+      * Segmented_sieve::max_hi
+      */
+     std::uint64_t operator()();
+
+private:
+     Segmented_sieve s_;
+     Prime_bits b_{};
+     std::size_t k_{0};
+     unsigned x_{0};
+     int small_{0};
+};
+
+/** Number of segments in a chunk of for_each_prime_segment(). */
+constexpr std::uint64_t chunk_segments = 32;
+
+/**
+ * Sieves \f$[lo, hi)\f$ in \c nthreads threads, if \c nthreads is 0
+ * in number_of_threads() threads, and calls \c f(s) for each segment
+ * \c s. The interval is split into chunks of chunk_segments segments
+ * sieved by separate Segmented_sieve objects. Calls for different
+ * chunks are concurrent and their order is not defined, so \c f must
+ * be safe to call concurrently.
+ *
+ * \throws std::invalid_argument unless \f$lo \leq hi \leq\f$
+ * Segmented_sieve::max_hi
+ */
+template <typename F>
+void for_each_prime_segment(std::uint64_t lo, std::uint64_t hi, F f,
+                            unsigned nthreads = 0) {
+     // Validates the interval.
+     static_cast<void>(Segmented_sieve(lo, hi));
+     if (lo == hi)
+          return;
+     std::uint64_t const c =
+          30 * chunk_segments * Segmented_sieve::segment_bytes(hi);
+     std::uint64_t const first = lo / c;
+     std::uint64_t const n = (hi - 1) / c - first + 1;
+     parallel_for(
+          n,
+          [&](std::size_t k) {
+               std::uint64_t const a = std::max(lo, (first + k) * c);
+               std::uint64_t const b = std::min(hi, a / c * c + c);
+               Segmented_sieve sieve(a, b);
+               Prime_bits s;
+               while (sieve.next(s))
+                    f(static_cast<Prime_bits const&>(s));
+          },
+          nthreads);
+}
+
+/**
+ * Returns the number of primes in \f$[lo, hi)\f$ computed in \c
+ * nthreads threads, if \c nthreads is 0 in number_of_threads()
+ * threads.
+ *
+ * \throws std::invalid_argument unless \f$lo \leq hi \leq\f$
+ * Segmented_sieve::max_hi
+ */
+std::uint64_t count_primes(std::uint64_t lo, std::uint64_t hi,
+                           unsigned nthreads = 0);
+
+/** \} */ /* end of group prime_sieve */
+
+}  // namespace SHG
+
+#endif
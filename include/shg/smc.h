@@ -7,7 +7,10 @@
 #ifndef SHG_SMC_H
 #define SHG_SMC_H
 
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
+#include <vector>
 #include <shg/except.h>
 #include <shg/matrix.h>
 #include <shg/rng.h>
@@ -69,7 +72,7 @@ struct SMC {
 
      private:
           Vecint const x;
-          Vecdouble const p;
+          Alias_table const a;
      };
      /**
       * geometric, 0 < p <= 1
@@ -141,6 +144,59 @@ struct SMC {
       */
      int generate(int T, bool cut = false);
 
+     /**
+      * Statistics of replications of SMC paths, accumulated by
+      * replicate().
+      */
+     struct Summary {
+          /** Adds the statistics of s to this object. */
+          void merge(Summary const& s);
+
+          std::uint64_t paths{0};  ///< number of paths
+          /**
+           * runs[j][l] is the number of sojourns of length l in the
+           * state j, that is, the number of runs of length l of the
+           * element j in Z as counted by run_length_distribution().
+           * The last sojourn in a path is counted after cutting if
+           * cut == true.
+           */
+          std::vector<std::vector<std::uint64_t>> runs{};
+          /** occupation[j] is the number of moments spent in j. */
+          std::vector<std::uint64_t> occupation{};
+          /** longest[l] is the number of paths whose longest run is
+              l. */
+          std::vector<std::uint64_t> longest{};
+     };
+
+     /**
+      * Generates n independent SMC paths as generate(T, cut) does
+      * and returns their statistics in summary. The paths are not
+      * stored.
+      *
+      * The paths are divided into chunks of replication_chunk paths,
+      * which are run by parallel_for() with nthreads threads. The
+      * chunk i uses Philox(seed).substream(i) and accumulates its
+      * statistics in a buffer of its own, which is then added to
+      * summary. The result depends only on n, T, cut and seed and
+      * not on the number of threads. The transitions are drawn from
+      * alias tables built once for alpha_ and the rows of P_, so the
+      * paths differ from those generated by generate() with g_.
+      *
+      * The threads call std_->generate() concurrently, so it must
+      * be thread-safe for different generators, as it is for the
+      * distributions defined here.
+      *
+      * Returns the same values as generate(), except that g_ is not
+      * used and need not be assigned. On error, summary is not
+      * changed.
+      */
+     int replicate(std::size_t n, int T, bool cut,
+                   std::uint64_t seed, Summary& summary,
+                   unsigned nthreads = 0);
+
+     /** The number of paths in one chunk of replicate(). */
+     static constexpr std::size_t replication_chunk = 4096;
+
      std::size_t const s_;  ///< number of states: 0, ..., s_ - 1
      Vecdouble alpha_;      ///< initial state distribution
      Matdouble P_;          ///< transition matrix (P(i, i) = 0)
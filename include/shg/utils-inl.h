@@ -327,6 +327,45 @@ T from_string(std::string const& s) {
      return x;
 }
 
+template <typename F>
+void parallel_for(std::size_t n, F f, unsigned nthreads) {
+     std::size_t const nt =
+          std::min<std::size_t>(number_of_threads(nthreads), n);
+     if (nt <= 1) {
+          for (std::size_t i = 0; i < n; i++)
+               f(i);
+          return;
+     }
+     std::atomic<std::size_t> next{0};
+     std::exception_ptr ep;
+     std::mutex mtx;
+     auto const work = [&]() {
+          for (;;) {
+               std::size_t const i = next++;
+               if (i >= n)
+                    return;
+               try {
+                    f(i);
+               } catch (...) {
+                    std::lock_guard<std::mutex> lock(mtx);
+                    if (!ep)
+                         ep = std::current_exception();
+                    next = n;
+                    return;
+               }
+          }
+     };
+     std::vector<std::thread> threads;
+     threads.reserve(nt - 1);
+     for (std::size_t t = 1; t < nt; t++)
+          threads.emplace_back(work);
+     work();
+     for (auto& t : threads)
+          t.join();
+     if (ep)
+          std::rethrow_exception(ep);
+}
+
 }  // namespace SHG
 
 #endif
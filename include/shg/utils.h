@@ -12,12 +12,16 @@
 #include <cstdlib>
 #include <ctime>
 #include <algorithm>
+#include <atomic>
 #include <chrono>
+#include <exception>
 #include <iostream>
 #include <limits>
+#include <mutex>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <thread>
 #include <type_traits>
 #include <vector>
 #include <boost/multiprecision/cpp_int.hpp>
@@ -505,6 +509,23 @@ T from_string(std::string const& s);
 
 bool dehtml(std::istream& f, std::ostream& g);
 
+/**
+ * Returns the number of threads to use. If \a nthreads is 0, it is
+ * the number of hardware threads, at least 1.
+ */
+unsigned number_of_threads(unsigned nthreads = 0);
+
+/**
+ * Calls \c f(i) for \c i = 0, ..., \a n - 1 in \a nthreads threads.
+ * If \a nthreads is 0, number_of_threads() threads are used. The
+ * calls are distributed dynamically, so their order is not defined
+ * and \c f must be safe to call concurrently for different \c i. If
+ * any call throws, the remaining indices are not processed and the
+ * first exception is rethrown in the calling thread.
+ */
+template <typename F>
+void parallel_for(std::size_t n, F f, unsigned nthreads = 0);
+
 /** \} */ /* end of group miscellaneous_utilities */
 
 }  // namespace SHG
@@ -0,0 +1,125 @@
+/**
+ * \file include/shg/ziggurat.h
+ * Ziggurat method for normal and exponential distributions.
+ */
+
+#ifndef SHG_ZIGGURAT_H
+#define SHG_ZIGGURAT_H
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace SHG {
+
+/**
+ * Tables of the ziggurat method \cite marsaglia-tsang-2000 in the
+ * version of \cite doornik-2005.
+ *
+ * The area under a decreasing density \f$f\f$ on \f$[0, \infty)\f$
+ * is covered by \f$c\f$ layers of equal area \f$v\f$: the base layer
+ * consisting of the rectangle \f$[0, r] \times [0, f(r)]\f$ and the
+ * tail \f$x > r\f$, and \f$c - 1\f$ rectangles \f$[0, x_i] \times
+ * [f(x_i), f(x_{i + 1})]\f$, where \f$x_1 = r\f$ and \f$x_c = 0\f$.
+ * For the base layer, \f$x_0 = v / f(r)\f$. A layer \f$i\f$ and \f$u
+ * \in [0, 1)\f$ are drawn. If \f$u x_i < x_{i + 1}\f$, which happens
+ * with probability about 0.99, \f$u x_i\f$ is returned. Otherwise
+ * the tail or the part of the rectangle outside the layer below is
+ * sampled by rejection.
+ *
+ * The random functions take a 64-bit random word. The layer is given
+ * by its lowest bits and \f$u\f$ by its highest 53 bits.
+ *
+ * \ingroup random_number_generator
+ */
+struct Ziggurat {
+     /**
+      * Computes the tables for \f$c\f$ layers of the density \f$f\f$
+      * with the inverse \f$f^{-1}\f$.
+      */
+     Ziggurat(int c, double r, double v, double (*f)(double),
+              double (*finv)(double));
+     /**
+      * Tables for \f$f(x) = \exp(-x^2 / 2)\f$ with 128 layers.
+      */
+     static Ziggurat const& normal();
+     /**
+      * Tables for \f$f(x) = \exp(-x)\f$ with 256 layers.
+      */
+     static Ziggurat const& exponential();
+
+     /** Returns the highest 53 bits of w as a number in [0, 1). */
+     static double unit(std::uint64_t w) {
+          return static_cast<double>(w >> 11) * 0x1p-53;
+     }
+     /** Returns the highest 53 bits of w as a number in (0, 1). */
+     static double open_unit(std::uint64_t w) {
+          return (static_cast<double>(w >> 11) + 0.5) * 0x1p-53;
+     }
+
+     std::uint64_t const mask;  ///< c - 1
+     double const r;
+     std::vector<double> x{};  ///< \f$x_0, \ldots, x_c\f$
+     std::vector<double> q{};  ///< \f$x_{i + 1} / x_i\f$
+};
+
+/**
+ * Returns a number normally distributed with mean 0 and variance 1.
+ * The function \c w() should return independent 64-bit random words,
+ * of which one is taken in about 99% of calls.
+ */
+template <typename W>
+double ziggurat_normal(W& w) {
+     static Ziggurat const& z = Ziggurat::normal();
+     for (;;) {
+          std::uint64_t const b = w();
+          std::size_t const i = b & z.mask;
+          double const u = 2.0 * Ziggurat::unit(b) - 1.0;
+          if (std::abs(u) < z.q[i])
+               return u * z.x[i];
+          if (i == 0) {
+               double x, y;
+               do {
+                    x = std::log(Ziggurat::open_unit(w())) / z.r;
+                    y = std::log(Ziggurat::open_unit(w()));
+               } while (-2.0 * y < x * x);
+               return u < 0.0 ? x - z.r : z.r - x;
+          }
+          double const x = u * z.x[i];
+          double const f0 =
+               std::exp(-0.5 * (z.x[i] * z.x[i] - x * x));
+          double const f1 =
+               std::exp(-0.5 * (z.x[i + 1] * z.x[i + 1] - x * x));
+          if (f1 + Ziggurat::unit(w()) * (f0 - f1) < 1.0)
+               return x;
+     }
+}
+
+/**
+ * Returns a number exponentially distributed with mean 1. The
+ * function \c w() should return independent 64-bit random words, of
+ * which one is taken in about 99% of calls.
+ */
+template <typename W>
+double ziggurat_exponential(W& w) {
+     static Ziggurat const& z = Ziggurat::exponential();
+     for (;;) {
+          std::uint64_t const b = w();
+          std::size_t const i = b & z.mask;
+          double const u = Ziggurat::unit(b);
+          if (u < z.q[i])
+               return u * z.x[i];
+          if (i == 0)
+               return z.r - std::log(Ziggurat::open_unit(w()));
+          double const x = u * z.x[i];
+          double const f0 = std::exp(x - z.x[i]);
+          double const f1 = std::exp(x - z.x[i + 1]);
+          if (f1 + Ziggurat::unit(w()) * (f0 - f1) < 1.0)
+               return x;
+     }
+}
+
+}  // namespace SHG
+
+#endif
@@ -6,11 +6,456 @@
 #include <shg/alggeom.h>
 #include <cctype>
 #include <algorithm>
+#include <map>
+#include <set>
 #include <shg/except.h>
+#include <shg/packpoly.h>
 #include <shg/utils.h>
 
 namespace SHG::ALGEBRA::ALGGEOM {
 
+namespace {
+
+/**
+ * Divides with packed polynomials. Returns false if the order of f
+ * is not one of the orders of Packed_layout or an exponent is too
+ * large to be packed.
+ */
+bool divide_packed(Polynomial const& f,
+                   std::vector<Polynomial> const& g,
+                   std::vector<Polynomial>& a, Polynomial& r) {
+     using P = Packed_polynomial<Element_coefficients>;
+     Packed_order order;
+     if (!packed_order(f.order(), order))
+          return false;
+     Packed_layout const layout(f.dim(), order);
+     Element_coefficients const field(f.as());
+     P pr(layout, field);
+     std::vector<P> pg, pa;
+     try {
+          pg.reserve(g.size());
+          for (auto const& gi : g)
+               pg.push_back(to_packed(gi, layout, field));
+          divide(to_packed(f, layout, field), pg, pa, pr);
+     } catch (std::overflow_error const&) {
+          return false;
+     }
+     for (std::vector<P>::size_type i = 0; i < pa.size(); i++)
+          a[i] = to_polynomial(pa[i], f.as());
+     r = to_polynomial(pr, f.as());
+     return true;
+}
+
+/**
+ * Groebner basis of packed polynomials, see Buchberger_packed and
+ * F4.
+ */
+template <typename F>
+class Packed_groebner {
+public:
+     using P = Packed_polynomial<F>;
+
+     Packed_groebner(Packed_layout const& layout, F const& field);
+     /** Buchberger algorithm. */
+     std::vector<P> run(std::vector<P> const& f);
+     /** F4 algorithm. */
+     std::vector<P> run_f4(std::vector<P> const& f,
+                           unsigned nthreads);
+
+private:
+     using Coef = typename F::Coef;
+     using Mono = std::vector<std::uint64_t>;
+
+     struct Pair {
+          std::size_t i;
+          std::size_t j;
+          Mono lcm;
+     };
+
+     /** Sparse row of a Macaulay matrix. */
+     struct Row {
+          std::vector<std::size_t> col{};
+          std::vector<Coef> c{};
+     };
+
+     void start(std::vector<P> const& f);
+     std::vector<P> basis() const;
+     std::vector<P> reduce_pairs(std::vector<Pair> const& pairs,
+                                 unsigned nthreads) const;
+     void reduce_row(Row& r, std::vector<Row> const& rows,
+                     std::vector<std::ptrdiff_t> const& pivot,
+                     std::size_t ncols) const;
+     void update(P h);
+     std::vector<std::uint64_t> lcm(std::size_t i,
+                                    std::size_t j) const;
+     bool coprime(std::size_t i, std::size_t j) const;
+     std::uint64_t const* lm(std::size_t i) const {
+          return all_[i].leading_monomial();
+     }
+     P s_polynomial(Pair const& p) const;
+     void normal_form(P& f) const;
+
+     Packed_layout const layout_;
+     F const field_;
+     std::vector<P> all_{};           // all polynomials
+     std::vector<std::size_t> g_{};   // indices of the basis
+     std::vector<Pair> b_{};          // pairs to be processed
+};
+
+template <typename F>
+Packed_groebner<F>::Packed_groebner(Packed_layout const& layout,
+                                    F const& field)
+     : layout_(layout), field_(field) {}
+
+template <typename F>
+std::vector<typename Packed_groebner<F>::P>
+Packed_groebner<F>::run(std::vector<P> const& f) {
+     start(f);
+     while (!b_.empty()) {
+          // Normal selection strategy.
+          auto it = b_.begin();
+          for (auto jt = it + 1; jt != b_.end(); ++jt)
+               if (layout_.compare(jt->lcm.data(),
+                                   it->lcm.data()) < 0)
+                    it = jt;
+          Pair const p = *it;
+          b_.erase(it);
+          P h = s_polynomial(p);
+          normal_form(h);
+          if (!h.is_zero())
+               update(h);
+     }
+     return basis();
+}
+
+/**
+ * See \cite faugere-1999. The pairs of the least degree are reduced
+ * together. Symbolic preprocessing adds to their halves the
+ * reducers of all the monomials which appear. Rows with the same
+ * leading monomial as a pivot row are reduced by the pivot rows in
+ * parallel and the remaining rows are brought to echelon form.
+ */
+template <typename F>
+std::vector<typename Packed_groebner<F>::P>
+Packed_groebner<F>::run_f4(std::vector<P> const& f,
+                           unsigned nthreads) {
+     start(f);
+     while (!b_.empty()) {
+          auto d = b_.front().lcm[0];
+          for (auto const& p : b_)
+               d = std::min(d, p.lcm[0]);
+          std::vector<Pair> selected, rest;
+          for (auto& p : b_)
+               if (p.lcm[0] == d)
+                    selected.push_back(std::move(p));
+               else
+                    rest.push_back(std::move(p));
+          b_.swap(rest);
+          for (auto& h : reduce_pairs(selected, nthreads))
+               update(std::move(h));
+     }
+     return basis();
+}
+
+template <typename F>
+void Packed_groebner<F>::start(std::vector<P> const& f) {
+     all_.clear();
+     g_.clear();
+     b_.clear();
+     for (auto const& fi : f) {
+          P h{fi};
+          normal_form(h);
+          if (!h.is_zero())
+               update(h);
+     }
+}
+
+/**
+ * Returns the reduced basis. The basis g_ is minimal.
+ */
+template <typename F>
+std::vector<typename Packed_groebner<F>::P>
+Packed_groebner<F>::basis() const {
+     std::vector<P> g;
+     for (auto const i : g_)
+          g.push_back(all_[i]);
+     std::vector<P const*> t;
+     for (std::size_t i = 0; i < g.size(); i++) {
+          t.clear();
+          for (std::size_t j = 0; j < g.size(); j++)
+               if (j != i)
+                    t.push_back(&g[j]);
+          reduce(g[i], t);
+          g[i].normalize();
+     }
+     return g;
+}
+
+/**
+ * Returns the new polynomials, sorted decreasingly by their leading
+ * monomials, obtained by reduction of the pairs.
+ */
+template <typename F>
+std::vector<typename Packed_groebner<F>::P>
+Packed_groebner<F>::reduce_pairs(std::vector<Pair> const& pairs,
+                                 unsigned nthreads) const {
+     auto const greater = [this](Mono const& x, Mono const& y) {
+          return layout_.compare(x.data(), y.data()) > 0;
+     };
+     // Monomials of the matrix, true if processed.
+     std::map<Mono, bool, decltype(greater)> monos(greater);
+     // Rows as multiples u * all_[i].
+     std::set<std::pair<std::size_t, Mono>> rows;
+     std::vector<std::pair<std::size_t, Mono>> order;
+     Mono t(layout_.words());
+     auto const add = [&](std::size_t i, Mono const& u) {
+          if (!rows.insert({i, u}).second)
+               return;
+          order.push_back({i, u});
+          auto const& g = all_[i];
+          for (std::size_t k = 0; k < g.size(); k++) {
+               layout_.mul(u.data(), g.monomial(k), t.data());
+               monos.insert({t, false});
+          }
+     };
+     Mono u(layout_.words());
+     for (auto const& p : pairs) {
+          layout_.div(p.lcm.data(), lm(p.i), u.data());
+          add(p.i, u);
+          layout_.div(p.lcm.data(), lm(p.j), u.data());
+          add(p.j, u);
+          monos[p.lcm] = true;
+     }
+     // Symbolic preprocessing. New monomials are less than the
+     // current one, so they are visited later.
+     for (auto it = monos.begin(); it != monos.end(); ++it) {
+          if (it->second)
+               continue;
+          it->second = true;
+          for (auto const i : g_)
+               if (layout_.divides(lm(i), it->first.data())) {
+                    layout_.div(it->first.data(), lm(i), u.data());
+                    add(i, u);
+                    break;
+               }
+     }
+
+     // Column 0 is the greatest monomial.
+     std::vector<Mono const*> col;
+     std::map<Mono, std::size_t, decltype(greater)> index(greater);
+     for (auto const& m : monos) {
+          index.insert(index.end(), {m.first, col.size()});
+          col.push_back(&m.first);
+     }
+     std::size_t const ncols = col.size();
+     std::vector<Row> a(order.size());
+     std::vector<std::ptrdiff_t> pivot(ncols, -1);
+     std::vector<std::size_t> rest;
+     for (std::size_t r = 0; r < order.size(); r++) {
+          auto const& g = all_[order[r].first];
+          auto const& v = order[r].second;
+          for (std::size_t k = 0; k < g.size(); k++) {
+               layout_.mul(v.data(), g.monomial(k), t.data());
+               a[r].col.push_back(index.find(t)->second);
+               a[r].c.push_back(g.coefficient(k));
+          }
+          // The polynomials are normalized, the leading
+          // coefficients of the rows are equal to one.
+          if (pivot[a[r].col[0]] < 0)
+               pivot[a[r].col[0]] = r;
+          else
+               rest.push_back(r);
+     }
+     SHG::parallel_for(
+          rest.size(),
+          [&](std::size_t k) {
+               reduce_row(a[rest[k]], a, pivot, ncols);
+          },
+          nthreads);
+
+     std::vector<std::size_t> fresh;
+     for (auto const r : rest) {
+          reduce_row(a[r], a, pivot, ncols);
+          if (a[r].col.empty())
+               continue;
+          field_.normalize(a[r].c.data(),
+                           a[r].c.data() + a[r].c.size());
+          pivot[a[r].col[0]] = r;
+          fresh.push_back(r);
+     }
+     std::sort(fresh.begin(), fresh.end(),
+               [&a](std::size_t x, std::size_t y) {
+                    return a[x].col[0] < a[y].col[0];
+               });
+     std::vector<P> h;
+     for (auto const r : fresh) {
+          h.emplace_back(layout_, field_);
+          auto const& x = a[r];
+          for (std::size_t k = 0; k < x.col.size(); k++)
+               h.back().push_back(x.c[k], col[x.col[k]]->data());
+     }
+     return h;
+}
+
+/**
+ * Reduces the row by the pivot rows. The leading coefficients of
+ * the pivot rows are equal to one.
+ */
+template <typename F>
+void Packed_groebner<F>::reduce_row(
+     Row& r, std::vector<Row> const& rows,
+     std::vector<std::ptrdiff_t> const& pivot,
+     std::size_t ncols) const {
+     if (r.col.empty())
+          return;
+     std::vector<Coef> acc(ncols, field_.zero());
+     for (std::size_t k = 0; k < r.col.size(); k++)
+          acc[r.col[k]] = r.c[k];
+     std::size_t const first = r.col[0];
+     r.col.clear();
+     r.c.clear();
+     for (std::size_t j = first; j < ncols; j++) {
+          if (field_.is_zero(acc[j]))
+               continue;
+          if (pivot[j] < 0) {
+               r.col.push_back(j);
+               r.c.push_back(acc[j]);
+               continue;
+          }
+          auto const& p = rows[pivot[j]];
+          Coef const x = acc[j];
+          for (std::size_t k = 0; k < p.col.size(); k++)
+               acc[p.col[k]] =
+                    field_.sub(acc[p.col[k]], field_.mul(x, p.c[k]));
+     }
+}
+
+/**
+ * The procedure UPDATE of \cite gebauer-moeller-1988.
+ */
+template <typename F>
+void Packed_groebner<F>::update(P h) {
+     h.normalize();
+     std::size_t const k = all_.size();
+     all_.push_back(h);
+     using Lcm = std::vector<std::uint64_t>;
+     auto const divides = [this](Lcm const& x, Lcm const& y) {
+          return layout_.divides(x.data(), y.data());
+     };
+
+     // Criterion M: drop (g, h) if the lcm of another new pair
+     // properly divides its lcm. Of the pairs with equal lcm one is
+     // kept, a coprime one if possible.
+     std::vector<Pair> c;
+     for (auto const i : g_)
+          c.push_back({i, k, lcm(i, k)});
+     std::vector<Pair> d;
+     for (std::size_t i = 0; i < c.size(); i++) {
+          bool keep = true;
+          if (!coprime(c[i].i, k)) {
+               for (std::size_t j = i + 1; j < c.size() && keep; j++)
+                    if (divides(c[j].lcm, c[i].lcm))
+                         keep = false;
+               for (std::size_t j = 0; j < d.size() && keep; j++)
+                    if (divides(d[j].lcm, c[i].lcm))
+                         keep = false;
+          }
+          if (keep)
+               d.push_back(c[i]);
+     }
+     // Criterion B: drop the old pairs (g1, g2) if lm(h) divides
+     // their lcm properly with respect to g1 and g2.
+     std::vector<Pair> b;
+     for (auto& p : b_) {
+          if (!layout_.divides(lm(k), p.lcm.data()) ||
+              lcm(p.i, k) == p.lcm || lcm(p.j, k) == p.lcm)
+               b.push_back(std::move(p));
+     }
+     // Criterion F: drop the new pairs with coprime leading
+     // monomials.
+     for (auto& p : d)
+          if (!coprime(p.i, k))
+               b.push_back(std::move(p));
+     b_.swap(b);
+     std::vector<std::size_t> g;
+     for (auto const i : g_)
+          if (!layout_.divides(lm(k), lm(i)))
+               g.push_back(i);
+     g.push_back(k);
+     g_.swap(g);
+}
+
+template <typename F>
+std::vector<std::uint64_t> Packed_groebner<F>::lcm(
+     std::size_t i, std::size_t j) const {
+     std::vector<std::uint64_t> z(layout_.words());
+     layout_.lcm(lm(i), lm(j), z.data());
+     return z;
+}
+
+template <typename F>
+bool Packed_groebner<F>::coprime(std::size_t i, std::size_t j) const {
+     auto const z = lcm(i, j);
+     return z[0] == lm(i)[0] + lm(j)[0];
+}
+
+template <typename F>
+typename Packed_groebner<F>::P Packed_groebner<F>::s_polynomial(
+     Pair const& p) const {
+     auto const& f = all_[p.i];
+     auto const& g = all_[p.j];
+     std::vector<std::uint64_t> u(layout_.words());
+     layout_.div(p.lcm.data(), f.leading_monomial(), u.data());
+     P s{f};
+     s.mul(u.data());
+     layout_.div(p.lcm.data(), g.leading_monomial(), u.data());
+     typename F::Coef a, b;
+     field_.factors(s.leading_coefficient(), g.leading_coefficient(),
+                    b, a);
+     s.mul_sub(b, a, u.data(), g);
+     return s;
+}
+
+template <typename F>
+void Packed_groebner<F>::normal_form(P& f) const {
+     std::vector<P const*> t;
+     t.reserve(g_.size());
+     for (auto const i : g_)
+          t.push_back(&all_[i]);
+     reduce(f, t);
+}
+
+/**
+ * Runs Packed_groebner and converts the basis to polynomials with
+ * leading coefficients equal to one. If \c clear is true, the
+ * denominators of \c f are cleared first. If \c nthreads is
+ * positive, the F4 algorithm is run in \c nthreads threads,
+ * otherwise the Buchberger algorithm.
+ */
+template <typename F>
+std::vector<Polynomial> packed_groebner(
+     std::vector<Polynomial> const& f, Packed_layout const& layout,
+     F const& field, bool clear, unsigned nthreads = 0) {
+     std::vector<Packed_polynomial<F>> pf;
+     for (auto const& p : f)
+          if (!p.is_zero())
+               pf.push_back(
+                    to_packed(clear ? clear_denominators(p) : p,
+                              layout, field));
+     Packed_groebner<F> pg(layout, field);
+     std::vector<Polynomial> g;
+     for (auto const& p :
+          nthreads > 0 ? pg.run_f4(pf, nthreads) : pg.run(pf)) {
+          g.push_back(to_polynomial(p, field.as()));
+          auto const lc = g.back().leading_coefficient();
+          if (!is_one(lc))
+               g.back() *= inv(lc);
+     }
+     return g;
+}
+
+}  // anonymous namespace
+
 void Polynomial_div::divide(Polynomial const& f,
                             std::vector<Polynomial> const& g) {
      using Sztp = std::vector<Polynomial>::size_type;
@@ -33,6 +478,8 @@ void Polynomial_div::divide(Polynomial const& f,
                     "division of polynomials: divisor has a wrong "
                     "order");
      a.resize(s);
+     if (divide_packed(f, g, a, r))
+          return;
      for (auto& ai : a) {
           ai = Polynomial(f.as(), f.dim());
           ai.order(f.order());
@@ -266,6 +713,75 @@ void Buchberger_improved::new_basis() {
      g_ = k;
 }
 
+void Buchberger_packed::run(S const& f) {
+     if (f.empty())
+          throw std::invalid_argument(
+               "Buchberger: no polynomial given");
+     int const dim = f.front().dim();
+     AS const* const as = f[0].as();
+     if (dim < 1)
+          throw std::invalid_argument(
+               "Buchberger: invalid dimension");
+     for (auto const& p : f)
+          if (p.dim() != dim)
+               throw std::invalid_argument(
+                    "Buchberger: bad number of variables");
+
+     Packed_order order;
+     if (packed_order(f[0].order(), order)) {
+          Packed_layout const layout(dim, order);
+          try {
+               if (auto const q = dynamic_cast<Field_Q const*>(as)) {
+                    g_ = packed_groebner(
+                         f, layout, Fraction_free_coefficients(q),
+                         true);
+                    return;
+               }
+               auto const zn = dynamic_cast<Ring_Zn const*>(as);
+               if (zn != nullptr && zn->is_field() && zn->n() > 2) {
+                    g_ = packed_groebner(f, layout,
+                                         Zp_coefficients(zn), false);
+                    return;
+               }
+               g_ = packed_groebner(f, layout,
+                                    Element_coefficients(as), false);
+               return;
+          } catch (std::overflow_error const&) {
+          }
+     }
+     Buchberger_improved b;
+     b.run(f);
+     g_ = b.g();
+}
+
+void F4::run(S const& f, unsigned nthreads) {
+     if (f.empty())
+          throw std::invalid_argument("F4: no polynomial given");
+     int const dim = f.front().dim();
+     if (dim < 1)
+          throw std::invalid_argument("F4: invalid dimension");
+     for (auto const& p : f)
+          if (p.dim() != dim)
+               throw std::invalid_argument(
+                    "F4: bad number of variables");
+
+     auto const zn = dynamic_cast<Ring_Zn const*>(f[0].as());
+     Packed_order order;
+     if (zn != nullptr && zn->is_field() && zn->n() > 2 &&
+         packed_order(f[0].order(), order)) {
+          try {
+               g_ = packed_groebner(f, Packed_layout(dim, order),
+                                    Zp_coefficients(zn), false,
+                                    number_of_threads(nthreads));
+               return;
+          } catch (std::overflow_error const&) {
+          }
+     }
+     Buchberger_packed b;
+     b.run(f);
+     g_ = b.g();
+}
+
 bool Buchberger_improved::criterion1(P const& f1, P const& f2) {
      for (auto it = g_.cbegin(); it != g_.cend(); ++it) {
           auto const& p = *it;
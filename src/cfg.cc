@@ -10,6 +10,10 @@
 #include <iostream>
 #include <utility>
 #include <algorithm>
+#include <bit>
+#include <numeric>
+#include <tuple>
+#include <unordered_set>
 #include <shg/utils.h>
 
 namespace SHG::PLP {
@@ -92,11 +96,18 @@ bool is_valid(Vecprod const& vp) {
                if (std::any_of(v.begin(), v.end(), isspace))
                     return false;
           }
-          for (Vecprod::size_type j = i + 1; j < vp.size(); j++)
-               if (p.lhs == vp[j].lhs && p.rhs == vp[j].rhs)
-                    return false;
      }
-     return true;
+     // Sort the productions to find equal ones.
+     std::vector<Vecprod::size_type> idx(vp.size());
+     std::iota(idx.begin(), idx.end(), 0);
+     std::sort(idx.begin(), idx.end(), [&vp](auto i, auto j) {
+          return std::tie(vp[i].lhs, vp[i].rhs) <
+                 std::tie(vp[j].lhs, vp[j].rhs);
+     });
+     return std::adjacent_find(idx.begin(), idx.end(),
+                               [&vp](auto i, auto j) {
+                                    return vp[i] == vp[j];
+                               }) == idx.end();
 }
 
 bool CNF_validator::is_valid(Vecprod const& vp) {
@@ -326,15 +337,255 @@ void CYK::add_node(Info const& q, Parse_tree& t) {
      }
 }
 
+void Bitset_CYK::set_grammar(Vecprod const& cfg) {
+     CNF_validator v;
+     if (!v.is_valid(cfg))
+          throw Invalid_grammar();
+     for (auto const& p : cfg)
+          if (p.rhs.size() == 2)
+               if (p.rhs[0] == v.s() || p.rhs[1] == v.s())
+                    throw Invalid_grammar();
+     cfg_ = &cfg;
+     vid_.clear();
+     for (auto const& a : v.v())
+          vid_.emplace(a, static_cast<int>(vid_.size()));
+     tid_.clear();
+     for (auto const& a : v.t())
+          tid_.emplace(a, static_cast<int>(tid_.size()));
+     nv_ = vid_.size();
+     nw_ = (nv_ + word_bits - 1) / word_bits;
+     start_ = vid_.at(v.s());
+
+     plhs_.resize(cfg.size());
+     tmask_.assign(tid_.size() * nw_, 0);
+     tprod_.assign(tid_.size(), {});
+     rhs_.assign(nv_, {});
+     // Binary productions grouped by (B, C), sorted by B, then by C.
+     std::map<std::pair<int, int>, std::vector<Vecprod::size_type>>
+          bin;
+     for (Vecprod::size_type ip = 0; ip < cfg.size(); ip++) {
+          Production const& p = cfg[ip];
+          int const a = plhs_[ip] = vid_.at(p.lhs);
+          if (p.rhs.size() == 1) {
+               int const t = tid_.at(p.rhs[0]);
+               set(&tmask_[t * nw_], a);
+               tprod_[t].push_back(ip);
+          } else {
+               int const b = vid_.at(p.rhs[0]);
+               int const c = vid_.at(p.rhs[1]);
+               bin[{b, c}].push_back(ip);
+               rhs_[a].push_back({b, c});
+          }
+     }
+     pairs_.assign(nv_, {});
+     rmask_.assign(nv_ * nw_, 0);
+     lmask_.clear();
+     bprod_.clear();
+     for (auto const& [bc, prods] : bin) {
+          Pair const q{bc.second, lmask_.size(), bprod_.size(),
+                       bprod_.size() + prods.size()};
+          lmask_.resize(lmask_.size() + nw_, 0);
+          for (auto const ip : prods)
+               set(&lmask_[q.mask], plhs_[ip]);
+          bprod_.insert(bprod_.end(), prods.begin(), prods.end());
+          set(&rmask_[bc.first * nw_], bc.second);
+          pairs_[bc.first].push_back(q);
+     }
+     n_ = 0;
+     d_.clear();
+     tree_.clear();
+}
+
+bool Bitset_CYK::recognize(Sentence const& X) {
+     fill(X);
+     return test(cell(0, n_ - 1), start_);
+}
+
+void Bitset_CYK::parse(Sentence const& X) {
+     fill(X);
+}
+
+/**
+ * Derivations are collected bottom-up for the cells and symbols
+ * which occur in some parse tree of the sentence. In each cell they
+ * are ordered by split, then by the derivations in the left and
+ * right cells, then by production, as in CYK::parse().
+ */
+CYK::Parse_tree const& Bitset_CYK::gen() {
+     tree_.clear();
+     if (n_ == 0 || !test(cell(0, n_ - 1), start_))
+          return tree_;
+     if (d_.empty()) {
+          mark_useful();
+          d_.assign(n_ * n_, {});
+          for (int j = 0; j < n_; j++)
+               for (int i = 0; i < n_ - j; i++)
+                    derive(i, j);
+     }
+     for (auto const& d : d_[n_ - 1])
+          if (d.sym == start_)
+               add_node(0, n_ - 1, d, tree_);
+     return tree_;
+}
+
+void Bitset_CYK::derive(int i, int j) {
+     int const n = n_;
+     Word const* const u = &useful_[(i * n + j) * nw_];
+     auto& d = d_[i * n + j];
+     if (j == 0) {
+          for (auto const ip : tprod_[x_[i]])
+               if (test(u, plhs_[ip]))
+                    d.push_back({plhs_[ip], ip, -1, -1, -1});
+          return;
+     }
+     for (int k = 0; k < j; k++) {
+          auto const& dl = d_[i * n + k];
+          auto const& dr = d_[(i + k + 1) * n + j - k - 1];
+          int const nl = dl.size(), nr = dr.size();
+          for (int l = 0; l < nl; l++)
+               for (int r = 0; r < nr; r++) {
+                    Pair const* const q = find(dl[l].sym, dr[r].sym);
+                    if (q == nullptr)
+                         continue;
+                    for (auto m = q->first; m < q->last; m++) {
+                         auto const ip = bprod_[m];
+                         if (test(u, plhs_[ip]))
+                              d.push_back({plhs_[ip], ip, k, l, r});
+                    }
+               }
+     }
+}
+
+Bitset_CYK::Word* Bitset_CYK::cell(int i, int j) {
+     return &chart_[(i * n_ + j) * nw_];
+}
+
+bool Bitset_CYK::test(Word const* s, int a) const {
+     return (s[a / word_bits] >> (a % word_bits)) & 1;
+}
+
+void Bitset_CYK::set(Word* s, int a) const {
+     s[a / word_bits] |= Word{1} << (a % word_bits);
+}
+
+Bitset_CYK::Pair const* Bitset_CYK::find(int b, int c) const {
+     auto const& v = pairs_[b];
+     auto const it = std::lower_bound(
+          v.begin(), v.end(), c,
+          [](Pair const& q, int c) { return q.c < c; });
+     return it != v.end() && it->c == c ? &*it : nullptr;
+}
+
+/**
+ * Implementation of \cite hopcroft-ullman-2003, page 163, with
+ * bitsets.
+ */
+void Bitset_CYK::fill(Sentence const& X) {
+     if (cfg_ == nullptr)
+          throw Invalid_grammar();
+     int const n = X.size();
+     if (n == 0)
+          throw Empty_sentence();
+     x_.resize(n);
+     for (int i = 0; i < n; i++) {
+          auto const it = tid_.find(X[i]);
+          if (it == tid_.end())
+               throw Unknown_terminal();
+          x_[i] = it->second;
+     }
+     n_ = n;
+     d_.clear();
+     chart_.assign(n * n * nw_, 0);
+     for (int i = 0; i < n; i++)
+          std::copy_n(&tmask_[x_[i] * nw_], nw_, cell(i, 0));
+     for (int j = 1; j < n; j++)
+          for (int i = 0; i < n - j; i++) {
+               Word* const a = cell(i, j);
+               for (int k = 0; k < j; k++) {
+                    Word const* const left = cell(i, k);
+                    Word const* const right =
+                         cell(i + k + 1, j - k - 1);
+                    for (int wl = 0; wl < nw_; wl++)
+                         for (Word bl = left[wl]; bl != 0;
+                              bl &= bl - 1) {
+                              int const b = wl * word_bits +
+                                            std::countr_zero(bl);
+                              auto const& pb = pairs_[b];
+                              if (pb.empty())
+                                   continue;
+                              Word const* const rm =
+                                   &rmask_[b * nw_];
+                              auto q = pb.begin();
+                              for (int wr = 0; wr < nw_; wr++)
+                                   for (Word br = rm[wr] & right[wr];
+                                        br != 0; br &= br - 1) {
+                                        int const c =
+                                             wr * word_bits +
+                                             std::countr_zero(br);
+                                        while (q->c < c)
+                                             ++q;
+                                        Word const* const lm =
+                                             &lmask_[q->mask];
+                                        for (int w = 0; w < nw_; w++)
+                                             a[w] |= lm[w];
+                                   }
+                         }
+               }
+          }
+}
+
+/**
+ * Marks the symbols which occur in some parse tree, going top-down
+ * from the start symbol in the whole sentence.
+ */
+void Bitset_CYK::mark_useful() {
+     int const n = n_;
+     useful_.assign(chart_.size(), 0);
+     set(&useful_[(n - 1) * nw_], start_);
+     for (int j = n - 1; j > 0; j--)
+          for (int i = 0; i < n - j; i++) {
+               Word const* const u = &useful_[(i * n + j) * nw_];
+               for (int w = 0; w < nw_; w++)
+                    for (Word bu = u[w]; bu != 0; bu &= bu - 1) {
+                         int const a =
+                              w * word_bits + std::countr_zero(bu);
+                         for (auto const& [b, c] : rhs_[a])
+                              for (int k = 0; k < j; k++) {
+                                   int const il = i * n + k;
+                                   int const ir =
+                                        (i + k + 1) * n + j - k - 1;
+                                   if (test(&chart_[il * nw_], b) &&
+                                       test(&chart_[ir * nw_], c)) {
+                                        set(&useful_[il * nw_], b);
+                                        set(&useful_[ir * nw_], c);
+                                   }
+                              }
+                    }
+          }
+}
+
+void Bitset_CYK::add_node(int i, int j, Derivation const& d,
+                          Parse_tree& t) {
+     t.push_back({(*cfg_)[d.p].lhs, d.p});
+     auto& c = t[t.degree() - 1];
+     if (d.k < 0) {
+          c.push_back(Parse_node((*cfg_)[d.p].rhs[0]));
+     } else {
+          int const n = n_;
+          int const ir = i + d.k + 1, jr = j - d.k - 1;
+          add_node(i, d.k, d_[i * n + d.k][d.l], c);
+          add_node(ir, jr, d_[ir * n + jr][d.r], c);
+     }
+}
+
 void Conversion_to_CNF::convert(Vecprod const& vp) {
      if (!is_valid(vp))
           throw CFG_error("invalid vector of productions");
      vp_ = vp;
-     set_variables();
-     set_terminals();
-     s_ = vp_[0].lhs;
+     set_symbols();
+     s_ = ids_[vp_[0].lhs];
      for (auto const& p : vp_)
-          if (p.lhs == s_ && p.rhs.size() == 0)
+          if (p.lhs == vp_[0].lhs && p.rhs.size() == 0)
                throw CFG_error("grammar generates empty string");
      cfg_.clear();
      nnewv_ = 0;
@@ -345,98 +596,137 @@ void Conversion_to_CNF::convert(Vecprod const& vp) {
      unit();
      remove_useless();
      order();
+     for (auto const& p : w_) {
+          Production q;
+          q.lhs = names_[p.lhs];
+          for (Symbol const x : p.rhs)
+               q.rhs.push_back(names_[x]);
+          cfg_.push_back(std::move(q));
+     }
+     w_.clear();
 }
 
-void Conversion_to_CNF::set_variables() {
-     v_.clear();
+std::size_t Conversion_to_CNF::Rule_hash::operator()(
+     Rule const& r) const {
+     std::size_t h = std::hash<Symbol>()(r.lhs);
+     for (Symbol const x : r.rhs)
+          h = h * 1000003 ^ std::hash<Symbol>()(x);
+     return h;
+}
+
+void Conversion_to_CNF::set_symbols() {
+     names_.clear();
+     ids_.clear();
+     is_var_.clear();
      for (auto const& p : vp_) {
           if (p.lhs.empty() || p.lhs[0] == reserved_char_)
                throw CFG_error("invalid variable name");
-          v_.insert(p.lhs);
+          intern(p.lhs, true);
      }
-}
-
-void Conversion_to_CNF::set_terminals() {
-     t_.clear();
+     bool found = false;
      for (auto const& p : vp_)
           for (auto const& s : p.rhs) {
                if (s.empty() || s[0] == reserved_char_)
                     throw CFG_error(
                          "invalid variable or terminal name");
-               if (v_.find(s) == v_.end())
-                    t_.insert(s);
+               if (!is_var_[intern(s, false)])
+                    found = true;
           }
-     if (t_.size() == 0)
+     if (!found)
           throw CFG_error("no terminals found");
 }
 
-std::string Conversion_to_CNF::newname() {
-     return "_" + std::to_string(nnewv_++);
+Conversion_to_CNF::Symbol Conversion_to_CNF::intern(
+     std::string const& name, bool var) {
+     auto const [it, inserted] =
+          ids_.try_emplace(name, names_.size());
+     if (inserted) {
+          names_.push_back(name);
+          is_var_.push_back(var);
+     }
+     return it->second;
+}
+
+Conversion_to_CNF::Symbol Conversion_to_CNF::newvar() {
+     // Names beginning with reserved_char_ are not in ids_.
+     names_.push_back("_" + std::to_string(nnewv_++));
+     is_var_.push_back(true);
+     return names_.size() - 1;
+}
+
+void Conversion_to_CNF::remove_duplicates(std::vector<Rule>& v) {
+     std::unordered_set<Rule, Rule_hash> seen;
+     seen.reserve(v.size());
+     auto const end =
+          std::remove_if(v.begin(), v.end(), [&seen](Rule const& r) {
+               return !seen.insert(r).second;
+          });
+     v.erase(end, v.end());
 }
 
 void Conversion_to_CNF::start() {
-     Production p;
-     p.rhs.push_back(s_);
-     s_ = p.lhs = newname();
-     v_.insert(s_);
-     cfg_.push_back(p);
-     for (auto const& p : vp_)
-          cfg_.push_back(p);
+     w_.clear();
+     Symbol const s = newvar();
+     w_.push_back({s, {s_}});
+     s_ = s;
+     for (auto const& p : vp_) {
+          Rule r{ids_[p.lhs], {}};
+          for (auto const& x : p.rhs)
+               r.rhs.push_back(ids_[x]);
+          w_.push_back(std::move(r));
+     }
 }
 
+/*
+ * For each terminal a on a right-hand side of length at least 2, a
+ * new variable _k --> a replaces a on such right-hand sides. One
+ * variable is added for each occurrence of a in the first right-hand
+ * side containing it, and the first of them replaces all
+ * occurrences. The other ones are removed by remove_useless().
+ */
 void Conversion_to_CNF::term() {
-     auto const n = cfg_.size();
-     Vecprod::size_type i, j;
-     for (i = 0; i < n; i++) {
-          auto const p = cfg_[i];
-          if (p.rhs.size() <= 1)
+     auto const n = w_.size();
+     std::vector<Symbol> repl(names_.size());
+     std::vector<char> replaced(names_.size(), false);
+     std::vector<Rule> added;
+     for (std::vector<Rule>::size_type i = 0; i < n; i++) {
+          auto& rhs = w_[i].rhs;
+          if (rhs.size() <= 1)
                continue;
-          for (auto const& s : p.rhs) {
-               if (t_.find(s) != t_.end()) {
-                    Production q;
-                    q.lhs = newname();
-                    v_.insert(q.lhs);
-                    q.rhs.push_back(s);
-                    cfg_.push_back(q);
-                    for (j = i; j < n; j++) {
-                         auto& r = cfg_[j];
-                         if (r.rhs.size() <= 1)
-                              continue;
-                         for (auto& s1 : r.rhs)
-                              if (s1 == s)
-                                   s1 = q.lhs;
+          for (auto& x : rhs)
+               if (!is_var_[x] && replaced[x])
+                    x = repl[x];
+          for (Symbol const x : rhs)
+               if (!is_var_[x]) {
+                    Symbol const q = newvar();
+                    added.push_back({q, {x}});
+                    if (!replaced[x]) {
+                         repl[x] = q;
+                         replaced[x] = true;
                     }
                }
-          }
+          for (auto& x : rhs)
+               if (!is_var_[x])
+                    x = repl[x];
      }
+     w_.insert(w_.end(), added.begin(), added.end());
 }
 
 void Conversion_to_CNF::bin() {
-     auto const n = cfg_.size();
-     std::string newn;
-     std::vector<std::string>::size_type j;
-     for (Vecprod::size_type i = 0; i < n; i++) {
-          auto const p = cfg_[i];
-          auto const k = p.rhs.size();
+     auto const n = w_.size();
+     for (std::vector<Rule>::size_type i = 0; i < n; i++) {
+          auto const p = w_[i].rhs;
+          auto const k = p.size();
           if (k <= 2)
                continue;
-          Production q;
-          newn = q.lhs = newname();
-          q.rhs.push_back(p.rhs[k - 2]);
-          q.rhs.push_back(p.rhs[k - 1]);
-          cfg_.push_back(q);
-          v_.insert(newn);
-          for (j = 1; j < k - 2; j++) {
-               q.lhs = newname();
-               q.rhs[0] = p.rhs[k - 2 - j];
-               q.rhs[1] = newn;
-               cfg_.push_back(q);
-               v_.insert(q.lhs);
-               newn = q.lhs;
+          Symbol newn = newvar();
+          w_.push_back({newn, {p[k - 2], p[k - 1]}});
+          for (std::vector<Symbol>::size_type j = 1; j < k - 2; j++) {
+               Symbol const q = newvar();
+               w_.push_back({q, {p[k - 2 - j], newn}});
+               newn = q;
           }
-          cfg_[i].rhs.clear();
-          cfg_[i].rhs.push_back(p.rhs[0]);
-          cfg_[i].rhs.push_back(newn);
+          w_[i].rhs = {p[0], newn};
      }
 }
 
@@ -488,133 +778,147 @@ void Conversion_to_CNF::bin() {
  */
 void Conversion_to_CNF::del() {
      nullable();
+     std::vector<Rule> w;
+     for (auto const& p : w_)
+          expand(p, w);
      w_.clear();
-     for (auto const& p : cfg_)
-          expand(p);
-     cfg_.clear();
      // Here check for 0_ --> epsilon
      // and remove duplicates.
      // After unit also remove duplicates and productions A --> A.
-     for (auto const& p : w_)
+     for (auto& p : w)
           if (p.rhs.size() != 0)
-               cfg_.push_back(p);
-     remove_duplicates(cfg_);
+               w_.push_back(std::move(p));
+     remove_duplicates(w_);
 }
 
+/*
+ * A unit production A --> B, the first one in w_, is removed and
+ * productions A --> x are appended for all productions B --> x,
+ * until there are no unit productions. Productions are not erased
+ * but marked as removed, and the productions of each variable are
+ * indexed. A production A --> x which has already been in w_ is not
+ * appended again, nor is A --> A. Previously, repeated unit
+ * productions were processed again, which never ended for cycles
+ * of unit productions like B --> C, C --> B, B --> B.
+ */
 void Conversion_to_CNF::unit() {
-     Vecprod::size_type i;
-     Production p0;
-     for (;;) {
-          bool found = false;
-          for (auto it = cfg_.begin(); it != cfg_.end(); ++it) {
-               if (it->rhs.size() != 1)
-                    continue;
-               if (v_.find(it->rhs[0]) != v_.end()) {
-                    found = true;
-                    p0 = *it;
-                    cfg_.erase(it);
-                    break;
-               }
-          }
-          if (!found)
+     using Index = std::vector<Rule>::size_type;
+     auto const is_unit = [this](Rule const& r) {
+          return r.rhs.size() == 1 && is_var_[r.rhs[0]];
+     };
+     std::vector<char> alive(w_.size(), true);
+     std::vector<std::vector<Index>> by_lhs(names_.size());
+     std::unordered_set<Rule, Rule_hash> present;
+     for (Index i = 0; i < w_.size(); i++) {
+          by_lhs[w_[i].lhs].push_back(i);
+          present.insert(w_[i]);
+     }
+     for (Index next = 0;; next++) {
+          while (next < w_.size() &&
+                 !(alive[next] && is_unit(w_[next])))
+               next++;
+          if (next == w_.size())
                break;
-          auto const n = cfg_.size();
-          for (i = 0; i < n; i++) {
-               auto& p = cfg_[i];
-               if (p.lhs == p0.rhs[0]) {
-                    Production p1 = p;
-                    p1.lhs = p0.lhs;
-                    cfg_.push_back(p1);
-               }
+          alive[next] = false;
+          Symbol const a = w_[next].lhs;
+          Symbol const b = w_[next].rhs[0];
+          auto const m = by_lhs[b].size();
+          for (Index t = 0; t < m; t++) {
+               Index const i = by_lhs[b][t];
+               if (!alive[i])
+                    continue;
+               Rule r{a, w_[i].rhs};
+               if (is_unit(r) && r.rhs[0] == a)
+                    continue;
+               if (!present.insert(r).second)
+                    continue;
+               w_.push_back(std::move(r));
+               alive.push_back(true);
+               by_lhs[a].push_back(w_.size() - 1);
           }
      }
-     remove_duplicates(cfg_);
+     Index k = 0;
+     for (Index i = 0; i < w_.size(); i++)
+          if (alive[i] && k++ != i)
+               w_[k - 1] = std::move(w_[i]);
+     w_.resize(k);
+     remove_duplicates(w_);
 }
 
 void Conversion_to_CNF::order() {
-     Vecprod::size_type i, k = 0;
+     auto const partition = [this](std::vector<Rule>::size_type k,
+                                   auto pred) {
+          for (auto i = k; i < w_.size(); i++)
+               if (pred(w_[i]))
+                    std::swap(w_[i], w_[k++]);
+          return k;
+     };
      // Productions _0 --> first.
-     do {
-          for (i = k; i < cfg_.size() && cfg_[i].lhs != s_; i++)
-               ;
-          if (i < cfg_.size())
-               std::swap(cfg_[i], cfg_[k++]);
-     } while (i < cfg_.size());
+     auto k = partition(0, [this](Rule const& r) {
+          return r.lhs == s_;
+     });
      // Right-hand sides with two nonterminals.
-     do {
-          for (i = k; i < cfg_.size() && cfg_[i].rhs.size() != 2; i++)
-               ;
-          if (i < cfg_.size())
-               std::swap(cfg_[i], cfg_[k++]);
-     } while (i < cfg_.size());
+     k = partition(k,
+                   [](Rule const& r) { return r.rhs.size() == 2; });
      // Right-hand sides with one terminal.
-     do {
-          for (i = k; i < cfg_.size() && cfg_[i].rhs.size() != 1; i++)
-               ;
-          if (i < cfg_.size())
-               std::swap(cfg_[i], cfg_[k++]);
-     } while (i < cfg_.size());
+     partition(k, [](Rule const& r) { return r.rhs.size() == 1; });
 }
 
 void Conversion_to_CNF::nullable() {
-     null_.clear();
-     for (auto const& p : cfg_)
-          if (p.rhs.size() == 0)
-               null_.insert(p.lhs);
-     if (null_.empty())
-          return;
-     bool found;
-     do {
-          found = false;
-          for (auto const& p : cfg_) {
-               if (std::all_of(p.rhs.begin(), p.rhs.end(),
-                               [this](std::string const& s) {
-                                    return null_.find(s) !=
-                                           null_.end();
-                               }))
-                    if (null_.find(p.lhs) == null_.end()) {
-                         null_.insert(p.lhs);
-                         found = true;
-                    }
+     null_.assign(names_.size(), false);
+     // For each production, the number of symbols on the right-hand
+     // side not known to be nullable.
+     std::vector<std::vector<Rule>::size_type> left(w_.size());
+     std::vector<std::vector<std::vector<Rule>::size_type>> occur(
+          names_.size());
+     std::vector<Symbol> queue;
+     for (std::vector<Rule>::size_type i = 0; i < w_.size(); i++) {
+          left[i] = w_[i].rhs.size();
+          for (Symbol const x : w_[i].rhs)
+               occur[x].push_back(i);
+          if (left[i] == 0 && !null_[w_[i].lhs]) {
+               null_[w_[i].lhs] = true;
+               queue.push_back(w_[i].lhs);
           }
-     } while (found);
+     }
+     while (!queue.empty()) {
+          Symbol const x = queue.back();
+          queue.pop_back();
+          for (auto const i : occur[x])
+               if (--left[i] == 0 && !null_[w_[i].lhs]) {
+                    null_[w_[i].lhs] = true;
+                    queue.push_back(w_[i].lhs);
+               }
+     }
 }
 
-void Conversion_to_CNF::expand(Production const& p) {
-     size_t nnullable = 0;  // number of nullable variables on rhs
-     std::vector<bool> v(p.rhs.size(), false);
-     for (std::vector<std::string>::size_type i = 0; i < p.rhs.size();
-          i++)
-          if (null_.find(p.rhs[i]) != null_.end()) {
-               nnullable++;
-               v[i] = true;
-          }
-     if (nnullable == 0) {
-          w_.push_back(p);
+void Conversion_to_CNF::expand(Rule const& p,
+                               std::vector<Rule>& w) const {
+     std::vector<std::vector<Symbol>::size_type> v;
+     for (std::vector<Symbol>::size_type i = 0; i < p.rhs.size(); i++)
+          if (null_[p.rhs[i]])
+               v.push_back(i);
+     if (v.empty()) {
+          w.push_back(p);
           return;
      }
-     std::vector<bool> bv(nnullable, false);
-     for (;;) {
-          Production p1;
-          p1.lhs = p.lhs;
-          size_t j = 0;
-          for (size_t i = 0; i < v.size(); i++) {
-               if (v[i]) {
-                    if (bv[j++])
-                         ;
-                    else
+     // Bit j of mask set means that the j-th nullable symbol is
+     // omitted.
+     assert(v.size() < 64);
+     std::uint64_t const n = std::uint64_t(1) << v.size();
+     for (std::uint64_t mask = 0; mask < n; mask++) {
+          Rule p1{p.lhs, {}};
+          std::vector<Symbol>::size_type j = 0;
+          for (std::vector<Symbol>::size_type i = 0; i < p.rhs.size();
+               i++)
+               if (j < v.size() && v[j] == i) {
+                    if (!(mask >> j & 1))
                          p1.rhs.push_back(p.rhs[i]);
-               } else
+                    j++;
+               } else {
                     p1.rhs.push_back(p.rhs[i]);
-          }
-          assert(j == nnullable);
-          w_.push_back(p1);
-          size_t i = 0;
-          while (i < bv.size() && bv[i])
-               bv[i++] = false;
-          if (i == bv.size())
-               break;
-          bv[i] = true;
+               }
+          w.push_back(std::move(p1));
      }
 }
 
@@ -624,31 +928,37 @@ void Conversion_to_CNF::expand(Production const& p) {
  * useless if its left hand side variable is useless.
  */
 void Conversion_to_CNF::remove_useless() {
-     for (auto it = v_.begin(); it != v_.end();) {
-          if (*it == s_) {
-               ++it;
-               continue;
-          }
-          bool found = false;
-          for (auto const& p : cfg_) {
-               auto const& r = p.rhs;
-               if (std::find(r.begin(), r.end(), *it) != r.end()) {
-                    found = true;
-                    break;
-               }
-          }
-          if (found) {
-               ++it;
+     using Index = std::vector<Rule>::size_type;
+     std::vector<Index> count(names_.size(), 0);
+     std::vector<std::vector<Index>> by_lhs(names_.size());
+     for (Index i = 0; i < w_.size(); i++) {
+          by_lhs[w_[i].lhs].push_back(i);
+          for (Symbol const x : w_[i].rhs)
+               count[x]++;
+     }
+     // Variables are visited in the order of their names.
+     std::vector<Symbol> v;
+     for (Symbol x = 0; x < names_.size(); x++)
+          if (is_var_[x])
+               v.push_back(x);
+     std::sort(v.begin(), v.end(), [this](Symbol x, Symbol y) {
+          return names_[x] < names_[y];
+     });
+     std::vector<char> alive(w_.size(), true);
+     for (Symbol const x : v) {
+          if (x == s_ || count[x] > 0)
                continue;
+          for (Index const i : by_lhs[x]) {
+               alive[i] = false;
+               for (Symbol const y : w_[i].rhs)
+                    count[y]--;
           }
-          // Remove all productions with lhs == *it.
-          auto end = std::remove_if(
-               cfg_.begin(), cfg_.end(),
-               [it](Production const& p) { return p.lhs == *it; });
-          cfg_.erase(end, cfg_.end());
-          // Remove *it from v_.
-          it = v_.erase(it);
      }
+     Index k = 0;
+     for (Index i = 0; i < w_.size(); i++)
+          if (alive[i] && k++ != i)
+               w_[k - 1] = std::move(w_[i]);
+     w_.resize(k);
 }
 
 Vecprod full_cnf(unsigned n, unsigned m) {
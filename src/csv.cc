@@ -4,10 +4,50 @@
  */
 
 #include <shg/csv.h>
+#include <algorithm>
+#include <charconv>
+#include <cstring>
 #include <stdexcept>
 
 namespace SHG {
 
+namespace {
+
+void check_separators(char field_separator, char quote_character,
+                      char const* func) {
+     if (field_separator == quote_character ||
+         field_separator == '\r' || field_separator == '\n' ||
+         quote_character == '\r' || quote_character == '\n')
+          throw std::invalid_argument(func);
+}
+
+// Appends the field s to out quoting it if it contains special
+// characters.
+void append_field(std::string& out, std::string_view s,
+                  char quote_character, std::string const& special) {
+     if (s.find_first_of(special) == s.npos) {
+          out += s;
+     } else {
+          out += quote_character;
+          for (char c : s) {
+               if (c == quote_character)
+                    out += quote_character;
+               out += c;
+          }
+          out += quote_character;
+     }
+}
+
+template <typename T>
+void from_chars_field(std::string_view s, T& x) {
+     char const* const last = s.data() + s.size();
+     auto const [p, ec] = std::from_chars(s.data(), last, x);
+     if (ec != std::errc() || p != last)
+          throw std::invalid_argument("invalid number");
+}
+
+}  // anonymous namespace
+
 CSV_writer::CSV_writer(std::ostream& ostr, char field_separator,
                        char quote_character)
      : field_separator_(field_separator),
@@ -15,10 +55,7 @@ CSV_writer::CSV_writer(std::ostream& ostr, char field_separator,
        special_(std::string() + field_separator_ + quote_character_ +
                 '\r' + '\n'),
        ostr_(ostr) {
-     if (field_separator_ == quote_character_ ||
-         field_separator_ == '\r' || field_separator_ == '\n' ||
-         quote_character_ == '\r' || quote_character_ == '\n')
-          throw std::invalid_argument(__func__);
+     check_separators(field_separator_, quote_character_, __func__);
 }
 
 void CSV_writer::write_record(std::vector<std::string> const& rec) {
@@ -37,17 +74,7 @@ void CSV_writer::add_field(std::string const& s) {
           first_ = false;
      else
           rec_ += field_separator_;
-     if (s.find_first_of(special_) == s.npos) {
-          rec_ += s;
-     } else {
-          rec_ += quote_character_;
-          for (char c : s) {
-               if (c == quote_character_)
-                    rec_ += quote_character_;
-               rec_ += c;
-          }
-          rec_ += quote_character_;
-     }
+     append_field(rec_, s, quote_character_, special_);
 }
 
 CSV_reader::CSV_reader(std::istream& istr, char field_separator,
@@ -55,10 +82,7 @@ CSV_reader::CSV_reader(std::istream& istr, char field_separator,
      : field_separator_(field_separator),
        quote_character_(quote_character),
        istr_(istr) {
-     if (field_separator_ == quote_character_ ||
-         field_separator_ == '\r' || field_separator_ == '\n' ||
-         quote_character_ == '\r' || quote_character_ == '\n')
-          throw std::invalid_argument(__func__);
+     check_separators(field_separator_, quote_character_, __func__);
 }
 
 void CSV_reader::getrec(std::vector<std::string>& rec) {
@@ -125,4 +149,234 @@ bool CSV_reader::is_end_of_record() {
      return eol;
 }
 
+CSV_buffered_writer::CSV_buffered_writer(std::ostream& ostr,
+                                         char field_separator,
+                                         char quote_character,
+                                         std::size_t buffer_size)
+     : field_separator_(field_separator),
+       quote_character_(quote_character),
+       special_(std::string() + field_separator_ + quote_character_ +
+                '\r' + '\n'),
+       ostr_(ostr),
+       buffer_size_(buffer_size) {
+     check_separators(field_separator_, quote_character_, __func__);
+     buf_.reserve(buffer_size_);
+}
+
+CSV_buffered_writer::~CSV_buffered_writer() {
+     try {
+          flush();
+     } catch (...) {
+     }
+}
+
+void CSV_buffered_writer::write_record(
+     std::vector<std::string> const& rec) {
+     write(rec);
+}
+
+void CSV_buffered_writer::write_record(
+     std::vector<std::string_view> const& rec) {
+     write(rec);
+}
+
+void CSV_buffered_writer::write_record(
+     std::vector<double> const& rec) {
+     if (rec.size() == 0)
+          return;
+     char tmp[32];
+     for (std::size_t i = 0; i < rec.size(); i++) {
+          if (i > 0)
+               buf_ += field_separator_;
+          auto const r = std::to_chars(tmp, tmp + sizeof tmp, rec[i]);
+          buf_.append(tmp, r.ptr);
+     }
+     buf_ += "\r\n";
+     if (buf_.size() >= buffer_size_)
+          flush();
+}
+
+void CSV_buffered_writer::flush() {
+     ostr_.write(buf_.data(), buf_.size());
+     buf_.clear();
+}
+
+template <typename T>
+void CSV_buffered_writer::write(std::vector<T> const& rec) {
+     if (rec.size() == 0)
+          return;
+     for (std::size_t i = 0; i < rec.size(); i++) {
+          if (i > 0)
+               buf_ += field_separator_;
+          append_field(buf_, rec[i], quote_character_, special_);
+     }
+     buf_ += "\r\n";
+     if (buf_.size() >= buffer_size_)
+          flush();
+}
+
+CSV_buffered_reader::CSV_buffered_reader(std::istream& istr,
+                                         char field_separator,
+                                         char quote_character,
+                                         std::size_t buffer_size)
+     : field_separator_(field_separator),
+       quote_character_(quote_character),
+       istr_(istr),
+       buf_(buffer_size) {
+     check_separators(field_separator_, quote_character_, __func__);
+     if (buffer_size == 0)
+          throw std::invalid_argument(__func__);
+     for (char c : {field_separator_, quote_character_, '\r', '\n'})
+          special_[static_cast<unsigned char>(c)] = true;
+}
+
+bool CSV_buffered_reader::getrec(std::vector<std::string_view>& rec) {
+     rec.clear();
+     fields_.clear();
+     std::size_t i = rs_;  // current position
+     std::size_t fs = i;   // start of the current field
+     bool quoted = false;
+     bool inquote = false;
+     bool last = false;  // the last field ends at end of input
+     for (;;) {
+          if (i == end_ && !fill(i, fs)) {
+               if (i > fs) {
+                    add_field(fs, i, quoted);
+                    last = true;
+               }
+               break;
+          }
+          char const* const b = buf_.data();
+          if (inquote) {
+               // Between quotes only a quote character is special.
+               void const* const p =
+                    std::memchr(b + i, quote_character_, end_ - i);
+               if (p == nullptr) {
+                    i = end_;
+               } else {
+                    i = static_cast<char const*>(p) - b + 1;
+                    inquote = false;
+               }
+               continue;
+          }
+          while (i < end_ &&
+                 !special_[static_cast<unsigned char>(b[i])])
+               i++;
+          if (i == end_)
+               continue;
+          char const c = b[i];
+          if (c == quote_character_) {
+               quoted = inquote = true;
+               i++;
+          } else if (c == field_separator_) {
+               add_field(fs, i, quoted);
+               fs = ++i;
+               quoted = false;
+          } else {
+               add_field(fs, i, quoted);
+               i++;
+               if (c == '\r' && (i < end_ || fill(i, fs)) &&
+                   buf_[i] == '\n')
+                    i++;
+               break;
+          }
+     }
+
+     std::size_t k = 0;
+     for (auto const& f : fields_) {
+          std::string_view const raw(buf_.data() + rs_ + f.begin,
+                                     f.end - f.begin);
+          if (!f.quoted) {
+               rec.push_back(raw);
+               continue;
+          }
+          // Unquote as CSV_reader does.
+          if (k == unquoted_.size())
+               unquoted_.emplace_back();
+          std::string& u = unquoted_[k++];
+          u.clear();
+          bool inq = false, prevq = false;
+          for (char c : raw) {
+               if (c == quote_character_) {
+                    if (inq) {
+                         inq = false;
+                         prevq = true;
+                    } else {
+                         if (prevq)
+                              u += c;
+                         prevq = false;
+                         inq = true;
+                    }
+               } else {
+                    prevq = false;
+                    u += c;
+               }
+          }
+          rec.push_back(u);
+     }
+     // As CSV_reader, drop an empty field at end of input.
+     if (last && rec.back().empty())
+          rec.pop_back();
+     rs_ = i;
+     return !rec.empty();
+}
+
+void CSV_buffered_reader::getrec(std::vector<std::string>& rec) {
+     getrec(views_);
+     rec.assign(views_.begin(), views_.end());
+}
+
+// Moves the current record to the beginning of the buffer, enlarges
+// the buffer if it is full and reads more data. Returns false if no
+// data could be read.
+bool CSV_buffered_reader::fill(std::size_t& i, std::size_t& fs) {
+     if (rs_ > 0) {
+          std::copy(buf_.begin() + rs_, buf_.begin() + end_,
+                    buf_.begin());
+          i -= rs_;
+          fs -= rs_;
+          end_ -= rs_;
+          rs_ = 0;
+     }
+     if (end_ == buf_.size())
+          buf_.resize(2 * buf_.size());
+     istr_.read(buf_.data() + end_, buf_.size() - end_);
+     auto const n = static_cast<std::size_t>(istr_.gcount());
+     end_ += n;
+     return n > 0;
+}
+
+void CSV_buffered_reader::add_field(std::size_t fs, std::size_t fe,
+                                    bool quoted) {
+     fields_.push_back({fs - rs_, fe - rs_, quoted});
+}
+
+void from_field(std::string_view s, int& x) {
+     from_chars_field(s, x);
+}
+
+void from_field(std::string_view s, long& x) {
+     from_chars_field(s, x);
+}
+
+void from_field(std::string_view s, long long& x) {
+     from_chars_field(s, x);
+}
+
+void from_field(std::string_view s, unsigned& x) {
+     from_chars_field(s, x);
+}
+
+void from_field(std::string_view s, unsigned long& x) {
+     from_chars_field(s, x);
+}
+
+void from_field(std::string_view s, unsigned long long& x) {
+     from_chars_field(s, x);
+}
+
+void from_field(std::string_view s, double& x) {
+     from_chars_field(s, x);
+}
+
 }  // namespace SHG
@@ -9,9 +9,14 @@
 #include <cstdlib>
 #include <cstdio>
 #include <iostream>
+#include <algorithm>
 #include <exception>
 #include <fstream>
+#include <limits>
+#include <queue>
 #include <sstream>
+#include <string_view>
+#include <tuple>
 #include <boost/iostreams/filtering_streambuf.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
 #include <shg/utils.h>
@@ -27,20 +32,410 @@ constexpr double eccentricity_squared =
 constexpr double one_minus_eccentricity_squared =
      1.0 - eccentricity_squared;
 
-}  // anonymous namespace
+// The first bytes of a binary track file.
+constexpr char track_magic[8] = {'S', 'H', 'G', 'T',
+                                 'R', 'A', 'C', 'K'};
 
-void convert(Geogr_coord const& g, Cart_coord& p) {
-     double const phi = degrees_to_radians(g.phi);
-     double const lambda = degrees_to_radians(g.lambda);
+/*
+ * Reads XML markup sequentially. Each call to next() reads one tag
+ * and the character data preceding it. Comments, CDATA sections,
+ * declarations and processing instructions are returned as tags
+ * too; their contents are not interpreted. Entity references are
+ * not expanded.
+ */
+class Markup_reader {
+public:
+     explicit Markup_reader(std::istream& f) : f_(f) {}
+     bool next();
+     std::string const& tag() const { return tag_; }
+     std::string const& text() const { return text_; }
+
+private:
+     int get();
+     bool complete() const;
+
+     std::istream& f_;
+     std::vector<char> buf_ = std::vector<char>(1 << 16);
+     std::size_t pos_{};
+     std::size_t end_{};
+     std::string tag_{};
+     std::string text_{};
+};
+
+bool Markup_reader::next() {
+     int c;
+     text_.clear();
+     tag_.clear();
+     while ((c = get()) != '<') {
+          if (c == EOF)
+               return false;
+          text_.push_back(static_cast<char>(c));
+     }
+     char quote = '\0';
+     for (;;) {
+          if ((c = get()) == EOF)
+               throw std::runtime_error("unexpected end of file");
+          if (quote != '\0') {
+               if (c == quote)
+                    quote = '\0';
+          } else if (c == '>' && complete()) {
+               return true;
+          } else if ((c == '"' || c == '\'') && !tag_.empty() &&
+                     tag_[0] != '!') {
+               quote = static_cast<char>(c);
+          }
+          tag_.push_back(static_cast<char>(c));
+     }
+}
+
+int Markup_reader::get() {
+     if (pos_ == end_) {
+          f_.read(buf_.data(), buf_.size());
+          pos_ = 0;
+          end_ = f_.gcount();
+          if (end_ == 0)
+               return EOF;
+     }
+     return static_cast<unsigned char>(buf_[pos_++]);
+}
+
+bool Markup_reader::complete() const {
+     std::string_view const t(tag_);
+     if (t.starts_with("!--"))
+          return t.size() >= 5 && t.ends_with("--");
+     if (t.starts_with("![CDATA["))
+          return t.size() >= 10 && t.ends_with("]]");
+     return true;
+}
+
+// Returns the name of the element in the tag t.
+std::string_view tag_name(std::string const& t) {
+     std::string_view v(t);
+     if (v.starts_with('/'))
+          v.remove_prefix(1);
+     auto const n = v.find_first_of(" \t\r\n/");
+     return n == v.npos ? v : v.substr(0, n);
+}
+
+// Returns the value of the attribute name in the tag t or an empty
+// string if there is no such attribute.
+std::string attribute(std::string const& t, std::string_view name) {
+     auto const isspace = [](char c) {
+          return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+     };
+     std::string::size_type i = 0;
+     while ((i = t.find(name, i)) != t.npos) {
+          std::string::size_type j = i + name.size();
+          bool const starts = i > 0 && isspace(t[i - 1]);
+          i = j;
+          if (!starts)
+               continue;
+          while (j < t.size() && isspace(t[j]))
+               j++;
+          if (j == t.size() || t[j] != '=')
+               continue;
+          j++;
+          while (j < t.size() && isspace(t[j]))
+               j++;
+          if (j == t.size() || (t[j] != '"' && t[j] != '\''))
+               continue;
+          auto const k = t.find(t[j], j + 1);
+          if (k == t.npos)
+               break;
+          return t.substr(j + 1, k - j - 1);
+     }
+     return "";
+}
+
+// Calls add(lat, lon, ele, time) for each point of the first track
+// segment of the first track in the GPX stream f. The arguments are
+// the texts of the attributes and elements, empty if missing.
+template <typename F>
+void scan_points(std::istream& f, F add) {
+     Markup_reader r(f);
+     std::string lat, lon, ele, time;
+     bool has_ele = false, has_time = false;
+     int ntrk = 0, nseg = 0;
+     bool in_seg = false, in_pt = false;
+     while (r.next()) {
+          std::string const& t = r.tag();
+          if (t.empty() || t[0] == '?' || t[0] == '!')
+               continue;
+          std::string_view const name = tag_name(t);
+          if (t[0] == '/') {
+               if (!in_pt) {
+                    if (name == "trkseg")
+                         in_seg = false;
+               } else if (name == "ele" && !has_ele) {
+                    ele = r.text();
+                    has_ele = true;
+               } else if (name == "time" && !has_time) {
+                    time = r.text();
+                    has_time = true;
+               } else if (name == "trkpt") {
+                    add(lat.c_str(), lon.c_str(), ele.c_str(),
+                        time.c_str());
+                    in_pt = false;
+               }
+               continue;
+          }
+          bool const empty = t.back() == '/';
+          if (name == "trk") {
+               ntrk++;
+          } else if (ntrk != 1 || in_pt) {
+               continue;
+          } else if (name == "trkseg") {
+               if (++nseg > 1)
+                    throw std::runtime_error(
+                         "more then one track segment found");
+               in_seg = !empty;
+          } else if (name == "trkpt" && in_seg) {
+               lat = attribute(t, "lat");
+               lon = attribute(t, "lon");
+               ele.clear();
+               time.clear();
+               has_ele = has_time = false;
+               if (empty)
+                    add(lat.c_str(), lon.c_str(), "", "");
+               else
+                    in_pt = true;
+          }
+     }
+}
+
+// Converts the texts of a track point to coordinates and time.
+void parse_point(char const* lat, char const* lon, char const* ele,
+                 char const* time, Geogr_coord& g,
+                 boost::posix_time::ptime& t) {
+     using std::runtime_error;
+     using boost::posix_time::ptime;
+     using boost::posix_time::from_iso_extended_string;
+     char* str_end;
+     char tmp[20];
+
+     if (!*lat)
+          throw runtime_error("missing latitude");
+     g.phi = std::strtod(lat, &str_end);
+     if (*str_end != '\0' || !std::isfinite(g.phi))
+          throw runtime_error("invalid latitude");
+     if (g.phi < -90.0 || g.phi > 90.0)
+          throw runtime_error("latitude out of range");
+
+     if (!*lon)
+          throw runtime_error("missing longitude");
+     g.lambda = std::strtod(lon, &str_end);
+     if (*str_end != '\0' || !std::isfinite(g.lambda))
+          throw runtime_error("invalid longitude");
+     if (g.lambda < -180.0 || g.lambda >= 180.0)
+          throw runtime_error("longitude out of range");
+
+     if (!*ele)
+          throw runtime_error("missing elevation");
+     g.h = std::strtod(ele, &str_end);
+     if (*str_end != '\0' || !std::isfinite(g.h))
+          throw runtime_error("invalid elevation");
+
+     // "2021-06-11T16:01:53Z" --> "2021-06-11T16:01:53"
+     strncpy(tmp, time, 19);
+     tmp[19] = '\0';
+     if (!*tmp)
+          throw runtime_error("missing timestamp");
+     try {
+          t = ptime(from_iso_extended_string(tmp));
+     } catch (std::exception const&) {
+          throw runtime_error("invalid timestamp");
+     }
+}
+
+// Returns the square of the distance from p to the segment ab.
+double dist2(Cart_coord const& p, Cart_coord const& a,
+             Cart_coord const& b) {
+     double const ux = b.x - a.x, uy = b.y - a.y, uz = b.z - a.z;
+     double const wx = p.x - a.x, wy = p.y - a.y, wz = p.z - a.z;
+     double const uu = ux * ux + uy * uy + uz * uz;
+     double t = uu > 0.0 ? (ux * wx + uy * wy + uz * wz) / uu : 0.0;
+     t = std::clamp(t, 0.0, 1.0);
+     return sqr(wx - t * ux) + sqr(wy - t * uy) + sqr(wz - t * uz);
+}
+
+// Returns the square of the distance between the segments p1q1 and
+// p2q2, Ericson, Real-Time Collision Detection, section 5.1.9.
+double dist2(Cart_coord const& p1, Cart_coord const& q1,
+             Cart_coord const& p2, Cart_coord const& q2) {
+     double const d1[3] = {q1.x - p1.x, q1.y - p1.y, q1.z - p1.z};
+     double const d2[3] = {q2.x - p2.x, q2.y - p2.y, q2.z - p2.z};
+     double const r[3] = {p1.x - p2.x, p1.y - p2.y, p1.z - p2.z};
+     auto const dot = [](double const* u, double const* v) {
+          return u[0] * v[0] + u[1] * v[1] + u[2] * v[2];
+     };
+     double const a = dot(d1, d1), e = dot(d2, d2), f = dot(d2, r);
+     double s, t;
+     if (a <= 0.0 && e <= 0.0) {
+          s = t = 0.0;
+     } else if (a <= 0.0) {
+          s = 0.0;
+          t = std::clamp(f / e, 0.0, 1.0);
+     } else {
+          double const c = dot(d1, r);
+          if (e <= 0.0) {
+               t = 0.0;
+               s = std::clamp(-c / a, 0.0, 1.0);
+          } else {
+               double const b = dot(d1, d2);
+               double const denom = a * e - b * b;
+               s = denom > 0.0 ? std::clamp((b * f - c * e) / denom,
+                                            0.0, 1.0)
+                               : 0.0;
+               t = (b * s + f) / e;
+               if (t < 0.0) {
+                    t = 0.0;
+                    s = std::clamp(-c / a, 0.0, 1.0);
+               } else if (t > 1.0) {
+                    t = 1.0;
+                    s = std::clamp((b - c) / a, 0.0, 1.0);
+               }
+          }
+     }
+     double d = 0.0;
+     for (int i = 0; i < 3; i++)
+          d += sqr(r[i] + s * d1[i] - t * d2[i]);
+     return d;
+}
+
+// Sorts the range [first, last) of n items into sort-tile-recursive
+// order for nodes of capacity m. center(x, k) is the coordinate k of
+// the center of the item x.
+template <typename It, typename C>
+void str_sort(It first, It last, std::size_t m, C center) {
+     std::size_t const n = last - first;
+     std::size_t const p = (n + m - 1) / m;  // number of nodes
+     auto s = static_cast<std::size_t>(std::cbrt(p));
+     while (s * s * s < p)
+          s++;
+     auto const by = [&center](int k) {
+          return [&center, k](auto const& u, auto const& v) {
+               return center(u, k) < center(v, k);
+          };
+     };
+     std::sort(first, last, by(0));
+     std::size_t const slab = s * s * m, run = s * m;
+     for (std::size_t i = 0; i < n; i += slab) {
+          auto const e = std::min(n, i + slab);
+          std::sort(first + i, first + e, by(1));
+          for (std::size_t j = i; j < e; j += run)
+               std::sort(first + j, first + std::min(e, j + run),
+                         by(2));
+     }
+}
+
+// Returns the square of the distance from p to the box with corners
+// lo and hi.
+double box_dist2(Cart_coord const& p, double const* lo,
+                 double const* hi) {
+     double const c[3] = {p.x, p.y, p.z};
+     double d = 0.0;
+     for (int k = 0; k < 3; k++) {
+          if (c[k] < lo[k])
+               d += sqr(lo[k] - c[k]);
+          else if (c[k] > hi[k])
+               d += sqr(c[k] - hi[k]);
+     }
+     return d;
+}
+
+// Returns the paths of the files *.gpx and *.gpx.gz in the
+// directory dir sorted by name.
+std::vector<std::filesystem::path> gpx_files(
+     std::filesystem::path const& dir) {
+     namespace fs = std::filesystem;
+     std::vector<fs::path> v;
+     for (auto const& p : fs::directory_iterator(dir)) {
+          if (!fs::is_regular_file(p.path()))
+               continue;
+          if (p.path().extension() == ".gpx" ||
+              (p.path().extension() == ".gz" &&
+               p.path().stem().extension() == ".gpx"))
+               v.push_back(p.path());
+     }
+     std::sort(v.begin(), v.end(), [](auto const& a, auto const& b) {
+          return a.filename() < b.filename();
+     });
+     return v;
+}
+
+// Computes statistics for the file path. If scan is true,
+// GPX_data::scan() is used, otherwise GPX_data::parse().
+Activity_statistics::Result statistics(
+     std::filesystem::path const& path, bool scan) {
+     namespace io = boost::iostreams;
+     using std::ios_base;
+     GPX_data d;
+     io::filtering_streambuf<io::input> inbuf;
+     Activity_statistics::Result r;
+
+     if (path.extension() == ".gz")
+          inbuf.push(io::gzip_decompressor());
+     r.fname = path.filename().generic_string();
+     r.status = "failed";
+
+     try {
+          std::ifstream f(path, ios_base::in | ios_base::binary);
+          inbuf.push(f);
+          std::istream instream(&inbuf);
+          if (scan) {
+               d.scan(instream);
+          } else {
+               // When not using buf and calling d.parse(instream),
+               // on Windows an exception "no random access:
+               // iostream stream error" is thrown.
+               std::stringstream buf(ios_base::in | ios_base::out |
+                                     ios_base::binary);
+               buf << instream.rdbuf();
+               d.parse(buf);
+          }
+          if (d.state() == GPX_data::State::ok) {
+               r.status = "ok";
+               r.distance = d.distance();
+               r.distance_on_ellipsoid = d.distance_on_ellipsoid();
+               r.uphill = d.uphill();
+               r.downhill = d.downhill();
+               r.start_time = d.start_time();
+               r.end_time = d.end_time();
+               r.elapsed_time = d.elapsed_time();
+               r.elapsed_seconds = d.elapsed_seconds();
+               r.speedms = d.speedms();
+               r.speedkmh = d.speedkmh();
+          }
+     } catch (std::exception const& e) {
+          r.status += ": ";
+          r.status += e.what();
+     }
+     return r;
+}
+
+/**
+ * Converts the geographical coordinates \a phi, \a lambda (in
+ * degrees) and \a h to the Cartesian coordinates \a x, \a y, \a z.
+ */
+inline void to_cartesian(double phi, double lambda, double h,
+                         double& x, double& y, double& z) {
+     phi = degrees_to_radians(phi);
+     lambda = degrees_to_radians(lambda);
      double const sin_phi = std::sin(phi);
      double const cos_phi = std::cos(phi);
      double const c =
           semi_major_axis /
           std::sqrt(1.0 - eccentricity_squared * sin_phi * sin_phi);
-     double const d = c + g.h;
-     p.x = d * cos_phi * std::cos(lambda);
-     p.y = d * cos_phi * std::sin(lambda);
-     p.z = (one_minus_eccentricity_squared * c + g.h) * sin_phi;
+     double const d = c + h;
+     x = d * cos_phi * std::cos(lambda);
+     y = d * cos_phi * std::sin(lambda);
+     z = (one_minus_eccentricity_squared * c + h) * sin_phi;
+}
+
+}  // anonymous namespace
+
+void convert(Geogr_coord const& g, Cart_coord& p) {
+     to_cartesian(g.phi, g.lambda, g.h, p.x, p.y, p.z);
 }
 
 double distance(Cart_coord const& p, Cart_coord const& q) {
@@ -59,6 +454,16 @@ void GPX_data::parse(std::istream& f) {
      parse(doc);
 }
 
+void GPX_data::scan(std::istream& f) {
+     state_ = State::error;
+     start();
+     scan_points(f, [this](char const* lat, char const* lon,
+                           char const* ele, char const* time) {
+          add_point(lat, lon, ele, time);
+     });
+     finish();
+}
+
 void GPX_data::parse(char const* fname) {
      using std::runtime_error;
 
@@ -123,101 +528,66 @@ double GPX_data::speedkmh() const {
 }
 
 void GPX_data::parse(pugi::xml_document const& doc) {
-     using std::runtime_error;
-     using boost::posix_time::ptime;
-     using boost::posix_time::from_iso_extended_string;
+     start();
+     pugi::xml_node ns =
+          doc.child("gpx").child("trk").child("trkseg");
+     for (pugi::xml_node p = ns.first_child(); p;
+          p = p.next_sibling())
+          add_point(p.attribute("lat").value(),
+                    p.attribute("lon").value(), p.child_value("ele"),
+                    p.child_value("time"));
+     ns = ns.next_sibling();
+     if (ns)
+          throw std::runtime_error(
+               "more then one track segment found");
+     finish();
+}
 
+void GPX_data::start() {
      distance_ = 0.0;
      distance_on_ellipsoid_ = 0.0;
      uphill_ = 0.0;
      downhill_ = 0.0;
-     bool first = true;
-     Geogr_coord gcp;   // previous
+     ntrkpts_ = 0;
+}
+
+void GPX_data::add_point(char const* lat, char const* lon,
+                         char const* ele, char const* time) {
      Geogr_coord gcc;   // current
-     Geogr_coord gcep;  // previous on ellipsoid
      Geogr_coord gcec;  // current on ellipsoid
-     Cart_coord ccp;    // previous
      Cart_coord ccc;    // current
-     Cart_coord ccep;   // previous on ellipsoid
      Cart_coord ccec;   // current on ellipsoid
-     char* str_end;
-     char tmp[20];
      boost::posix_time::ptime ctime;
-     unsigned ntrkpts = 0;  // number of track points
-
-     gcp = {0.0, 0.0, 0.0};  // to shut up warnings
-     gcec.h = 0.0;
-     pugi::xml_node ns =
-          doc.child("gpx").child("trk").child("trkseg");
-     for (pugi::xml_node p = ns.first_child(); p;
-          p = p.next_sibling()) {
-          char const* v = p.attribute("lat").value();
-          if (!*v)
-               throw runtime_error("missing latitude");
-          gcec.phi = gcc.phi = std::strtod(v, &str_end);
-          if (*str_end != '\0' || !std::isfinite(gcc.phi))
-               throw runtime_error("invalid latitude");
-          if (gcc.phi < -90.0 || gcc.phi > 90.0)
-               throw runtime_error("latitude out of range");
-
-          v = p.attribute("lon").value();
-          if (!*v)
-               throw runtime_error("missing longitude");
-          gcec.lambda = gcc.lambda = std::strtod(v, &str_end);
-          if (*str_end != '\0' || !std::isfinite(gcc.lambda))
-               throw runtime_error("invalid longitude");
-          if (gcc.lambda < -180.0 || gcc.lambda >= 180.0)
-               throw runtime_error("longitude out of range");
-
-          v = p.child_value("ele");
-          if (!*v)
-               throw runtime_error("missing elevation");
-          gcc.h = std::strtod(v, &str_end);
-          if (*str_end != '\0' || !std::isfinite(gcc.h))
-               throw runtime_error("invalid elevation");
-
-          // "2021-06-11T16:01:53Z" --> "2021-06-11T16:01:53"
-          strncpy(tmp, p.child_value("time"), 19);
-          tmp[19] = '\0';
-          if (!*tmp)
-               throw runtime_error("missing timestamp");
-          try {
-               ctime = ptime(from_iso_extended_string(tmp));
-          } catch (std::exception const&) {
-               throw runtime_error("invalid timestamp");
-          }
-
-          convert(gcc, ccc);
-          convert(gcec, ccec);
 
-          if (first) {
-               start_time_ = end_time_ = ctime;
-               first = false;
-          } else {
-               distance_ += SHG::GPS::distance(ccp, ccc);
-               distance_on_ellipsoid_ +=
-                    SHG::GPS::distance(ccep, ccec);
-               if (gcc.h > gcp.h)
-                    uphill_ += gcc.h - gcp.h;
-               else if (gcc.h < gcp.h)
-                    downhill_ += gcp.h - gcc.h;
-               if (ctime < end_time_)
-                    throw runtime_error("timestamp mismatch");
-               end_time_ = ctime;
-          }
-          gcp = gcc;
-          ccp = ccc;
-          gcep = gcec;
-          ccep = ccec;
-          ntrkpts++;
+     parse_point(lat, lon, ele, time, gcc, ctime);
+     gcec = {gcc.phi, gcc.lambda, 0.0};
+     convert(gcc, ccc);
+     convert(gcec, ccec);
+
+     if (ntrkpts_ == 0) {
+          start_time_ = end_time_ = ctime;
+     } else {
+          distance_ += SHG::GPS::distance(ccp_, ccc);
+          distance_on_ellipsoid_ += SHG::GPS::distance(ccep_, ccec);
+          if (gcc.h > hp_)
+               uphill_ += gcc.h - hp_;
+          else if (gcc.h < hp_)
+               downhill_ += hp_ - gcc.h;
+          if (ctime < end_time_)
+               throw std::runtime_error("timestamp mismatch");
+          end_time_ = ctime;
      }
-     ns = ns.next_sibling();
-     if (ns)
-          throw runtime_error("more then one track segment found");
-     if (ntrkpts <= 1)
-          throw runtime_error("not enough track points");
+     hp_ = gcc.h;
+     ccp_ = ccc;
+     ccep_ = ccec;
+     ntrkpts_++;
+}
+
+void GPX_data::finish() {
+     if (ntrkpts_ <= 1)
+          throw std::runtime_error("not enough track points");
      if ((end_time_ - start_time_).total_seconds() < 1)
-          throw runtime_error("elapsed time is zero seconds");
+          throw std::runtime_error("elapsed time is zero seconds");
      state_ = State::ok;
 }
 
@@ -227,60 +597,348 @@ void GPX_data::check_state() const {
                "successfully call the method parse() first");
 }
 
-void Activity_statistics::run(std::filesystem::path const& dir) {
-     namespace fs = std::filesystem;
-     namespace io = boost::iostreams;
-     using std::ios_base;
-     GPX_data d;
+void Track::clear() {
+     phi.clear();
+     lambda.clear();
+     h.clear();
+     t.clear();
+}
 
-     for (auto const& p : fs::directory_iterator(dir)) {
-          if (!fs::is_regular_file(p.path()))
+void Track::push_back(Geogr_coord const& g, boost::int64_t time) {
+     phi.push_back(g.phi);
+     lambda.push_back(g.lambda);
+     h.push_back(g.h);
+     t.push_back(time);
+}
+
+void Track::read_gpx(std::istream& f) {
+     using boost::posix_time::ptime;
+     ptime const epoch(boost::gregorian::date(1970, 1, 1));
+     clear();
+     try {
+          scan_points(f, [this, &epoch](char const* lat,
+                                        char const* lon,
+                                        char const* ele,
+                                        char const* time) {
+               Geogr_coord g;
+               ptime pt;
+               parse_point(lat, lon, ele, time, g, pt);
+               boost::int64_t const s = (pt - epoch).total_seconds();
+               if (size() > 0 && s < t.back())
+                    throw std::runtime_error("timestamp mismatch");
+               push_back(g, s);
+          });
+     } catch (...) {
+          clear();
+          throw;
+     }
+}
+
+void write(Track const& tr, std::ostream& f) {
+     std::size_t const n = tr.size();
+     f.write(track_magic, sizeof track_magic);
+     f.write(reinterpret_cast<char const*>(&n), sizeof n);
+     f.write(reinterpret_cast<char const*>(tr.phi.data()),
+             n * sizeof(double));
+     f.write(reinterpret_cast<char const*>(tr.lambda.data()),
+             n * sizeof(double));
+     f.write(reinterpret_cast<char const*>(tr.h.data()),
+             n * sizeof(double));
+     f.write(reinterpret_cast<char const*>(tr.t.data()),
+             n * sizeof(boost::int64_t));
+}
+
+void read(Track& tr, std::istream& f) {
+     char magic[sizeof track_magic];
+     std::size_t n;
+     f.read(magic, sizeof magic);
+     f.read(reinterpret_cast<char*>(&n), sizeof n);
+     if (f.fail())
+          return;
+     if (!std::equal(magic, magic + sizeof magic, track_magic)) {
+          f.setstate(std::ios_base::failbit);
+          return;
+     }
+     Track u;
+     auto const get = [&f, n](auto& v) {
+          // Read in chunks not to allocate much for a bad n.
+          std::size_t const chunk = 1 << 16;
+          while (v.size() < n && f) {
+               auto const k = v.size();
+               v.resize(k + std::min(chunk, n - k));
+               f.read(reinterpret_cast<char*>(v.data() + k),
+                      (v.size() - k) * sizeof v[0]);
+          }
+     };
+     get(u.phi);
+     get(u.lambda);
+     get(u.h);
+     get(u.t);
+     if (f.fail())
+          return;
+     tr = std::move(u);
+}
+
+void convert(Track const& tr, Cart_track& c, bool on_ellipsoid) {
+     std::size_t const n = tr.size();
+     double const* const phi = tr.phi.data();
+     double const* const lambda = tr.lambda.data();
+     double const* const h = tr.h.data();
+     c.x.resize(n);
+     c.y.resize(n);
+     c.z.resize(n);
+     double* const x = c.x.data();
+     double* const y = c.y.data();
+     double* const z = c.z.data();
+     for (std::size_t i = 0; i < n; i++)
+          to_cartesian(phi[i], lambda[i], on_ellipsoid ? 0.0 : h[i],
+                       x[i], y[i], z[i]);
+}
+
+void segment_distances(Cart_track const& c, std::vector<double>& d) {
+     std::size_t const n = c.x.size();
+     d.resize(n > 0 ? n - 1 : 0);
+     double const* const x = c.x.data();
+     double const* const y = c.y.data();
+     double const* const z = c.z.data();
+     for (std::size_t i = 0; i + 1 < n; i++)
+          d[i] = std::hypot(x[i + 1] - x[i], y[i + 1] - y[i],
+                            z[i + 1] - z[i]);
+}
+
+void cumulative_distance(std::vector<double> const& d,
+                         std::vector<double>& s) {
+     s.resize(d.size() + 1);
+     s[0] = 0.0;
+     for (std::size_t i = 0; i < d.size(); i++)
+          s[i + 1] = s[i] + d[i];
+}
+
+void elevation_gain(std::vector<double> const& h, double threshold,
+                    double& uphill, double& downhill) {
+     if (!(threshold >= 0.0))
+          throw std::invalid_argument(__func__);
+     uphill = downhill = 0.0;
+     if (h.empty())
+          return;
+     double ref = h[0];
+     for (std::size_t i = 1; i < h.size(); i++) {
+          if (h[i] > ref) {
+               if (h[i] - ref >= threshold) {
+                    uphill += h[i] - ref;
+                    ref = h[i];
+               }
+          } else if (h[i] < ref) {
+               if (ref - h[i] >= threshold) {
+                    downhill += ref - h[i];
+                    ref = h[i];
+               }
+          }
+     }
+}
+
+void speeds(std::vector<double> const& d,
+            std::vector<boost::int64_t> const& t,
+            std::vector<double>& v) {
+     if (t.size() != d.size() + 1 && !(t.empty() && d.empty()))
+          throw std::invalid_argument(__func__);
+     v.resize(d.size());
+     for (std::size_t i = 0; i < d.size(); i++)
+          v[i] = d[i] / static_cast<double>(t[i + 1] - t[i]);
+}
+
+void Track_index::build(std::vector<Track> const& tracks) {
+     segs_.clear();
+     nodes_.clear();
+     Cart_track c;
+     for (std::size_t i = 0; i < tracks.size(); i++) {
+          convert(tracks[i], c);
+          std::size_t const n = c.x.size();
+          if (n == 1)
+               segs_.push_back({{c.x[0], c.y[0], c.z[0]},
+                                {c.x[0], c.y[0], c.z[0]},
+                                i});
+          for (std::size_t j = 0; j + 1 < n; j++)
+               segs_.push_back({{c.x[j], c.y[j], c.z[j]},
+                                {c.x[j + 1], c.y[j + 1], c.z[j + 1]},
+                                i});
+     }
+     if (segs_.empty())
+          return;
+
+     str_sort(segs_.begin(), segs_.end(), capacity,
+              [](Segment const& s, int k) {
+                   return k == 0   ? s.a.x + s.b.x
+                          : k == 1 ? s.a.y + s.b.y
+                                   : s.a.z + s.b.z;
+              });
+     for (std::size_t i = 0; i < segs_.size(); i += capacity) {
+          Node u{{}, i, std::min(segs_.size(), i + capacity), true};
+          for (int k = 0; k < 3; k++) {
+               u.box.lo[k] = std::numeric_limits<double>::infinity();
+               u.box.hi[k] = -u.box.lo[k];
+          }
+          for (std::size_t j = u.first; j < u.last; j++) {
+               Segment const& s = segs_[j];
+               double const a[3] = {s.a.x, s.a.y, s.a.z};
+               double const b[3] = {s.b.x, s.b.y, s.b.z};
+               for (int k = 0; k < 3; k++) {
+                    u.box.lo[k] =
+                         std::min({u.box.lo[k], a[k], b[k]});
+                    u.box.hi[k] =
+                         std::max({u.box.hi[k], a[k], b[k]});
+               }
+          }
+          nodes_.push_back(u);
+     }
+
+     // Pack each level into the next one until one node is left.
+     std::size_t first = 0;
+     while (nodes_.size() - first > 1) {
+          std::size_t const last = nodes_.size();
+          auto const b = nodes_.begin();
+          str_sort(b + first, b + last, capacity,
+                   [](Node const& u, int k) {
+                        return u.box.lo[k] + u.box.hi[k];
+                   });
+          for (std::size_t i = first; i < last; i += capacity) {
+               Node u{nodes_[i].box, i, std::min(last, i + capacity),
+                      false};
+               for (std::size_t j = u.first + 1; j < u.last; j++)
+                    for (int k = 0; k < 3; k++) {
+                         u.box.lo[k] = std::min(u.box.lo[k],
+                                                nodes_[j].box.lo[k]);
+                         u.box.hi[k] = std::max(u.box.hi[k],
+                                                nodes_[j].box.hi[k]);
+                    }
+               nodes_.push_back(u);
+          }
+          first = last;
+     }
+}
+
+template <typename F>
+void Track_index::search(Box const& q, F f) const {
+     if (nodes_.empty())
+          return;
+     std::vector<std::size_t> stack{nodes_.size() - 1};
+     while (!stack.empty()) {
+          Node const& u = nodes_[stack.back()];
+          stack.pop_back();
+          bool disjoint = false;
+          for (int k = 0; k < 3; k++)
+               if (u.box.hi[k] < q.lo[k] || u.box.lo[k] > q.hi[k])
+                    disjoint = true;
+          if (disjoint)
                continue;
-          io::filtering_streambuf<io::input> inbuf;
+          for (std::size_t i = u.first; i < u.last; i++)
+               if (u.leaf)
+                    f(segs_[i]);
+               else
+                    stack.push_back(i);
+     }
+}
 
-          if (p.path().extension() == ".gz" &&
-              p.path().stem().extension() == ".gpx") {
-               inbuf.push(io::gzip_decompressor());
-          } else if (p.path().extension() != ".gpx") {
+std::vector<std::size_t> Track_index::within(Cart_coord const& p,
+                                             double r) const {
+     return within(p, p, r);
+}
+
+std::vector<std::size_t> Track_index::within(Cart_coord const& a,
+                                             Cart_coord const& b,
+                                             double r) const {
+     double const r2 = r * r;
+     Box const q{{std::min(a.x, b.x) - r, std::min(a.y, b.y) - r,
+                  std::min(a.z, b.z) - r},
+                 {std::max(a.x, b.x) + r, std::max(a.y, b.y) + r,
+                  std::max(a.z, b.z) + r}};
+     std::vector<std::size_t> v;
+     search(q, [&](Segment const& s) {
+          if ((v.empty() || v.back() != s.track) &&
+              dist2(a, b, s.a, s.b) <= r2)
+               v.push_back(s.track);
+     });
+     std::sort(v.begin(), v.end());
+     v.erase(std::unique(v.begin(), v.end()), v.end());
+     return v;
+}
+
+std::vector<Track_index::Neighbour> Track_index::nearest(
+     Cart_coord const& p, std::size_t k) const {
+     // Best-first search. An entry (d, i, true) is the node i at
+     // distance at least d, (d, i, false) is the segment i at
+     // distance d.
+     using Entry = std::tuple<double, std::size_t, bool>;
+     std::priority_queue<Entry, std::vector<Entry>, std::greater<>>
+          queue;
+     std::vector<Neighbour> v;
+     std::vector<std::size_t> found;
+     if (!nodes_.empty() && k > 0)
+          queue.emplace(0.0, nodes_.size() - 1, true);
+     while (!queue.empty()) {
+          auto const [d, i, node] = queue.top();
+          queue.pop();
+          if (!node) {
+               std::size_t const t = segs_[i].track;
+               if (std::find(found.begin(), found.end(), t) !=
+                   found.end())
+                    continue;
+               found.push_back(t);
+               v.push_back({t, std::sqrt(d)});
+               if (v.size() == k)
+                    break;
                continue;
           }
-          Result r;
-          r.fname = p.path().filename().generic_string();
-          r.status = "failed";
-
-          try {
-               std::ifstream f(p.path(),
-                               ios_base::in | ios_base::binary);
-               inbuf.push(f);
-               std::istream instream(&inbuf);
-               // When not using buf and calling
-               // d.parse(instream), on Windows an exception "no
-               // random access: iostream stream error" is
-               // thrown.
-               std::stringstream buf(ios_base::in | ios_base::out |
-                                     ios_base::binary);
-               buf << instream.rdbuf();
-               d.parse(buf);
-               if (d.state() == GPX_data::State::ok) {
-                    r.status = "ok";
-                    r.distance = d.distance();
-                    r.distance_on_ellipsoid =
-                         d.distance_on_ellipsoid();
-                    r.uphill = d.uphill();
-                    r.downhill = d.downhill();
-                    r.start_time = d.start_time();
-                    r.end_time = d.end_time();
-                    r.elapsed_time = d.elapsed_time();
-                    r.elapsed_seconds = d.elapsed_seconds();
-                    r.speedms = d.speedms();
-                    r.speedkmh = d.speedkmh();
-               }
-          } catch (std::exception const& e) {
-               r.status += ": ";
-               r.status += e.what();
+          Node const& u = nodes_[i];
+          for (std::size_t j = u.first; j < u.last; j++) {
+               if (u.leaf)
+                    queue.emplace(dist2(p, segs_[j].a, segs_[j].b),
+                                  j, false);
+               else
+                    queue.emplace(box_dist2(p, nodes_[j].box.lo,
+                                            nodes_[j].box.hi),
+                                  j, true);
           }
-          results_.push_back(r);
      }
+     return v;
+}
+
+std::vector<std::vector<std::size_t>> Track_index::within(
+     std::vector<Cart_coord> const& p, double r,
+     unsigned nthreads) const {
+     std::vector<std::vector<std::size_t>> v(p.size());
+     parallel_for(
+          p.size(), [&](std::size_t i) { v[i] = within(p[i], r); },
+          nthreads);
+     return v;
+}
+
+std::vector<std::vector<Track_index::Neighbour>> Track_index::nearest(
+     std::vector<Cart_coord> const& p, std::size_t k,
+     unsigned nthreads) const {
+     std::vector<std::vector<Neighbour>> v(p.size());
+     parallel_for(
+          p.size(), [&](std::size_t i) { v[i] = nearest(p[i], k); },
+          nthreads);
+     return v;
+}
+
+void Activity_statistics::run(std::filesystem::path const& dir) {
+     for (auto const& p : gpx_files(dir))
+          results_.push_back(statistics(p, false));
+}
+
+void Activity_statistics::run(std::filesystem::path const& dir,
+                              unsigned nthreads) {
+     auto const files = gpx_files(dir);
+     auto const n = results_.size();
+     results_.resize(n + files.size());
+     parallel_for(
+          files.size(),
+          [&](std::size_t i) {
+               results_[n + i] = statistics(files[i], true);
+          },
+          nthreads);
 }
 
 }  // namespace SHG::GPS
@@ -6,6 +6,9 @@
 // #define GRSCFG_DEBUG
 
 #include <shg/grscfg.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
 #include <numeric>
 #ifdef GRSCFG_DEBUG
 #include <iostream>
@@ -26,6 +29,14 @@ void McKenzie::set_grammar(Vecprod const& vp) {
      s_.clear();
      map1.clear();
      map2.clear();
+     tn_ = -1;
+     tw_ = 0;
+     f_.clear();
+     slot_.clear();
+     fp_.clear();
+     cum_.clear();
+     cbase_.clear();
+     overflow_ = false;
 
      // Collect nonterminals and terminals.
      for (auto const& p : vp)
@@ -111,6 +122,38 @@ Vecsent McKenzie::generate(int count, int length) {
      return v;
 }
 
+Vecsent McKenzie::generate_fast(int count, int length,
+                               unsigned nthreads) {
+     if (count <= 0)
+          return {};
+     if (length > tn_)
+          build_tables(length);
+     if (overflow_)
+          return generate(count, length);
+     Vecsent v(count);
+     if (length < 1 || f(1, length) == 0.0)
+          return v;
+     int constexpr block = 64;
+     int const nb = (count + block - 1) / block;
+     // The block b takes the stream b of a Philox generator with a
+     // 64-bit seed drawn from mzt_, so the blocks share no numbers.
+     auto const half = [this]() {
+          return static_cast<std::uint64_t>(mzt_() * 0x1p32);
+     };
+     std::uint64_t const seed = half() << 32 | half();
+     Philox const g(seed);
+     parallel_for(
+          nb,
+          [&](std::size_t b) {
+               Philox h = g.substream(b);
+               int const e = std::min<int>((b + 1) * block, count);
+               for (int i = b * block; i < e; i++)
+                    fast_g(1, length, h, v[i]);
+          },
+          nthreads);
+     return v;
+}
+
 McKenzie::List McKenzie::f_f(int i, int n) {
      auto const p = std::make_pair(i, n);
      auto const it = map1.find(p);
@@ -217,4 +260,124 @@ Sentence McKenzie::f_g_prim(int i, int j, int k, int n) {
      }
 }
 
+void McKenzie::build_tables(int length) {
+     // tn_ is set when the tables are complete, so that they are
+     // built again if count() throws.
+     tn_ = -1;
+     tw_ = length + 1;
+     int const w = tw_;
+     int ns = 0, nc = 0;
+     slot_.assign(r_ + 1, {});
+     cbase_.assign(r_ + 1, 0);
+     for (int i = 1; i <= r_; i++) {
+          slot_[i].resize(s_[i] + 1);
+          for (int j = 1; j <= s_[i]; j++) {
+               slot_[i][j] = ns;
+               ns += t_(i, j);
+          }
+          cbase_[i] = nc;
+          nc += w * s_[i];
+     }
+     f_.assign((r_ + 1) * w, 0.0);
+     fp_.assign(ns * w, 0.0);
+     cum_.assign(nc, 0.0);
+     overflow_ = false;
+     std::vector<char> state;
+     for (int n = 1; n <= length; n++) {
+          state.assign(r_ + 1, 0);
+          for (int i = 1; i <= r_; i++)
+               count(i, n, state);
+          for (int i = 1; i <= r_; i++)
+               for (int j = 1; j <= s_[i]; j++)
+                    if (int const t = t_(i, j);
+                        t > 1 && !is_terminal(P_[i][j][t]))
+                         fp_[(slot_[i][j] + t - 1) * w + n] =
+                              f(P_[i][j][t], n);
+     }
+     tn_ = length;
+}
+
+/**
+ * Calculates f(i, n) and fp(i, j, k, n) for all j and k, assuming
+ * that the tables are filled for lengths less than n. The last
+ * nonterminal of a production of length greater than 1 is left to
+ * build_tables(), as it does not contribute to f(i, n). Only unit
+ * productions make f(i, n) depend on other values for the same n.
+ * \c state[i] is 0 before, 1 during and 2 after the calculation for
+ * i.
+ */
+void McKenzie::count(int i, int n, std::vector<char>& state) {
+     if (state[i] == 2)
+          return;
+     if (state[i] == 1)
+          ERROR();
+     state[i] = 1;
+     int const w = tw_;
+     double total = 0.0;
+     for (int j = 1; j <= s_[i]; j++) {
+          int const t = t_(i, j);
+          for (int k = t; k >= 1; k--) {
+               int const x = P_[i][j][k];
+               double v = 0.0;
+               if (is_terminal(x)) {
+                    if (k == t)
+                         v = n == 1 ? 1.0 : 0.0;
+                    else if (n > 1)
+                         v = fp(i, j, k + 1, n - 1);
+               } else if (k == t) {
+                    if (t > 1)
+                         continue;  // filled in build_tables()
+                    count(x, n, state);
+                    v = f(x, n);
+               } else {
+                    for (int el = 1; el <= n - t + k; el++)
+                         v += f(x, el) * fp(i, j, k + 1, n - el);
+               }
+               fp_[(slot_[i][j] + k - 1) * w + n] = v;
+          }
+          total += fp(i, j, 1, n);
+          cum_[cbase_[i] + n * s_[i] + j - 1] = total;
+     }
+     f_[i * w + n] = total;
+     if (!std::isfinite(total))
+          overflow_ = true;
+     state[i] = 2;
+}
+
+/**
+ * Appends to \c s a random string of length \c n derived from the
+ * nonterminal \c i. f(i, n) must be positive.
+ */
+void McKenzie::fast_g(int i, int n, Philox& g, Sentence& s) const {
+     double const* const c = &cum_[cbase_[i] + n * s_[i]];
+     double const u = g.uniopen() * c[s_[i] - 1];
+     int const j = std::upper_bound(c, c + s_[i] - 1, u) - c + 1;
+     int const t = t_(i, j);
+     for (int k = 1; k <= t; k++) {
+          int const x = P_[i][j][k];
+          if (is_terminal(x)) {
+               s.push_back(termnls_[x - r_]);
+               n--;
+          } else if (k == t) {
+               fast_g(x, n, g, s);
+          } else {
+               // Choose the length of the string derived from x.
+               double const v = g.uniopen() * fp(i, j, k, n);
+               double acc = 0.0;
+               int el = 0;
+               for (int e = 1; e <= n - t + k; e++)
+                    if (double const y =
+                             f(x, e) * fp(i, j, k + 1, n - e);
+                        y > 0.0) {
+                         el = e;
+                         acc += y;
+                         if (acc > v)
+                              break;
+                    }
+               fast_g(x, el, g, s);
+               n -= el;
+          }
+     }
+}
+
 }  // namespace SHG::PLP
@@ -0,0 +1,429 @@
+/**
+ * \file src/ifact.cc
+ * Integer factorization.
+ */
+
+#include <shg/ifact.h>
+#include <algorithm>
+#include <array>
+#include <bit>
+
+namespace SHG {
+
+namespace {
+
+#ifdef __SIZEOF_INT128__
+__extension__ typedef unsigned __int128 U128;
+#else
+using U128 = Uint128;
+#endif
+
+std::uint64_t low64(U128 const& x) {
+     return static_cast<std::uint64_t>(x & ~std::uint64_t{0});
+}
+
+U128 to_u128(Uint128 const& x) {
+     std::uint64_t const mask = ~std::uint64_t{0};
+     U128 const hi = static_cast<std::uint64_t>(x >> 64);
+     return hi << 64 | static_cast<std::uint64_t>(x & mask);
+}
+
+Uint128 from_u128(U128 const& x) {
+     return Uint128(low64(x >> 64)) << 64 | low64(x);
+}
+
+/**
+ * Returns the lower half of \f$xy\f$ and sets hi to the upper half.
+ */
+std::uint64_t mul_wide(std::uint64_t x, std::uint64_t y,
+                       std::uint64_t& hi) {
+     U128 const t = static_cast<U128>(x) * y;
+     hi = low64(t >> 64);
+     return static_cast<std::uint64_t>(t);
+}
+
+U128 mul_wide(U128 const& x, U128 const& y, U128& hi) {
+     std::uint64_t const x0 = low64(x), x1 = low64(x >> 64);
+     std::uint64_t const y0 = low64(y), y1 = low64(y >> 64);
+     U128 const p00 = static_cast<U128>(x0) * y0;
+     U128 const p01 = static_cast<U128>(x0) * y1;
+     U128 const p10 = static_cast<U128>(x1) * y0;
+     U128 const p11 = static_cast<U128>(x1) * y1;
+     U128 const mid = (p00 >> 64) + low64(p01) + low64(p10);
+     hi = p11 + (p01 >> 64) + (p10 >> 64) + (mid >> 64);
+     return (mid << 64) | low64(p00);
+}
+
+/**
+ * Arithmetic modulo odd n > 1 in Montgomery form with \f$R =
+ * 2^w\f$, where w is the number of bits of W. Numbers \f$x\f$ are
+ * represented by \f$xR \bmod n\f$ \cite montgomery-1985.
+ */
+template <typename W>
+class Montgomery {
+public:
+     explicit Montgomery(W const& n) : n_(n) {
+          // n * n = 1 mod 8, each step doubles the number of bits.
+          inv_ = n;
+          for (int i = 0; i < 7; i++)
+               inv_ *= 2 - n * inv_;
+          one_ = (W(0) - n) % n;
+          r2_ = one_;
+          for (int i = 0; i < std::numeric_limits<W>::digits; i++)
+               r2_ = add(r2_, r2_);
+     }
+     W const& n() const { return n_; }
+     W const& one() const { return one_; }
+     W to(W const& x) const { return mul(x % n_, r2_); }
+     W add(W const& x, W const& y) const {
+          W const s = x + y;
+          return s < x || s >= n_ ? s - n_ : s;
+     }
+     W sub(W const& x, W const& y) const {
+          return x >= y ? x - y : x - y + n_;
+     }
+     W mul(W const& x, W const& y) const {
+          W hi;
+          W const lo = mul_wide(x, y, hi);
+          return redc(hi, lo);
+     }
+     W pow(W x, W e) const {
+          W y = one_;
+          for (; e != 0; e >>= 1) {
+               if ((e & 1) != 0)
+                    y = mul(y, x);
+               x = mul(x, x);
+          }
+          return y;
+     }
+
+private:
+     /**
+      * Returns \f$(hi R + lo) R^{-1} \bmod n\f$ for \f$hi < n\f$. As
+      * \f$mn \equiv lo \pmod{R}\f$, the lower halves cancel.
+      */
+     W redc(W const& hi, W const& lo) const {
+          W mh;
+          mul_wide(W(lo * inv_), n_, mh);
+          return hi >= mh ? hi - mh : hi - mh + n_;
+     }
+
+     W n_;
+     W inv_{};  ///< n^{-1} mod R
+     W one_{};  ///< R mod n
+     W r2_{};   ///< R^2 mod n
+};
+
+/**
+ * Returns true if n is a strong probable prime to the base a.
+ */
+template <typename W>
+bool strong_probable_prime(Montgomery<W> const& m, W const& d,
+                           int s, W const& a) {
+     W const minus_one = m.n() - m.one();
+     W x = m.to(a);
+     if (x == 0)
+          return true;
+     x = m.pow(x, d);
+     if (x == m.one() || x == minus_one)
+          return true;
+     for (int r = 1; r < s; r++) {
+          x = m.mul(x, x);
+          if (x == minus_one)
+               return true;
+          if (x == m.one())
+               return false;
+     }
+     return false;
+}
+
+/**
+ * Miller-Rabin test of odd n > 1 to the bases [first, last).
+ */
+template <typename W, typename It>
+bool miller_rabin_bases(W const& n, It first, It last) {
+     Montgomery<W> const m(n);
+     W d = n - 1;
+     int s = 0;
+     while ((d & 1) == 0) {
+          d >>= 1;
+          s++;
+     }
+     for (; first != last; ++first)
+          if (!strong_probable_prime(m, d, s, W(*first)))
+               return false;
+     return true;
+}
+
+/**
+ * Divisibility by a small odd prime p. The number n is divisible by
+ * p if and only if \f$n p^{-1} \bmod 2^{64} \leq \lfloor (2^{64} -
+ * 1) / p \rfloor\f$.
+ */
+struct Small_prime {
+     std::uint32_t p;
+     std::uint64_t inv;
+     std::uint64_t lim;
+};
+
+constexpr std::uint32_t small_prime_bound = 1024;
+
+constexpr int count_small_primes() {
+     int k = 0;
+     for (int p = 3; p < static_cast<int>(small_prime_bound); p++)
+          if (is_primec(p))
+               k++;
+     return k;
+}
+
+constexpr auto small_primes = []() {
+     std::array<Small_prime, count_small_primes()> a{};
+     std::size_t k = 0;
+     for (int p = 3; p < static_cast<int>(small_prime_bound); p++) {
+          if (!is_primec(p))
+               continue;
+          std::uint64_t const q = p;
+          std::uint64_t inv = q;
+          for (int i = 0; i < 5; i++)
+               inv *= 2 - q * inv;
+          a[k++] = {static_cast<std::uint32_t>(p), inv,
+                    ~std::uint64_t{0} / q};
+     }
+     return a;
+}();
+
+/**
+ * Divides n by 2 and the small primes as many times as possible,
+ * appending the primes to f.
+ */
+void remove_small_factors(std::uint64_t& n,
+                          std::vector<std::uint64_t>& f) {
+     for (; n > 1 && (n & 1) == 0; n >>= 1)
+          f.push_back(2);
+     for (auto const& sp : small_primes) {
+          if (n < std::uint64_t{sp.p} * sp.p)
+               break;
+          for (std::uint64_t q; (q = n * sp.inv) <= sp.lim; n = q)
+               f.push_back(sp.p);
+     }
+}
+
+void remove_small_factors(U128& n, std::vector<U128>& f) {
+     for (; n > 1 && (n & 1) == 0; n >>= 1)
+          f.push_back(2);
+     for (auto const& sp : small_primes) {
+          if (n >> 64 == 0)
+               break;
+          for (; n % sp.p == 0; n /= sp.p)
+               f.push_back(sp.p);
+     }
+}
+
+/**
+ * Returns the greatest common divisor of a and odd b.
+ */
+std::uint64_t gcd_odd(std::uint64_t a, std::uint64_t b) {
+     // Binary algorithm, see \cite knuth-2002b, section 4.5.2,
+     // algorithm B.
+     if (a == 0)
+          return b;
+     a >>= std::countr_zero(a);
+     while (a != b) {
+          if (a > b)
+               std::swap(a, b);
+          b -= a;
+          b >>= std::countr_zero(b);
+     }
+     return a;
+}
+
+U128 gcd_odd(U128 a, U128 b) {
+     while (a != 0) {
+          U128 const t = b % a;
+          b = a;
+          a = t;
+     }
+     return b;
+}
+
+int bit_width(std::uint64_t x) {
+     return std::bit_width(x);
+}
+
+int bit_width(U128 const& x) {
+     std::uint64_t const hi = low64(x >> 64);
+     return hi != 0 ? 64 + std::bit_width(hi)
+                    : std::bit_width(low64(x));
+}
+
+/**
+ * Returns \f$\lfloor \sqrt{n} \rfloor\f$ for n > 0 by Newton's
+ * method started above the root.
+ */
+template <typename W>
+W isqrt(W const& n) {
+     W x = W(1) << ((bit_width(n) + 1) / 2);
+     for (;;) {
+          W const y = (x + n / x) >> 1;
+          if (y >= x)
+               return x;
+          x = y;
+     }
+}
+
+/**
+ * Returns a nontrivial divisor of odd composite n.
+ */
+template <typename W>
+W rho_divisor(W const& n) {
+     constexpr long batch = 128;
+     Montgomery<W> const m(n);
+     for (W c = 1;; c++) {
+          W const cm = m.to(c);
+          auto const f = [&](W const& x) {
+               return m.add(m.mul(x, x), cm);
+          };
+          W x, y = m.to(2), ys, q = m.one(), g = 1;
+          for (long r = 1; g == 1; r *= 2) {
+               x = y;
+               for (long i = 0; i < r; i++)
+                    y = f(y);
+               for (long k = 0; k < r && g == 1; k += batch) {
+                    ys = y;
+                    for (long i = 0; i < batch && i < r - k; i++) {
+                         y = f(y);
+                         q = m.mul(q, m.sub(x, y));
+                    }
+                    g = gcd_odd(q, n);
+               }
+          }
+          if (g == n) {
+               do {
+                    ys = f(ys);
+                    g = gcd_odd(m.sub(x, ys), n);
+               } while (g == 1);
+          }
+          if (g != n)
+               return g;
+     }
+}
+
+constexpr std::uint64_t bases64[]{2,      325,     9375,      28178,
+                                  450775, 9780504, 1795265022};
+constexpr std::uint32_t bases128[]{2,  3,  5,  7,  11, 13, 17,
+                                   19, 23, 29, 31, 37, 41, 43,
+                                   47, 53, 59, 61, 67, 71};
+
+/**
+ * Miller-Rabin test without trial division for odd n > 1.
+ */
+bool is_odd_prime(std::uint64_t n) {
+     return miller_rabin_bases(n, std::cbegin(bases64),
+                               std::cend(bases64));
+}
+
+bool is_odd_prime(U128 const& n) {
+     if (n >> 64 == 0)
+          return is_odd_prime(low64(n));
+     // 3317044064679887385961981, Sorenson and Webster 2015.
+     U128 const bound =
+          (static_cast<U128>(179817) << 64) | 0x51adc5b22410a5fdULL;
+     return miller_rabin_bases(
+          n, std::cbegin(bases128),
+          std::cbegin(bases128) + (n < bound ? 13 : 20));
+}
+
+/**
+ * Appends to f the prime factors of n having no factors less than
+ * small_prime_bound.
+ */
+template <typename W>
+void split(W const& n, std::vector<W>& f) {
+     std::vector<W> s{n};
+     while (!s.empty()) {
+          W const m = s.back();
+          s.pop_back();
+          if (m == 1)
+               continue;
+          if constexpr (!std::is_same_v<W, std::uint64_t>) {
+               if (m >> 64 == 0) {
+                    std::vector<std::uint64_t> g;
+                    split(low64(m), g);
+                    f.insert(f.end(), g.cbegin(), g.cend());
+                    continue;
+               }
+          }
+          if (m < W(small_prime_bound) * small_prime_bound ||
+              is_odd_prime(m)) {
+               f.push_back(m);
+          } else {
+               // Pollard's rho method needs sqrt(p) steps for p^2.
+               W const r = isqrt(m);
+               W const d = r * r == m ? r : rho_divisor(m);
+               s.push_back(d);
+               s.push_back(m / d);
+          }
+     }
+     std::sort(f.begin(), f.end());
+}
+
+}  // anonymous namespace
+
+bool is_prime64(std::uint64_t n) {
+     if (n < 2)
+          return false;
+     if ((n & 1) == 0)
+          return n == 2;
+     for (std::size_t i = 0; i < 16; i++) {
+          auto const& sp = small_primes[i];
+          if (n * sp.inv <= sp.lim)
+               return n == sp.p;
+     }
+     if (n < small_prime_bound)
+          return true;
+     return is_odd_prime(n);
+}
+
+bool is_prime128(Uint128 const& n) {
+     if (n >> 64 == 0)
+          return is_prime64(static_cast<std::uint64_t>(n));
+     if ((n & 1) == 0)
+          return false;
+     for (std::size_t i = 0; i < 16; i++)
+          if (n % small_primes[i].p == 0)
+               return false;
+     return is_odd_prime(to_u128(n));
+}
+
+std::vector<std::uint64_t> prime_factors64(std::uint64_t n) {
+     std::vector<std::uint64_t> f;
+     if (n < 2)
+          return f;
+     remove_small_factors(n, f);
+     split(n, f);
+     return f;
+}
+
+std::vector<Uint128> prime_factors128(Uint128 const& n) {
+     if (n >> 64 == 0) {
+          auto const f =
+               prime_factors64(static_cast<std::uint64_t>(n));
+          return std::vector<Uint128>(f.cbegin(), f.cend());
+     }
+     U128 m = to_u128(n);
+     std::vector<U128> f;
+     remove_small_factors(m, f);
+     if (m >> 64 == 0) {
+          for (auto const p : prime_factors64(low64(m)))
+               f.push_back(p);
+     } else {
+          split(m, f);
+     }
+     std::sort(f.begin(), f.end());
+     std::vector<Uint128> r;
+     for (auto const& p : f)
+          r.push_back(from_u128(p));
+     return r;
+}
+
+}  // namespace SHG
@@ -4,6 +4,9 @@
  */
 
 #include <shg/ipart.h>
+#include <algorithm>
+#include <cmath>
+#include <numeric>
 
 namespace SHG {
 
@@ -38,4 +41,116 @@ last:
      G = false;
 }
 
+namespace {
+
+/**
+ * Appends to tasks the subproblems of the subtree of prefix with the
+ * remaining sum r and the minimum next part m. The children of the
+ * node are children(r, m) and the subtree of the child i has
+ * count(r, i) partitions. Subtrees larger than size are split
+ * further, adjacent smaller ones are joined as long as their total
+ * does not exceed size.
+ */
+template <typename Ch, typename Cnt>
+void split(std::vector<int>& prefix, int r, int m, double size,
+           Ch children, Cnt count,
+           std::vector<Partition_task>& tasks) {
+     Partition_task t;
+     double s = 0.0;
+     bool open = false;
+     auto const flush = [&]() {
+          if (open) {
+               tasks.push_back(t);
+               open = false;
+               s = 0.0;
+          }
+     };
+     for (int const i : children(r, m)) {
+          double const c = count(r, i);
+          if (c > size && i < r) {
+               flush();
+               prefix.push_back(i);
+               split(prefix, r - i, i, size, children, count, tasks);
+               prefix.pop_back();
+          } else {
+               if (open && s + c > size)
+                    flush();
+               if (!open) {
+                    t.prefix = prefix;
+                    t.first = i;
+                    open = true;
+               }
+               t.last = i;
+               s += c;
+          }
+     }
+     flush();
+}
+
+}  // anonymous namespace
+
+std::vector<Partition_task> split_partitions(int n,
+                                             std::size_t ntasks) {
+     if (n < 1 || ntasks < 1)
+          SHG_THROW(std::invalid_argument, __func__);
+     // q[r][m] is the number of partitions of r into parts not less
+     // than m.
+     std::vector<std::vector<double>> q(
+          n + 1, std::vector<double>(n + 2, 0.0));
+     std::fill(q[0].begin(), q[0].end(), 1.0);
+     for (int r = 1; r <= n; r++)
+          for (int m = r; m >= 1; m--)
+               q[r][m] = q[r][m + 1] + q[r - m][m];
+     auto const children = [](int r, int m) {
+          std::vector<int> c;
+          for (int i = m; 2 * i <= r; i++)
+               c.push_back(i);
+          if (r >= m)
+               c.push_back(r);
+          return c;
+     };
+     auto const count = [&q](int r, int i) {
+          return i == r ? 1.0 : q[r - i][i];
+     };
+     double const size = std::max(1.0, q[n][1] / ntasks);
+     std::vector<Partition_task> tasks;
+     std::vector<int> prefix;
+     split(prefix, n, 1, size, children, count, tasks);
+     return tasks;
+}
+
+std::vector<Partition_task> split_ordered_partitions(
+     int n, std::size_t ntasks) {
+     if (n < 1 || ntasks < 1)
+          SHG_THROW(std::invalid_argument, __func__);
+     auto const children = [](int r, int) {
+          std::vector<int> c(r);
+          std::iota(c.begin(), c.end(), 1);
+          return c;
+     };
+     auto const count = [](int r, int i) {
+          return i == r ? 1.0 : std::ldexp(1.0, r - i - 1);
+     };
+     double const size =
+          std::max(1.0, std::ldexp(1.0, n - 1) / ntasks);
+     std::vector<Partition_task> tasks;
+     std::vector<int> prefix;
+     split(prefix, n, 1, size, children, count, tasks);
+     return tasks;
+}
+
+namespace IPART {
+
+int rest(int n, Partition_task const& t) {
+     int s = 0;
+     for (int const x : t.prefix) {
+          if (x < 1 || x >= n - s)
+               SHG_THROW(std::invalid_argument, __func__);
+          s += x;
+     }
+     return n - s;
+}
+
+}  // namespace IPART
+
 }  // namespace SHG
@@ -9,6 +9,8 @@
 #include <cmath>
 #include <stdexcept>
 #include <string>
+#include <utility>
+#include <vector>
 #include <shg/except.h>
 #include <shg/utils.h>
 
@@ -85,6 +87,67 @@ double weighted_median(SHG::Vecdouble const& x,
      return 0.5 * (x[k - 1] + x[l - 1]);
 }
 
+double median_unsorted(SHG::Vecdouble const& x) {
+     size_t const n = x.size();
+     if (n < 1)
+          throw invalid_argument(
+               "invalid dimension in median_unsorted");
+     std::vector<double> y(x.begin(), x.end());
+     auto const mid = y.begin() + n / 2;
+     std::nth_element(y.begin(), mid, y.end());
+     if (n % 2 == 1)
+          return *mid;
+     return 0.5 * (*std::max_element(y.begin(), mid) + *mid);
+}
+
+double weighted_median_unsorted(SHG::Vecdouble const& x,
+                                SHG::Vecdouble const& w) {
+     size_t const n = x.size();
+     if (n < 1 || w.size() != n)
+          throw invalid_argument(__func__);
+     std::vector<std::pair<double, double>> v(n);
+     double total = 0.0;
+     for (size_t i = 0; i < n; i++) {
+          if (w[i] < 0.0)
+               throw invalid_argument(__func__);
+          v[i] = {x[i], w[i]};
+          total += w[i];
+     }
+     if (total <= 0.0)  // all weights equal to 0
+          throw invalid_argument(__func__);
+     auto const less = [](std::pair<double, double> const& a,
+                          std::pair<double, double> const& b) {
+          return a.first < b.first;
+     };
+     double const half = 0.5 * total;
+     double acc = 0.0;  // weight of v[0], ..., v[lo - 1]
+     size_t lo = 0, hi = n;
+     while (hi - lo > 1) {
+          size_t const mid = lo + (hi - lo) / 2;
+          std::nth_element(v.begin() + lo, v.begin() + mid,
+                           v.begin() + hi, less);
+          double wl = 0.0;
+          for (size_t i = lo; i < mid; i++)
+               wl += v[i].second;
+          if (acc + wl >= half) {
+               hi = mid;
+          } else {
+               acc += wl;
+               lo = mid;
+          }
+     }
+     if (acc + v[lo].second > half)
+          return v[lo].first;
+     double upper = 0.0;
+     bool found = false;
+     for (size_t i = lo + 1; i < n; i++)
+          if (v[i].second > 0.0 && (!found || v[i].first < upper)) {
+               upper = v[i].first;
+               found = true;
+          }
+     return found ? 0.5 * (v[lo].first + upper) : v[lo].first;
+}
+
 Unilapmixmod::Degenerate_distribution::Degenerate_distribution()
      : Exception("degenerate distribution in m-step") {}
 
@@ -295,6 +295,416 @@ vector<double> Sample::srt(vector<double> const& v) {
      return x;
 }
 
+double order_statistic(std::vector<double>& x, std::size_t k) {
+     if (k >= x.size())
+          throw invalid_argument(__func__);
+     auto const it = x.begin() + k;
+     std::nth_element(x.begin(), it, x.end());
+     return *it;
+}
+
+double quantile(std::vector<double>& x, double p) {
+     if (x.empty())
+          throw invalid_argument(__func__);
+     SHG_VALIDATE(0 < p && p < 1);
+     return order_statistic(x, iceil(x.size() * p) - 1);
+}
+
+Order_statistics::Order_statistics(std::vector<double> const& support)
+     : x_(support), w_(), f_(), mask_(1) {
+     if (x_.empty())
+          throw invalid_argument(__func__);
+     std::sort(x_.begin(), x_.end());
+     x_.erase(std::unique(x_.begin(), x_.end()), x_.end());
+     w_.assign(x_.size(), 0.0);
+     f_.assign(x_.size() + 1, 0.0);
+     while (2 * mask_ <= x_.size())
+          mask_ *= 2;
+}
+
+void Order_statistics::insert(double x, double w) {
+     if (!(w >= 0.0))
+          throw invalid_argument(__func__);
+     add(index(x), w);
+}
+
+void Order_statistics::erase(double x, double w) {
+     std::size_t const i = index(x);
+     if (!(w >= 0.0) || w > w_[i])
+          throw invalid_argument(__func__);
+     add(i, -w);
+}
+
+void Order_statistics::assign(std::vector<double> const& w) {
+     std::size_t const m = x_.size();
+     if (w.size() != m)
+          throw invalid_argument(__func__);
+     for (std::size_t i = 0; i < m; i++)
+          if (!(w[i] >= 0.0))
+               throw invalid_argument(__func__);
+     w_ = w;
+     // Build the tree in linear time.
+     for (std::size_t i = 1; i <= m; i++)
+          f_[i] = w_[i - 1];
+     for (std::size_t i = 1; i <= m; i++) {
+          std::size_t const j = i + (i & (~i + 1));
+          if (j <= m)
+               f_[j] += f_[i];
+     }
+}
+
+double Order_statistics::total() const {
+     double s = 0.0;
+     for (std::size_t i = x_.size(); i > 0; i -= i & (~i + 1))
+          s += f_[i];
+     return s;
+}
+
+double Order_statistics::cdf(double x) const {
+     double const t = total();
+     if (!(t > 0.0))
+          throw invalid_argument(__func__);
+     std::size_t i =
+          std::upper_bound(x_.begin(), x_.end(), x) - x_.begin();
+     double s = 0.0;
+     for (; i > 0; i -= i & (~i + 1))
+          s += f_[i];
+     return s / t;
+}
+
+double Order_statistics::quantile(double p) const {
+     double const t = total();
+     if (!(t > 0.0))
+          throw invalid_argument(__func__);
+     SHG_VALIDATE(0 < p && p < 1);
+     return x_[search(p * t, false)];
+}
+
+double Order_statistics::median() const {
+     double const t = total();
+     if (!(t > 0.0))
+          throw invalid_argument(__func__);
+     double const half = 0.5 * t;
+     std::size_t const k = search(half, false);
+     std::size_t const l = search(half, true);
+     return k == l ? x_[k] : 0.5 * (x_[k] + x_[l]);
+}
+
+std::size_t Order_statistics::index(double x) const {
+     auto const it = std::lower_bound(x_.begin(), x_.end(), x);
+     if (it == x_.end() || *it != x)
+          throw invalid_argument(__func__);
+     return it - x_.begin();
+}
+
+void Order_statistics::add(std::size_t i, double w) {
+     w_[i] += w;
+     for (std::size_t j = i + 1; j < f_.size(); j += j & (~j + 1))
+          f_[j] += w;
+}
+
+std::size_t Order_statistics::search(double t, bool strict) const {
+     // Find the largest j such that the sum of f_[1], ..., f_[j]
+     // (ie. of the weights of points 0, ..., j - 1) is less than (or
+     // not greater than if strict) t.
+     std::size_t j = 0;
+     double s = 0.0;
+     for (std::size_t b = mask_; b > 0; b /= 2) {
+          std::size_t const k = j + b;
+          if (k < f_.size() &&
+              (strict ? s + f_[k] <= t : s + f_[k] < t)) {
+               j = k;
+               s += f_[k];
+          }
+     }
+     return std::min(j, x_.size() - 1);
+}
+
+void Moments::add(double x) {
+     if (n_ == 0) {
+          min_ = max_ = x;
+     } else if (x < min_) {
+          min_ = x;
+     } else if (x > max_) {
+          max_ = x;
+     }
+     double const n1 = n_;
+     double const n = ++n_;
+     double const d = x - mean_;
+     double const dn = d / n;
+     double const dn2 = dn * dn;
+     double const t = d * dn * n1;
+     mean_ += dn;
+     m4_ += t * dn2 * (n * n - 3.0 * n + 3.0) + 6.0 * dn2 * m2_ -
+            4.0 * dn * m3_;
+     m3_ += t * dn * (n - 2.0) - 3.0 * dn * m2_;
+     m2_ += t;
+}
+
+void Moments::merge(Moments const& other) {
+     if (other.n_ == 0)
+          return;
+     if (n_ == 0) {
+          *this = other;
+          return;
+     }
+     Moments const b = other;
+     double const na = n_, nb = b.n_, n = na + nb;
+     double const d = b.mean_ - mean_;
+     double const d2 = d * d;
+     double const nab = na * nb;
+     m4_ += b.m4_ +
+            d2 * d2 * nab * (na * na - nab + nb * nb) / (n * n * n) +
+            6.0 * d2 * (na * na * b.m2_ + nb * nb * m2_) / (n * n) +
+            4.0 * d * (na * b.m3_ - nb * m3_) / n;
+     m3_ += b.m3_ + d * d2 * nab * (na - nb) / (n * n) +
+            3.0 * d * (na * b.m2_ - nb * m2_) / n;
+     m2_ += b.m2_ + d2 * nab / n;
+     mean_ += d * nb / n;
+     n_ += b.n_;
+     min_ = std::min(min_, b.min_);
+     max_ = std::max(max_, b.max_);
+}
+
+std::size_t Moments::n() const {
+     return n_;
+}
+
+double Moments::mean() const {
+     if (n_ == 0)
+          throw invalid_argument(__func__);
+     return mean_;
+}
+
+double Moments::var() const {
+     if (n_ == 0)
+          throw invalid_argument(__func__);
+     return m2_ / n_;
+}
+
+double Moments::var1() const {
+     if (n_ < 2)
+          throw invalid_argument(__func__);
+     return m2_ / (n_ - 1.0);
+}
+
+double Moments::stddev() const {
+     return sqrt(var());
+}
+
+double Moments::skewness() const {
+     if (n_ == 0)
+          throw invalid_argument(__func__);
+     if (m2_ <= 0.0)
+          throw range_error(__func__);
+     return sqrt(static_cast<double>(n_)) * m3_ / pow(m2_, 1.5);
+}
+
+double Moments::kurtosis() const {
+     if (n_ == 0)
+          throw invalid_argument(__func__);
+     if (m2_ <= 0.0)
+          throw range_error(__func__);
+     return n_ * m4_ / (m2_ * m2_) - 3.0;
+}
+
+double Moments::min() const {
+     if (n_ == 0)
+          throw invalid_argument(__func__);
+     return min_;
+}
+
+double Moments::max() const {
+     if (n_ == 0)
+          throw invalid_argument(__func__);
+     return max_;
+}
+
+Quantile_sketch::Quantile_sketch(double compression)
+     : compression_(compression),
+       capacity_(compression >= 10.0
+                      ? static_cast<std::size_t>(5.0 * compression)
+                      : 0) {
+     SHG_VALIDATE(compression >= 10.0);
+}
+
+void Quantile_sketch::add(double x, double w) {
+     SHG_VALIDATE(std::isfinite(x) && w > 0.0 && std::isfinite(w));
+     if (total_ == 0.0) {
+          min_ = max_ = x;
+     } else if (x < min_) {
+          min_ = x;
+     } else if (x > max_) {
+          max_ = x;
+     }
+     total_ += w;
+     buffer_.push_back({x, w});
+     if (buffer_.size() >= capacity_)
+          compress();
+}
+
+void Quantile_sketch::merge(Quantile_sketch const& other) {
+     if (other.total_ == 0.0)
+          return;
+     other.compress();
+     vector<Centroid> const c = other.centroids_;
+     if (total_ == 0.0) {
+          min_ = other.min_;
+          max_ = other.max_;
+     } else {
+          min_ = std::min(min_, other.min_);
+          max_ = std::max(max_, other.max_);
+     }
+     total_ += other.total_;
+     buffer_.insert(buffer_.end(), c.begin(), c.end());
+     compress();
+}
+
+double Quantile_sketch::total() const {
+     return total_;
+}
+
+double Quantile_sketch::cdf(double x) const {
+     check_nonempty();
+     if (x < min_)
+          return 0.0;
+     if (x >= max_)
+          return 1.0;
+     compress();
+     double t0 = 0.0, x0 = min_, cum = 0.0;
+     for (auto const& c : centroids_) {
+          double const t1 = cum + 0.5 * c.weight;
+          if (x < c.mean)
+               return (t0 + (t1 - t0) * (x - x0) / (c.mean - x0)) /
+                      total_;
+          t0 = t1;
+          x0 = c.mean;
+          cum += c.weight;
+     }
+     return (t0 + (total_ - t0) * (x - x0) / (max_ - x0)) / total_;
+}
+
+double Quantile_sketch::quantile(double p) const {
+     check_nonempty();
+     SHG_VALIDATE(0 < p && p < 1);
+     compress();
+     double const t = p * total_;
+     auto const interpolate = [t](double t0, double x0, double t1,
+                                  double x1) {
+          return t1 > t0 ? x0 + (x1 - x0) * (t - t0) / (t1 - t0)
+                         : x1;
+     };
+     double t0 = 0.0, x0 = min_, cum = 0.0;
+     for (auto const& c : centroids_) {
+          double const t1 = cum + 0.5 * c.weight;
+          if (t <= t1)
+               return interpolate(t0, x0, t1, c.mean);
+          t0 = t1;
+          x0 = c.mean;
+          cum += c.weight;
+     }
+     return interpolate(t0, x0, total_, max_);
+}
+
+double Quantile_sketch::range() const {
+     return max() - min();
+}
+
+double Quantile_sketch::iqr() const {
+     return quantile(0.75) - quantile(0.25);
+}
+
+double Quantile_sketch::min() const {
+     check_nonempty();
+     return min_;
+}
+
+double Quantile_sketch::max() const {
+     check_nonempty();
+     return max_;
+}
+
+Sample::Histdata Quantile_sketch::histogram() const {
+     double h = 2.0 * pow(total(), -1.0 / 3.0) * iqr();
+     if (h < eps)
+          h = 2.0 * pow(total(), -1.0 / 3.0) * range();
+     if (h < eps)
+          return Sample::Histdata(0.0, 0.0);
+     return histogram(iceil(range() / h));
+}
+
+Sample::Histdata Quantile_sketch::histogram(int k) const {
+     check_nonempty();
+     if (k <= 0)
+          return Sample::Histdata(0.0, 0.0);
+     Sample::Histdata hd(min(), max());
+     hd.h = (hd.max - hd.min) / k;
+     if (hd.h >= eps) {
+          hd.f.resize(k);
+          double z = 0.0, z1, d;
+          for (int j = 0, j1 = 1; j < k; j++, j1++) {
+               z1 = j1 < k ? cdf(hd.min + hd.h * j1) : 1.0;
+               z1 /= hd.h;
+               d = hd.f[j] = z1 - z;
+               if (d > hd.maxheight)
+                    hd.maxheight = d;
+               z = z1;
+          }
+     }
+     return hd;
+}
+
+std::size_t Quantile_sketch::size() const {
+     compress();
+     return centroids_.size();
+}
+
+void Quantile_sketch::compress() const {
+     if (buffer_.empty())
+          return;
+     buffer_.insert(buffer_.end(), centroids_.begin(),
+                    centroids_.end());
+     std::sort(buffer_.begin(), buffer_.end(),
+               [](Centroid const& a, Centroid const& b) {
+                    return a.mean < b.mean;
+               });
+     double const c = compression_ / (2.0 * Constants::pi<double>);
+     // Returns the largest q such that k(q) - k(q0) <= 1 for the
+     // scale function k(q) = c * asin(2q - 1).
+     auto const limit = [c](double q0) {
+          double const k = c * std::asin(2.0 * q0 - 1.0) + 1.0;
+          if (k >= 0.5 * Constants::pi<double> * c)
+               return 1.0;
+          return 0.5 * (std::sin(k / c) + 1.0);
+     };
+     centroids_.clear();
+     Centroid cur = buffer_[0];
+     double sofar = 0.0;
+     double qlimit = limit(0.0);
+     for (std::size_t i = 1; i < buffer_.size(); i++) {
+          Centroid const& b = buffer_[i];
+          if ((sofar + cur.weight + b.weight) / total_ <= qlimit) {
+               cur.weight += b.weight;
+               cur.mean +=
+                    (b.mean - cur.mean) * b.weight / cur.weight;
+          } else {
+               sofar += cur.weight;
+               centroids_.push_back(cur);
+               qlimit = limit(sofar / total_);
+               cur = b;
+          }
+     }
+     centroids_.push_back(cur);
+     buffer_.clear();
+}
+
+void Quantile_sketch::check_nonempty() const {
+     if (total_ == 0.0)
+          throw invalid_argument("empty quantile sketch");
+}
+
+double const Quantile_sketch::eps = 1e-12;
+
 std::vector<std::vector<int>> run_length_distribution(
      std::vector<int> const& x, int m) {
      vector<vector<int>> v(m);
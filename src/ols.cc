@@ -5,10 +5,12 @@
  */
 
 #include <shg/ols.h>
+#include <algorithm>
 #include <cmath>
 #include <iomanip>
 #include <iostream>
 #include <limits>
+#include <optional>
 #include <shg/drbnwtsn.h>
 #include <shg/specfunc.h>
 #include <shg/utils.h>
@@ -25,88 +27,26 @@ OLS::Internal_error::Internal_error()
      : Exception("internal error in OLS") {}
 
 OLS::OLS(Matdouble const& X, Vecdouble const& y, bool add_intercept)
-     : problem_name_(),
-       n_(X.nrows()),
-       k_(add_intercept ? X.ncols() + 1 : X.ncols()),
-       dof_(n_ - k_),
-       intercept_(add_intercept),
-       beta_(k_),
-       ser_(),
-       r2_(),
-       rbar2_(),
-       var_(),
-       standard_err_(k_),
-       cov_(k_, k_),
-       fitted_(n_),
-       residuals_(n_),
-       rss_(0.0),
-       tss_(0.0),
-       ess_(),
-       mean_y_(),
-       stddev_y_(0.0),
-       positive_y_(true),
-       variation_y_(),
-       tstat_(k_, -1.0),
-       pvalt_(k_),
-       fstat_(-1.0),
-       pvalf_(),
-       dw_d_(-1.0),
-       dw_pvalpos_(-1.0),
-       dw_pvalneg_(-1.0) {
+     : OLS(X.nrows(), add_intercept ? X.ncols() + 1 : X.ncols(),
+           add_intercept) {
      if (n_ < 1 || k_ < 1 || n_ < k_ ||
          static_cast<std::size_t>(n_) != y.size())
           throw Invalid_argument();
 
-     estimate(X, y);
-
-     // Check cov_. Is this really needed? At least for cholesky?
-     for (int i = 0; i < k_; i++)
-          if (!(cov_(i, i) > 0.0))
-               throw Singular_covariance_matrix();
-
-     // Calculate mean of dependent variable, standard deviation of
-     // dependent variable, coefficient of variation of dependent
-     // variable and total sum of squares.
-
-     mean_y_ = y(0);
-     for (int i = 1; i < n_; i++) {
-          double const yi = y(i);
-          double const d = yi - mean_y_;
-          mean_y_ += d / (i + 1);
-          stddev_y_ += (yi - mean_y_) * d;
-          if (yi <= 0.0)
-               positive_y_ = false;
-     }
-     if (!(stddev_y_ >= 0.0))
-          throw Internal_error();
-     if (add_intercept) {
-          tss_ = stddev_y_;
-     } else {
-          for (int t = 0; t < n_; t++)
-               tss_ += sqr(y(t));
-     }
-     stddev_y_ = std::sqrt(stddev_y_ / n_);
-     if (positive_y_)
-          variation_y_ = stddev_y_ / mean_y_;
+     OLS_accumulator a(X.ncols(), add_intercept);
+     a.add(X, y);
+     estimate(a);
 
+     fitted_.resize(n_);
+     residuals_.resize(n_);
      if (dof_ == 0) {
           // If dof_ == 0, then n_ == k_. We assign:
           fitted_ = y;
           residuals_ = 0.0;
-          rss_ = 0.0;
-          ess_ = tss_;
-          r2_ = 1.0;
-          rbar2_ = 1.0;
-          var_ = 0.0;
-          ser_ = 0.0;
-          standard_err_ = 0.0;
-          cov_ = 0.0;
+          summarize();
           return;
      }
 
-     if (dof_ <= 0 || n_ <= k_)
-          throw Internal_error();
-
      // Calculate fitted values, residuals, rss.
      if (add_intercept) {
           for (int t = 0; t < n_; t++) {
@@ -129,57 +69,65 @@ OLS::OLS(Matdouble const& X, Vecdouble const& y, bool add_intercept)
                rss_ += e * e;
           }
      }
+     summarize();
+}
 
-     ess_ = tss_ - rss_;
-     if (ess_ < 0.0) {
-          rss_ = tss_;
-          ess_ = 0.0;
-     }
-
-     var_ = 1.0 / dof_ * rss_;
-     ser_ = std::sqrt(var_);
-
-     // Calculate covariance matrix of parameters, standard errors of
-     // parameters and t statistics.
-     for (int i = 0; i < k_; i++) {
-          double const s = standard_err_(i) =
-               std::sqrt(cov_(i, i) *= var_);
-          double const b = beta_(i);
-          if (std::abs(b / std::numeric_limits<double>::max()) < s) {
-               tstat_(i) = std::abs(b) / s;
-               pvalt_(i) = 2.0 * (1.0 - probst(tstat_(i), dof_));
+OLS::OLS(OLS_accumulator const& a)
+     : OLS(a.nobs(), a.nparams(), a.intercept()) {
+     if (n_ < 1 || k_ < 1 || n_ < k_)
+          throw Invalid_argument();
+     estimate(a);
+     if (dof_ > 0) {
+          // rss_ = w^T Z^T Z w, where w = (-beta_, 1).
+          Vecdouble w(k_ + 1);
+          for (int i = 0; i < k_; i++)
+               w(i) = -beta_(i);
+          w(k_) = 1.0;
+          double s = 0.0;
+          for (int i = 0; i <= k_; i++) {
+               double t = 0.0;
+               for (int j = i + 1; j <= k_; j++)
+                    t += a.zz_(i, j) * w(j);
+               s += w(i) * (a.zz_(i, i) * w(i) + 2.0 * t);
           }
-          for (int j = i + 1; j < k_; j++)
-               cov_(j, i) = cov_(i, j) *= var_;
-     }
-
-     // Calculate F-statistic.
-     double const eps = n_ / std::numeric_limits<double>::max();
-     double q;
-     if (tss_ > 0.0 && (q = rss_ / tss_) > eps) {
-          rbar2_ = 1.0 - (n_ - 1.0) / dof_ * q;
-          r2_ = 1.0 - q;
-          double const nk = static_cast<double>(n_) - k_;
-          if (add_intercept && k_ > 1)
-               // fstat_ = (ess_ / (k_ - 1)) / (rss_ / (n_ - k_));
-               fstat_ = (1.0 / q - 1.0) * nk / (k_ - 1.0);
-          else
-               // fstat_ = (ess_ / k_) / (rss_ / (n_ - k_));
-               fstat_ = (1.0 / q - 1.0) * nk / k_;
-          int const dfnum = add_intercept && k_ > 1 ? k_ - 1 : k_;
-          pvalf_ = 1.0 - cdffdist(dfnum, n_ - k_, fstat_);
-     } else {
-          // If tss_ == 0, then rss_ == ess_ == 0. All y(i) are
-          // constant. If there is no intercept, then y(i) = 0 for all
-          // i and a model with b(i) = 0 explains all. If there is an
-          // intercept, then y(i) = const for all i and a model with
-          // b(0) = const explains all.
-          r2_ = rbar2_ = 1.0;
+          rss_ = s > 0.0 ? s : 0.0;
      }
+     summarize();
 }
 
+OLS::OLS(int n, int k, bool add_intercept)
+     : problem_name_(),
+       n_(n),
+       k_(k),
+       dof_(n_ - k_),
+       intercept_(add_intercept),
+       beta_(k_),
+       ser_(),
+       r2_(),
+       rbar2_(),
+       var_(),
+       standard_err_(k_),
+       cov_(k_, k_),
+       fitted_(),
+       residuals_(),
+       rss_(0.0),
+       tss_(0.0),
+       ess_(),
+       mean_y_(),
+       stddev_y_(0.0),
+       positive_y_(true),
+       variation_y_(),
+       tstat_(k_, -1.0),
+       pvalt_(k_),
+       fstat_(-1.0),
+       pvalf_(),
+       dw_d_(-1.0),
+       dw_pvalpos_(-1.0),
+       dw_pvalneg_(-1.0) {}
+
 void OLS::dw() {
-     if (!intercept_ || k_ <= 1 || n_ < 6 || dof_ < 4 ||
+     if (residuals_.size() != static_cast<std::size_t>(n_) ||
+         !intercept_ || k_ <= 1 || n_ < 6 || dof_ < 4 ||
          rss_ < tolerance_)
           return;
      double x = 0.0;
@@ -289,52 +237,12 @@ void OLS::print(std::ostream& f) const {
      f.flags(opts);
 }
 
-void OLS::estimate(Matdouble const& X, Vecdouble const& y) {
+void OLS::estimate(OLS_accumulator const& a) {
      Vecdouble xty(k_);
-     if (intercept_) {
-          int i, i1, j, j1, l;
-          double s;
-          cov_(0, 0) = n_;
-          for (j = 1; j < k_; j++) {
-               s = 0.0;
-               j1 = j - 1;
-               for (l = 0; l < n_; l++)
-                    s += X(l, j1);
-               cov_(0, j) = s;
-          }
-          s = 0.0;
-          for (l = 0; l < n_; l++)
-               s += y(l);
-          xty(0) = s;
-          for (i = 1; i < k_; i++) {
-               i1 = i - 1;
-               for (j = i; j < k_; j++) {
-                    j1 = j - 1;
-                    s = 0.0;
-                    for (l = 0; l < n_; l++)
-                         s += X(l, i1) * X(l, j1);
-                    cov_(i, j) = s;
-               }
-               s = 0.0;
-               for (l = 0; l < n_; l++)
-                    s += X(l, i1) * y(l);
-               xty(i) = s;
-          }
-     } else {
-          int i, j, l;
-          double s;
-          for (i = 0; i < k_; i++) {
-               for (j = i; j < k_; j++) {
-                    s = 0.0;
-                    for (l = 0; l < n_; l++)
-                         s += X(l, i) * X(l, j);
-                    cov_(i, j) = s;
-               }
-               s = 0.0;
-               for (l = 0; l < n_; l++)
-                    s += X(l, i) * y(l);
-               xty(i) = s;
-          }
+     for (int i = 0; i < k_; i++) {
+          for (int j = i; j < k_; j++)
+               cov_(i, j) = a.zz_(i, j);
+          xty(i) = a.zz_(i, k_);
      }
      try {
           cholesky(cov_, tolerance_);
@@ -352,6 +260,92 @@ void OLS::estimate(Matdouble const& X, Vecdouble const& y) {
                s += cov_(i, j) * xty(j);
           beta_(i) = s;
      }
+
+     // Check cov_. Is this really needed? At least for cholesky?
+     for (int i = 0; i < k_; i++)
+          if (!(cov_(i, i) > 0.0))
+               throw Singular_covariance_matrix();
+
+     // Take mean of dependent variable, standard deviation of
+     // dependent variable, coefficient of variation of dependent
+     // variable and total sum of squares.
+
+     mean_y_ = a.mean_y_;
+     stddev_y_ = a.m2_y_;
+     positive_y_ = a.positive_y_;
+     if (!(stddev_y_ >= 0.0))
+          throw Internal_error();
+     if (intercept_)
+          tss_ = stddev_y_;
+     else
+          tss_ = a.zz_(k_, k_);
+     stddev_y_ = std::sqrt(stddev_y_ / n_);
+     if (positive_y_)
+          variation_y_ = stddev_y_ / mean_y_;
+}
+
+void OLS::summarize() {
+     if (dof_ == 0) {
+          rss_ = 0.0;
+          ess_ = tss_;
+          r2_ = 1.0;
+          rbar2_ = 1.0;
+          var_ = 0.0;
+          ser_ = 0.0;
+          standard_err_ = 0.0;
+          cov_ = 0.0;
+          return;
+     }
+
+     if (dof_ <= 0 || n_ <= k_)
+          throw Internal_error();
+
+     ess_ = tss_ - rss_;
+     if (ess_ < 0.0) {
+          rss_ = tss_;
+          ess_ = 0.0;
+     }
+
+     var_ = 1.0 / dof_ * rss_;
+     ser_ = std::sqrt(var_);
+
+     // Calculate covariance matrix of parameters, standard errors of
+     // parameters and t statistics.
+     for (int i = 0; i < k_; i++) {
+          double const s = standard_err_(i) =
+               std::sqrt(cov_(i, i) *= var_);
+          double const b = beta_(i);
+          if (std::abs(b / std::numeric_limits<double>::max()) < s) {
+               tstat_(i) = std::abs(b) / s;
+               pvalt_(i) = 2.0 * (1.0 - probst(tstat_(i), dof_));
+          }
+          for (int j = i + 1; j < k_; j++)
+               cov_(j, i) = cov_(i, j) *= var_;
+     }
+
+     // Calculate F-statistic.
+     double const eps = n_ / std::numeric_limits<double>::max();
+     double q;
+     if (tss_ > 0.0 && (q = rss_ / tss_) > eps) {
+          rbar2_ = 1.0 - (n_ - 1.0) / dof_ * q;
+          r2_ = 1.0 - q;
+          double const nk = static_cast<double>(n_) - k_;
+          if (intercept_ && k_ > 1)
+               // fstat_ = (ess_ / (k_ - 1)) / (rss_ / (n_ - k_));
+               fstat_ = (1.0 / q - 1.0) * nk / (k_ - 1.0);
+          else
+               // fstat_ = (ess_ / k_) / (rss_ / (n_ - k_));
+               fstat_ = (1.0 / q - 1.0) * nk / k_;
+          int const dfnum = intercept_ && k_ > 1 ? k_ - 1 : k_;
+          pvalf_ = 1.0 - cdffdist(dfnum, n_ - k_, fstat_);
+     } else {
+          // If tss_ == 0, then rss_ == ess_ == 0. All y(i) are
+          // constant. If there is no intercept, then y(i) = 0 for all
+          // i and a model with b(i) = 0 explains all. If there is an
+          // intercept, then y(i) = const for all i and a model with
+          // b(0) = const explains all.
+          r2_ = rbar2_ = 1.0;
+     }
 }
 
 char const* OLS::stars(double x) {
@@ -370,4 +364,277 @@ char const* OLS::stars(double x) {
 double const OLS::tolerance_ =
      100.0 * std::numeric_limits<double>::epsilon();
 
+OLS_accumulator::OLS_accumulator(int k, bool add_intercept)
+     : k_(add_intercept ? k + 1 : k),
+       intercept_(add_intercept),
+       zz_(),
+       z_() {
+     if (k < 0 || k_ < 1)
+          throw OLS::Invalid_argument();
+     zz_.assign(k_ + 1, k_ + 1, 0.0);
+     z_.assign(k_ + 1, 1.0);
+}
+
+void OLS_accumulator::add(double const* x, double y) {
+     std::copy(x, x + (intercept_ ? k_ - 1 : k_),
+               z_.begin() + (intercept_ ? 1 : 0));
+     z_(k_) = y;
+     update();
+}
+
+void OLS_accumulator::add(Matdouble const& X, Vecdouble const& y) {
+     std::size_t const k = intercept_ ? k_ - 1 : k_;
+     if (X.ncols() != k || X.nrows() != y.size())
+          throw OLS::Invalid_argument();
+     for (std::size_t l = 0; l < X.nrows(); l++)
+          add(X[l], y(l));
+}
+
+void OLS_accumulator::merge(OLS_accumulator const& a) {
+     if (a.k_ != k_ || a.intercept_ != intercept_)
+          throw OLS::Invalid_argument();
+     if (a.n_ == 0)
+          return;
+     for (int i = 0; i <= k_; i++)
+          for (int j = i; j <= k_; j++)
+               zz_(i, j) += a.zz_(i, j);
+     // Chan, Golub, LeVeque formula for combining variances.
+     double const n = static_cast<double>(n_) + a.n_;
+     double const d = a.mean_y_ - mean_y_;
+     mean_y_ += d * (a.n_ / n);
+     m2_y_ += a.m2_y_ + d * d * (n_ / n) * a.n_;
+     n_ += a.n_;
+     positive_y_ = positive_y_ && a.positive_y_;
+}
+
+void OLS_accumulator::update() {
+     int const m = k_ + 1;
+     double const* const z = z_.c_vec();
+     for (int i = 0; i < m; i++) {
+          double const zi = z[i];
+          double* const row = zz_[i];
+          for (int j = i; j < m; j++)
+               row[j] += zi * z[j];
+     }
+     double const y = z[k_];
+     double const d = y - mean_y_;
+     n_++;
+     mean_y_ += d / n_;
+     m2_y_ += (y - mean_y_) * d;
+     if (y <= 0.0)
+          positive_y_ = false;
+}
+
+Rolling_OLS::Rolling_OLS(Matdouble const& X, Vecdouble const& y,
+                         int window, bool add_intercept,
+                         bool expanding)
+     : k_(add_intercept ? X.ncols() + 1 : X.ncols()),
+       w_(window),
+       m_(),
+       intercept_(add_intercept),
+       r_(),
+       z_(),
+       beta_(),
+       standard_err_(),
+       ser_(),
+       r2_(),
+       fstat_(),
+       pvalt_(),
+       pvalf_() {
+     int const n = X.nrows();
+     if (k_ < 1 || w_ <= k_ || n < w_ ||
+         static_cast<std::size_t>(n) != y.size())
+          throw OLS::Invalid_argument();
+     m_ = n - w_ + 1;
+     r_.resize(k_ + 1, k_ + 1);
+     z_.resize(k_ + 1);
+     beta_.resize(m_, k_);
+     standard_err_.resize(m_, k_);
+     ser_.resize(m_);
+     r2_.resize(m_);
+     fstat_.resize(m_);
+     pvalt_.resize(m_, k_);
+     pvalf_.resize(m_);
+
+     refactor(X, y, 0, w_);
+     solve(0, w_);
+     for (int j = 1; j < m_; j++) {
+          int const last = j + w_ - 1;
+          if (expanding) {
+               load(X, y, last);
+               update(z_.c_vec());
+               solve(j, last + 1);
+               continue;
+          }
+          bool ok = j % w_ != 0;
+          if (ok) {
+               load(X, y, j - 1);
+               ok = downdate(z_.c_vec());
+          }
+          if (ok) {
+               load(X, y, last);
+               update(z_.c_vec());
+          } else {
+               refactor(X, y, j, last + 1);
+          }
+          solve(j, w_);
+     }
+}
+
+void Rolling_OLS::update(double* z) {
+     int const m = k_ + 1;
+     for (int i = 0; i < m; i++) {
+          double* const ri = r_[i];
+          double const a = ri[i];
+          double const b = z[i];
+          double const r = std::hypot(a, b);
+          if (r == 0.0)
+               continue;
+          double const c = a / r;
+          double const s = b / r;
+          ri[i] = r;
+          for (int j = i + 1; j < m; j++) {
+               double const t = ri[j];
+               ri[j] = c * t + s * z[j];
+               z[j] = c * z[j] - s * t;
+          }
+     }
+}
+
+bool Rolling_OLS::downdate(double* z) {
+     int const m = k_ + 1;
+     for (int i = 0; i < m; i++) {
+          double* const ri = r_[i];
+          double const a = ri[i];
+          double const b = z[i];
+          if (b == 0.0)
+               continue;
+          double const d = (a - b) * (a + b);
+          if (!(d > 0.0))
+               return false;
+          double const r = std::sqrt(d);
+          double const c = r / a;
+          double const s = b / a;
+          ri[i] = r;
+          for (int j = i + 1; j < m; j++) {
+               ri[j] = (ri[j] - s * z[j]) / c;
+               z[j] = c * z[j] - s * ri[j];
+          }
+     }
+     return true;
+}
+
+void Rolling_OLS::refactor(Matdouble const& X, Vecdouble const& y,
+                           int first, int last) {
+     r_ = 0.0;
+     for (int t = first; t < last; t++) {
+          load(X, y, t);
+          update(z_.c_vec());
+     }
+}
+
+void Rolling_OLS::load(Matdouble const& X, Vecdouble const& y,
+                       int t) {
+     if (intercept_) {
+          z_(0) = 1.0;
+          std::copy(X[t], X[t] + k_ - 1, z_.begin() + 1);
+     } else {
+          std::copy(X[t], X[t] + k_, z_.begin());
+     }
+     z_(k_) = y(t);
+}
+
+void Rolling_OLS::solve(int j, int nobs) {
+     double* const b = beta_[j];
+     double* const se = standard_err_[j];
+     double const nan = std::numeric_limits<double>::quiet_NaN();
+     // The window is singular if a column of Z is almost a linear
+     // combination of the preceding ones, that is, if r_(i, i) is
+     // small relative to the norm of the column i of r_, which is the
+     // norm of the column i of Z.
+     for (int i = 0; i < k_; i++) {
+          double c = 0.0;
+          for (int l = 0; l <= i; l++)
+               c += sqr(r_(l, i));
+          if (sqr(r_(i, i)) <= tolerance * c) {
+               std::fill(b, b + k_, nan);
+               std::fill(se, se + k_, nan);
+               std::fill(pvalt_[j], pvalt_[j] + k_, nan);
+               ser_(j) = r2_(j) = fstat_(j) = pvalf_(j) = nan;
+               return;
+          }
+     }
+     for (int i = k_ - 1; i >= 0; i--) {
+          double s = r_(i, k_);
+          for (int l = i + 1; l < k_; l++)
+               s -= r_(i, l) * b[l];
+          b[i] = s / r_(i, i);
+     }
+     double const rss = sqr(r_(k_, k_));
+     double tss = rss;
+     for (int i = intercept_ ? 1 : 0; i < k_; i++)
+          tss += sqr(r_(i, k_));
+     int const dof = nobs - k_;
+     double const var = rss / dof;
+     ser_(j) = std::sqrt(var);
+
+     // Diagonal of (R_X^T R_X)^{-1} = R_X^{-1} R_X^{-T} from the rows
+     // of R_X^{-1}, calculated by columns in z_.
+     for (int i = 0; i < k_; i++)
+          se[i] = 0.0;
+     for (int l = 0; l < k_; l++) {
+          // Column l of R_X^{-1}.
+          for (int i = l; i >= 0; i--) {
+               double s = i == l ? 1.0 : 0.0;
+               for (int p = i + 1; p <= l; p++)
+                    s -= r_(i, p) * z_(p);
+               z_(i) = s / r_(i, i);
+               se[i] += sqr(z_(i));
+          }
+     }
+     double* const pt = pvalt_[j];
+     for (int i = 0; i < k_; i++) {
+          se[i] = std::sqrt(se[i] * var);
+          double const t = std::abs(b[i]);
+          pt[i] = 0.0;
+          if (t / std::numeric_limits<double>::max() < se[i])
+               pt[i] = 2.0 * (1.0 - probst(t / se[i], dof));
+     }
+
+     double const eps = nobs / std::numeric_limits<double>::max();
+     double q;
+     fstat_(j) = -1.0;
+     pvalf_(j) = 0.0;
+     if (tss > 0.0 && (q = rss / tss) > eps) {
+          r2_(j) = 1.0 - q;
+          int const dfnum = intercept_ && k_ > 1 ? k_ - 1 : k_;
+          fstat_(j) = (1.0 / q - 1.0) * dof / dfnum;
+          pvalf_(j) = 1.0 - cdffdist(dfnum, dof, fstat_(j));
+     } else {
+          r2_(j) = 1.0;
+     }
+}
+
+std::vector<Rolling_OLS> rolling_ols(std::vector<Matdouble> const& X,
+                                     std::vector<Vecdouble> const& y,
+                                     int window, bool add_intercept,
+                                     bool expanding,
+                                     unsigned nthreads) {
+     if (X.size() != y.size())
+          throw OLS::Invalid_argument();
+     std::vector<std::optional<Rolling_OLS>> res(X.size());
+     parallel_for(
+          X.size(),
+          [&](std::size_t i) {
+               res[i].emplace(X[i], y[i], window, add_intercept,
+                              expanding);
+          },
+          nthreads);
+     std::vector<Rolling_OLS> v;
+     v.reserve(res.size());
+     for (auto& r : res)
+          v.push_back(std::move(*r));
+     return v;
+}
+
 }  // namespace SHG
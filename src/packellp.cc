@@ -269,9 +269,20 @@ void Congruent_regular::operator()(int k, std::vector<int> const& a) {
      }
 }
 
-void Congruent_regular::run() {
-     Ordered_partitions_generator g(n_, *this);
-     g.generate();
+void Congruent_regular::run(unsigned nthreads) {
+     auto const reduce = [](Congruent_regular& x,
+                            Congruent_regular const& y) {
+          if (!y.first_ && (x.first_ || y.area_ < x.area_)) {
+               x.p_ = y.p_;
+               x.area_ = y.area_;
+               x.first_ = false;
+          }
+     };
+     Congruent_regular const r =
+          parallel_ordered_partitions(n_, *this, reduce, nthreads);
+     p_ = r.p_;
+     area_ = r.area_;
+     first_ = r.first_;
 }
 
 std::size_t Congruent_regular::n() const {
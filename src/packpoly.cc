@@ -0,0 +1,187 @@
+/**
+ * \file src/packpoly.cc
+ * Packed polynomials.
+ */
+
+#include <shg/packpoly.h>
+
+namespace SHG::ALGEBRA {
+
+bool packed_order(Monomial_cmp cmp, Packed_order& order) {
+     if (cmp == lex_cmp)
+          order = Packed_order::lex;
+     else if (cmp == grlex_cmp)
+          order = Packed_order::grlex;
+     else if (cmp == grevlex_cmp)
+          order = Packed_order::grevlex;
+     else
+          return false;
+     return true;
+}
+
+Monomial_cmp monomial_cmp(Packed_order order) {
+     switch (order) {
+     case Packed_order::lex:
+          return lex_cmp;
+     case Packed_order::grlex:
+          return grlex_cmp;
+     case Packed_order::grevlex:
+          return grevlex_cmp;
+     }
+     throw std::invalid_argument(__func__);
+}
+
+Packed_layout::Packed_layout(int dim, Packed_order order)
+     : dim_(dim), order_(order), words_(1 + (dim + 7) / 8) {
+     if (dim < 1)
+          throw std::invalid_argument(
+               "packed monomial: invalid dimension");
+}
+
+void Packed_layout::pack(Monomial const& m, std::uint64_t* w) const {
+     if (m.dim() != dim_)
+          throw std::invalid_argument(
+               "packed monomial: bad number of variables");
+     std::fill(w, w + words_, 0);
+     for (int i = 0; i < dim_; i++) {
+          int const e = m[i];
+          if (e > max_exponent)
+               throw std::overflow_error(
+                    "packed monomial: exponent too large");
+          int const j = order_ == Packed_order::grevlex ? dim_ - 1 - i
+                                                        : i;
+          w[0] += e;
+          w[1 + j / 8] |= static_cast<std::uint64_t>(e)
+                          << (8 * (7 - j % 8));
+     }
+}
+
+Monomial Packed_layout::unpack(std::uint64_t const* w) const {
+     std::vector<int> e(dim_);
+     for (int i = 0; i < dim_; i++) {
+          int const j = order_ == Packed_order::grevlex ? dim_ - 1 - i
+                                                        : i;
+          e[i] = (w[1 + j / 8] >> (8 * (7 - j % 8))) & 0xff;
+     }
+     return Monomial(e);
+}
+
+void Element_coefficients::factors(Coef const& x, Coef const& y,
+                                   Coef& b, Coef& a) const {
+     b = as_->one();
+     a = x / y;
+}
+
+void Element_coefficients::normalize(Coef* first, Coef* last) const {
+     Coef const c = as_->one() / *first;
+     for (; first != last; ++first)
+          *first = as_->mul(c, *first);
+}
+
+Zp_coefficients::Zp_coefficients(Ring_Zn const* as)
+     : as_(as), p_(), pinv_(), r2_(), one_() {
+     int const n = as->n();
+     if (n < 3 || n % 2 == 0 || !as->is_field())
+          throw std::invalid_argument(
+               "Z_p coefficients: modulus is not an odd prime");
+     p_ = n;
+     std::uint32_t inv = p_;  // p * p = 1 mod 8
+     for (int i = 0; i < 4; i++)
+          inv *= 2 - p_ * inv;
+     pinv_ = -inv;
+     std::uint64_t const r = (std::uint64_t{1} << 32) % p_;
+     one_ = r;
+     r2_ = r * r % p_;
+}
+
+Zp_coefficients::Coef Zp_coefficients::from_element(
+     Element const& x) const {
+     std::uint64_t const v = as_->value(x);
+     return redc(v * r2_);
+}
+
+Element Zp_coefficients::to_element(Coef const& x) const {
+     return as_->element(redc(x));
+}
+
+Zp_coefficients::Coef Zp_coefficients::inv(Coef const& x) const {
+     if (x == 0)
+          throw std::invalid_argument(
+               "Z_p coefficients: division by zero");
+     Coef y = one_, z = x;
+     for (std::uint32_t n = p_ - 2; n > 0; n >>= 1) {
+          if (n & 1)
+               y = mul(y, z);
+          z = mul(z, z);
+     }
+     return y;
+}
+
+void Zp_coefficients::factors(Coef const& x, Coef const& y, Coef& b,
+                              Coef& a) const {
+     b = one_;
+     a = div(x, y);
+}
+
+void Zp_coefficients::normalize(Coef* first, Coef* last) const {
+     Coef const c = inv(*first);
+     for (; first != last; ++first)
+          *first = mul(c, *first);
+}
+
+Zp_coefficients::Coef Zp_coefficients::redc(std::uint64_t t) const {
+     std::uint32_t const m = static_cast<std::uint32_t>(t) * pinv_;
+     std::uint64_t const u =
+          (t + static_cast<std::uint64_t>(m) * p_) >> 32;
+     return u >= p_ ? u - p_ : u;
+}
+
+Fraction_free_coefficients::Coef
+Fraction_free_coefficients::from_element(Element const& x) const {
+     auto const& v = as_->value(x);
+     if (denominator(v) != 1)
+          throw std::invalid_argument(
+               "fraction-free coefficients: not an integer");
+     return numerator(v);
+}
+
+Element Fraction_free_coefficients::to_element(Coef const& x) const {
+     return as_->element(Field_Q::ET(x));
+}
+
+void Fraction_free_coefficients::factors(Coef const& x,
+                                         Coef const& y, Coef& b,
+                                         Coef& a) const {
+     Coef const d = gcd(x, y);
+     b = y / d;
+     a = x / d;
+     if (b < 0) {
+          b = -b;
+          a = -a;
+     }
+}
+
+void Fraction_free_coefficients::normalize(Coef* first,
+                                           Coef* last) const {
+     Coef d = 0;
+     for (auto it = first; it != last && d != 1; ++it)
+          d = gcd(d, *it);
+     if (*first < 0)
+          d = -d;
+     if (d != 1)
+          for (; first != last; ++first)
+               *first /= d;
+}
+
+Polynomial clear_denominators(Polynomial const& p) {
+     auto const q = dynamic_cast<Field_Q const*>(p.as());
+     if (q == nullptr)
+          throw std::invalid_argument(
+               "clear denominators: polynomial not over Q");
+     boost::multiprecision::cpp_int d = 1;
+     for (auto const& t : p.terms())
+          d = lcm(d, denominator(q->value(t.second)));
+     return p * q->element(Field_Q::ET(d));
+}
+
+}  // namespace SHG::ALGEBRA
@@ -11,10 +11,29 @@
 #include <iostream>
 #include <iomanip>
 #include <cmath>
+#include <functional>
+#include <limits>
+#include <tuple>
+#include <utility>
 #include <shg/utils.h>
 
 namespace SHG::PLP {
 
+namespace {
+
+/**
+ * Returns \f$\log(e^a + e^b)\f$.
+ */
+double log_add(double a, double b) {
+     if (a < b)
+          std::swap(a, b);
+     if (b == -std::numeric_limits<double>::infinity())
+          return a;
+     return a + std::log1p(std::exp(b - a));
+}
+
+}  // anonymous namespace
+
 std::ostream& operator<<(std::ostream& stream,
                          S_production const& sp) {
      stream << "{" << sp.prod << ", " << sp.prob << "}";
@@ -51,6 +70,9 @@ PCFG::PCFG(PCFG const& other)
        V_(other.V_),
        bp_(other.bp_),
        up_(other.up_),
+       by_left_(other.by_left_),
+       by_parent_(other.by_parent_),
+       log_space_(other.log_space_),
        nonterminal_names_(other.nonterminal_names_),
        terminal_names_(other.terminal_names_),
        nmap_(other.nmap_),
@@ -59,6 +81,8 @@ PCFG::PCFG(PCFG const& other)
        m_(other.m_),
        beta_(other.beta_),
        alpha_(other.alpha_),
+       nz_(other.nz_),
+       nz_begin_(other.nz_begin_),
        delta_(other.delta_),
        psi_(other.psi_),
        ftab_(other.ftab_),
@@ -72,6 +96,9 @@ PCFG::PCFG(PCFG&& other) noexcept
        V_(std::move(other.V_)),
        bp_(std::move(other.bp_)),
        up_(std::move(other.up_)),
+       by_left_(std::move(other.by_left_)),
+       by_parent_(std::move(other.by_parent_)),
+       log_space_(other.log_space_),
        nonterminal_names_(std::move(other.nonterminal_names_)),
        terminal_names_(std::move(other.terminal_names_)),
        nmap_(std::move(other.nmap_)),
@@ -80,6 +107,8 @@ PCFG::PCFG(PCFG&& other) noexcept
        m_(std::move(other.m_)),
        beta_(std::move(other.beta_)),
        alpha_(std::move(other.alpha_)),
+       nz_(std::move(other.nz_)),
+       nz_begin_(std::move(other.nz_begin_)),
        delta_(std::move(other.delta_)),
        psi_(std::move(other.psi_)),
        ftab_(std::move(other.ftab_)),
@@ -95,6 +124,9 @@ PCFG& PCFG::operator=(PCFG const& other) {
           V_ = other.V_;
           bp_ = other.bp_;
           up_ = other.up_;
+          by_left_ = other.by_left_;
+          by_parent_ = other.by_parent_;
+          log_space_ = other.log_space_;
           nonterminal_names_ = other.nonterminal_names_;
           terminal_names_ = other.terminal_names_;
           nmap_ = other.nmap_;
@@ -103,6 +135,8 @@ PCFG& PCFG::operator=(PCFG const& other) {
           m_ = other.m_;
           beta_ = other.beta_;
           alpha_ = other.alpha_;
+          nz_ = other.nz_;
+          nz_begin_ = other.nz_begin_;
           delta_ = other.delta_;
           psi_ = other.psi_;
           ftab_ = other.ftab_;
@@ -118,6 +152,9 @@ PCFG& PCFG::operator=(PCFG&& other) {
      V_ = std::move(other.V_);
      bp_ = std::move(other.bp_);
      up_ = std::move(other.up_);
+     by_left_ = std::move(other.by_left_);
+     by_parent_ = std::move(other.by_parent_);
+     log_space_ = other.log_space_;
      nonterminal_names_ = std::move(other.nonterminal_names_);
      terminal_names_ = std::move(other.terminal_names_);
      nmap_ = std::move(other.nmap_);
@@ -126,6 +163,8 @@ PCFG& PCFG::operator=(PCFG&& other) {
      m_ = std::move(other.m_);
      beta_ = std::move(other.beta_);
      alpha_ = std::move(other.alpha_);
+     nz_ = std::move(other.nz_);
+     nz_begin_ = std::move(other.nz_begin_);
      delta_ = std::move(other.delta_);
      psi_ = std::move(other.psi_);
      ftab_ = std::move(other.ftab_);
@@ -179,10 +218,6 @@ void PCFG::set(Vecprod const& vp, std::vector<double> const& prob,
 
      bp_.resize(n_);
      up_.resize(n_);
-     beta_.resize(n_);
-     alpha_.resize(n_);
-     delta_.resize(n_);
-     psi_.resize(n_);
 
      // Assign probabilities to productions.
      for (Vecprod::size_type i = 0; i < vp.size(); i++) {
@@ -199,6 +234,7 @@ void PCFG::set(Vecprod const& vp, std::vector<double> const& prob,
      }
      if (!probs_valid(tol))
           goto fail;
+     index_rules();
      return;
 fail:
      clear();
@@ -210,6 +246,8 @@ void PCFG::clear() {
      V_ = 0;
      bp_.clear();
      up_.clear();
+     by_left_.clear();
+     by_parent_.clear();
      nonterminal_names_.clear();
      terminal_names_.clear();
      nmap_.clear();
@@ -219,6 +257,8 @@ void PCFG::clear() {
      psi_.clear();
      beta_.clear();
      alpha_.clear();
+     nz_.clear();
+     nz_begin_.clear();
      delta_.clear();
      ftab_.clear();
      gtab_.clear();
@@ -256,7 +296,8 @@ double PCFG::prob(Sentence const& w) {
      check();
      set(w);
      fill_beta();
-     return beta_[0][0][m_ - 1];
+     double const b = beta(0, 0, m_ - 1);
+     return log_space_ ? std::exp(b) : b;
 }
 
 double PCFG::log_prob(Vecsent const& vs) {
@@ -270,6 +311,13 @@ double PCFG::log_prob(Vecsent const& vs) {
      return lp;
 }
 
+double PCFG::log_prob(Sentence const& w) {
+     check();
+     set(w);
+     fill_beta();
+     return sentence_log_prob();
+}
+
 double PCFG::prob_outside(Sentence const& w, Index k) {
      check();
      set(w);
@@ -278,9 +326,16 @@ double PCFG::prob_outside(Sentence const& w, Index k) {
                "k must be less than length of sentence");
      fill_beta();
      fill_alpha();
+     if (log_space_) {
+          double sum = chart_zero();
+          for (Index j = 0; j < n_; j++)
+               sum = log_add(sum, alpha(j, k, k) +
+                                       std::log(prob(j, w_[k])));
+          return std::exp(sum);
+     }
      double sum = 0.0;
      for (Index j = 0; j < n_; j++)
-          sum += alpha_[j][k][k] * prob(j, w_[k]);
+          sum += alpha(j, k, k) * prob(j, w_[k]);
      return sum;
 }
 
@@ -289,11 +344,56 @@ void PCFG::cyk(Sentence const& w, double& prob, Parse_tree& t) {
      set(w);
      fill_beta();
      fill_delta();
-     prob = delta_[0][0][m_ - 1];
+     prob = delta(0, 0, m_ - 1);
+     if (log_space_)
+          prob = std::exp(prob);
+     t.clear();
+     add_node(0, 0, m_ - 1, t);
+}
+
+void PCFG::log_cyk(Sentence const& w, double& logprob,
+                   Parse_tree& t) {
+     check();
+     set(w);
+     fill_beta();
+     fill_delta();
+     logprob = delta(0, 0, m_ - 1);
+     if (!log_space_)
+          logprob = std::log(logprob);
      t.clear();
      add_node(0, 0, m_ - 1, t);
 }
 
+void PCFG::beam_cyk(Sentence const& w, Index beam, double threshold,
+                    double& prob, Parse_tree& t, Beam_stats& stats) {
+     if (beam == 0)
+          throw std::invalid_argument("beam must be positive");
+     if (!(threshold >= 0.0 && threshold < 1.0))
+          throw std::invalid_argument("threshold must be in [0, 1)");
+     check();
+     set(w);
+     stats = Beam_stats();
+     fill_delta_beam(beam, threshold, stats);
+     if (delta(0, 0, m_ - 1) == chart_zero()) {
+          stats.fallback = true;
+          fill_beta();
+          fill_delta();
+     }
+     prob = delta(0, 0, m_ - 1);
+     if (log_space_)
+          prob = std::exp(prob);
+     t.clear();
+     add_node(0, 0, m_ - 1, t);
+}
+
+void PCFG::set_log_space(bool on) {
+     log_space_ = on;
+}
+
+bool PCFG::log_space() const {
+     return log_space_;
+}
+
 int PCFG::inside_outside(Vecsent const& vs, double accuracy,
                          double tol, int max_iter, int& iter,
                          double& logp) {
@@ -316,6 +416,14 @@ int PCFG::inside_outside(Vecsent const& vs, double accuracy,
      std::vector<Binary> bp_old;
      std::vector<Unary> up_old;
      double logp_old;
+     // The tables of one_iteration() hold probabilities. The mode is
+     // restored on return and when an exception is thrown.
+     struct Restore {
+          bool& flag;
+          bool const saved;
+          ~Restore() { flag = saved; }
+     } const restore{log_space_, log_space_};
+     log_space_ = false;
 
      iter = 0;
      init_tables(vs);
@@ -358,6 +466,82 @@ int PCFG::inside_outside(Vecsent const& vs, double accuracy,
      if (status > 2) {
           bp_ = bp_old;
           up_ = up_old;
+          index_rules();
+          logp = logp_old;
+     }
+     return status;
+}
+
+int PCFG::inside_outside(Vecsent const& vs, double accuracy,
+                         double tol, int max_iter, int& iter,
+                         double& logp, unsigned nthreads) {
+     check();
+     if (vs.empty())
+          throw std::invalid_argument("empty vector of sentences");
+     Corpus corpus(vs.size());
+     for (Index i = 0; i < vs.size(); i++) {
+          if (vs[i].empty())
+               throw std::invalid_argument("empty sentence");
+          for (auto const& w : vs[i])
+               if (auto const it = tmap_.find(w); it != tmap_.end())
+                    corpus[i].push_back(it->second);
+               else
+                    throw std::invalid_argument(
+                         "invalid terminal in sentence");
+     }
+     if (accuracy <= 0.0)
+          throw std::invalid_argument("accuracy must be positive");
+
+     int status = 0;
+     std::vector<Binary> bp_old;
+     std::vector<Unary> up_old;
+     double logp_old;
+     std::size_t const nt = number_of_threads(nthreads);
+     std::vector<PCFG> workers(std::min(nt, vs.size()));
+
+     iter = 0;
+     Counts c = expected_counts(corpus, workers, max_iter > 0);
+     if (!c.ok)
+          return 1;
+     logp = c.logp;
+     for (;;) {
+          if (iter >= max_iter) {
+               status = 2;
+               break;
+          }
+          iter++;
+          bp_old = bp_;
+          up_old = up_;
+          logp_old = logp;
+          if (c.small) {
+               status = 3;
+               break;
+          }
+          if (maximize(c) != 0) {
+               status = 4;
+               break;
+          }
+          if (!probs_valid(tol)) {
+               status = 5;
+               break;
+          }
+          c = expected_counts(corpus, workers, iter < max_iter);
+          if (!c.ok) {
+               status = 6;
+               break;
+          }
+          logp = c.logp;
+          if (logp < logp_old) {
+               status = 7;
+               break;
+          }
+          if (logp - logp_old < accuracy)
+               break;
+     }
+     if (status > 2) {
+          bp_ = bp_old;
+          up_ = up_old;
+          index_rules();
           logp = logp_old;
      }
      return status;
@@ -388,6 +572,7 @@ void PCFG::remove_productions(double eps) {
      }
      bp_ = bp;
      up_ = up;
+     index_rules();
 }
 
 void PCFG::check() const {
@@ -437,7 +622,7 @@ double PCFG::log_prob(Vecsent const& vs, bool& ok) {
      ok = true;
      double s = 0.0;
      for (auto const& w : vs) {
-          double const lp = std::log(prob(w));
+          double const lp = log_prob(w);
           if (!std::isfinite(lp)) {
                ok = false;
                return 0.0;
@@ -473,110 +658,254 @@ void PCFG::add_node(Index i, Index p, Index q, Parse_tree& t) {
           t.push_back(nd);
           return;
      }
-     auto const& psi = psi_[i][p][q];
-     t.data().prob = prob(i, psi.j, psi.k);
+     auto const& b = psi(i, p, q);
+     t.data().prob = prob(i, b.j, b.k);
      t.push_back(nd);
-     add_node(psi.j, p, psi.r, t[0]);
+     add_node(b.j, p, b.r, t[0]);
      t.push_back(nd);
-     add_node(psi.k, psi.r + 1, q, t[1]);
+     add_node(b.k, b.r + 1, q, t[1]);
 }
 
-void PCFG::fill_beta() {
-     for (Index j = 0; j < n_; j++) {
-          beta_[j].clear();
-          beta_[j].resize(m_);
-          for (Index p = 0; p < m_; p++) {
-               beta_[j][p].resize(m_);
-               beta_[j][p][p] = prob(j, w_[p]);
+PCFG::Index PCFG::cell(Index p, Index q) const {
+     Index const dg = q - p;
+     return dg * m_ - dg * (dg - 1) / 2 + p;
+}
+
+double& PCFG::beta(Index j, Index p, Index q) {
+     return beta_[cell(p, q) * n_ + j];
+}
+
+double& PCFG::alpha(Index j, Index p, Index q) {
+     return alpha_[cell(p, q) * n_ + j];
+}
+
+double& PCFG::delta(Index j, Index p, Index q) {
+     return delta_[cell(p, q) * n_ + j];
+}
+
+PCFG::Backtrace& PCFG::psi(Index j, Index p, Index q) {
+     return psi_[cell(p, q) * n_ + j];
+}
+
+void PCFG::index_rules() {
+     by_left_.assign(n_, {});
+     by_parent_.assign(n_, {});
+     for (Index j = 0; j < n_; j++)
+          for (auto const& b : bp_[j]) {
+               auto const [r, s] = b.first;
+               double const lp = std::log(b.second);
+               by_left_[r].push_back({j, s, b.second, lp});
+               by_parent_[j].push_back({r, s, b.second, lp});
           }
+}
+
+double PCFG::to_chart(double x) const {
+     return log_space_ ? std::log(x) : x;
+}
+
+double PCFG::chart_zero() const {
+     return log_space_ ? -std::numeric_limits<double>::infinity()
+                       : 0.0;
+}
+
+double PCFG::sentence_log_prob() {
+     double const b = beta(0, 0, m_ - 1);
+     return log_space_ ? b : std::log(b);
+}
+
+void PCFG::fill_beta() {
+     Index const nc = m_ * (m_ + 1) / 2;
+     double const zero = chart_zero();
+     beta_.assign(nc * n_, zero);
+     nz_.clear();
+     nz_begin_.resize(nc + 1);
+     nz_begin_[0] = 0;
+     for (Index p = 0; p < m_; p++) {
+          for (Index j = 0; j < n_; j++)
+               if ((beta(j, p, p) = to_chart(prob(j, w_[p]))) != zero)
+                    nz_.push_back(j);
+          nz_begin_[cell(p, p) + 1] = nz_.size();
      }
      for (Index dg = 1; dg < m_; dg++)
           for (Index p = 0; p < m_ - dg; p++) {
                Index const q = p + dg;
-               for (Index j = 0; j < n_; j++) {
-                    double sum = 0.0;
-                    for (auto const& b : bp_[j]) {
-                         for (Index d = p; d < q; d++)
-                              sum += b.second *
-                                     beta_[b.first.first][p][d] *
-                                     beta_[b.first.second][d + 1][q];
+               Index const c = cell(p, q);
+               double* const b = &beta_[c * n_];
+               for (Index d = p; d < q; d++) {
+                    Index const cl = cell(p, d);
+                    double const* const bl = &beta_[cl * n_];
+                    double const* const br = &beta(0, d + 1, q);
+                    Index const e = nz_begin_[cl + 1];
+                    for (Index i = nz_begin_[cl]; i < e; i++) {
+                         Index const r = nz_[i];
+                         double const x = bl[r];
+                         for (auto const& rule : by_left_[r]) {
+                              double const y = br[rule.b];
+                              if (y == zero)
+                                   continue;
+                              double& z = b[rule.a];
+                              if (log_space_)
+                                   z = log_add(z, rule.lprob + x + y);
+                              else
+                                   z += rule.prob * x * y;
+                         }
                     }
-                    beta_[j][p][q] = sum;
                }
+               for (Index j = 0; j < n_; j++)
+                    if (b[j] != zero)
+                         nz_.push_back(j);
+               nz_begin_[c + 1] = nz_.size();
           }
 }
 
 void PCFG::fill_alpha() {
-     for (Index j = 0; j < n_; j++) {
-          alpha_[j].clear();
-          alpha_[j].resize(m_);
-          for (auto& p : alpha_[j])
-               p.resize(m_);
-     }
-     alpha_[0][0][m_ - 1] = 1.0;
-     Index dg = m_ - 1;
-     while (dg-- > 0) {
+     double const zero = chart_zero();
+     alpha_.assign(m_ * (m_ + 1) / 2 * n_, zero);
+     alpha(0, 0, m_ - 1) = to_chart(1.0);
+     for (Index dg = m_ - 1; dg > 0; dg--)
           for (Index p = 0; p < m_ - dg; p++) {
                Index const q = p + dg;
                for (Index j = 0; j < n_; j++) {
-                    double sum = 0.0;
-                    for (Index f = 0; f < bp_.size(); f++) {
-                         for (auto const& b : bp_[f]) {
-                              if (b.first.first == j) {
-                                   Index const g = b.first.second;
-                                   for (Index e = q + 1; e < m_;
-                                        e++) {
-                                        sum += alpha_[f][p][e] *
-                                               b.second *
-                                               beta_[g][q + 1][e];
-                                   }
-                              }
-                              if (b.first.second == j) {
-                                   Index const g = b.first.first;
-                                   for (Index e = 0; e < p; e++)
-                                        sum += alpha_[f][e][q] *
-                                               b.second *
-                                               beta_[g][e][p - 1];
+                    double const a = alpha(j, p, q);
+                    if (a == zero)
+                         continue;
+                    for (auto const& rule : by_parent_[j]) {
+                         Index const r = rule.a;
+                         Index const s = rule.b;
+                         for (Index d = p; d < q; d++) {
+                              double const bl = beta(r, p, d);
+                              double const br = beta(s, d + 1, q);
+                              double& zl = alpha(r, p, d);
+                              double& zr = alpha(s, d + 1, q);
+                              if (log_space_) {
+                                   double const u = a + rule.lprob;
+                                   zl = log_add(zl, u + br);
+                                   zr = log_add(zr, u + bl);
+                              } else {
+                                   zl += a * rule.prob * br;
+                                   zr += a * rule.prob * bl;
                               }
                          }
                     }
-                    alpha_[j][p][q] = sum;
                }
           }
-     }
 }
 
 void PCFG::fill_delta() {
-     for (Index i = 0; i < n_; i++) {
-          delta_[i].clear();
-          delta_[i].resize(m_);
-          psi_[i].clear();
-          psi_[i].resize(m_);
-          for (Index p = 0; p < m_; p++) {
-               delta_[i][p].resize(m_);
-               delta_[i][p][p] = prob(i, w_[p]);
-               psi_[i][p].resize(m_);
+     Index const nc = m_ * (m_ + 1) / 2;
+     delta_.assign(nc * n_, chart_zero());
+     psi_.assign(nc * n_, {0, 0, 0});
+     for (Index p = 0; p < m_; p++)
+          for (Index i = 0; i < n_; i++)
+               delta(i, p, p) = to_chart(prob(i, w_[p]));
+     Index edges = 0;
+     for (Index dg = 1; dg < m_; dg++)
+          for (Index p = 0; p < m_ - dg; p++)
+               viterbi_cell(p, p + dg, edges);
+}
+
+void PCFG::viterbi_cell(Index p, Index q, Index& edges) {
+     double const zero = chart_zero();
+     // Returns true if (j, k, r) precedes b.
+     auto const precedes = [](Index j, Index k, Index r,
+                              Backtrace const& b) {
+          return std::tie(j, k, r) < std::tie(b.j, b.k, b.r);
+     };
+     Index const c = cell(p, q);
+     double* const dt = &delta_[c * n_];
+     Backtrace* const ps = &psi_[c * n_];
+     for (Index r = p; r < q; r++) {
+          Index const cl = cell(p, r);
+          double const* const dl = &delta_[cl * n_];
+          double const* const dr = &delta(0, r + 1, q);
+          // Nonzero delta is the same as nonzero beta.
+          Index const e = nz_begin_[cl + 1];
+          for (Index l = nz_begin_[cl]; l < e; l++) {
+               Index const j = nz_[l];
+               for (auto const& rule : by_left_[j]) {
+                    Index const k = rule.b;
+                    if (dr[k] == zero)
+                         continue;
+                    edges++;
+                    Index const i = rule.a;
+                    double const d = log_space_
+                                          ? rule.lprob + dl[j] + dr[k]
+                                          : rule.prob * dl[j] * dr[k];
+                    if (d > dt[i] || (d == dt[i] && d != zero &&
+                                      precedes(j, k, r, ps[i]))) {
+                         dt[i] = d;
+                         ps[i] = {j, k, r};
+                    }
+               }
+          }
+     }
+}
+
+void PCFG::fill_delta_beam(Index beam, double threshold,
+                           Beam_stats& stats) {
+     Index const nc = m_ * (m_ + 1) / 2;
+     double const zero = chart_zero();
+     double const lt = to_chart(threshold);
+     delta_.assign(nc * n_, zero);
+     psi_.assign(nc * n_, {0, 0, 0});
+     nz_.clear();
+     nz_begin_.resize(nc + 1);
+     nz_begin_[0] = 0;
+     std::vector<std::pair<double, Index>> v;
+     auto const prune = [&](Index p, Index q) {
+          Index const c = cell(p, q);
+          double* const dt = &delta_[c * n_];
+          if (p == 0 && q == m_ - 1) {
+               // Only N^0 is used in the root cell, so it is never
+               // pruned there.
+               if (dt[0] != zero) {
+                    nz_.push_back(0);
+                    stats.cells++;
+               }
+               nz_begin_[c + 1] = nz_.size();
+               return;
+          }
+          v.clear();
+          for (Index j = 0; j < n_; j++)
+               if (dt[j] != zero)
+                    v.emplace_back(dt[j], j);
+          if (!v.empty()) {
+               double const best =
+                    std::max_element(v.begin(), v.end())->first;
+               double const cut =
+                    log_space_ ? best + lt : best * threshold;
+               auto it = std::partition(
+                    v.begin(), v.end(),
+                    [cut](auto const& x) { return x.first >= cut; });
+               if (static_cast<Index>(it - v.begin()) > beam) {
+                    std::nth_element(v.begin(), v.begin() + beam, it,
+                                     std::greater<>());
+                    it = v.begin() + beam;
+               }
+               stats.pruned += v.end() - it;
+               for (auto i = it; i != v.end(); ++i)
+                    dt[i->second] = zero;
+               v.erase(it, v.end());
+               std::sort(v.begin(), v.end(),
+                         [](auto const& x, auto const& y) {
+                              return x.second < y.second;
+                         });
+               for (auto const& x : v)
+                    nz_.push_back(x.second);
+               if (!v.empty())
+                    stats.cells++;
           }
+          nz_begin_[c + 1] = nz_.size();
+     };
+     for (Index p = 0; p < m_; p++) {
+          for (Index i = 0; i < n_; i++)
+               delta(i, p, p) = to_chart(prob(i, w_[p]));
+          prune(p, p);
      }
      for (Index dg = 1; dg < m_; dg++)
           for (Index p = 0; p < m_ - dg; p++) {
-               Index const q = p + dg;
-               for (Index i = 0; i < n_; i++) {
-                    double max = 0.0;
-                    for (Index j = 0; j < n_; j++)
-                         for (Index k = 0; k < n_; k++)
-                              for (Index r = p; r < q; r++) {
-                                   double const d =
-                                        prob(i, j, k) *
-                                        delta_[j][p][r] *
-                                        delta_[k][r + 1][q];
-                                   if (d > max) {
-                                        max = d;
-                                        psi_[i][p][q] = {j, k, r};
-                                   }
-                              }
-                    delta_[i][p][q] = max;
-               }
+               viterbi_cell(p, p + dg, stats.edges);
+               prune(p, p + dg);
           }
 }
 
@@ -636,7 +965,7 @@ int PCFG::one_iteration(Vecsent const& vs) {
                w_[k] = tmap_.find(vs[i][k])->second;
           fill_beta();
           fill_alpha();
-          double const denominator = beta_[0][0][m_ - 1];
+          double const denominator = beta(0, 0, m_ - 1);
           if (denominator <= 1e-50)
                return 1;
           for (Index p = 0; p < m_; p++)
@@ -646,10 +975,10 @@ int PCFG::one_iteration(Vecsent const& vs) {
                               for (Index s = 0; s < n_; s++) {
                                    double sum = 0.0;
                                    for (Index d = p; d < q; d++)
-                                        sum += alpha_[j][p][q] *
+                                        sum += alpha(j, p, q) *
                                                prob(j, r, s) *
-                                               beta_[r][p][d] *
-                                               beta_[s][d + 1][q];
+                                               beta(r, p, d) *
+                                               beta(s, d + 1, q);
                                    ftab_[i][p][q][j][r][s] =
                                         sum / denominator;
                               }
@@ -657,16 +986,16 @@ int PCFG::one_iteration(Vecsent const& vs) {
                for (Index j = 0; j < n_; j++)
                     for (Index k = 0; k < V_; k++)
                          if (w_[h] == k)
-                              gtab_[i][h][j][k] = alpha_[j][h][h] *
-                                                  beta_[j][h][h] /
+                              gtab_[i][h][j][k] = alpha(j, h, h) *
+                                                  beta(j, h, h) /
                                                   denominator;
                          else
                               gtab_[i][h][j][k] = 0.0;
           for (Index p = 0; p < m_; p++)
                for (Index q = p; q < m_; q++)
                     for (Index j = 0; j < n_; j++)
-                         htab_[i][p][q][j] = alpha_[j][p][q] *
-                                             beta_[j][p][q] /
+                         htab_[i][p][q][j] = alpha(j, p, q) *
+                                             beta(j, p, q) /
                                              denominator;
      }
 
@@ -697,6 +1026,114 @@ int PCFG::one_iteration(Vecsent const& vs) {
                p.second = num / den;
           }
      }
+     index_rules();
+     return 0;
+}
+
+void PCFG::expected_counts(Corpus const& vs, Index begin, Index end,
+                           bool counts, Counts& c) {
+     c.binary.resize(n_);
+     for (Index j = 0; j < n_; j++)
+          c.binary[j].assign(by_parent_[j].size(), 0.0);
+     c.unary.assign(n_ * V_, 0.0);
+     c.total.assign(n_, 0.0);
+     c.logp = 0.0;
+     c.ok = true;
+     c.small = false;
+     for (Index i = begin; i < end; i++) {
+          w_ = vs[i];
+          m_ = w_.size();
+          fill_beta();
+          double const pi = beta(0, 0, m_ - 1);
+          double const lp = std::log(pi);
+          if (!std::isfinite(lp))
+               c.ok = false;
+          c.logp += lp;
+          if (pi <= 1e-50)
+               c.small = true;
+          if (!counts || c.small)
+               continue;
+          fill_alpha();
+          // (11.25) and (11.26) of manning-schutze-2003, page 400
+          for (Index dg = 1; dg < m_; dg++)
+               for (Index p = 0; p < m_ - dg; p++) {
+                    Index const q = p + dg;
+                    for (Index j = 0; j < n_; j++) {
+                         double const a = alpha(j, p, q);
+                         if (a == 0.0)
+                              continue;
+                         auto const& rules = by_parent_[j];
+                         for (Index k = 0; k < rules.size(); k++) {
+                              Index const r = rules[k].a;
+                              Index const s = rules[k].b;
+                              double sum = 0.0;
+                              for (Index d = p; d < q; d++)
+                                   sum += beta(r, p, d) *
+                                          beta(s, d + 1, q);
+                              c.binary[j][k] +=
+                                   a * rules[k].prob * sum / pi;
+                         }
+                    }
+               }
+          for (Index p = 0; p < m_; p++)
+               for (Index q = p; q < m_; q++)
+                    for (Index j = 0; j < n_; j++) {
+                         double const x =
+                              alpha(j, p, q) * beta(j, p, q) / pi;
+                         c.total[j] += x;
+                         if (p == q)
+                              c.unary[j * V_ + w_[p]] += x;
+                    }
+     }
+}
+
+PCFG::Counts PCFG::expected_counts(Corpus const& vs,
+                                   std::vector<PCFG>& workers,
+                                   bool counts) {
+     Index const nw = workers.size();
+     Index const omega = vs.size();
+     std::vector<Counts> c(nw);
+     parallel_for(
+          nw,
+          [&](std::size_t b) {
+               PCFG& w = workers[b];
+               w.n_ = n_;
+               w.V_ = V_;
+               w.up_ = up_;
+               w.by_left_ = by_left_;
+               w.by_parent_ = by_parent_;
+               w.expected_counts(vs, b * omega / nw,
+                                 (b + 1) * omega / nw, counts, c[b]);
+          },
+          nw);
+     Counts& c0 = c[0];
+     for (Index b = 1; b < nw; b++) {
+          for (Index j = 0; j < n_; j++)
+               for (Index k = 0; k < c0.binary[j].size(); k++)
+                    c0.binary[j][k] += c[b].binary[j][k];
+          for (Index i = 0; i < c0.unary.size(); i++)
+               c0.unary[i] += c[b].unary[i];
+          for (Index j = 0; j < n_; j++)
+               c0.total[j] += c[b].total[j];
+          c0.logp += c[b].logp;
+          c0.ok = c0.ok && c[b].ok;
+          c0.small = c0.small || c[b].small;
+     }
+     return std::move(c0);
+}
+
+int PCFG::maximize(Counts const& c) {
+     for (Index j = 0; j < n_; j++) {
+          double const den = c.total[j];
+          if (den <= 1e-50)
+               return 2;
+          Index k = 0;
+          for (auto& p : bp_[j])
+               p.second = c.binary[j][k++] / den;
+          for (auto& p : up_[j])
+               p.second = c.unary[j * V_ + p.first] / den;
+     }
+     index_rules();
      return 0;
 }
 
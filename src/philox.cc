@@ -0,0 +1,147 @@
+/**
+ * \file src/philox.cc
+ * Philox counter-based random number generator.
+ */
+
+#include <shg/philox.h>
+#include <shg/ziggurat.h>
+
+namespace SHG {
+
+namespace {
+
+constexpr std::uint32_t m0 = 0xd2511f53;
+constexpr std::uint32_t m1 = 0xcd9e8d57;
+constexpr std::uint32_t w0 = 0x9e3779b9;
+constexpr std::uint32_t w1 = 0xbb67ae85;
+
+inline std::uint64_t join(std::uint32_t lo, std::uint32_t hi) {
+     return std::uint64_t{hi} << 32 | lo;
+}
+
+}  // anonymous namespace
+
+Philox::Counter Philox::bijection(Counter c, Key k) {
+     for (int r = 0; r < 10; r++) {
+          if (r > 0) {
+               k[0] += w0;
+               k[1] += w1;
+          }
+          std::uint64_t const p0 = std::uint64_t{m0} * c[0];
+          std::uint64_t const p1 = std::uint64_t{m1} * c[2];
+          c = {static_cast<std::uint32_t>(p1 >> 32) ^ c[1] ^ k[0],
+               static_cast<std::uint32_t>(p1),
+               static_cast<std::uint32_t>(p0 >> 32) ^ c[3] ^ k[1],
+               static_cast<std::uint32_t>(p0)};
+     }
+     return c;
+}
+
+Philox::Philox(std::uint64_t seed, std::uint64_t stream)
+     : key_{static_cast<std::uint32_t>(seed),
+            static_cast<std::uint32_t>(seed >> 32)},
+       stream_(stream) {}
+
+double Philox::operator()() {
+     return Ziggurat::unit(bits());
+}
+
+std::uint64_t Philox::bits() {
+     if (pos_ % 2 == 0) {
+          buf_ = block(pos_ / 2);
+          pos_++;
+          return join(buf_[0], buf_[1]);
+     }
+     pos_++;
+     return join(buf_[2], buf_[3]);
+}
+
+Philox Philox::substream(std::uint64_t stream) const {
+     return Philox(seed(), stream);
+}
+
+void Philox::discard(std::uint64_t n) {
+     if (n == 0)
+          return;
+     pos_ += n;
+     if (pos_ % 2 == 1)
+          buf_ = block(pos_ / 2);
+}
+
+std::uint64_t Philox::seed() const {
+     return join(key_[0], key_[1]);
+}
+
+std::uint64_t Philox::stream() const {
+     return stream_;
+}
+
+void Philox::uniform(double* x, std::size_t n) {
+     generate(n,
+              [&x](std::uint64_t u) { *x++ = Ziggurat::unit(u); });
+}
+
+void Philox::normal(double* x, std::size_t n) {
+     auto w = [this]() { return bits(); };
+     for (std::size_t i = 0; i < n; i++)
+          x[i] = SHG::ziggurat_normal(w);
+}
+
+void Philox::exponential(double* x, std::size_t n) {
+     auto w = [this]() { return bits(); };
+     for (std::size_t i = 0; i < n; i++)
+          x[i] = SHG::ziggurat_exponential(w);
+}
+
+void Philox::write(std::ostream& f) const {
+     f.write(reinterpret_cast<char const*>(key_.data()),
+             sizeof key_[0] * key_.size());
+     f.write(reinterpret_cast<char const*>(&stream_), sizeof stream_);
+     f.write(reinterpret_cast<char const*>(&pos_), sizeof pos_);
+}
+
+void Philox::read(std::istream& f) {
+     Key key;
+     std::uint64_t stream, pos;
+     f.read(reinterpret_cast<char*>(key.data()),
+            sizeof key[0] * key.size());
+     if (f.fail())
+          return;
+     f.read(reinterpret_cast<char*>(&stream), sizeof stream);
+     if (f.fail())
+          return;
+     f.read(reinterpret_cast<char*>(&pos), sizeof pos);
+     if (f.fail())
+          return;
+     key_ = key;
+     stream_ = stream;
+     pos_ = 0;
+     discard(pos);
+}
+
+Philox::Counter Philox::block(std::uint64_t i) const {
+     return bijection({static_cast<std::uint32_t>(i),
+                       static_cast<std::uint32_t>(i >> 32),
+                       static_cast<std::uint32_t>(stream_),
+                       static_cast<std::uint32_t>(stream_ >> 32)},
+                      key_);
+}
+
+template <typename F>
+void Philox::generate(std::size_t n, F f) {
+     if (n > 0 && pos_ % 2 == 1) {
+          f(bits());
+          n--;
+     }
+     std::uint64_t i = pos_ / 2;
+     for (; n >= 2; n -= 2, i++) {
+          Counter const b = block(i);
+          f(join(b[0], b[1]));
+          f(join(b[2], b[3]));
+     }
+     pos_ = 2 * i;
+     if (n > 0)
+          f(bits());
+}
+
+}  // namespace SHG
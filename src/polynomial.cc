@@ -5,11 +5,157 @@
 
 #include <shg/polynomial.h>
 #include <algorithm>
+#include <cstdint>
+#include <stdexcept>
 #include <shg/except.h>
+#include <shg/packpoly.h>
 #include <shg/utils.h>
 
 namespace SHG::ALGEBRA {
 
+namespace {
+
+/**
+ * Terms with packed monomials in decreasing lex order.
+ */
+struct Lex_terms {
+     std::vector<std::uint64_t> m{};
+     std::vector<Element> c{};
+};
+
+/**
+ * Packs the terms of a polynomial in decreasing lex order, that is,
+ * in the reverse order of the map.
+ */
+void pack(Polynomial::Terms const& t, Packed_layout const& layout,
+          std::vector<std::uint64_t>& m,
+          std::vector<Element const*>& c) {
+     std::size_t const w = layout.words();
+     m.resize(t.size() * w);
+     c.clear();
+     for (auto it = t.crbegin(); it != t.crend(); ++it) {
+          layout.pack(it->first, m.data() + c.size() * w);
+          c.push_back(&it->second);
+     }
+}
+
+/**
+ * Multiplies the terms [i0, i1) of x by y with a heap of pairs of
+ * terms. The heap holds at most one pair (i, j) for each i. When
+ * (i, j) is removed, (i, j + 1) is inserted and, if j = 0, also
+ * (i + 1, 0), so the greatest remaining product is always on the
+ * heap.
+ */
+Lex_terms heap_multiply(Packed_layout const& layout, AS const* as,
+                        std::vector<std::uint64_t> const& xm,
+                        std::vector<Element const*> const& xc,
+                        std::size_t i0, std::size_t i1,
+                        std::vector<std::uint64_t> const& ym,
+                        std::vector<Element const*> const& yc) {
+     std::size_t const w = layout.words();
+     std::size_t const ny = yc.size();
+     Element const zero = as->zero();
+     std::vector<std::uint64_t> prod((i1 - i0) * w);
+     std::vector<std::size_t> ii(i1 - i0), jj(i1 - i0), heap;
+     heap.reserve(i1 - i0);
+     auto const less = [&](std::size_t a, std::size_t b) {
+          return layout.compare(prod.data() + a * w,
+                                prod.data() + b * w) < 0;
+     };
+     auto const insert = [&](std::size_t s, std::size_t i,
+                             std::size_t j) {
+          ii[s] = i;
+          jj[s] = j;
+          layout.mul(xm.data() + i * w, ym.data() + j * w,
+                     prod.data() + s * w);
+          heap.push_back(s);
+          std::push_heap(heap.begin(), heap.end(), less);
+     };
+     Lex_terms r;
+     std::vector<std::uint64_t> cur(w);
+     Element acc = zero;
+     bool first = true;
+     auto const flush = [&]() {
+          if (acc != zero) {
+               r.m.insert(r.m.end(), cur.cbegin(), cur.cend());
+               r.c.push_back(acc);
+          }
+     };
+     insert(0, i0, 0);
+     while (!heap.empty()) {
+          std::pop_heap(heap.begin(), heap.end(), less);
+          std::size_t const s = heap.back();
+          heap.pop_back();
+          std::size_t const i = ii[s], j = jj[s];
+          std::uint64_t const* const p = prod.data() + s * w;
+          Element const a = as->mul(*xc[i], *yc[j]);
+          if (first || layout.compare(p, cur.data()) != 0) {
+               if (!first)
+                    flush();
+               std::copy(p, p + w, cur.begin());
+               acc = a;
+               first = false;
+          } else {
+               acc = as->add(acc, a);
+          }
+          if (j == 0 && i + 1 < i1)
+               insert(i + 1 - i0, i + 1, 0);
+          if (j + 1 < ny)
+               insert(s, i, j + 1);
+     }
+     flush();
+     return r;
+}
+
+/**
+ * Adds two sums of terms.
+ */
+Lex_terms merge(Packed_layout const& layout, AS const* as,
+                Lex_terms const& x, Lex_terms const& y) {
+     std::size_t const w = layout.words();
+     Element const zero = as->zero();
+     std::size_t const nx = x.c.size(), ny = y.c.size();
+     std::size_t i = 0, j = 0;
+     Lex_terms r;
+     auto const append = [&](Lex_terms const& z, std::size_t k,
+                             Element const& a) {
+          r.m.insert(r.m.end(), z.m.cbegin() + k * w,
+                     z.m.cbegin() + (k + 1) * w);
+          r.c.push_back(a);
+     };
+     while (i < nx || j < ny) {
+          int c;
+          if (i == nx)
+               c = -1;
+          else if (j == ny)
+               c = 1;
+          else
+               c = layout.compare(x.m.data() + i * w,
+                                  y.m.data() + j * w);
+          if (c > 0) {
+               append(x, i, x.c[i]);
+               i++;
+          } else if (c < 0) {
+               append(y, j, y.c[j]);
+               j++;
+          } else {
+               Element const a = as->add(x.c[i], y.c[j]);
+               if (a != zero)
+                    append(x, i, a);
+               i++;
+               j++;
+          }
+     }
+     return r;
+}
+
+/**
+ * Minimum number of pairs of terms multiplied in one chunk.
+ */
+constexpr std::size_t min_chunk_pairs = 1 << 15;
+
+}  // anonymous namespace
+
 Polynomial::Polynomial(AS const* as) : Polynomial(as, 1) {}
 
 Polynomial::Polynomial(int dim) : Polynomial(&q_, dim) {}
@@ -96,13 +242,7 @@ Polynomial& Polynomial::operator-=(Polynomial const& x) {
 }
 
 Polynomial& Polynomial::operator*=(Polynomial const& x) {
-     if (!is_valid(*this, x))
-          SHG_THROW(std::invalid_argument, __func__);
-     Polynomial y(as_, dim_);
-     for (auto const& [m, a] : t_)
-          for (auto const& [mx, ax] : x.t_)
-               y.add(as_->mul(a, ax), m * mx);
-     t_ = y.t_;
+     *this = multiply(*this, x, 1);
      return *this;
 }
 
@@ -325,6 +465,60 @@ Polynomial one_var(std::vector<Element> const& a) {
      return x;
 }
 
+Polynomial multiply(Polynomial const& x, Polynomial const& y,
+                    unsigned nthreads) {
+     if (!Polynomial::is_valid(x, y))
+          SHG_THROW(std::invalid_argument, __func__);
+     AS const* const as = x.as_;
+     Polynomial z(as, x.dim_);
+     z.order_ = x.order_;
+     if (x.t_.empty() || y.t_.empty())
+          return z;
+     Packed_layout const layout(x.dim_, Packed_order::lex);
+     std::vector<std::uint64_t> xm, ym;
+     std::vector<Element const*> xc, yc;
+     try {
+          pack(x.t_, layout, xm, xc);
+          pack(y.t_, layout, ym, yc);
+          std::size_t const nx = xc.size();
+          std::size_t const nchunks = std::min<std::size_t>(
+               {number_of_threads(nthreads), nx,
+                std::max<std::size_t>(
+                     nx * yc.size() / min_chunk_pairs, 1)});
+          std::vector<Lex_terms> chunk(nchunks);
+          parallel_for(
+               nchunks,
+               [&](std::size_t k) {
+                    chunk[k] = heap_multiply(
+                         layout, as, xm, xc, nx * k / nchunks,
+                         nx * (k + 1) / nchunks, ym, yc);
+               },
+               nchunks);
+          while (chunk.size() > 1) {
+               std::vector<Lex_terms> next((chunk.size() + 1) / 2);
+               for (std::size_t k = 0; k < next.size(); k++)
+                    if (2 * k + 1 < chunk.size())
+                         next[k] = merge(layout, as, chunk[2 * k],
+                                         chunk[2 * k + 1]);
+                    else
+                         next[k] = std::move(chunk[2 * k]);
+               chunk.swap(next);
+          }
+          Lex_terms& r = chunk.front();
+          std::size_t const w = layout.words();
+          for (std::size_t k = r.c.size(); k-- > 0;)
+               z.t_.emplace_hint(z.t_.end(),
+                                 layout.unpack(r.m.data() + k * w),
+                                 std::move(r.c[k]));
+     } catch (std::overflow_error const&) {
+          z.t_.clear();
+          for (auto const& [m, a] : x.t_)
+               for (auto const& [my, ay] : y.t_)
+                    z.add(as->mul(a, ay), m * my);
+     }
+     return z;
+}
+
 Polynomial_ring::Polynomial_ring(AS const* as)
      : Polynomial_ring(as, 1) {
      if (as == nullptr)
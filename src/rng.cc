@@ -5,12 +5,15 @@
  */
 
 #include <shg/rng.h>
+#include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include <cstdlib>
 #include <limits>
 #include <stdexcept>
 #include <shg/except.h>
 #include <shg/mconsts.h>
+#include <shg/ziggurat.h>
 
 namespace SHG {
 
@@ -24,6 +27,45 @@ using std::size_t;
 using std::sqrt;
 using std::tan;
 
+namespace {
+
+/**
+ * Returns a 64-bit word with the highest 53 bits taken from one
+ * uniform number and the lowest 11 bits from another.
+ */
+std::uint64_t word(RNG& g) {
+     auto const u = static_cast<std::uint64_t>(g() * 0x1p53);
+     auto const v = static_cast<std::uint64_t>(g() * 0x1p11);
+     return u << 11 | (v & 0x7ff);
+}
+
+/**
+ * Returns \f$\log k!\f$ for an integer \f$k \geq 0\f$, from a
+ * table for \f$k < 10\f$ and from the Stirling series otherwise
+ * \cite hormann-1993. Unlike std::lgamma(), it does not set the
+ * global variable signgam, so it may be called in many threads.
+ */
+double log_factorial(double k) {
+     static double const t[10]{0.0,
+                               0.0,
+                               0.69314718055994530942,
+                               1.79175946922805500081,
+                               3.17805383034794561964,
+                               4.78749174278204599425,
+                               6.57925121201010099506,
+                               8.52516136106541430017,
+                               10.60460290274525022842,
+                               12.80182748008146961121};
+     if (k < 10.0)
+          return t[static_cast<int>(k)];
+     double const k1 = k + 1.0;
+     double const r = 1.0 / (k1 * k1);
+     return (k + 0.5) * log(k1) - k1 + 0.91893853320467274178 +
+            (1.0 / 12.0 - (1.0 / 360.0 - r / 1260.0) * r) / k1;
+}
+
+}  // anonymous namespace
+
 double RNG::unipos() {
      double x;
      do {
@@ -55,6 +97,22 @@ double RNG::exponential() {
      return -log(unipos());
 }
 
+double RNG::ziggurat_exponential() {
+     auto w = [this]() { return word(*this); };
+     return SHG::ziggurat_exponential(w);
+}
+
+void RNG::uniform(double* x, size_t n) {
+     for (size_t i = 0; i < n; i++)
+          x[i] = operator()();
+}
+
+void RNG::exponential(double* x, size_t n) {
+     auto w = [this]() { return word(*this); };
+     for (size_t i = 0; i < n; i++)
+          x[i] = SHG::ziggurat_exponential(w);
+}
+
 void RNG::simplex_surface(Vecdouble& x) {
      SHG_VALIDATE(x.size() > 0);
      size_t i;
@@ -87,6 +145,17 @@ double RNG::normal() {
      return operator()() < 0.5 ? -x : x;
 }
 
+double RNG::ziggurat_normal() {
+     auto w = [this]() { return word(*this); };
+     return SHG::ziggurat_normal(w);
+}
+
+void RNG::normal(double* x, size_t n) {
+     auto w = [this]() { return word(*this); };
+     for (size_t i = 0; i < n; i++)
+          x[i] = SHG::ziggurat_normal(w);
+}
+
 void RNG::random_sample(int n, int N, Vecint& x) {
      SHG_VALIDATE(n > 0 && n <= N);
      x.resize(n);
@@ -153,44 +222,43 @@ double RNG::beta(double a, double b) {
 
 unsigned int RNG::binomial(double p, unsigned int n) {
      SHG_VALIDATE(p >= 0.0 && p <= 1.0);
-     int a, b, k = 0;
-     double x;
-
-     while (n > 10) {
-          a = 1 + (n / 2);
-          b = 1 + n - a;
-          x = beta(a, b);
-          if (x >= p) {
-               n = a - 1;
-               p /= x;
-          } else {
-               k += a;
-               n = b - 1;
-               p = (p - x) / (1 - x);
+     double const r = std::min(p, 1.0 - p);
+     if (n == 0 || r == 0.0)
+          return p > 0.5 ? n : 0;
+     double const q = 1.0 - r;
+     double const nr = n * r;
+     unsigned int y;
+     if (nr < 10.0) {
+          // Algorithm BINV.
+          double const qn = exp(n * log(q));
+          double const bound =
+               std::min<double>(n, nr + 10.0 * sqrt(nr * q + 1.0));
+          double px = qn;
+          double u = operator()();
+          y = 0;
+          while (u > px) {
+               y++;
+               if (y > bound) {
+                    y = 0;
+                    px = qn;
+                    u = operator()();
+               } else {
+                    u -= px;
+                    px = ((n - y + 1) * r * px) / (y * q);
+               }
           }
+     } else {
+          y = binomial_btpe(r, n);
      }
-     for (unsigned int i = 0; i < n; i++)
-          if (operator()() < p)
-               k++;
-     return k;
+     return p > 0.5 ? n - y : y;
 }
 
 unsigned int RNG::poisson(double mu) {
      SHG_VALIDATE(mu > 0.0);
-     unsigned int m, k = 0;
-     double x;
-
-     while (mu > 10.0) {
-          m = static_cast<int>(0.875 * mu);
-          x = gamma_int(m);
-          if (x < mu) {
-               k += m;
-               mu -= x;
-          } else {
-               return k + binomial(mu / x, m - 1);
-          }
-     }
+     if (mu >= 10.0)
+          return poisson_ptrs(mu);
      double const emu = exp(-mu);
+     unsigned int k = 0;
      double prod = 1.0;
      do {
           prod *= operator()();
@@ -244,6 +312,125 @@ double RNG::gamma_int(unsigned int const a) {
      return s;
 }
 
+unsigned int RNG::binomial_btpe(double const r,
+                               unsigned int const n) {
+     double const q = 1.0 - r;
+     double const nrq = n * r * q;
+     double const fm = n * r + r;
+     double const m = floor(fm);
+     double const p1 = floor(2.195 * sqrt(nrq) - 4.6 * q) + 0.5;
+     double const xm = m + 0.5;
+     double const xl = xm - p1;
+     double const xr = xm + p1;
+     double const c = 0.134 + 20.5 / (15.3 + m);
+     double a = (fm - xl) / (fm - xl * r);
+     double const laml = a * (1.0 + a / 2.0);
+     a = (xr - fm) / (xr * q);
+     double const lamr = a * (1.0 + a / 2.0);
+     double const p2 = p1 * (1.0 + 2.0 * c);
+     double const p3 = p2 + c / laml;
+     double const p4 = p3 + c / lamr;
+     auto const stirling = [](double x) {
+          double const x2 = x * x;
+          return (13860.0 -
+                  (462.0 - (132.0 - (99.0 - 140.0 / x2) / x2) / x2) /
+                       x2) /
+                 x / 166320.0;
+     };
+
+     for (;;) {
+          double const u = operator()() * p4;
+          double v = operator()();
+          double y;
+          if (u <= p1) {
+               // Triangular region, accepted immediately.
+               return static_cast<unsigned int>(
+                    floor(xm - p1 * v + u));
+          } else if (u <= p2) {
+               // Parallelogram region.
+               double const x = xl + (u - p1) / c;
+               v = v * c + 1.0 - std::abs(m - x + 0.5) / p1;
+               if (v > 1.0)
+                    continue;
+               y = floor(x);
+          } else if (u <= p3) {
+               // Left exponential tail.
+               y = floor(xl + log(v) / laml);
+               if (y < 0.0 || v == 0.0)
+                    continue;
+               v = v * (u - p2) * laml;
+          } else {
+               // Right exponential tail.
+               y = floor(xr - log(v) / lamr);
+               if (y > n || v == 0.0)
+                    continue;
+               v = v * (u - p3) * lamr;
+          }
+          double const k = std::abs(y - m);
+          if (k <= 20.0 || k >= nrq / 2.0 - 1.0) {
+               // Explicit evaluation of f(y) / f(m).
+               double const s = r / q;
+               double const aa = s * (n + 1);
+               double f = 1.0;
+               if (m < y)
+                    for (double i = m + 1.0; i <= y; i++)
+                         f *= aa / i - s;
+               else if (m > y)
+                    for (double i = y + 1.0; i <= m; i++)
+                         f /= aa / i - s;
+               if (v <= f)
+                    return static_cast<unsigned int>(y);
+               continue;
+          }
+          // Squeezing with the normal approximation, then the final
+          // test with Stirling's formula.
+          double const rho =
+               (k / nrq) *
+               ((k * (k / 3.0 + 0.625) + 1.0 / 6.0) / nrq + 0.5);
+          double const t = -k * k / (2.0 * nrq);
+          double const aa = log(v);
+          if (aa < t - rho)
+               return static_cast<unsigned int>(y);
+          if (aa > t + rho)
+               continue;
+          double const x1 = y + 1.0;
+          double const f1 = m + 1.0;
+          double const z = n + 1.0 - m;
+          double const w = n - y + 1.0;
+          double const bound =
+               xm * log(f1 / x1) + (n - m + 0.5) * log(z / w) +
+               (y - m) * log(w * r / (x1 * q)) + stirling(f1) +
+               stirling(z) + stirling(x1) + stirling(w);
+          if (aa <= bound)
+               return static_cast<unsigned int>(y);
+     }
+}
+
+unsigned int RNG::poisson_ptrs(double const mu) {
+     double const smu = sqrt(mu);
+     double const b = 0.931 + 2.53 * smu;
+     double const a = -0.059 + 0.02483 * b;
+     double const log_inv_alpha = log(1.1239 + 1.1328 / (b - 3.4));
+     double const vr = 0.9277 - 3.6224 / (b - 2.0);
+     double const log_mu = log(mu);
+     for (;;) {
+          double const u = operator()() - 0.5;
+          double const v = unipos();
+          double const us = 0.5 - std::abs(u);
+          double const k = floor((2.0 * a / us + b) * u + mu + 0.43);
+          bool const accept =
+               (us >= 0.07 && v <= vr) ||
+               (k >= 0.0 && (us >= 0.013 || v <= us) &&
+                log(v) + log_inv_alpha - log(a / (us * us) + b) <=
+                     -mu + k * log_mu - log_factorial(k));
+          if (accept) {
+               if (!(k <= numeric_limits<unsigned int>::max()))
+                    throw overflow_error(__func__);
+               return static_cast<unsigned int>(k);
+          }
+     }
+}
+
 double RNG::gamma_large(double const a) {
      using Constants::pi;
      double const sqa = sqrt(2.0 * a - 1.0);
@@ -279,4 +466,54 @@ double RNG::gamma_frac(double const a) {
      return x;
 }
 
+Alias_table::Alias_table(Vecdouble const& w)
+     : q_(w.size()), alias_(w.size()) {
+     size_t const n = w.size();
+     SHG_VALIDATE(n > 0);
+     double sum = 0.0;
+     for (size_t i = 0; i < n; i++) {
+          SHG_VALIDATE(w[i] >= 0.0 && std::isfinite(w[i]));
+          sum += w[i];
+     }
+     SHG_VALIDATE(sum > 0.0 && std::isfinite(sum));
+     // Vose's algorithm: each cell of a small value is filled up with
+     // a part of a large one.
+     std::vector<int> small, large;
+     for (size_t i = 0; i < n; i++) {
+          q_[i] = w[i] * n / sum;
+          alias_[i] = i;
+          (q_[i] < 1.0 ? small : large).push_back(i);
+     }
+     while (!small.empty() && !large.empty()) {
+          int const s = small.back();
+          int const l = large.back();
+          small.pop_back();
+          alias_[s] = l;
+          q_[l] -= 1.0 - q_[s];
+          if (q_[l] < 1.0) {
+               large.pop_back();
+               small.push_back(l);
+          }
+     }
+     // What is left has q = 1 up to rounding errors, but values of
+     // weight 0 must never be returned.
+     int const imax =
+          std::max_element(w.begin(), w.end()) - w.begin();
+     for (int const i : small)
+          if (w[i] > 0.0) {
+               q_[i] = 1.0;
+          } else {
+               q_[i] = 0.0;
+               alias_[i] = imax;
+          }
+     for (int const i : large)
+          q_[i] = 1.0;
+}
+
+int Alias_table::operator()(RNG& g) const {
+     double const u = g() * q_.size();
+     size_t const i = std::min(static_cast<size_t>(u), q_.size() - 1);
+     return u - i < q_[i] ? i : alias_[i];
+}
+
 }  // namespace SHG
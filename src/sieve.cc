@@ -0,0 +1,239 @@
+/**
+ * \file src/sieve.cc
+ * Segmented sieve of Eratosthenes.
+ */
+
+#include <shg/sieve.h>
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
+#include <stdexcept>
+#include <shg/except.h>
+
+namespace SHG {
+
+namespace {
+
+/**
+ * Index in Prime_bits::wheel of residues modulo 30, -1 for residues
+ * not coprime to 30.
+ */
+constexpr auto wheel_index = []() {
+     std::array<int, 30> a{};
+     a.fill(-1);
+     for (int i = 0; i < 8; i++)
+          a[Prime_bits::wheel[i]] = i;
+     return a;
+}();
+
+/**
+ * clear_mask[i][j] clears the bit of \f$p(30k + w_j)\f$ for \f$p
+ * \equiv w_i \pmod{30}\f$.
+ */
+constexpr auto clear_mask = []() {
+     std::array<std::array<std::uint8_t, 8>, 8> a{};
+     for (int i = 0; i < 8; i++)
+          for (int j = 0; j < 8; j++) {
+               int const r =
+                    Prime_bits::wheel[i] * Prime_bits::wheel[j] % 30;
+               a[i][j] = static_cast<std::uint8_t>(
+                    ~(1u << wheel_index[r]));
+          }
+     return a;
+}();
+
+std::uint64_t isqrt(std::uint64_t n) {
+     auto r = static_cast<std::uint64_t>(
+          std::sqrt(static_cast<double>(n)));
+     while (r * r > n)
+          r--;
+     while ((r + 1) * (r + 1) <= n)
+          r++;
+     return r;
+}
+
+/**
+ * Primes not represented on the wheel.
+ */
+constexpr std::uint64_t small_primes[]{2, 3, 5};
+
+bool is_small_prime(std::uint64_t n) {
+     return n == 2 || n == 3 || n == 5;
+}
+
+}  // anonymous namespace
+
+Prime_bits::Prime_bits(std::uint64_t lo, std::uint64_t hi,
+                       unsigned nthreads)
+     : lo_(lo), hi_(hi), base_(lo / 30 * 30) {
+     if (lo > hi || hi > Segmented_sieve::max_hi)
+          SHG_THROW(std::invalid_argument, __func__);
+     if (lo == hi)
+          return;
+     b_.resize((hi - base_ + 29) / 30);
+     for_each_prime_segment(
+          lo, hi,
+          [this](Prime_bits const& s) {
+               std::copy(s.b_.cbegin(), s.b_.cend(),
+                         b_.begin() + (s.base_ - base_) / 30);
+          },
+          nthreads);
+}
+
+bool Prime_bits::is_prime(std::uint64_t n) const {
+     if (n < lo_ || n >= hi_)
+          SHG_THROW(std::invalid_argument, __func__);
+     int const i = wheel_index[n % 30];
+     if (i < 0)
+          return is_small_prime(n);
+     return (b_[(n - base_) / 30] >> i & 1) != 0;
+}
+
+std::uint64_t Prime_bits::count() const {
+     std::uint64_t c = 0;
+     for (std::uint64_t const p : small_primes)
+          if (lo_ <= p && p < hi_)
+               c++;
+     for (auto const x : b_)
+          c += std::popcount(x);
+     return c;
+}
+
+std::vector<std::uint64_t> Prime_bits::primes() const {
+     std::vector<std::uint64_t> v;
+     v.reserve(count());
+     for_each([&v](std::uint64_t p) { v.push_back(p); });
+     return v;
+}
+
+std::size_t Segmented_sieve::segment_bytes(std::uint64_t x) {
+     return std::clamp<std::uint64_t>(std::bit_ceil(isqrt(x)) / 2,
+                                      1 << 16, 1 << 20);
+}
+
+Segmented_sieve::Segmented_sieve(std::uint64_t lo, std::uint64_t hi)
+     : lo_(lo), hi_(hi), base_(lo / 30 * 30) {
+     if (lo > hi || hi > max_hi)
+          SHG_THROW(std::invalid_argument, __func__);
+     if (lo < hi)
+          nbytes_ = (hi - base_ + 29) / 30;
+}
+
+/**
+ * Appends to p_ the primes in (limit_, limit].
+ */
+void Segmented_sieve::extend(std::uint64_t limit) {
+     std::vector<char> composite(limit + 1);
+     for (std::uint64_t i = 3; i * i <= limit; i += 2)
+          if (!composite[i])
+               for (std::uint64_t j = i * i; j <= limit; j += 2 * i)
+                    composite[j] = 1;
+     for (std::uint64_t i = limit_ + 1; i <= limit; i++) {
+          int const k = wheel_index[i % 30];
+          if (k >= 0 && i > 1 && !composite[i]) {
+               p_.push_back(static_cast<std::uint32_t>(i));
+               pi_.push_back(static_cast<std::uint8_t>(k));
+          }
+     }
+     limit_ = limit;
+}
+
+bool Segmented_sieve::next(Prime_bits& s) {
+     if (pos_ >= nbytes_)
+          return false;
+     std::uint64_t const start = base_ + 30 * pos_;
+     std::uint64_t const n = std::min<std::uint64_t>(
+          segment_bytes(start), nbytes_ - pos_);
+     std::uint64_t const end = std::min(hi_, start + 30 * n);
+
+     // Sieving primes up to sqrt(end - 1) are needed. The list is
+     // extended at least twice to amortize the cost of extension.
+     std::uint64_t const need = isqrt(end - 1);
+     if (need > limit_) {
+          std::uint64_t const twice =
+               std::min(2 * limit_, isqrt(hi_ - 1));
+          extend(std::max(need, twice));
+     }
+     for (; active_ < p_.size() &&
+            std::uint64_t{p_[active_]} * p_[active_] < end;
+          active_++) {
+          std::uint64_t const p = p_[active_];
+          std::uint64_t const first = std::max(start, p * p);
+          std::uint64_t const m0 = (first + p - 1) / p;
+          for (int j = 0; j < 8; j++) {
+               std::uint64_t const m =
+                    m0 + (Prime_bits::wheel[j] + 30 - m0 % 30) % 30;
+               off_.push_back(
+                    static_cast<std::uint32_t>((p * m - start) / 30));
+          }
+     }
+
+     s.b_.assign(n, 0xff);
+     std::uint8_t* const b = s.b_.data();
+     for (std::size_t i = 0; i < active_; i++) {
+          std::uint64_t const p = p_[i];
+          auto const& mask = clear_mask[pi_[i]];
+          std::uint32_t* const off = off_.data() + 8 * i;
+          for (int j = 0; j < 8; j++) {
+               std::uint8_t const m = mask[j];
+               std::uint64_t k = off[j];
+               for (; k < n; k += p)
+                    b[k] &= m;
+               off[j] = static_cast<std::uint32_t>(k - n);
+          }
+     }
+
+     // Clears 1 and the numbers outside [lo, hi).
+     for (int i = 0; i < 8; i++) {
+          std::uint64_t const x = start + Prime_bits::wheel[i];
+          if (x == 1 || x < lo_)
+               b[0] &= static_cast<std::uint8_t>(~(1u << i));
+          std::uint64_t const y = x + 30 * (n - 1);
+          if (y >= hi_)
+               b[n - 1] &= static_cast<std::uint8_t>(~(1u << i));
+     }
+     s.lo_ = std::max(lo_, start);
+     s.hi_ = end;
+     s.base_ = start;
+     pos_ += n;
+     return true;
+}
+
+Prime_generator::Prime_generator(std::uint64_t start)
+     : s_(start, Segmented_sieve::max_hi) {
+     if (start >= Segmented_sieve::max_hi)
+          SHG_THROW(std::invalid_argument, __func__);
+     while (small_ < 3 && small_primes[small_] < start)
+          small_++;
+}
+
+std::uint64_t Prime_generator::operator()() {
+     if (small_ < 3)
+          return small_primes[small_++];
+     for (;;) {
+          if (x_ != 0) {
+               int const i = std::countr_zero(x_);
+               x_ &= x_ - 1;
+               return b_.base_ + 30 * (k_ - 1) + Prime_bits::wheel[i];
+          }
+          if (k_ < b_.b_.size()) {
+               x_ = b_.b_[k_++];
+               continue;
+          }
+          if (!s_.next(b_))
+               SHG_THROW(std::overflow_error, __func__);
+          k_ = 0;
+     }
+}
+
+std::uint64_t count_primes(std::uint64_t lo, std::uint64_t hi,
+                           unsigned nthreads) {
+     std::atomic<std::uint64_t> c{0};
+     for_each_prime_segment(
+          lo, hi, [&c](Prime_bits const& s) { c += s.count(); },
+          nthreads);
+     return c;
+}
+
+}  // namespace SHG
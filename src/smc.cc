@@ -5,11 +5,15 @@
  */
 
 #include <shg/smc.h>
+#include <algorithm>
 #include <cmath>
 #include <limits>
+#include <mutex>
 #include <string>
+#include <utility>
 #include <shg/mconsts.h>
 #include <shg/mstat.h>
+#include <shg/philox.h>
 
 namespace SHG {
 
@@ -23,8 +27,13 @@ using std::string;
 
 SMC::STD::~STD() {}
 
-SMC::Finite::Finite(Vecint const& x, Vecdouble const& p)
-     : x(x), p(p) {
+namespace {
+
+/**
+ * Checks the arguments of SMC::Finite::Finite() and returns \c p.
+ */
+Vecdouble const& finite_probabilities(Vecint const& x,
+                                      Vecdouble const& p) {
      SHG_ASSERT(x.size() == p.size());
      double sum = 0.0;
      for (size_t i = 0; i < x.size(); i++) {
@@ -33,10 +42,16 @@ SMC::Finite::Finite(Vecint const& x, Vecdouble const& p)
           sum += p[i];
      }
      SHG_ASSERT(abs(sum - 1.0) < 1e-4);
+     return p;
 }
 
+}  // anonymous namespace
+
+SMC::Finite::Finite(Vecint const& x, Vecdouble const& p)
+     : x(x), a(finite_probabilities(x, p)) {}
+
 int SMC::Finite::generate(RNG& g) const {
-     int const i = g.finite(p);
+     int const i = a(g);
      SHG_ASSERT(static_cast<size_t>(i) < x.size());
      return x[i];
 }
@@ -162,6 +177,86 @@ int SMC::generate(int T, bool cut) {
      return 0;
 }
 
+void SMC::Summary::merge(Summary const& s) {
+     auto const add = [](std::vector<std::uint64_t>& x,
+                         std::vector<std::uint64_t> const& y) {
+          if (x.size() < y.size())
+               x.resize(y.size());
+          for (size_t i = 0; i < y.size(); i++)
+               x[i] += y[i];
+     };
+     paths += s.paths;
+     if (runs.size() < s.runs.size())
+          runs.resize(s.runs.size());
+     for (size_t j = 0; j < s.runs.size(); j++)
+          add(runs[j], s.runs[j]);
+     add(occupation, s.occupation);
+     add(longest, s.longest);
+}
+
+int SMC::replicate(std::size_t n, int T, bool cut, std::uint64_t seed,
+                   Summary& summary, unsigned nthreads) {
+     int const status = check_data();
+     if (status != 0 && status != 5)
+          return status;
+     if (T < 1)
+          return 6;
+     Alias_table const alpha(alpha_);
+     std::vector<Alias_table> P;
+     P.reserve(s_);
+     Vecdouble q(s_);
+     for (size_t i = 0; i < s_; i++) {
+          for (size_t j = 0; j < s_; j++)
+               q[j] = P_(i, j);
+          P.emplace_back(q);
+     }
+     auto const count = [](std::vector<std::uint64_t>& h, int x) {
+          auto const i = static_cast<size_t>(x);
+          if (h.size() <= i)
+               h.resize(i + 1);
+          h[i]++;
+     };
+     Summary total;
+     total.runs.resize(s_);
+     total.occupation.resize(s_);
+     std::mutex m;
+     Philox const g0(seed);
+     size_t const nchunks =
+          (n + replication_chunk - 1) / replication_chunk;
+     parallel_for(
+          nchunks,
+          [&](size_t c) {
+               Philox g = g0.substream(c);
+               Summary u;
+               u.runs.resize(s_);
+               u.occupation.resize(s_);
+               u.paths = std::min(n - c * replication_chunk,
+                                  replication_chunk);
+               for (std::uint64_t i = 0; i < u.paths; i++) {
+                    int t = 0, longest = 0;
+                    int k = alpha(g);
+                    for (;;) {
+                         int x = std_->generate(g);
+                         if (cut && x > T - t)
+                              x = T - t;
+                         count(u.runs[k], x);
+                         u.occupation[k] += x;
+                         if (x > longest)
+                              longest = x;
+                         if ((t += x) >= T)
+                              break;
+                         k = P[k](g);
+                    }
+                    count(u.longest, longest);
+               }
+               std::lock_guard<std::mutex> lock(m);
+               total.merge(u);
+          },
+          nthreads);
+     summary = std::move(total);
+     return 0;
+}
+
 // Returns: 0 - ok, 1 - invalid dimension of alpha_ or P_, 2 -
 // incorrect value of alpha_, 3 - incorrect value of P_, 4 - std_ not
 // assigned, 5 - g_ not assigned.
@@ -240,4 +240,11 @@ std::string to_octal(std::string const& s) {
      return oss.str();
 }
 
+unsigned number_of_threads(unsigned nthreads) {
+     if (nthreads > 0)
+          return nthreads;
+     unsigned const n = std::thread::hardware_concurrency();
+     return n > 0 ? n : 1;
+}
+
 }  // namespace SHG
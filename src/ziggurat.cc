@@ -0,0 +1,58 @@
+/**
+ * \file src/ziggurat.cc
+ * Ziggurat method for normal and exponential distributions.
+ */
+
+#include <shg/ziggurat.h>
+
+namespace SHG {
+
+namespace {
+
+double normal_density(double x) {
+     return std::exp(-0.5 * x * x);
+}
+
+double normal_inverse(double y) {
+     return std::sqrt(-2.0 * std::log(y));
+}
+
+double exponential_density(double x) {
+     return std::exp(-x);
+}
+
+double exponential_inverse(double y) {
+     return -std::log(y);
+}
+
+}  // anonymous namespace
+
+Ziggurat::Ziggurat(int c, double r, double v, double (*f)(double),
+                   double (*finv)(double))
+     : mask(c - 1), r(r), x(c + 1), q(c) {
+     x[0] = v / f(r);
+     x[1] = r;
+     for (int i = 2; i < c; i++) {
+          double const y = v / x[i - 1] + f(x[i - 1]);
+          x[i] = y < 1.0 ? finv(y) : 0.0;
+     }
+     x[c] = 0.0;
+     for (int i = 0; i < c; i++)
+          q[i] = x[i + 1] / x[i];
+}
+
+Ziggurat const& Ziggurat::normal() {
+     static Ziggurat const z(128, 3.442619855899, 9.91256303526217e-3,
+                             normal_density, normal_inverse);
+     return z;
+}
+
+Ziggurat const& Ziggurat::exponential() {
+     static Ziggurat const z(256, 7.69711747013104972,
+                             3.949659822581572e-3,
+                             exponential_density,
+                             exponential_inverse);
+     return z;
+}
+
+}  // namespace SHG
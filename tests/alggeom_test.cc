@@ -1,4 +1,5 @@
 #include <shg/alggeom.h>
+#include <shg/mzt.h>
 #include <shg/utils.h>
 #include "buchbdat.h"
 #include "tests.h"
@@ -328,6 +329,149 @@ BOOST_DATA_TEST_CASE(buchberger_test,
      BOOST_CHECK(true);
 }
 
+BOOST_DATA_TEST_CASE(buchberger_packed_test,
+                     bdata::xrange(buchberger_test_data_size), xr) {
+     using SHG::ALGEBRA::ALGGEOM::Buchberger_packed;
+     BOOST_REQUIRE(buchberger_test_data.size() ==
+                   buchberger_test_data_size);
+     auto const& tc = buchberger_test_data[xr];
+     Test_data td;
+     td.init(tc.f, tc.g, tc.ordering);
+     Buchberger_packed b;
+     b.run(td.f_);
+     BOOST_CHECK(SHG::have_equal_content(b.g(), td.g_));
+}
+
+/**
+ * Buchberger_packed and Buchberger_improved for random polynomials
+ * over \f$\mathbb{Z}_p\f$. For p = 2, Element_coefficients are
+ * used.
+ */
+BOOST_DATA_TEST_CASE(buchberger_packed_zp_test,
+                     bdata::xrange(3) * bdata::xrange(3), xr1, xr2) {
+     using SHG::ALGEBRA::ALGGEOM::Buchberger_improved;
+     using SHG::ALGEBRA::ALGGEOM::Buchberger_packed;
+     using SHG::ALGEBRA::Monomial;
+     using SHG::ALGEBRA::Monomial_cmp;
+     using SHG::ALGEBRA::Polynomial;
+     using SHG::ALGEBRA::Ring_Zn;
+     int const p[] = {2, 7, 32003};
+     Monomial_cmp const cmp[] = {SHG::ALGEBRA::lex_cmp,
+                                 SHG::ALGEBRA::grlex_cmp,
+                                 SHG::ALGEBRA::grevlex_cmp};
+     Ring_Zn const F(p[xr1]);
+     SHG::MZT g;
+     for (int k = 0; k < 5; k++) {
+          std::vector<Polynomial> f;
+          for (int i = 0; i < 3; i++) {
+               Polynomial q(&F, 3);
+               q.order(cmp[xr2]);
+               for (int j = 0; j < 3; j++)
+                    q += {F.element(g.uni(F.n())),
+                          Monomial{g.uni(3), g.uni(3), g.uni(3)}};
+               f.push_back(q);
+          }
+          Buchberger_improved b1;
+          Buchberger_packed b2;
+          b1.run(f);
+          b2.run(f);
+          BOOST_CHECK(SHG::have_equal_content(b1.g(), b2.g()));
+     }
+}
+
+/**
+ * Returns the polynomial over \f$\mathbb{Q}\f$ reduced modulo
+ * F.n().
+ */
+SHG::ALGEBRA::Polynomial modp(SHG::ALGEBRA::Polynomial const& q,
+                              SHG::ALGEBRA::Ring_Zn const& F) {
+     using SHG::ALGEBRA::Field_Q;
+     using SHG::ALGEBRA::Polynomial;
+     using boost::multiprecision::cpp_int;
+     auto const& Q = dynamic_cast<Field_Q const&>(*q.as());
+     auto const residue = [&F](cpp_int const& x) {
+          cpp_int y = x % F.n();
+          if (y < 0)
+               y += F.n();
+          return F.element(y.convert_to<int>());
+     };
+     Polynomial r(&F, q.dim());
+     r.order(q.order());
+     for (auto const& [m, a] : q.terms()) {
+          auto const& v = Q.value(a);
+          r += {residue(numerator(v)) / residue(denominator(v)), m};
+     }
+     return r;
+}
+
+/**
+ * F4 for the Buchberger test data modulo a prime.
+ */
+BOOST_DATA_TEST_CASE(f4_test,
+                     bdata::xrange(buchberger_test_data_size) *
+                          bdata::xrange(1, 3),
+                     xr, nthreads) {
+     using SHG::ALGEBRA::ALGGEOM::F4;
+     using SHG::ALGEBRA::Polynomial;
+     using SHG::ALGEBRA::Ring_Zn;
+     BOOST_REQUIRE(buchberger_test_data.size() ==
+                   buchberger_test_data_size);
+     auto const& tc = buchberger_test_data[xr];
+     Test_data td;
+     td.init(tc.f, tc.g, tc.ordering);
+     Ring_Zn const F(32003);
+     std::vector<Polynomial> f, g;
+     for (auto const& p : td.f_)
+          f.push_back(modp(p, F));
+     for (auto const& p : td.g_)
+          g.push_back(modp(p, F));
+     F4 b;
+     b.run(f, nthreads);
+     BOOST_CHECK(SHG::have_equal_content(b.g(), g));
+}
+
+/**
+ * F4 and Buchberger_packed for random polynomials. Over Z_2 and Q,
+ * F4 uses Buchberger_packed.
+ */
+BOOST_DATA_TEST_CASE(f4_random_test,
+                     bdata::xrange(4) * bdata::xrange(3), xr1, xr2) {
+     using SHG::ALGEBRA::ALGGEOM::Buchberger_packed;
+     using SHG::ALGEBRA::ALGGEOM::F4;
+     using SHG::ALGEBRA::AS;
+     using SHG::ALGEBRA::Field_Q;
+     using SHG::ALGEBRA::Monomial;
+     using SHG::ALGEBRA::Monomial_cmp;
+     using SHG::ALGEBRA::Polynomial;
+     using SHG::ALGEBRA::Ring_Zn;
+     Ring_Zn const Z2(2), Z7(7), Z32003(32003);
+     Field_Q const Q;
+     AS const* const as[] = {&Z2, &Z7, &Z32003, &Q};
+     Monomial_cmp const cmp[] = {SHG::ALGEBRA::lex_cmp,
+                                 SHG::ALGEBRA::grlex_cmp,
+                                 SHG::ALGEBRA::grevlex_cmp};
+     SHG::MZT g;
+     for (int k = 0; k < 5; k++) {
+          std::vector<Polynomial> f;
+          for (int i = 0; i < 3; i++) {
+               Polynomial q(as[xr1], 3);
+               q.order(cmp[xr2]);
+               for (int j = 0; j < 3; j++) {
+                    auto c = as[xr1]->one();
+                    for (int l = g.uni(7); l > 0; l--)
+                         c += as[xr1]->one();
+                    q += {c, Monomial{g.uni(3), g.uni(3), g.uni(3)}};
+               }
+               f.push_back(q);
+          }
+          Buchberger_packed b1;
+          F4 b2;
+          b1.run(f);
+          b2.run(f, 2);
+          BOOST_CHECK(SHG::have_equal_content(b1.g(), b2.g()));
+     }
+}
+
 /**
  * Non-zero polynomial equal to zero for all values.
  * \cite cox-little-oshea-2007, exercise 2, page 5.
@@ -1,4 +1,8 @@
 #include <shg/cfg.h>
+#include <algorithm>
+#include <set>
+#include <tuple>
+#include <shg/mzt.h>
 #include "tests.h"
 #include "cfgdata.h"
 
@@ -405,6 +409,142 @@ BOOST_AUTO_TEST_CASE(lukasiewicz_notation_test) {
                  "W(FK(K), B(W(FN(N), W(p)), W(FN(N), W(q)))))))");
 }
 
+BOOST_AUTO_TEST_CASE(bitset_cyk_test) {
+     using SHG::PLP::Bitset_CYK;
+     CYK cyk;
+     Bitset_CYK bcyk;
+     auto const check = [&cyk, &bcyk](Sentence const& X) {
+          bool const r = cyk.recognize(X);
+          BOOST_CHECK(bcyk.recognize(X) == r);
+          cyk.parse(X);
+          bcyk.parse(X);
+          BOOST_CHECK(bcyk.gen().to_string() ==
+                      cyk.gen().to_string());
+     };
+
+     cyk.set_grammar(test_grammars[0]);
+     bcyk.set_grammar(test_grammars[0]);
+     check({"b", "a", "a", "b", "a"});
+     check({"b", "b", "b"});
+     BOOST_CHECK_THROW(bcyk.recognize({"b", "c"}),
+                       SHG::PLP::Unknown_terminal);
+     BOOST_CHECK_THROW(bcyk.parse({}), SHG::PLP::Empty_sentence);
+
+     cyk.set_grammar(test_grammars[2]);
+     bcyk.set_grammar(test_grammars[2]);
+     check({"astronomers", "saw", "stars", "with", "ears"});
+
+     Conversion_to_CNF conv;
+     conv.convert(test_grammars[5]);
+     cyk.set_grammar(conv.cfg());
+     bcyk.set_grammar(conv.cfg());
+     for (std::size_t i = 0; i < std::size(ubda_res); i++) {
+          Sentence const X(i + 1, "x");
+          bcyk.parse(X);
+          BOOST_CHECK(bcyk.gen().to_string() == ubda_res[i]);
+     }
+
+     conv.convert(test_grammars[13]);
+     cyk.set_grammar(conv.cfg());
+     bcyk.set_grammar(conv.cfg());
+     check(gre_test_input(2, 0));
+     check(gre_test_input(2, 4));
+     BOOST_CHECK(bcyk.recognize(gre_test_input(2, 200)));
+
+     cyk.set_grammar(test_grammars[17]);
+     bcyk.set_grammar(test_grammars[17]);
+     check({"E", "N", "A", "p", "q", "K", "N", "p", "N", "q"});
+     check({"E", "N", "A", "p", "q", "K", "N", "p", "N"});
+
+     BOOST_CHECK_THROW(bcyk.set_grammar(test_grammars[1]),
+                       SHG::PLP::Invalid_grammar);
+}
+
+// A random grammar with more nonterminals than bits in a word.
+BOOST_AUTO_TEST_CASE(bitset_cyk_random_test) {
+     using SHG::PLP::Bitset_CYK;
+     int const nv = 100, nt = 3, nb = 1000;
+     SHG::MZT g;
+     Vecprod vp;
+     std::set<std::tuple<int, int, int>> rules;
+     while (static_cast<int>(rules.size()) < nb)
+          rules.insert({g.uni(nv), 1 + g.uni(nv - 1),
+                        1 + g.uni(nv - 1)});
+     for (auto const& [a, b, c] : rules)
+          vp.push_back({"v" + std::to_string(a),
+                        {"v" + std::to_string(b),
+                         "v" + std::to_string(c)}});
+     for (int a = 0; a < nv; a++)
+          vp.push_back({"v" + std::to_string(a),
+                        {"t" + std::to_string(a % nt)}});
+     std::sort(vp.begin(), vp.end(),
+               [](auto const& p, auto const& q) {
+                    return p.lhs == "v0" && q.lhs != "v0";
+               });
+     CYK cyk;
+     Bitset_CYK bcyk;
+     cyk.set_grammar(vp);
+     bcyk.set_grammar(vp);
+     int accepted = 0;
+     for (int i = 0; i < 50; i++) {
+          Sentence X(1 + g.uni(4));
+          for (auto& t : X)
+               t = "t" + std::to_string(g.uni(nt));
+          bool const r = cyk.recognize(X);
+          BOOST_CHECK(bcyk.recognize(X) == r);
+          accepted += r;
+          if (X.size() <= 3) {
+               cyk.parse(X);
+               bcyk.parse(X);
+               BOOST_CHECK(bcyk.gen().to_string() ==
+                           cyk.gen().to_string());
+          }
+     }
+     BOOST_CHECK(accepted > 0);
+}
+
+// A large random grammar with epsilon productions, long right-hand
+// sides and a unit cycle.
+BOOST_AUTO_TEST_CASE(large_grammar_conversion_test) {
+     int const nv = 200, nt = 5, np = 3000;
+     SHG::MZT g;
+     auto const v = [](int i) { return "V" + std::to_string(i); };
+     auto const t = [](int i) { return "t" + std::to_string(i); };
+     Vecprod vp;
+     vp.push_back({v(0), {v(1), v(2)}});
+     for (int a = 1; a < nv; a++)
+          vp.push_back({v(a), {t(a % nt)}});
+     std::set<std::string> seen;
+     for (int i = 0; i < np; i++) {
+          int const a = 1 + g.uni(nv - 1);
+          Sentence rhs(2 + g.uni(4));
+          for (auto& x : rhs)
+               x = g.uni(4) == 0 ? t(g.uni(nt))
+                                 : v(1 + g.uni(nv - 1));
+          if (seen.insert(v(a) + SHG::PLP::to_string(rhs)).second)
+               vp.push_back({v(a), rhs});
+     }
+     for (int a = nv - 10; a < nv; a++)
+          vp.push_back({v(a), {}});
+     vp.push_back({v(1), {v(2)}});
+     vp.push_back({v(2), {v(3)}});
+     vp.push_back({v(3), {v(1)}});
+     vp.push_back({v(3), {v(3)}});
+     BOOST_REQUIRE(is_valid(vp));
+
+     Conversion_to_CNF conv;
+     conv.convert(vp);
+     SHG::PLP::CNF_validator validator;
+     BOOST_REQUIRE(validator.is_valid(conv.cfg()));
+     BOOST_CHECK(conv.cfg().size() > vp.size());
+
+     SHG::PLP::Bitset_CYK cyk;
+     cyk.set_grammar(conv.cfg());
+     BOOST_CHECK(cyk.recognize({t(1), t(2)}));
+     BOOST_CHECK(cyk.recognize({t(2), t(2)}));
+     BOOST_CHECK(cyk.recognize({t(3), t(1)}));
+}
+
 Vecprod const full_cnf_test_result{
      {"v0", {"v0", "v0"}}, {"v0", {"v0", "v1"}}, {"v0", {"v0", "v2"}},
      {"v0", {"v1", "v0"}}, {"v0", {"v1", "v1"}}, {"v0", {"v1", "v2"}},
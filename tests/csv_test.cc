@@ -1,6 +1,8 @@
 #include <shg/csv.h>
 #include <algorithm>
 #include <sstream>
+#include <string_view>
+#include <shg/mzt.h>
 #include "tests.h"
 
 namespace TESTS {
@@ -170,6 +172,96 @@ BOOST_AUTO_TEST_CASE(field_separator_followed_by_end_of_record_test) {
      BOOST_CHECK(v.size() == 0);
 }
 
+BOOST_AUTO_TEST_CASE(csv_buffered_writer_test) {
+     using SHG::CSV_buffered_writer;
+     for (std::size_t size : {1, 10, 1 << 20}) {
+          for (auto const& td : vc) {
+               ostringstream ss(binout);
+               {
+                    CSV_buffered_writer csvw(ss, ',', '"', size);
+                    for (auto const& r : td.raw) {
+                         csvw.write_record(r);
+                         vector<std::string_view> const v(r.begin(),
+                                                          r.end());
+                         csvw.write_record(v);
+                    }
+               }
+               string expected;
+               for (auto const& r : td.raw) {
+                    ostringstream ss1(binout);
+                    CSV_writer(ss1).write_record(r);
+                    expected += ss1.str() + ss1.str();
+               }
+               BOOST_CHECK(ss.str() == expected);
+          }
+     }
+     ostringstream ss(binout);
+     CSV_buffered_writer csvw(ss);
+     csvw.write_record(vector<double>{0.1, -1e300, 5.0});
+     BOOST_CHECK(ss.str().empty());
+     csvw.flush();
+     BOOST_CHECK(ss.str() == "0.1,-1e+300,5\r\n");
+}
+
+// Compares CSV_buffered_reader with CSV_reader.
+void compare_readers(string const& s, std::size_t size) {
+     istringstream ss1(s, bininp), ss2(s, bininp);
+     CSV_reader r1(ss1);
+     SHG::CSV_buffered_reader r2(ss2, ',', '"', size);
+     vector<string> v1, v2;
+     for (;;) {
+          r1.getrec(v1);
+          r2.getrec(v2);
+          BOOST_REQUIRE(v1 == v2);
+          if (v1.empty())
+               break;
+     }
+}
+
+BOOST_AUTO_TEST_CASE(csv_buffered_reader_test) {
+     for (std::size_t size : {1, 2, 3, 7, 1 << 20})
+          for (auto const& c : vc)
+               compare_readers(c.csv, size);
+     for (char const* s :
+          {"", "a", "\r\n", ",\r\n", "a,", "a,\"\"", "a\rb",
+           "a\r\n\nb", "\"a", "x\"y\"z,\"\"\"q"})
+          for (std::size_t size : {1, 2, 1 << 20})
+               compare_readers(s, size);
+
+     // Random input of special characters.
+     SHG::MZT g;
+     char const alphabet[] = {',', '"', '\r', '\n', 'a', 'b'};
+     for (int i = 0; i < 500; i++) {
+          string s(g.uni(30), ' ');
+          for (auto& c : s)
+               c = alphabet[g.uni(std::size(alphabet))];
+          compare_readers(s, 1 + g.uni(8));
+     }
+
+     // Views into the buffer.
+     istringstream ss("12,-3.5,\"x\"\"y\"\r\n", bininp);
+     SHG::CSV_buffered_reader csvr(ss);
+     vector<std::string_view> v;
+     BOOST_REQUIRE(csvr.getrec(v));
+     BOOST_REQUIRE(v.size() == 3);
+     int n;
+     double x;
+     SHG::from_field(v[0], n);
+     SHG::from_field(v[1], x);
+     BOOST_CHECK(n == 12);
+     BOOST_CHECK(x == -3.5);
+     BOOST_CHECK(v[2] == "x\"y");
+     using SHG::from_field;
+     using std::invalid_argument;
+     BOOST_CHECK_THROW(from_field(v[2], x), invalid_argument);
+     BOOST_CHECK_THROW(from_field("12 ", n), invalid_argument);
+     BOOST_CHECK_THROW(from_field("1e10", n), invalid_argument);
+     unsigned u;
+     BOOST_CHECK_THROW(from_field("-1", u), invalid_argument);
+     BOOST_CHECK(!csvr.getrec(v));
+     BOOST_CHECK(v.empty());
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace TESTS
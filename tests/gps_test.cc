@@ -1,4 +1,5 @@
 #include <shg/gps.h>
+#include <algorithm>
 #include <cmath>
 #include <iomanip>
 #include <fstream>
@@ -6,6 +7,7 @@
 #include <boost/iostreams/filtering_streambuf.hpp>
 #include <boost/iostreams/copy.hpp>
 #include <boost/iostreams/filter/gzip.hpp>
+#include <shg/mzt.h>
 #include "tests.h"
 #include "gpsdata.h"
 
@@ -166,6 +168,132 @@ BOOST_AUTO_TEST_CASE(gpx_positive_test) {
      BOOST_CHECK(facmp(d.speedkmh(), 13.42, 0.01) == 0);
 }
 
+BOOST_AUTO_TEST_CASE(gpx_scan_test) {
+     std::string gpx{gpx1};
+     gpx += gpx2;
+     gpx += gpx3;
+     GPX_data d, e;
+     std::istringstream iss(gpx);
+     BOOST_REQUIRE_NO_THROW(d.parse(iss));
+     iss.clear();
+     iss.str(gpx);
+     BOOST_REQUIRE_NO_THROW(e.scan(iss));
+     BOOST_CHECK(e.state() == GPX_data::State::ok);
+     BOOST_CHECK(e.distance() == d.distance());
+     BOOST_CHECK(e.distance_on_ellipsoid() ==
+                 d.distance_on_ellipsoid());
+     BOOST_CHECK(e.uphill() == d.uphill());
+     BOOST_CHECK(e.downhill() == d.downhill());
+     BOOST_CHECK(e.start_time() == d.start_time());
+     BOOST_CHECK(e.end_time() == d.end_time());
+     BOOST_CHECK(e.elapsed_seconds() == d.elapsed_seconds());
+
+     // Comments and attributes in other order.
+     std::string const pt = R"(
+   <!-- <trkpt lat="0" lon="0"> -->
+   <trkpt lon = '18.6134050' lat="54.3809510" ><ele>13.0</ele>
+    <time>2021-06-11T16:02:04Z</time><extensions/></trkpt>)";
+     gpx.insert(gpx.find("  </trkseg>"), pt);
+     iss.clear();
+     iss.str(gpx);
+     BOOST_REQUIRE_NO_THROW(e.scan(iss));
+     BOOST_CHECK(e.distance() == d.distance());
+     BOOST_CHECK(e.elapsed_seconds() == d.elapsed_seconds() + 1);
+}
+
+BOOST_AUTO_TEST_CASE(track_index_test) {
+     using SHG::GPS::Track;
+     using SHG::GPS::Cart_track;
+     using SHG::GPS::Track_index;
+     SHG::MZT g;
+     auto const u = [&g](double a, double b) {
+          return a + (b - a) * g();
+     };
+     std::vector<Track> tracks(300);
+     for (auto& tr : tracks) {
+          double phi = u(54.30, 54.45);
+          double lambda = u(18.50, 18.70);
+          int const n = g.uni(4) == 0 ? g.uni(2) : 1 + g.uni(60);
+          for (int i = 0; i < n; i++) {
+               tr.push_back({phi, lambda, u(0.0, 50.0)}, i);
+               phi += u(-0.0005, 0.0005);
+               lambda += u(-0.0005, 0.0005);
+          }
+     }
+     Track_index ind;
+     ind.build(tracks);
+
+     // Distance from p to the nearest point of track i, by
+     // sampling the segments.
+     auto const brute = [&tracks](Cart_coord const& p,
+                                  std::size_t i) {
+          Cart_track c;
+          convert(tracks[i], c);
+          double d = std::numeric_limits<double>::infinity();
+          for (std::size_t j = 0; j < c.x.size(); j++) {
+               std::size_t const k = std::min(j + 1, c.x.size() - 1);
+               for (int m = 0; m <= 1000; m++) {
+                    double const t = m / 1000.0;
+                    Cart_coord const q{
+                         c.x[j] + t * (c.x[k] - c.x[j]),
+                         c.y[j] + t * (c.y[k] - c.y[j]),
+                         c.z[j] + t * (c.z[k] - c.z[j])};
+                    d = std::min(d, SHG::GPS::distance(p, q));
+               }
+          }
+          return d;
+     };
+
+     std::vector<Cart_coord> points(20);
+     for (auto& p : points)
+          convert({u(54.30, 54.45), u(18.50, 18.70), 20.0}, p);
+     double const r = 1000.0;
+     auto const w = ind.within(points, r, 3);
+     auto const nn = ind.nearest(points, 5, 3);
+     BOOST_REQUIRE(w.size() == points.size());
+     for (std::size_t q = 0; q < points.size(); q++) {
+          std::vector<double> d(tracks.size());
+          for (std::size_t i = 0; i < tracks.size(); i++)
+               d[i] = brute(points[q], i);
+          for (std::size_t i = 0; i < tracks.size(); i++) {
+               bool const in = std::binary_search(w[q].begin(),
+                                                  w[q].end(), i);
+               if (d[i] < r - 0.01)
+                    BOOST_CHECK(in);
+               else if (d[i] > r + 0.01)
+                    BOOST_CHECK(!in);
+          }
+          BOOST_REQUIRE(nn[q].size() == 5);
+          for (std::size_t j = 0; j < 5; j++) {
+               auto const [t, dt] = nn[q][j];
+               BOOST_CHECK(std::abs(d[t] - dt) < 0.01);
+               if (j > 0)
+                    BOOST_CHECK(nn[q][j - 1].distance <= dt);
+               for (std::size_t i = 0; i < tracks.size(); i++)
+                    if (d[i] < dt - 0.01)
+                         BOOST_CHECK(std::any_of(
+                              nn[q].begin(), nn[q].end(),
+                              [i](auto const& u) {
+                                   return u.track == i;
+                              }));
+          }
+     }
+
+     // Segment query against point queries at its ends.
+     Cart_coord const& a = points[0];
+     Cart_coord const& b = points[1];
+     auto const v = ind.within(a, b, r);
+     for (Cart_coord const& e : {a, b})
+          for (auto i : ind.within(e, r))
+               BOOST_CHECK(std::binary_search(v.begin(), v.end(), i));
+
+     Track_index empty;
+     empty.build({});
+     BOOST_CHECK(empty.size() == 0);
+     BOOST_CHECK(empty.within(a, r).empty());
+     BOOST_CHECK(empty.nearest(a, 3).empty());
+}
+
 void exec_negative_test(char const* s) {
      GPX_data d;
      BOOST_CHECK(d.state() == GPX_data::State::initialized);
@@ -182,6 +310,10 @@ void exec_negative_test(char const* s) {
      BOOST_CHECK_THROW(d.elapsed_seconds(), std::logic_error);
      BOOST_CHECK_THROW(d.speedms(), std::logic_error);
      BOOST_CHECK_THROW(d.speedkmh(), std::logic_error);
+     GPX_data e;
+     std::istringstream iss2(s);
+     BOOST_CHECK_THROW(e.scan(iss2), std::runtime_error);
+     BOOST_CHECK(e.state() == GPX_data::State::error);
 }
 
 constexpr char const* const two_track_segments = R"(
@@ -245,6 +377,86 @@ BOOST_AUTO_TEST_CASE(gpx_two_track_segments_test) {
      exec_negative_test(two_track_segments);
 }
 
+BOOST_AUTO_TEST_CASE(track_test) {
+     using SHG::GPS::Track;
+     using SHG::GPS::Cart_track;
+     using SHG::GPS::cumulative_distance;
+     using SHG::GPS::elevation_gain;
+     using SHG::GPS::speeds;
+     std::string gpx{gpx1};
+     gpx += gpx2;
+     gpx += gpx3;
+     GPX_data d;
+     Track tr;
+     std::istringstream iss(gpx);
+     BOOST_REQUIRE_NO_THROW(d.scan(iss));
+     iss.clear();
+     iss.str(gpx);
+     BOOST_REQUIRE_NO_THROW(tr.read_gpx(iss));
+     BOOST_REQUIRE(tr.size() == 10);
+     BOOST_CHECK(tr.t.back() - tr.t.front() == d.elapsed_seconds());
+
+     Cart_track c;
+     std::vector<double> dist, cum, v;
+     convert(tr, c);
+     for (std::size_t i = 0; i < tr.size(); i++) {
+          Cart_coord p;
+          convert({tr.phi[i], tr.lambda[i], tr.h[i]}, p);
+          BOOST_CHECK(c.x[i] == p.x && c.y[i] == p.y &&
+                      c.z[i] == p.z);
+     }
+     segment_distances(c, dist);
+     BOOST_REQUIRE(dist.size() == 9);
+     cumulative_distance(dist, cum);
+     BOOST_REQUIRE(cum.size() == 10);
+     BOOST_CHECK(cum.back() == d.distance());
+     convert(tr, c, true);
+     segment_distances(c, dist);
+     cumulative_distance(dist, cum);
+     BOOST_CHECK(cum.back() == d.distance_on_ellipsoid());
+
+     double up, down;
+     elevation_gain(tr.h, 0.0, up, down);
+     BOOST_CHECK(up == d.uphill());
+     BOOST_CHECK(down == d.downhill());
+     elevation_gain({10.0, 10.5, 11.5, 11.0, 12.0, 9.0}, 1.0, up,
+                    down);
+     BOOST_CHECK(facmp(up, 1.5, 1e-12) == 0);
+     BOOST_CHECK(facmp(down, 2.5, 1e-12) == 0);
+     BOOST_CHECK_THROW(elevation_gain(tr.h, -1.0, up, down),
+                       std::invalid_argument);
+
+     speeds(dist, tr.t, v);
+     BOOST_REQUIRE(v.size() == 9);
+     BOOST_CHECK(facmp(v[0], dist[0] / 2.0, 1e-12) == 0);
+     BOOST_CHECK_THROW(speeds(dist, {}, v), std::invalid_argument);
+
+     std::stringstream ss(bininpout);
+     write(tr, ss);
+     Track tr1;
+     read(tr1, ss);
+     BOOST_REQUIRE(!ss.fail());
+     BOOST_CHECK(tr1.phi == tr.phi && tr1.lambda == tr.lambda &&
+                 tr1.h == tr.h && tr1.t == tr.t);
+     std::string const good = ss.str();
+     std::string bad = good;
+     bad[0] = 'X';
+     ss.str(bad);
+     ss.clear();
+     read(tr1, ss);
+     BOOST_CHECK(ss.fail());
+     BOOST_CHECK(tr1.size() == tr.size());
+     ss.str(good.substr(0, 100));
+     ss.clear();
+     read(tr1, ss);
+     BOOST_CHECK(ss.fail());
+
+     iss.clear();
+     iss.str(two_track_segments);
+     BOOST_CHECK_THROW(tr.read_gpx(iss), std::runtime_error);
+     BOOST_CHECK(tr.size() == 0);
+}
+
 constexpr char const* const no_trkpt = R"(
 <?xml version="1.0" encoding="UTF-8"?>
 <gpx creator="StravaGPX Android" xmlns:xsi="http://www.w3.org/2001/XMLSchema-instance" xsi:schemaLocation="http://www.topografix.com/GPX/1/1 http://www.topografix.com/GPX/1/1/gpx.xsd" version="1.1" xmlns="http://www.topografix.com/GPX/1/1">
@@ -587,6 +799,38 @@ BOOST_AUTO_TEST_CASE(activity_statistics_test,
           BOOST_CHECK(u);
 }
 
+BOOST_AUTO_TEST_CASE(activity_statistics_parallel_test,
+                     *boost::unit_test::fixture(&setup, &teardown)) {
+     namespace fs = std::filesystem;
+     fs::path const p = fs::temp_directory_path() / "shg";
+     Activity_statistics as1, as2;
+     BOOST_REQUIRE_NO_THROW(as1.run(p));
+     for (unsigned nthreads : {1, 2, 5}) {
+          as2.init();
+          BOOST_REQUIRE_NO_THROW(as2.run(p, nthreads));
+          BOOST_REQUIRE(as2.results().size() == std::size(res));
+          for (std::size_t i = 0; i < std::size(res); i++) {
+               auto const& r = as1.results()[i];
+               auto const& t = as2.results()[i];
+               BOOST_CHECK(r.fname == t.fname);
+               BOOST_CHECK(r.status == t.status);
+               BOOST_CHECK(r.distance == t.distance);
+               BOOST_CHECK(r.distance_on_ellipsoid ==
+                           t.distance_on_ellipsoid);
+               BOOST_CHECK(r.uphill == t.uphill);
+               BOOST_CHECK(r.downhill == t.downhill);
+               BOOST_CHECK(r.start_time == t.start_time);
+               BOOST_CHECK(r.end_time == t.end_time);
+               BOOST_CHECK(r.elapsed_seconds == t.elapsed_seconds);
+          }
+     }
+     BOOST_CHECK(std::is_sorted(
+          as2.results().begin(), as2.results().end(),
+          [](auto const& a, auto const& b) {
+               return a.fname < b.fname;
+          }));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace TESTS
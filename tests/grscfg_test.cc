@@ -1,4 +1,6 @@
 #include <shg/grscfg.h>
+#include <cstdlib>
+#include <map>
 #include "tests.h"
 #include "cfgdata.h"
 
@@ -218,6 +220,51 @@ BOOST_AUTO_TEST_CASE(long_sentence_test) {
      BOOST_CHECK(v == res_long_sentence);
 }
 
+BOOST_AUTO_TEST_CASE(generate_fast_test) {
+     // Even palindromes over {a, b}, each generated once.
+     McKenzie gen;
+     gen.set_grammar(test_grammars[19]);
+     std::map<SHG::PLP::Sentence, int> freq;
+     int const count = 8000;
+     auto const v = gen.generate_fast(count, 6, 4);
+     BOOST_REQUIRE(v.size() == count);
+     for (auto const& w : v) {
+          BOOST_REQUIRE(w.size() == 6);
+          for (int i = 0; i < 3; i++)
+               BOOST_CHECK(w[i] == w[5 - i]);
+          freq[w]++;
+     }
+     BOOST_CHECK(freq.size() == 8);
+     for (auto const& [w, n] : freq)
+          BOOST_CHECK(std::abs(n - count / 8) < 150);
+     for (auto const& w : gen.generate_fast(10, 5))
+          BOOST_CHECK(w.empty());
+}
+
+BOOST_AUTO_TEST_CASE(generate_fast_threads_test) {
+     McKenzie gen1, gen2;
+     gen1.set_grammar(test_grammars[18]);
+     gen2.set_grammar(test_grammars[18]);
+     auto const v1 = gen1.generate_fast(500, 40, 1);
+     auto const v2 = gen2.generate_fast(500, 40, 0);
+     BOOST_CHECK(v1 == v2);
+     for (auto const& w : v1)
+          BOOST_CHECK(w.size() == 40);
+     BOOST_CHECK(gen1.generate_fast(500, 30, 1) !=
+                 gen1.generate_fast(500, 30, 1));
+}
+
+BOOST_AUTO_TEST_CASE(generate_fast_unit_cycle_test) {
+     // The unit cycle S --> A --> S gives infinitely many
+     // derivations. The tables are not used after the failure.
+     McKenzie gen;
+     gen.set_grammar({{"S", {"A"}}, {"A", {"S"}}, {"S", {"a"}}});
+     for (int i = 0; i < 2; i++)
+          BOOST_CHECK_THROW(gen.generate_fast(10, 3), CFG_error);
+     gen.set_grammar(test_grammars[19]);
+     BOOST_CHECK(gen.generate_fast(10, 6).size() == 10);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace TESTS
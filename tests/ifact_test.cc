@@ -1,5 +1,6 @@
 #include <shg/ifact.h>
 #include <boost/multiprecision/cpp_int.hpp>
+#include <shg/mzt.h>
 #include <shg/utils.h>
 #include "tests.h"
 
@@ -29,7 +30,103 @@ BOOST_AUTO_TEST_CASE(is_prime_cpp_int_test) {
      BOOST_CHECK(is_prime(M_31));
 }
 
-/// \todo error: vector iterators incompatible
+BOOST_AUTO_TEST_CASE(is_prime64_test) {
+     using SHG::is_prime64;
+     using SHG::is_prime_trial;
+
+     for (std::uint64_t n = 0; n < 100000; n++)
+          BOOST_CHECK(is_prime64(n) == is_prime_trial(n));
+     SHG::MZT g;
+     for (int i = 0; i < 10000; i++) {
+          std::uint64_t const n =
+               static_cast<std::uint64_t>(g.uni(1 << 30)) << 6 |
+               g.uni(64);
+          BOOST_CHECK(is_prime64(n) == is_prime_trial(n));
+     }
+     // Carmichael numbers and strong pseudoprimes to the bases 2, 3,
+     // 5, 7 and to the first nine primes.
+     for (std::uint64_t const n :
+          {561ULL, 41041ULL, 3215031751ULL, 3825123056546413051ULL})
+          BOOST_CHECK(!is_prime64(n));
+     BOOST_CHECK(is_prime64((1ULL << 61) - 1));
+     BOOST_CHECK(is_prime64(18446744073709551557ULL));
+     BOOST_CHECK(!is_prime64(18446744073709551615ULL));
+     BOOST_CHECK(!is_prime64(4294967291ULL * 4294967279ULL));
+}
+
+BOOST_AUTO_TEST_CASE(is_prime128_test) {
+     using SHG::Uint128;
+     using SHG::is_prime128;
+
+     Uint128 const one = 1;
+     BOOST_CHECK(is_prime128((one << 127) - 1));
+     BOOST_CHECK(is_prime128((one << 89) - 1));
+     BOOST_CHECK(!is_prime128((one << 127) - 3));
+     BOOST_CHECK(!is_prime128(((one << 61) - 1) * ((one << 61) - 1)));
+     // Strong pseudoprime to the first 12 prime bases.
+     BOOST_CHECK(!is_prime128(Uint128("318665857834031151167461")));
+     BOOST_CHECK(is_prime128(Uint128(2)));
+     BOOST_CHECK(!is_prime128(Uint128(1)));
+}
+
+/**
+ * Checks that f are primes in nondecreasing order with the product
+ * n.
+ */
+template <class T>
+void check_prime_factors(T const& n, std::vector<T> const& f) {
+     T m = 1;
+     for (std::size_t i = 0; i < f.size(); i++) {
+          BOOST_CHECK(SHG::is_prime(f[i]));
+          BOOST_CHECK(i == 0 || f[i - 1] <= f[i]);
+          m *= f[i];
+     }
+     BOOST_CHECK(m == n);
+}
+
+BOOST_AUTO_TEST_CASE(prime_factors64_test) {
+     using SHG::prime_factors64;
+     using Vec = std::vector<std::uint64_t>;
+
+     BOOST_CHECK(prime_factors64(0).empty());
+     BOOST_CHECK(prime_factors64(1).empty());
+     BOOST_CHECK(prime_factors64(2) == Vec{2});
+     BOOST_CHECK(prime_factors64(1024) == Vec(10, 2));
+     BOOST_CHECK(prime_factors64(18446744073709551615ULL) ==
+                 (Vec{3, 5, 17, 257, 641, 65537, 6700417}));
+     BOOST_CHECK(prime_factors64(4294967291ULL * 4294967279ULL) ==
+                 (Vec{4294967279ULL, 4294967291ULL}));
+     BOOST_CHECK(prime_factors64(4294967291ULL * 4294967291ULL) ==
+                 (Vec{4294967291ULL, 4294967291ULL}));
+     BOOST_CHECK(prime_factors64(1031ULL * 1031 * 1031 * 1033) ==
+                 (Vec{1031, 1031, 1031, 1033}));
+     SHG::MZT g;
+     for (int i = 0; i < 2000; i++) {
+          std::uint64_t const n =
+               static_cast<std::uint64_t>(g.uni(1 << 30)) << 30 |
+               g.uni(1 << 30);
+          check_prime_factors(n, prime_factors64(n));
+     }
+}
+
+BOOST_AUTO_TEST_CASE(prime_factors128_test) {
+     using SHG::Uint128;
+     using SHG::prime_factors128;
+     using Vec = std::vector<Uint128>;
+
+     Uint128 const one = 1;
+     Uint128 const m61 = (one << 61) - 1, m127 = (one << 127) - 1;
+     BOOST_CHECK(prime_factors128(m127) == Vec{m127});
+     BOOST_CHECK(prime_factors128(Uint128(6)) == (Vec{2, 3}));
+     BOOST_CHECK(prime_factors128(m61 * 1000003 * 998244353) ==
+                 (Vec{1000003, 998244353, m61}));
+     BOOST_CHECK(prime_factors128(m61 * m61) == (Vec{m61, m61}));
+     BOOST_CHECK(prime_factors128(one << 100) == Vec(100, 2));
+     Uint128 const n = (one << 64) * 3 * 1031 * 1000003;
+     BOOST_CHECK(prime_factors128(n).size() == 67);
+     check_prime_factors(n, prime_factors128(n));
+}
+
 BOOST_AUTO_TEST_CASE(integer_factorization_test) {
      using SHG::Integer_factorization;
      using SHG::ipower;
@@ -40,7 +137,6 @@ BOOST_AUTO_TEST_CASE(integer_factorization_test) {
      f.factorize(1);
      BOOST_CHECK(f.repr().size() == 0);
      for (unsigned n = 2; n <= 100; n++) {
-          // vector iterators incompatible happens here
           f.factorize(n);
           auto const& r = f.repr();
           unsigned n1 = 1;
@@ -71,6 +167,78 @@ BOOST_AUTO_TEST_CASE(integer_factorization_cpp_int_test) {
           BOOST_CHECK(r[i].p == t[i] && r[i].n == i + 1);
 }
 
+BOOST_AUTO_TEST_CASE(integer_factorization_big_cpp_int_test) {
+     using SHG::Integer_factorization;
+     using SHG::is_prime;
+     using boost::multiprecision::cpp_int;
+
+     cpp_int const one = 1;
+     cpp_int const m89 = (one << 89) - 1, m127 = (one << 127) - 1;
+     cpp_int const m521 = (one << 521) - 1, n = m89 * m127;
+     BOOST_CHECK(is_prime(m521));
+     BOOST_CHECK(!is_prime(n));
+
+     Integer_factorization<cpp_int> f;
+     f.factorize(m127 * 1000003 * 1000003 * 998244353);
+     auto const& r = f.repr();
+     BOOST_REQUIRE(r.size() == 3);
+     BOOST_CHECK(r[0].p == 1000003 && r[0].n == 2);
+     BOOST_CHECK(r[1].p == 998244353 && r[1].n == 1);
+     BOOST_CHECK(r[2].p == m127 && r[2].n == 1);
+}
+
+BOOST_AUTO_TEST_CASE(integer_factorization_uint128_test) {
+     using SHG::Integer_factorization;
+     using SHG::Uint128;
+     using SHG::is_prime;
+
+     Uint128 const one = 1;
+     Uint128 const m61 = (one << 61) - 1, m127 = (one << 127) - 1;
+     Uint128 const p = (one << 64) - 59;  // the largest 64-bit prime
+     BOOST_CHECK(is_prime(m127));
+     BOOST_CHECK(is_prime(p));
+     BOOST_CHECK(!is_prime(m61 * p));
+     BOOST_CHECK(!is_prime(Uint128(1)));
+     BOOST_CHECK(is_prime(Uint128(2)));
+
+     Integer_factorization<Uint128> f;
+     f.factorize(9 * Uint128(998244353) * p);
+     auto const& r = f.repr();
+     BOOST_REQUIRE(r.size() == 3);
+     BOOST_CHECK(r[0].p == 3 && r[0].n == 2);
+     BOOST_CHECK(r[1].p == 998244353 && r[1].n == 1);
+     BOOST_CHECK(r[2].p == p && r[2].n == 1);
+     f.factorize(Uint128(360));
+     BOOST_REQUIRE(f.repr().size() == 3);
+     BOOST_CHECK(f.repr()[2].p == 5 && f.repr()[2].n == 1);
+}
+
+BOOST_AUTO_TEST_CASE(batch_factorize_test) {
+     using SHG::Integer_factorization;
+     using SHG::factorize;
+
+     SHG::MZT g;
+     std::vector<long long> n(1000);
+     for (auto& x : n)
+          x = static_cast<long long>(g.uni(1 << 30)) << 30 |
+              g.uni(1 << 30);
+     n[0] = 0;
+     n[1] = 1;
+     for (unsigned const nthreads : {1u, 4u}) {
+          auto const f = factorize(n, nthreads);
+          BOOST_REQUIRE(f.size() == n.size());
+          for (std::size_t i = 0; i < n.size(); i++) {
+               Integer_factorization<long long> h;
+               h.factorize(n[i]);
+               auto const& a = f[i].repr();
+               auto const& b = h.repr();
+               BOOST_REQUIRE(a.size() == b.size());
+               for (std::size_t j = 0; j < a.size(); j++)
+                    BOOST_CHECK(a[j].p == b[j].p && a[j].n == b[j].n);
+          }
+     }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace TESTS
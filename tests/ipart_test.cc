@@ -2,6 +2,7 @@
 #include <algorithm>
 #include <iterator>
 #include <numeric>
+#include <boost/multiprecision/cpp_int.hpp>
 #include "tests.h"
 
 namespace TESTS {
@@ -12,6 +13,13 @@ using SHG::partgen;
 using SHG::accel_asc;
 using SHG::rule_asc;
 using SHG::Ordered_partitions_generator;
+using SHG::split_partitions;
+using SHG::split_ordered_partitions;
+using SHG::generate_partitions;
+using SHG::generate_ordered_partitions;
+using SHG::parallel_partitions;
+using SHG::parallel_ordered_partitions;
+using SHG::partition_numbers;
 
 struct Partitions {
      std::vector<std::vector<int>> tab{};
@@ -185,6 +193,80 @@ BOOST_DATA_TEST_CASE(ordered_partition_generator_test,
      BOOST_CHECK(p.is_lexicographically_sorted());
 }
 
+BOOST_DATA_TEST_CASE(split_partitions_test,
+                     bdata::xrange(1, 21) *
+                          bdata::make({1, 3, 7, 50}),
+                     n, ntasks) {
+     Partitions p0, p1, q0, q1;
+     accel_asc(n, p0);
+     for (auto const& t : split_partitions(n, ntasks))
+          generate_partitions(n, t, p1);
+     BOOST_CHECK(p1.tab == p0.tab);
+     Ordered_partitions_generator g(n, q0);
+     g.generate();
+     auto const tasks = split_ordered_partitions(n, ntasks);
+     for (auto const& t : tasks)
+          generate_ordered_partitions(n, t, q1);
+     BOOST_CHECK(q1.tab == q0.tab);
+     if (n > 10)
+          BOOST_CHECK(tasks.size() >= static_cast<unsigned>(ntasks));
+}
+
+BOOST_AUTO_TEST_CASE(parallel_partitions_test) {
+     auto const join = [](Partitions& x, Partitions const& y) {
+          x.tab.insert(x.tab.end(), y.tab.cbegin(), y.tab.cend());
+     };
+     for (int n = 1; n <= 22; n++) {
+          Partitions p0, q0;
+          accel_asc(n, p0);
+          Ordered_partitions_generator g(n, q0);
+          g.generate();
+          for (unsigned nthreads : {1, 4}) {
+               Partitions const p1 = parallel_partitions(
+                    n, Partitions(), join, nthreads);
+               BOOST_CHECK(p1.tab == p0.tab);
+               Partitions const q1 = parallel_ordered_partitions(
+                    n, Partitions(), join, nthreads);
+               BOOST_CHECK(q1.tab == q0.tab);
+          }
+     }
+}
+
+BOOST_AUTO_TEST_CASE(parallel_partitions_count_test) {
+     struct Counter {
+          std::uint64_t n{0};
+          void operator()(int, std::vector<int> const&) { n++; }
+     };
+     auto const add = [](Counter& x, Counter const& y) {
+          x.n += y.n;
+     };
+     int const n = 60;
+     Counter const c = parallel_partitions(n, Counter(), add);
+     BOOST_CHECK(c.n == partition_numbers<std::uint64_t>(n)[n]);
+     BOOST_CHECK(c.n == 966467);
+}
+
+BOOST_AUTO_TEST_CASE(partition_numbers_test) {
+     using boost::multiprecision::cpp_int;
+     std::vector<std::size_t> const p0{
+          1,  1,  2,   3,   5,   7,   11,  15,  22,  30, 42,
+          56, 77, 101, 135, 176, 231, 297, 385, 490, 627};
+     auto const p1 = partition_numbers<std::size_t>(20);
+     BOOST_CHECK(p1 == p0);
+     auto const p2 = partition_numbers<std::uint64_t>(416);
+     BOOST_CHECK(p2[100] == 190569292);
+     BOOST_CHECK(p2[416] == 17873792969689876004u);
+     BOOST_CHECK_THROW(partition_numbers<std::uint64_t>(417),
+                       std::overflow_error);
+     auto const p3 = partition_numbers<std::uint32_t>(50);
+     BOOST_CHECK(p3[50] == 204226);
+     auto const p4 = partition_numbers<cpp_int>(500);
+     BOOST_CHECK(p4[416] == p2[416]);
+     BOOST_CHECK(p4[500] == cpp_int("2300165032574323995027"));
+     BOOST_CHECK_THROW(partition_numbers<std::uint64_t>(-1),
+                       std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace TESTS
@@ -1,4 +1,6 @@
 #include <shg/laplace.h>
+#include <algorithm>
+#include <vector>
 #include <shg/mzt.h>
 #include <shg/utils.h>
 #include "tests.h"
@@ -183,6 +185,44 @@ BOOST_AUTO_TEST_CASE(weighted_median_test) {
      BOOST_CHECK_THROW(weighted_median(x, w), std::invalid_argument);
 }
 
+BOOST_AUTO_TEST_CASE(median_unsorted_test) {
+     using SHG::median_unsorted;
+     using SHG::weighted_median_unsorted;
+     MZT g;
+     for (int n = 1; n <= 50; n++) {
+          Vecdouble x(n), w(n);
+          for (int i = 0; i < n; i++) {
+               x[i] = g.uni(10);
+               w[i] = g.uni(3);
+          }
+          std::vector<std::size_t> order(n);
+          for (int i = 0; i < n; i++)
+               order[i] = i;
+          std::sort(order.begin(), order.end(),
+                    [&x](std::size_t a, std::size_t b) {
+                         return x[a] < x[b];
+                    });
+          Vecdouble xs(n), ws(n);
+          for (int i = 0; i < n; i++) {
+               xs[i] = x[order[i]];
+               ws[i] = w[order[i]];
+          }
+          BOOST_CHECK(median_unsorted(x) == median(xs));
+          if (sum(w) > 0.0)
+               BOOST_CHECK(weighted_median_unsorted(x, w) ==
+                           weighted_median(xs, ws));
+          else
+               BOOST_CHECK_THROW(weighted_median_unsorted(x, w),
+                                 std::invalid_argument);
+     }
+     Vecdouble const x{3, 0, 2, 1}, w{0, 1, 0, 1};
+     BOOST_CHECK(weighted_median_unsorted(x, w) == 0.5);
+     BOOST_CHECK_THROW(median_unsorted(Vecdouble()),
+                       std::invalid_argument);
+     BOOST_CHECK_THROW(weighted_median_unsorted(x, Vecdouble(3)),
+                       std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_CASE(mixture_test) {
      Vecdouble w(3), mu(3), lambda(3);
 
@@ -1,4 +1,6 @@
 #include <shg/mstat.h>
+#include <algorithm>
+#include <cmath>
 #include <cstdlib>
 #include <vector>
 #include <shg/mzt.h>
@@ -135,6 +137,187 @@ BOOST_AUTO_TEST_CASE(sample_test) {
      }
 }
 
+BOOST_AUTO_TEST_CASE(quantile_test) {
+     using SHG::order_statistic;
+     using SHG::quantile;
+     MZT g;
+     std::vector<double> x(101);
+     for (auto& e : x)
+          e = g();
+     Sample const s(x);
+     std::vector<double> y(x);
+     std::sort(y.begin(), y.end());
+     for (std::size_t k = 0; k < x.size(); k++) {
+          std::vector<double> z(x);
+          BOOST_CHECK(order_statistic(z, k) == y[k]);
+     }
+     for (int i = 1; i < 100; i++) {
+          std::vector<double> z(x);
+          double const p = i / 100.0;
+          BOOST_CHECK(quantile(z, p) == s.quantile(p));
+     }
+     BOOST_CHECK_THROW(order_statistic(x, x.size()),
+                       std::invalid_argument);
+     BOOST_CHECK_THROW(quantile(x, 0.0), Invalid_argument);
+     std::vector<double> e;
+     BOOST_CHECK_THROW(quantile(e, 0.5), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(order_statistics_test) {
+     using SHG::Order_statistics;
+     MZT g;
+     int const n = 500, w = 31;
+     std::vector<double> x(n);
+     for (auto& e : x)
+          e = g.uni(100);
+     // Rolling median and quartiles.
+     Order_statistics os(x);
+     for (int t = 0; t < n; t++) {
+          os.insert(x[t]);
+          if (t >= w)
+               os.erase(x[t - w]);
+          if (t < w - 1)
+               continue;
+          std::vector<double> y(x.begin() + t - w + 1,
+                                x.begin() + t + 1);
+          Sample const s(y);
+          BOOST_CHECK(os.total() == w);
+          BOOST_CHECK(os.quantile(0.25) == s.quantile(0.25));
+          BOOST_CHECK(os.quantile(0.5) == s.quantile(0.5));
+          BOOST_CHECK(os.median() == s.quantile(0.5));
+          BOOST_CHECK(faeq(os.cdf(x[t]), s.cdf(x[t]), 1e-15));
+     }
+
+     // Weighted median over the same support.
+     std::vector<double> const support{1.0, 2.0, 3.0, 4.0};
+     Order_statistics ws(support);
+     ws.assign({1.0, 0.0, 0.0, 1.0});
+     BOOST_CHECK(ws.median() == 2.5);
+     ws.assign({0.0, 1.0, 1.0, 1.0});
+     BOOST_CHECK(ws.median() == 3.0);
+     ws.assign({1.0, 1.0, 1.0, 1.0});
+     BOOST_CHECK(ws.median() == 2.5);
+     ws.erase(1.0);
+     BOOST_CHECK(ws.median() == 3.0);
+     BOOST_CHECK(ws.quantile(0.1) == 2.0);
+     BOOST_CHECK_THROW(ws.erase(1.0), std::invalid_argument);
+     BOOST_CHECK_THROW(ws.insert(1.5), std::invalid_argument);
+     BOOST_CHECK_THROW(ws.insert(1.0, -1.0), std::invalid_argument);
+     BOOST_CHECK_THROW(ws.assign({1.0}), std::invalid_argument);
+     ws.assign({0.0, 0.0, 0.0, 0.0});
+     BOOST_CHECK_THROW(ws.median(), std::invalid_argument);
+     BOOST_CHECK_THROW(Order_statistics(std::vector<double>()),
+                       std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(moments_test) {
+     using SHG::Moments;
+     MZT g;
+     int const n = 1000;
+     Vecdouble x(n);
+     for (int i = 0; i < n; i++)
+          x[i] = 10.0 + g.exponential();
+     // Two-pass central moments.
+     double const m = SHG::mean(x);
+     double m2 = 0.0, m3 = 0.0, m4 = 0.0;
+     for (int i = 0; i < n; i++) {
+          double const d = x[i] - m;
+          m2 += d * d;
+          m3 += d * d * d;
+          m4 += d * d * d * d;
+     }
+     m2 /= n;
+     m3 /= n;
+     m4 /= n;
+
+     Moments a, b, c, all;
+     for (int i = 0; i < n; i++) {
+          all.add(x[i]);
+          (i < 100 ? a : i < 700 ? b : c).add(x[i]);
+     }
+     a.merge(b);
+     a.merge(c);
+     for (Moments const* s : {&all, &a}) {
+          double mean, var;
+          SHG::mean_var(x, mean, var);
+          BOOST_CHECK(s->n() == static_cast<std::size_t>(n));
+          BOOST_CHECK(faeq(s->mean(), mean, 1e-12));
+          BOOST_CHECK(faeq(s->var(), var, 1e-12));
+          SHG::mean_var1(x, mean, var);
+          BOOST_CHECK(faeq(s->var1(), var, 1e-12));
+          BOOST_CHECK(faeq(s->stddev(), SHG::stddev(&x[0], n),
+                           1e-12));
+          BOOST_CHECK(faeq(s->skewness(), m3 / std::pow(m2, 1.5),
+                           1e-10));
+          BOOST_CHECK(faeq(s->kurtosis(), m4 / (m2 * m2) - 3.0,
+                           1e-10));
+          BOOST_CHECK(s->min() ==
+                      *std::min_element(x.begin(), x.end()));
+          BOOST_CHECK(s->max() ==
+                      *std::max_element(x.begin(), x.end()));
+     }
+
+     Moments e;
+     BOOST_CHECK_THROW(e.mean(), std::invalid_argument);
+     e.add(1.0);
+     BOOST_CHECK_THROW(e.var1(), std::invalid_argument);
+     BOOST_CHECK_THROW(e.skewness(), std::range_error);
+     e.merge(Moments());
+     BOOST_CHECK(e.n() == 1 && e.mean() == 1.0 && e.var() == 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(quantile_sketch_test) {
+     using SHG::Quantile_sketch;
+     MZT g;
+     int const n = 100000, nshards = 4;
+     std::vector<double> x(n);
+     for (auto& e : x)
+          e = g.normal();
+     Sample const s(x);
+     Quantile_sketch all;
+     std::vector<Quantile_sketch> shard(nshards);
+     for (int i = 0; i < n; i++) {
+          all.add(x[i]);
+          shard[i % nshards].add(x[i]);
+     }
+     Quantile_sketch merged;
+     for (auto const& q : shard)
+          merged.merge(q);
+     for (Quantile_sketch const* q : {&all, &merged}) {
+          BOOST_CHECK(q->total() == n);
+          BOOST_CHECK(q->size() <= 200);
+          BOOST_CHECK(q->min() == s.min());
+          BOOST_CHECK(q->max() == s.max());
+          // The rank error is small, especially in the tails.
+          for (double p : {0.001, 0.01, 0.1, 0.25, 0.5, 0.75, 0.9,
+                           0.99, 0.999}) {
+               double const tol = 0.01 * std::sqrt(p * (1.0 - p));
+               BOOST_CHECK(std::abs(s.cdf(q->quantile(p)) - p) < tol);
+               BOOST_CHECK(std::abs(q->cdf(s.quantile(p)) - p) < tol);
+          }
+          BOOST_CHECK(faeq(q->iqr(), s.iqr(), 0.01));
+          BOOST_CHECK(q->cdf(s.min() - 1.0) == 0.0);
+          BOOST_CHECK(q->cdf(s.max()) == 1.0);
+          auto const h = q->histogram(), hs = s.histogram();
+          BOOST_REQUIRE(h.f.size() == hs.f.size());
+          double area = 0.0;
+          for (std::size_t j = 0; j < h.f.size(); j++) {
+               area += h.f[j] * h.h;
+               BOOST_CHECK_SMALL(h.f[j] - hs.f[j], 0.05);
+          }
+          BOOST_CHECK(faeq(area, 1.0, 1e-12));
+     }
+
+     Quantile_sketch e;
+     BOOST_CHECK_THROW(e.quantile(0.5), std::invalid_argument);
+     e.add(3.0, 2.0);
+     BOOST_CHECK(e.quantile(0.5) == 3.0);
+     BOOST_CHECK(e.cdf(3.0) == 1.0);
+     BOOST_CHECK_THROW(e.add(1.0, 0.0), Invalid_argument);
+     BOOST_CHECK_THROW(e.quantile(1.0), Invalid_argument);
+     BOOST_CHECK_THROW(Quantile_sketch(1.0), Invalid_argument);
+}
+
 /*
  * The results tested here are:
  *
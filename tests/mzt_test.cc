@@ -1,5 +1,8 @@
 #include <shg/mzt.h>
+#include <cmath>
 #include <sstream>
+#include <stdexcept>
+#include <vector>
 #include <shg/except.h>
 #include "tests.h"
 
@@ -173,8 +176,10 @@ BOOST_AUTO_TEST_CASE(poisson_test) {
           for (int j = 0; j < 1000; j++)
                s += g.poisson(mui);
      }
-     BOOST_CHECK(s == 1166264u);
+     BOOST_CHECK(s == 1164971u);
      BOOST_CHECK_THROW(g.poisson(0.0), Invalid_argument);
+     for (int j = 0; j < 100; j++)
+          BOOST_CHECK_THROW(g.poisson(1e10), std::overflow_error);
 }
 
 BOOST_AUTO_TEST_CASE(negative_binomial_test) {
@@ -193,7 +198,7 @@ BOOST_AUTO_TEST_CASE(negative_binomial_test) {
                     s += g.negative_binomial(ti, pj);
           }
      }
-     BOOST_CHECK(s == 3760982173u);
+     BOOST_CHECK(s == 3755337728u);
      BOOST_CHECK_THROW(g.negative_binomial(0.0, 0.5),
                        Invalid_argument);
      BOOST_CHECK_THROW(g.negative_binomial(1.0, 0.0),
@@ -202,6 +207,99 @@ BOOST_AUTO_TEST_CASE(negative_binomial_test) {
                        Invalid_argument);
 }
 
+BOOST_AUTO_TEST_CASE(ziggurat_test) {
+     MZT g, h;
+     std::size_t const n = 200000;
+     std::vector<double> x(n);
+     g.normal(x.data(), n);
+     double s = 0.0, s2 = 0.0;
+     for (std::size_t i = 0; i < n; i++) {
+          BOOST_CHECK(x[i] == h.ziggurat_normal());
+          s += x[i];
+          s2 += x[i] * x[i];
+     }
+     BOOST_CHECK(std::abs(s / n) < 0.01);
+     BOOST_CHECK(std::abs(s2 / n - 1.0) < 0.01);
+     g.exponential(x.data(), n);
+     s = s2 = 0.0;
+     for (std::size_t i = 0; i < n; i++) {
+          BOOST_CHECK(x[i] == h.ziggurat_exponential());
+          BOOST_CHECK(x[i] >= 0.0);
+          s += x[i];
+          s2 += x[i] * x[i];
+     }
+     BOOST_CHECK(std::abs(s / n - 1.0) < 0.01);
+     BOOST_CHECK(std::abs(s2 / n - 2.0) < 0.04);
+     g.uniform(x.data(), n);
+     for (std::size_t i = 0; i < n; i++)
+          BOOST_CHECK(x[i] == h());
+}
+
+BOOST_AUTO_TEST_CASE(alias_table_test) {
+     using SHG::Alias_table;
+     MZT g;
+     Vecdouble const w{0.5, 0.0, 2.0, 1.0, 0.5, 0.0};
+     Alias_table const a(w);
+     BOOST_CHECK(a.size() == w.size());
+     int const n = 400000;
+     std::vector<int> k(w.size());
+     for (int i = 0; i < n; i++) {
+          int const x = a(g);
+          BOOST_REQUIRE(x >= 0 && x < static_cast<int>(w.size()));
+          k[x]++;
+     }
+     for (std::size_t i = 0; i < w.size(); i++) {
+          double const p = w[i] / 4.0;
+          double const sd = std::sqrt(n * p * (1.0 - p));
+          BOOST_CHECK(std::abs(k[i] - n * p) <= 4.0 * sd);
+     }
+     BOOST_CHECK(k[1] == 0 && k[5] == 0);
+
+     Alias_table const a1(Vecdouble{3.0});
+     for (int i = 0; i < 100; i++)
+          BOOST_CHECK(a1(g) == 0);
+
+     BOOST_CHECK_THROW(Alias_table{Vecdouble()}, Invalid_argument);
+     BOOST_CHECK_THROW(Alias_table(Vecdouble{1.0, -1.0}),
+                       Invalid_argument);
+     BOOST_CHECK_THROW(Alias_table(Vecdouble{0.0, 0.0}),
+                       Invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(binomial_poisson_moments_test) {
+     MZT g;
+     int const n = 100000;
+     for (double const p : {0.01, 0.3, 0.5, 0.9}) {
+          for (unsigned int const m : {20u, 100u, 1000u, 100000u}) {
+               double s = 0.0, s2 = 0.0;
+               for (int i = 0; i < n; i++) {
+                    unsigned int const x = g.binomial(p, m);
+                    BOOST_REQUIRE(x <= m);
+                    s += x;
+                    s2 += static_cast<double>(x) * x;
+               }
+               double const mean = s / n;
+               double const var = s2 / n - mean * mean;
+               double const v = m * p * (1.0 - p);
+               BOOST_CHECK(std::abs(mean - m * p) <
+                           5.0 * std::sqrt(v / n));
+               BOOST_CHECK(std::abs(var / v - 1.0) < 0.04);
+          }
+     }
+     for (double const mu : {0.5, 9.0, 10.0, 30.0, 1000.0, 1e6}) {
+          double s = 0.0, s2 = 0.0;
+          for (int i = 0; i < n; i++) {
+               double const x = g.poisson(mu);
+               s += x;
+               s2 += x * x;
+          }
+          double const mean = s / n;
+          double const var = s2 / n - mean * mean;
+          BOOST_CHECK(std::abs(mean - mu) < 5.0 * std::sqrt(mu / n));
+          BOOST_CHECK(std::abs(var / mu - 1.0) < 0.03);
+     }
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace TESTS
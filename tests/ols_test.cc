@@ -1,4 +1,5 @@
 #include <shg/ols.h>
+#include <cmath>
 #include <cstring>
 #include <sstream>
 #include "tests.h"
@@ -885,6 +886,179 @@ BOOST_AUTO_TEST_CASE(strdlr_wampler5_test) {
      BOOST_CHECK(nd >= 15);
 }
 
+BOOST_AUTO_TEST_CASE(accumulator_test) {
+     using SHG::OLS_accumulator;
+     using SHG::freq;
+     Matdouble X(greene7_8_X);
+     for (size_t i = 0; i < X.nrows(); i++)
+          X(i, 0) += 1900.0;
+     Vecdouble const& y = greene7_8_y;
+     OLS const ols(X, y);
+
+     // The whole sample in one accumulator gives the same results.
+     OLS_accumulator a(X.ncols());
+     a.add(X, y);
+     OLS const ols1(a);
+     BOOST_CHECK(ols1.nobs() == ols.nobs());
+     BOOST_CHECK(ols1.nparams() == ols.nparams());
+     BOOST_CHECK(ols1.intercept());
+     for (int i = 0; i < ols.nparams(); i++)
+          BOOST_CHECK(ols1.beta()(i) == ols.beta()(i));
+     BOOST_CHECK(ols1.mean_y() == ols.mean_y());
+     BOOST_CHECK(ols1.stddev_y() == ols.stddev_y());
+     BOOST_CHECK(ols1.tss() == ols.tss());
+     BOOST_CHECK(ols1.fitted().size() == 0);
+     BOOST_CHECK(ols1.residuals().size() == 0);
+
+     // Three accumulators merged.
+     std::size_t const n1 = 10, n2 = 25;
+     OLS_accumulator a1(X.ncols()), a2(X.ncols()), a3(X.ncols());
+     for (std::size_t l = 0; l < n1; l++)
+          a1.add(X[l], y(l));
+     for (std::size_t l = n1; l < n2; l++)
+          a2.add(X[l], y(l));
+     for (std::size_t l = n2; l < X.nrows(); l++)
+          a3.add(X[l], y(l));
+     a2.merge(a3);
+     a1.merge(a2);
+     BOOST_CHECK(a1.nobs() == ols.nobs());
+     OLS const ols2(a1);
+     double const eps = 1e-6;
+     for (int i = 0; i < ols.nparams(); i++) {
+          BOOST_CHECK(freq(ols2.beta()(i), ols.beta()(i), eps));
+          BOOST_CHECK(freq(ols2.tstat()(i), ols.tstat()(i), eps));
+          BOOST_CHECK(freq(ols2.pvalt()(i), ols.pvalt()(i), eps));
+          for (int j = 0; j < ols.nparams(); j++)
+               BOOST_CHECK(
+                    freq(ols2.cov()(i, j), ols.cov()(i, j), eps));
+     }
+     BOOST_CHECK(freq(ols2.rss(), ols.rss(), eps));
+     BOOST_CHECK(freq(ols2.r2(), ols.r2(), 1e-8));
+     BOOST_CHECK(freq(ols2.fstat(), ols.fstat(), eps));
+     BOOST_CHECK(freq(ols2.pvalf(), ols.pvalf(), eps));
+     BOOST_CHECK(freq(ols2.mean_y(), ols.mean_y(), 1e-14));
+     BOOST_CHECK(freq(ols2.stddev_y(), ols.stddev_y(), 1e-14));
+     BOOST_CHECK(ols2.positive_y() == ols.positive_y());
+
+     OLS_accumulator b(X.ncols(), false);
+     BOOST_CHECK_THROW(a1.merge(b), OLS::Invalid_argument);
+     BOOST_CHECK_THROW(b.add(X, Vecdouble(3)), OLS::Invalid_argument);
+     BOOST_CHECK_THROW(OLS{b}, OLS::Invalid_argument);
+     BOOST_CHECK_THROW(OLS_accumulator(0, false),
+                       OLS::Invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(rolling_ols_test) {
+     using SHG::Rolling_OLS;
+     using SHG::faeq;
+     int const n = 200, k = 3;
+     Matdouble X(n, k);
+     Vecdouble y(n);
+     for (int t = 0; t < n; t++) {
+          X(t, 0) = std::sin(0.1 * t);
+          X(t, 1) = std::cos(0.37 * t) + 0.01 * t;
+          X(t, 2) = (t % 7) - 3.0;
+          y(t) = 1.0 + 2.0 * X(t, 0) - X(t, 1) + 0.5 * X(t, 2) +
+                 std::sin(1.3 * t * t);
+     }
+     double const eps = 1e-9;
+     for (int w : {10, 25, 50})
+          for (bool intercept : {true, false})
+               for (bool expanding : {false, true}) {
+                    Rolling_OLS const r(X, y, w, intercept,
+                                        expanding);
+                    BOOST_CHECK(r.nwindows() == n - w + 1);
+                    BOOST_CHECK(r.window() == w);
+                    for (int j = 0; j < r.nwindows(); j++) {
+                         int const first = expanding ? 0 : j;
+                         int const nobs = j + w - first;
+                         Matdouble Xj(nobs, k);
+                         Vecdouble yj(nobs);
+                         for (int t = 0; t < nobs; t++) {
+                              for (int i = 0; i < k; i++)
+                                   Xj(t, i) = X(first + t, i);
+                              yj(t) = y(first + t);
+                         }
+                         OLS const ols(Xj, yj, intercept);
+                         BOOST_REQUIRE(r.nparams() == ols.nparams());
+                         for (int i = 0; i < ols.nparams(); i++) {
+                              BOOST_CHECK(faeq(r.beta()(j, i),
+                                               ols.beta()(i), eps));
+                              BOOST_CHECK(
+                                   faeq(r.standard_err()(j, i),
+                                        ols.standard_err()(i), eps));
+                         }
+                         BOOST_CHECK(
+                              faeq(r.ser()(j), ols.ser(), eps));
+                         BOOST_CHECK(
+                              faeq(r.r2()(j), ols.r2(), eps));
+                         BOOST_CHECK(faeq(r.fstat()(j), ols.fstat(),
+                                          eps * ols.fstat()));
+                         BOOST_CHECK(faeq(r.pvalf()(j), ols.pvalf(),
+                                          eps));
+                         for (int i = 0; i < ols.nparams(); i++)
+                              BOOST_CHECK(faeq(r.pvalt()(j, i),
+                                               ols.pvalt()(i), eps));
+                    }
+               }
+
+     // Many series in parallel.
+     std::vector<Matdouble> vX(5, X);
+     std::vector<Vecdouble> vy(5, y);
+     for (int i = 0; i < 5; i++)
+          for (int t = 0; t < n; t++)
+               vy[i](t) *= i + 1.0;
+     auto const v = SHG::rolling_ols(vX, vy, 20);
+     BOOST_REQUIRE(v.size() == 5);
+     for (int i = 0; i < 5; i++) {
+          Rolling_OLS const r(vX[i], vy[i], 20);
+          BOOST_CHECK(v[i].beta().vector() == r.beta().vector());
+          BOOST_CHECK(v[i].r2() == r.r2());
+     }
+
+     BOOST_CHECK_THROW(Rolling_OLS(X, y, k + 1),
+                       OLS::Invalid_argument);
+     BOOST_CHECK_THROW(Rolling_OLS(X, y, n + 1),
+                       OLS::Invalid_argument);
+     vy.pop_back();
+     BOOST_CHECK_THROW(SHG::rolling_ols(vX, vy, 20),
+                       OLS::Invalid_argument);
+
+     // Singular windows give NaN.
+     Matdouble X1(20, 1, 0.0);
+     Vecdouble y1(20, 1.0);
+     for (int t = 10; t < 20; t++)
+          X1(t, 0) = t;
+     Rolling_OLS const r1(X1, y1, 5);
+     BOOST_CHECK(std::isnan(r1.beta()(0, 1)));
+     BOOST_CHECK(std::isnan(r1.r2()(5)));
+     BOOST_CHECK(std::isnan(r1.pvalt()(5, 0)));
+     BOOST_CHECK(std::isnan(r1.pvalf()(5)));
+     BOOST_CHECK(!std::isnan(r1.beta()(6, 1)));
+     BOOST_CHECK(faeq(r1.beta()(15, 0), 1.0, eps));
+
+     // Singularity does not depend on the scale of the data.
+     Matdouble X2(X);
+     for (int t = 0; t < n; t++)
+          for (int i = 0; i < k; i++)
+               X2(t, i) *= 1e-8;
+     Rolling_OLS const r2(X2, y, 20);
+     Rolling_OLS const r3(X, y, 20);
+     for (int j = 0; j < r2.nwindows(); j++) {
+          double const b = 1e8 * r3.beta()(j, 1);
+          BOOST_CHECK(faeq(r2.beta()(j, 1), b, 1e-9 * std::abs(b)));
+          BOOST_CHECK(faeq(r2.r2()(j), r3.r2()(j), eps));
+     }
+     for (int t = 0; t < n; t++) {
+          X2(t, 0) = 1e8 * t;
+          X2(t, 1) = 2e8 * t + 1e-3 * (t % 2);
+          X2(t, 2) = 1e8 * (t % 7);
+     }
+     Rolling_OLS const r4(X2, y, 20);
+     for (int j = 0; j < r4.nwindows(); j++)
+          BOOST_CHECK(std::isnan(r4.beta()(j, 1)));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace TESTS
@@ -0,0 +1,355 @@
+#include <shg/packpoly.h>
+#include <sstream>
+#include <shg/alggeom.h>
+#include <shg/mzt.h>
+#include <shg/utils.h>
+#include "tests.h"
+
+namespace TESTS {
+
+BOOST_AUTO_TEST_SUITE(packpoly_test)
+
+using SHG::ALGEBRA::Element_coefficients;
+using SHG::ALGEBRA::Monomial;
+using SHG::ALGEBRA::Monomial_cmp;
+using SHG::ALGEBRA::Packed_layout;
+using SHG::ALGEBRA::Packed_order;
+using SHG::ALGEBRA::Packed_polynomial;
+using SHG::ALGEBRA::Polynomial;
+using SHG::ALGEBRA::grevlex_cmp;
+using SHG::ALGEBRA::grlex_cmp;
+using SHG::ALGEBRA::lex_cmp;
+using SHG::ALGEBRA::ALGGEOM::Polynomial_div;
+
+Packed_order const orders[] = {Packed_order::lex, Packed_order::grlex,
+                               Packed_order::grevlex};
+
+Monomial random_monomial(SHG::MZT& g, int dim, int maxexp) {
+     std::vector<int> e(dim);
+     for (auto& ei : e)
+          ei = g.uni(maxexp + 1);
+     return Monomial(e);
+}
+
+/**
+ * Returns a random polynomial over Q with at most n terms and
+ * exponents not greater than maxexp.
+ */
+Polynomial random_polynomial(SHG::MZT& g, int dim, int n,
+                             int maxexp, Monomial_cmp cmp) {
+     std::ostringstream oss;
+     oss << dim << ' ' << n;
+     for (int i = 0; i < n; i++) {
+          oss << ' ' << g.uni(-9, 9) << "/1 " << dim;
+          for (int j = 0; j < dim; j++)
+               oss << ' ' << g.uni(maxexp + 1);
+     }
+     Polynomial p = SHG::from_string<Polynomial>(oss.str());
+     p.order(cmp);
+     return p;
+}
+
+// Equal to lex_cmp(), grlex_cmp() and grevlex_cmp(), but not
+// recognized by packed_order(), so that Polynomial_div does not use
+// packed polynomials.
+bool lex_cmp1(Monomial const& x, Monomial const& y) {
+     return lex_cmp(x, y);
+}
+
+bool grlex_cmp1(Monomial const& x, Monomial const& y) {
+     return grlex_cmp(x, y);
+}
+
+bool grevlex_cmp1(Monomial const& x, Monomial const& y) {
+     return grevlex_cmp(x, y);
+}
+
+BOOST_AUTO_TEST_CASE(packed_order_test) {
+     using SHG::ALGEBRA::monomial_cmp;
+     using SHG::ALGEBRA::packed_order;
+     Packed_order order = Packed_order::grlex;
+     for (auto const o : orders) {
+          BOOST_CHECK(packed_order(monomial_cmp(o), order));
+          BOOST_CHECK(order == o);
+     }
+     BOOST_CHECK(!packed_order(lex_cmp1, order));
+     BOOST_CHECK(order == Packed_order::grevlex);
+     BOOST_CHECK_THROW(Packed_layout(0, Packed_order::lex),
+                       std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(packed_layout_test) {
+     SHG::MZT g;
+     std::vector<std::uint64_t> x, y, z;
+     for (int dim = 1; dim <= 20; dim++) {
+          for (auto const o : orders) {
+               Packed_layout const layout(dim, o);
+               auto const cmp = SHG::ALGEBRA::monomial_cmp(o);
+               BOOST_CHECK(layout.words() == 1 + (dim + 7) / 8);
+               x.resize(layout.words());
+               y.resize(layout.words());
+               z.resize(layout.words());
+               for (int k = 0; k < 200; k++) {
+                    int const maxexp = k % 2 == 0 ? 2 : 63;
+                    Monomial const a =
+                         random_monomial(g, dim, maxexp);
+                    Monomial const b =
+                         random_monomial(g, dim, maxexp);
+                    layout.pack(a, x.data());
+                    layout.pack(b, y.data());
+                    BOOST_CHECK(layout.unpack(x.data()) == a);
+                    BOOST_CHECK(layout.deg(x.data()) == a.deg());
+                    int const c = layout.compare(x.data(), y.data());
+                    BOOST_CHECK((c < 0) == cmp(a, b));
+                    BOOST_CHECK((c > 0) == cmp(b, a));
+                    BOOST_CHECK((c == 0) == (a == b));
+                    BOOST_CHECK(layout.divides(x.data(), y.data()) ==
+                                a.divides(b));
+                    layout.mul(x.data(), y.data(), z.data());
+                    BOOST_CHECK(layout.unpack(z.data()) == a * b);
+                    BOOST_CHECK(layout.deg(z.data()) ==
+                                (a * b).deg());
+                    layout.div(z.data(), x.data(), z.data());
+                    BOOST_CHECK(layout.unpack(z.data()) == b);
+                    layout.lcm(x.data(), y.data(), z.data());
+                    BOOST_CHECK(layout.unpack(z.data()) == lcm(a, b));
+                    BOOST_CHECK(layout.deg(z.data()) ==
+                                lcm(a, b).deg());
+               }
+          }
+     }
+     Packed_layout const layout(3, Packed_order::grlex);
+     x.resize(layout.words());
+     y.resize(layout.words());
+     z.resize(layout.words());
+     BOOST_CHECK_THROW(layout.pack(Monomial{1, 2}, x.data()),
+                       std::invalid_argument);
+     BOOST_CHECK_THROW(layout.pack(Monomial{1, 128, 0}, x.data()),
+                       std::overflow_error);
+     layout.pack(Monomial{1, 127, 0}, x.data());
+     layout.pack(Monomial{0, 0, 127}, y.data());
+     BOOST_CHECK_NO_THROW(layout.mul(x.data(), y.data(), z.data()));
+     layout.pack(Monomial{0, 1, 0}, y.data());
+     BOOST_CHECK_THROW(layout.mul(x.data(), y.data(), z.data()),
+                       std::overflow_error);
+}
+
+BOOST_AUTO_TEST_CASE(packed_polynomial_test) {
+     using SHG::ALGEBRA::to_packed;
+     using SHG::ALGEBRA::to_polynomial;
+     SHG::MZT g;
+     for (auto const o : orders) {
+          auto const cmp = SHG::ALGEBRA::monomial_cmp(o);
+          Packed_layout const layout(4, o);
+          for (int k = 0; k < 20; k++) {
+               Polynomial const p =
+                    random_polynomial(g, 4, 30, 5, cmp);
+               Polynomial const q =
+                    random_polynomial(g, 4, 30, 5, cmp);
+               Element_coefficients const field(p.as());
+               auto pp = to_packed(p, layout, field);
+               auto const pq = to_packed(q, layout, field);
+               BOOST_CHECK(pp.size() == p.terms().size());
+               BOOST_CHECK(to_polynomial(pp, p.as()) == p);
+               if (p.is_zero())
+                    continue;
+               BOOST_CHECK(layout.unpack(pp.leading_monomial()) ==
+                           p.leading_monomial());
+               BOOST_CHECK(pp.leading_coefficient() ==
+                           p.leading_coefficient());
+               for (std::size_t i = 1; i < pp.size(); i++)
+                    BOOST_CHECK(layout.compare(pp.monomial(i - 1),
+                                               pp.monomial(i)) > 0);
+
+               // p - a u q
+               Monomial const u = random_monomial(g, 4, 3);
+               std::vector<std::uint64_t> w(layout.words());
+               layout.pack(u, w.data());
+               auto const a = q.is_zero() ? p.leading_coefficient()
+                                          : q.leading_coefficient();
+               pp.sub_mul(a, w.data(), pq);
+               Polynomial const r = p - SHG::ALGEBRA::Term(a, u) * q;
+               BOOST_CHECK(to_polynomial(pp, p.as()) == r);
+               while (!pp.is_zero())
+                    pp.pop_front();
+          }
+     }
+}
+
+BOOST_AUTO_TEST_CASE(packed_division_test) {
+     Monomial_cmp const cmp[] = {lex_cmp, grlex_cmp, grevlex_cmp};
+     Monomial_cmp const cmp1[] = {lex_cmp1, grlex_cmp1, grevlex_cmp1};
+     SHG::MZT g;
+     for (int k = 0; k < 60; k++) {
+          int const dim = 1 + k % 4;
+          int const l = k % 3;
+          Polynomial const f =
+               random_polynomial(g, dim, 12, 5, cmp[l]);
+          std::vector<Polynomial> d, d1;
+          for (int i = 0; i < 3; i++) {
+               Polynomial p;
+               do {
+                    p = random_polynomial(g, dim, 3, 2, cmp[l]);
+               } while (p.is_zero());
+               d.push_back(p);
+               p.order(cmp1[l]);
+               d1.push_back(p);
+          }
+          Polynomial f1{f};
+          f1.order(cmp1[l]);
+          Polynomial_div pd, pd1;
+          pd.divide(f, d);
+          pd1.divide(f1, d1);
+          BOOST_CHECK(pd.r == pd1.r);
+          BOOST_CHECK(pd.r.order() == cmp[l]);
+          BOOST_REQUIRE(pd.a.size() == pd1.a.size());
+          for (std::size_t i = 0; i < pd.a.size(); i++) {
+               BOOST_CHECK(pd.a[i] == pd1.a[i]);
+               BOOST_CHECK(pd.a[i].order() == cmp[l]);
+          }
+     }
+}
+
+BOOST_AUTO_TEST_CASE(packed_division_overflow_test) {
+     // x^100y divided by x^50 - y^120 gives the quotient x^50y +
+     // y^121 and the remainder y^241, which cannot be packed.
+     auto const f =
+          SHG::from_string<Polynomial>("2 1 1/1 2 100 1");
+     auto const d = SHG::from_string<Polynomial>(
+          "2 2 1/1 2 50 0 -1/1 2 0 120");
+     Polynomial_div pd;
+     pd.divide(f, {d});
+     BOOST_REQUIRE(pd.a.size() == 1);
+     BOOST_CHECK(pd.a[0] == SHG::from_string<Polynomial>(
+                                 "2 2 1/1 2 50 1 1/1 2 0 121"));
+     BOOST_CHECK(pd.r ==
+                 SHG::from_string<Polynomial>("2 1 1/1 2 0 241"));
+}
+
+BOOST_AUTO_TEST_CASE(zp_coefficients_test) {
+     using SHG::ALGEBRA::Ring_Zn;
+     using SHG::ALGEBRA::Zp_coefficients;
+     for (int const p : {3, 7, 32003, 2147483647}) {
+          Ring_Zn const F(p);
+          Zp_coefficients const Z(&F);
+          BOOST_CHECK(Z.p() == static_cast<std::uint32_t>(p));
+          BOOST_CHECK(Z.is_zero(Z.from_element(F.zero())));
+          BOOST_CHECK(Z.is_one(Z.from_element(F.one())));
+          // Ring_Zn overflows for large p, the results are
+          // calculated directly.
+          auto const value = [&](std::uint32_t a) {
+               return static_cast<long long>(
+                    F.value(Z.to_element(a)));
+          };
+          SHG::MZT g;
+          for (int k = 0; k < 1000; k++) {
+               long long const x = g.uni(p);
+               long long const y = g.uni(p);
+               auto const a = Z.from_element(F.element(x));
+               auto const b = Z.from_element(F.element(y));
+               BOOST_CHECK(value(a) == x);
+               BOOST_CHECK(value(Z.neg(a)) == (p - x) % p);
+               BOOST_CHECK(value(Z.sub(a, b)) == (x - y + p) % p);
+               BOOST_CHECK(value(Z.mul(a, b)) == x * y % p);
+               if (!Z.is_zero(b)) {
+                    BOOST_CHECK(Z.mul(Z.div(a, b), b) == a);
+                    BOOST_CHECK(Z.is_one(Z.mul(b, Z.inv(b))));
+               }
+          }
+     }
+     for (int const p : {1, 2, 9, 32001}) {
+          Ring_Zn const F(p);
+          BOOST_CHECK_THROW(Zp_coefficients{&F},
+                            std::invalid_argument);
+     }
+}
+
+BOOST_AUTO_TEST_CASE(fraction_free_coefficients_test) {
+     using SHG::ALGEBRA::Field_Q;
+     using SHG::ALGEBRA::Fraction_free_coefficients;
+     using SHG::ALGEBRA::clear_denominators;
+     using Coef = Fraction_free_coefficients::Coef;
+     auto const p = SHG::from_string<Polynomial>(
+          "2 3 1/2 2 1 0 -2/3 2 0 1 5/1 2 0 0");
+     auto const& F = dynamic_cast<Field_Q const&>(*p.as());
+     Fraction_free_coefficients const Q(&F);
+     BOOST_CHECK(Q.from_element(F.element(-12)) == -12);
+     BOOST_CHECK(Q.to_element(Coef(5)) == F.element(5));
+     BOOST_CHECK_THROW(Q.from_element(F.element(1, 2)),
+                       std::invalid_argument);
+     Coef a, b;
+     Q.factors(Coef(6), Coef(-4), b, a);
+     BOOST_CHECK(b == 2 && a == -3);
+     std::vector<Coef> c{-6, 4, 10};
+     Q.normalize(c.data(), c.data() + c.size());
+     BOOST_CHECK(c == std::vector<Coef>({3, -2, -5}));
+
+     auto const q = clear_denominators(p);
+     BOOST_CHECK(q == p * F.element(6));
+     SHG::ALGEBRA::Ring_Zn const Z5(5);
+     BOOST_CHECK_THROW(clear_denominators(Polynomial(&Z5)),
+                       std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(reduce_test) {
+     using SHG::ALGEBRA::Field_Q;
+     using SHG::ALGEBRA::Fraction_free_coefficients;
+     using SHG::ALGEBRA::clear_denominators;
+     using SHG::ALGEBRA::reduce;
+     using SHG::ALGEBRA::to_packed;
+     using SHG::ALGEBRA::to_polynomial;
+     Monomial_cmp const cmp[] = {lex_cmp, grlex_cmp, grevlex_cmp};
+     SHG::MZT g;
+     for (int k = 0; k < 30; k++) {
+          int const l = k % 3;
+          Packed_layout const layout(3, orders[l]);
+          Polynomial const f = random_polynomial(g, 3, 12, 5, cmp[l]);
+          std::vector<Polynomial> d;
+          for (int i = 0; i < 3; i++) {
+               Polynomial p;
+               do {
+                    p = random_polynomial(g, 3, 3, 2, cmp[l]);
+               } while (p.is_zero());
+               d.push_back(p);
+          }
+          Polynomial_div pd;
+          pd.divide(f, d);
+
+          Element_coefficients const E(f.as());
+          auto pf = to_packed(f, layout, E);
+          std::vector<Packed_polynomial<Element_coefficients>> pd1;
+          std::vector<Packed_polynomial<Element_coefficients> const*>
+               t1;
+          for (auto const& p : d)
+               pd1.push_back(to_packed(p, layout, E));
+          for (auto const& p : pd1)
+               t1.push_back(&p);
+          reduce(pf, t1);
+          BOOST_CHECK(to_polynomial(pf, f.as()) == pd.r);
+
+          auto const F = dynamic_cast<Field_Q const*>(f.as());
+          BOOST_REQUIRE(F != nullptr);
+          Fraction_free_coefficients const Q(F);
+          auto pq = to_packed(clear_denominators(f), layout, Q);
+          std::vector<Packed_polynomial<Fraction_free_coefficients>>
+               pd2;
+          std::vector<
+               Packed_polynomial<Fraction_free_coefficients> const*>
+               t2;
+          for (auto const& p : d)
+               pd2.push_back(
+                    to_packed(clear_denominators(p), layout, Q));
+          for (auto const& p : pd2)
+               t2.push_back(&p);
+          reduce(pq, t2);
+          auto const r = to_polynomial(pq, f.as());
+          BOOST_REQUIRE(r.is_zero() == pd.r.is_zero());
+          if (!r.is_zero())
+               BOOST_CHECK(r * pd.r.leading_coefficient() ==
+                           pd.r * r.leading_coefficient());
+     }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace TESTS
@@ -1,4 +1,5 @@
 #include <shg/pcfg.h>
+#include <cmath>
 #include <iomanip>
 #include <sstream>
 #include <shg/mzt.h>
@@ -99,6 +100,144 @@ BOOST_AUTO_TEST_CASE(basic_test) {
      BOOST_CHECK(q == res_cyk);
 }
 
+BOOST_AUTO_TEST_CASE(log_space_test) {
+     PCFG pcfg;
+     pcfg.set(test_grammars[2], probs);
+     BOOST_CHECK(!pcfg.log_space());
+     pcfg.set_log_space(true);
+     BOOST_CHECK(pcfg.log_space());
+     Sentence const X{"astronomers", "saw", "stars", "with", "ears"};
+     double const prob = pcfg.prob(X);
+     BOOST_CHECK(faeq(prob, 0.0015876, tol));
+     BOOST_CHECK(faeq(pcfg.log_prob(X), std::log(0.0015876), tol));
+     for (PCFG::Index k = 0; k < X.size(); k++) {
+          double const prob_outside = pcfg.prob_outside(X, k);
+          BOOST_CHECK(faeq(prob_outside, prob, tol));
+     }
+     double prob2;
+     PCFG::Parse_tree t;
+     pcfg.cyk(X, prob2, t);
+     BOOST_CHECK(faeq(prob2, 0.0009072, tol));
+     BOOST_CHECK(t.to_string() == res_cyk);
+     pcfg.log_cyk(X, prob2, t);
+     BOOST_CHECK(faeq(prob2, std::log(0.0009072), tol));
+     BOOST_CHECK(t.to_string() == res_cyk);
+     // The charts are reused for a shorter sentence.
+     Sentence const Y{"astronomers", "saw", "stars"};
+     pcfg.set_log_space(false);
+     double const p1 = pcfg.prob(Y);
+     pcfg.set_log_space(true);
+     BOOST_CHECK(faeq(pcfg.prob(Y), p1, tol));
+     BOOST_CHECK(faeq(pcfg.prob(X), prob, tol));
+}
+
+BOOST_AUTO_TEST_CASE(log_space_underflow_test) {
+     std::vector<double> const probs{0.05, 0.05, 0.45, 0.45,
+                                     1.0,  1.0,  1.0,  1.0};
+     PCFG pcfg;
+     pcfg.set(test_grammars[19], probs);
+     MZT mzt;
+     for (std::size_t const n : {10, 40, 600}) {
+          // A random palindrome of length n.
+          Sentence X(n);
+          for (std::size_t i = 0; i < n / 2; i++)
+               X[i] = X[n - 1 - i] = mzt.uni(2) == 0 ? "a" : "b";
+          pcfg.set_log_space(false);
+          double const lp0 = pcfg.log_prob(X);
+          pcfg.set_log_space(true);
+          double const lp1 = pcfg.log_prob(X);
+          double p1;
+          PCFG::Parse_tree t1;
+          pcfg.log_cyk(X, p1, t1);
+          BOOST_CHECK(std::isfinite(lp1));
+          BOOST_CHECK(faeq(p1, lp1, 1e-12));
+          if (n < 100) {
+               BOOST_CHECK(faeq(lp0, lp1, 1e-12));
+               pcfg.set_log_space(false);
+               double p0;
+               PCFG::Parse_tree t0;
+               pcfg.log_cyk(X, p0, t0);
+               BOOST_CHECK(faeq(p0, p1, 1e-12));
+               BOOST_CHECK(t0.to_string() == t1.to_string());
+          } else {
+               BOOST_CHECK(std::isinf(lp0));
+          }
+     }
+}
+
+BOOST_AUTO_TEST_CASE(beam_cyk_test) {
+     PCFG pcfg;
+     pcfg.set(test_grammars[2], probs);
+     Sentence const X{"astronomers", "saw", "stars", "with", "ears"};
+     double prob;
+     PCFG::Parse_tree t;
+     PCFG::Beam_stats stats;
+     pcfg.beam_cyk(X, 6, 0.0, prob, t, stats);
+     BOOST_CHECK(faeq(prob, 0.0009072, tol));
+     BOOST_CHECK(t.to_string() == res_cyk);
+     // 4 of the 15 cells are empty even without pruning.
+     BOOST_CHECK(stats.cells == 11);
+     BOOST_CHECK(stats.edges > 0);
+     BOOST_CHECK(stats.pruned == 0);
+     BOOST_CHECK(!stats.fallback);
+     pcfg.beam_cyk(X, 1, 0.5, prob, t, stats);
+     BOOST_CHECK(faeq(prob, 0.0009072, tol));
+     BOOST_CHECK(t.to_string() == res_cyk);
+     BOOST_CHECK(stats.pruned > 0);
+     BOOST_CHECK(stats.cells == 11);
+     BOOST_CHECK(!stats.fallback);
+     // NP --> saw is pruned in favour of V --> saw.
+     Sentence const Y{"astronomers", "saw", "saw"};
+     pcfg.beam_cyk(Y, 1, 0.0, prob, t, stats);
+     BOOST_CHECK(stats.fallback);
+     BOOST_CHECK(stats.cells < 6);
+     BOOST_CHECK(faeq(prob, 0.1 * 0.7 * 0.04, tol));
+     // B beats S in the root cell, but S is not pruned there.
+     PCFG pcfg1;
+     pcfg1.set({{"S", {"A", "A"}},
+                {"S", {"B", "B"}},
+                {"A", {"a"}},
+                {"B", {"A", "A"}}},
+               {0.3, 0.7, 1.0, 1.0});
+     pcfg1.beam_cyk({"a", "a"}, 1, 0.5, prob, t, stats);
+     BOOST_CHECK(!stats.fallback);
+     BOOST_CHECK(faeq(prob, 0.3, tol));
+     BOOST_CHECK(stats.cells == 3);
+     BOOST_CHECK_THROW(pcfg.beam_cyk(X, 0, 0.0, prob, t, stats),
+                       std::invalid_argument);
+     BOOST_CHECK_THROW(pcfg.beam_cyk(X, 1, 1.0, prob, t, stats),
+                       std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(beam_cyk_random_test) {
+     Vecprod vp = full_cnf(6, 2);
+     std::vector<double> prob;
+     MZT mzt;
+     add_probabilities(vp, prob, mzt);
+     PCFG pcfg;
+     pcfg.set(vp, prob);
+     for (int n = 0; n < 20; n++) {
+          Sentence w(mzt.uni(30) + 1);
+          for (auto& s : w)
+               s = mzt.uni(2) == 0 ? "t0" : "t1";
+          for (bool const log_space : {false, true}) {
+               pcfg.set_log_space(log_space);
+               double p0, p1, p2;
+               PCFG::Parse_tree t0, t1, t2;
+               PCFG::Beam_stats s1, s2;
+               pcfg.cyk(w, p0, t0);
+               pcfg.beam_cyk(w, 6, 0.0, p1, t1, s1);
+               BOOST_CHECK(p1 == p0);
+               BOOST_CHECK(t1.to_string() == t0.to_string());
+               BOOST_CHECK(s1.pruned == 0);
+               pcfg.beam_cyk(w, 2, 1e-3, p2, t2, s2);
+               BOOST_CHECK(p2 <= p0);
+               BOOST_CHECK(s2.edges <= s1.edges);
+               BOOST_CHECK(s2.cells <= s1.cells);
+          }
+     }
+}
+
 BOOST_DATA_TEST_CASE(inside_outside_probabilities_test,
                      bdata::xrange(8) * bdata::xrange(8), xr1, xr2) {
      std::vector<double> const probs{1.0, 0.25, 0.125, 0.75, 0.875};
@@ -398,6 +537,55 @@ BOOST_AUTO_TEST_CASE(inside_outside_basic_test) {
      BOOST_CHECK(oss.str() == inside_outside_besic_test_result);
 }
 
+BOOST_AUTO_TEST_CASE(parallel_inside_outside_test) {
+     Vecsent ts;
+     {
+          McKenzie gen;
+          gen.set_grammar(test_grammars[19]);
+          MZT mzt;
+          for (int n = 0; n < 50; n++) {
+               int const k = (mzt.uni(10) + 1) * 2;
+               auto const v = gen.generate(1, k);
+               ts.insert(ts.end(), v.begin(), v.end());
+          }
+     }
+     Vecprod vp = full_cnf(4, 2);
+     for (auto& p : vp) {
+          if (p.rhs[0] == "t0")
+               p.rhs[0] = "a";
+          else if (p.rhs[0] == "t1")
+               p.rhs[0] = "b";
+     }
+     std::vector<double> prob;
+     MZT mzt;
+     add_probabilities(vp, prob, mzt);
+     PCFG serial;
+     serial.set(vp, prob);
+     int iter0;
+     double logp0;
+     int const status0 =
+          serial.inside_outside(ts, 1e-8, tol, 10, iter0, logp0);
+     BOOST_CHECK(status0 == 2);
+     auto const vsp0 = serial.vecsprod();
+     for (unsigned nthreads : {1, 3, 0}) {
+          PCFG pcfg;
+          pcfg.set(vp, prob);
+          int iter;
+          double logp;
+          int const status = pcfg.inside_outside(
+               ts, 1e-8, tol, 10, iter, logp, nthreads);
+          BOOST_CHECK(status == status0);
+          BOOST_CHECK(iter == iter0);
+          BOOST_CHECK(faeq(logp, logp0, 1e-12));
+          BOOST_CHECK(faeq(pcfg.log_prob(ts), logp, 1e-12));
+          auto const vsp = pcfg.vecsprod();
+          BOOST_REQUIRE(vsp.size() == vsp0.size());
+          for (Vecsprod::size_type i = 0; i < vsp.size(); i++)
+               BOOST_CHECK(std::abs(vsp[i].prob - vsp0[i].prob) <
+                           1e-12);
+     }
+}
+
 BOOST_AUTO_TEST_CASE(constructor_test) {
      Vecprod const& vp0 = test_grammars[19];
      PCFG a;
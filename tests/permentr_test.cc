@@ -1,4 +1,6 @@
 #include <shg/permentr.h>
+#include <map>
+#include <shg/mzt.h>
 #include "tests.h"
 
 namespace TESTS {
@@ -39,6 +41,76 @@ BOOST_AUTO_TEST_CASE(const_test) {
                faeq(permutation_entropy(test_data, L), 0.0, 5e-6));
 }
 
+BOOST_AUTO_TEST_CASE(ordinal_pattern_counts_test) {
+     using SHG::ordinal_pattern;
+     using SHG::ordinal_pattern_counts;
+     typedef vector<std::size_t> Permutation;
+     SHG::MZT g;
+     vector<int> x(300);
+     for (auto& e : x)
+          e = g.uni(5);  // many ties
+     for (std::size_t L = 2; L <= 6; L++) {
+          std::map<Permutation, std::size_t> c;
+          Permutation p(L);
+          for (std::size_t n = 0; n + L <= x.size(); n++) {
+               std::iota(p.begin(), p.end(), 0);
+               std::stable_sort(
+                    p.begin(), p.end(),
+                    [n, &x](std::size_t i, std::size_t j) {
+                         return x[n + i] < x[n + j];
+                    });
+               c[p]++;
+          }
+          auto const counts =
+               ordinal_pattern_counts(x.data(), x.size(), L);
+          std::size_t total = 0;
+          for (std::size_t k = 0; k < counts.size(); k++) {
+               auto const it = c.find(ordinal_pattern(k, L));
+               BOOST_CHECK(counts[k] ==
+                           (it == c.end() ? 0 : it->second));
+               total += counts[k];
+          }
+          BOOST_CHECK(total == x.size() - L + 1);
+     }
+     BOOST_CHECK(ordinal_pattern(0, 4) == Permutation({0, 1, 2, 3}));
+     BOOST_CHECK(ordinal_pattern(23, 4) == Permutation({3, 2, 1, 0}));
+     BOOST_CHECK_THROW(ordinal_pattern(24, 4), std::invalid_argument);
+     BOOST_CHECK_THROW(ordinal_pattern_counts(x.data(), 5, 6),
+                       std::invalid_argument);
+     BOOST_CHECK_THROW(ordinal_pattern_counts(x.data(), x.size(), 11),
+                       std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(parallel_test) {
+     using SHG::multiscale_permutation_entropy;
+     SHG::MZT g;
+     vector<vector<double>> x(7, vector<double>(500));
+     for (auto& v : x)
+          for (auto& e : v)
+               e = g();
+     auto const h = permutation_entropy(x, 4, 3);
+     BOOST_REQUIRE(h.size() == x.size());
+     for (std::size_t i = 0; i < x.size(); i++)
+          BOOST_CHECK(h[i] == permutation_entropy(x[i], 4));
+
+     auto const m = multiscale_permutation_entropy(x[0], 3, 5, 2);
+     BOOST_REQUIRE(m.size() == 5);
+     BOOST_CHECK(m[0] == permutation_entropy(x[0], 3));
+     vector<double> y(x[0].size() / 5);
+     for (std::size_t j = 0; j < y.size(); j++) {
+          double s = 0.0;
+          for (std::size_t l = 0; l < 5; l++)
+               s += x[0][5 * j + l];
+          y[j] = s / 5;
+     }
+     BOOST_CHECK(m[4] == permutation_entropy(y, 3));
+     // White noise has nearly maximal entropy log2(3!) at all scales.
+     for (auto const e : m)
+          BOOST_CHECK(e > 2.3 && e <= std::log2(6.0) + 1e-12);
+     BOOST_CHECK_THROW(multiscale_permutation_entropy(x[0], 3, 200),
+                       std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace TESTS
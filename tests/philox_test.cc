@@ -0,0 +1,157 @@
+#include <shg/philox.h>
+#include <cmath>
+#include <set>
+#include <sstream>
+#include <vector>
+#include "tests.h"
+
+namespace TESTS {
+
+BOOST_AUTO_TEST_SUITE(philox_test)
+
+using SHG::Philox;
+
+// Known answers from the Random123 library.
+BOOST_AUTO_TEST_CASE(bijection_test) {
+     struct Kat {
+          Philox::Counter c;
+          Philox::Key k;
+          Philox::Counter r;
+     };
+     std::vector<Kat> const kat{
+          {{0, 0, 0, 0},
+           {0, 0},
+           {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}},
+          {{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+           {0xffffffff, 0xffffffff},
+           {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}},
+          {{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+           {0xa4093822, 0x299f31d0},
+           {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}}};
+     for (auto const& t : kat)
+          BOOST_CHECK(Philox::bijection(t.c, t.k) == t.r);
+}
+
+BOOST_AUTO_TEST_CASE(counter_test) {
+     std::uint64_t const seed = 0x299f31d0a4093822;
+     Philox g(seed, 7);
+     for (std::uint64_t i = 0; i < 10; i++) {
+          auto const b = Philox::bijection(
+               {static_cast<std::uint32_t>(i), 0, 7, 0},
+               {0xa4093822, 0x299f31d0});
+          BOOST_CHECK(g.bits() == (std::uint64_t{b[1]} << 32 | b[0]));
+          BOOST_CHECK(g.bits() == (std::uint64_t{b[3]} << 32 | b[2]));
+     }
+     BOOST_CHECK(g.seed() == seed);
+     BOOST_CHECK(g.stream() == 7);
+     BOOST_CHECK(g.position() == 20);
+}
+
+BOOST_AUTO_TEST_CASE(discard_test) {
+     Philox g(5, 3);
+     std::vector<std::uint64_t> u(100);
+     for (auto& x : u)
+          x = g.bits();
+     for (std::uint64_t n = 0; n < 50; n++) {
+          Philox h(5, 3);
+          h.discard(n);
+          h.discard(n);
+          for (std::size_t i = 2 * n; i < u.size(); i++)
+               BOOST_CHECK(h.bits() == u[i]);
+     }
+     Philox h(5, 3);
+     h.discard(std::uint64_t{1} << 40);
+     h.bits();
+     BOOST_CHECK(h.position() == (std::uint64_t{1} << 40) + 1);
+}
+
+BOOST_AUTO_TEST_CASE(substream_test) {
+     Philox const g(11);
+     std::set<std::uint64_t> s;
+     int const nstreams = 64;
+     int const n = 1000;
+     for (int i = 0; i < nstreams; i++) {
+          Philox h = g.substream(i);
+          BOOST_CHECK(h.seed() == 11);
+          BOOST_CHECK(h.stream() == static_cast<std::uint64_t>(i));
+          for (int j = 0; j < n; j++)
+               s.insert(h.bits());
+     }
+     BOOST_CHECK(s.size() == nstreams * n);
+     Philox h1(11, 1), h2 = g.substream(1);
+     for (int j = 0; j < n; j++)
+          BOOST_CHECK(h1() == h2());
+}
+
+BOOST_AUTO_TEST_CASE(bulk_test) {
+     std::size_t const n = 1001;
+     for (std::size_t skip : {0, 1}) {
+          Philox g(123), h(123);
+          g.discard(skip);
+          h.discard(skip);
+          std::vector<double> x(n), y(n);
+          g.uniform(x.data(), n);
+          for (std::size_t i = 0; i < n; i++)
+               y[i] = h();
+          BOOST_CHECK(x == y);
+          BOOST_CHECK(g.position() == h.position());
+          for (std::size_t k : {1, 2, 3, 500}) {
+               for (std::size_t i = 0; i < n; i += k)
+                    g.uniform(x.data() + i, std::min(k, n - i));
+               for (std::size_t i = 0; i < n; i++)
+                    y[i] = h();
+               BOOST_CHECK(x == y);
+          }
+     }
+}
+
+BOOST_AUTO_TEST_CASE(distribution_test) {
+     std::size_t const n = 1000000;
+     std::vector<double> x(n);
+     Philox g(2024);
+     auto const moments = [&x](double& m, double& v) {
+          double s = 0.0, s2 = 0.0;
+          for (double const t : x) {
+               s += t;
+               s2 += t * t;
+          }
+          m = s / x.size();
+          v = s2 / x.size() - m * m;
+     };
+     double m, v;
+     g.uniform(x.data(), n);
+     moments(m, v);
+     BOOST_CHECK(std::abs(m - 0.5) < 0.002);
+     BOOST_CHECK(std::abs(v - 1.0 / 12.0) < 0.001);
+     for (double const t : x)
+          BOOST_CHECK(t >= 0.0 && t < 1.0);
+     g.normal(x.data(), n);
+     moments(m, v);
+     BOOST_CHECK(std::abs(m) < 0.005);
+     BOOST_CHECK(std::abs(v - 1.0) < 0.005);
+     g.exponential(x.data(), n);
+     moments(m, v);
+     BOOST_CHECK(std::abs(m - 1.0) < 0.005);
+     BOOST_CHECK(std::abs(v - 1.0) < 0.01);
+     for (double const t : x)
+          BOOST_CHECK(t > 0.0 && std::isfinite(t));
+}
+
+BOOST_AUTO_TEST_CASE(write_read_test) {
+     Philox g(77, 5);
+     g.discard(13);
+     std::stringstream ss(bininpout);
+     g.write(ss);
+     BOOST_CHECK(!ss.fail());
+     Philox g1;
+     g1.read(ss);
+     BOOST_CHECK(!ss.fail());
+     BOOST_CHECK(g1.seed() == 77);
+     BOOST_CHECK(g1.stream() == 5);
+     for (int i = 0; i < 1000; i++)
+          BOOST_CHECK(g.uni(100) == g1.uni(100));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace TESTS
@@ -1,5 +1,6 @@
 #include <shg/polynomial.h>
 #include <shg/binom.h>
+#include <shg/mzt.h>
 #include <shg/utils.h>
 #include "tests.h"
 
@@ -501,6 +502,86 @@ BOOST_AUTO_TEST_CASE(polynomial1_over_Z_multiplication_test) {
      }
 }
 
+/**
+ * Returns \f$xy\f$ computed term by term.
+ */
+SHG::ALGEBRA::Polynomial naive_product(
+     SHG::ALGEBRA::Polynomial const& x,
+     SHG::ALGEBRA::Polynomial const& y) {
+     SHG::ALGEBRA::Polynomial z(x.as(), x.dim());
+     for (auto const& [m, a] : y.terms())
+          z += x * SHG::ALGEBRA::Term(a, m);
+     return z;
+}
+
+/**
+ * Returns a random polynomial over Z with at most n terms and
+ * exponents not greater than maxexp.
+ */
+SHG::ALGEBRA::Polynomial random_polynomial(
+     SHG::ALGEBRA::Ring_Z const* Z, SHG::MZT& g, int dim, int n,
+     int maxexp) {
+     using SHG::ALGEBRA::Monomial;
+     SHG::ALGEBRA::Polynomial p(Z, dim);
+     std::vector<int> e(dim);
+     for (int i = 0; i < n; i++) {
+          for (auto& ei : e)
+               ei = g.uni(maxexp + 1);
+          p += {Z->element(g.uni(-9, 9)), Monomial(e)};
+     }
+     return p;
+}
+
+BOOST_AUTO_TEST_CASE(multiply_test) {
+     using SHG::ALGEBRA::Monomial;
+     using SHG::ALGEBRA::Polynomial;
+     using SHG::ALGEBRA::Ring_Z;
+     using SHG::ALGEBRA::grlex_cmp;
+     using SHG::ALGEBRA::multiply;
+
+     Ring_Z const Z;
+     SHG::MZT g;
+     for (int dim = 1; dim <= 10; dim += 3) {
+          for (int n : {1, 5, 40, 300}) {
+               Polynomial const x =
+                    random_polynomial(&Z, g, dim, n, 6);
+               Polynomial const y =
+                    random_polynomial(&Z, g, dim, n, 6);
+               Polynomial const z = naive_product(x, y);
+               BOOST_CHECK(multiply(x, y) == z);
+               BOOST_CHECK(multiply(x, y, 4) == z);
+               BOOST_CHECK(x * y == z);
+               Polynomial const zero(&Z, dim);
+               BOOST_CHECK(multiply(x, zero).is_zero());
+          }
+     }
+
+     // Cancellation of all terms of the same monomial.
+     Polynomial x(&Z, 2), y(&Z, 2), z(&Z, 2);
+     x += {Z.element(1), Monomial{1, 0}};
+     x += {Z.element(1), Monomial{0, 1}};
+     y += {Z.element(1), Monomial{1, 0}};
+     y += {Z.element(-1), Monomial{0, 1}};
+     z += {Z.element(1), Monomial{2, 0}};
+     z += {Z.element(-1), Monomial{0, 2}};
+     BOOST_CHECK(multiply(x, y) == z);
+     BOOST_CHECK(z.terms().size() == 2);
+
+     // Exponents too large to be packed.
+     x += {Z.element(3), Monomial{200, 1}};
+     y += {Z.element(2), Monomial{0, 130}};
+     BOOST_CHECK(multiply(x, y) == naive_product(x, y));
+     BOOST_CHECK(multiply(x, y, 2) == naive_product(x, y));
+
+     // The order of the first factor is kept.
+     x.order(grlex_cmp);
+     BOOST_CHECK(multiply(x, y).order() == grlex_cmp);
+     BOOST_CHECK(multiply(y, x).order() != grlex_cmp);
+
+     BOOST_CHECK_THROW(multiply(x, Polynomial(&Z, 3)),
+                       std::invalid_argument);
+}
+
 BOOST_AUTO_TEST_CASE(polynomial1_over_Z_value_operator_test) {
      using SHG::ALGEBRA::Polynomial;
      using SHG::ALGEBRA::Ring_Z;
@@ -0,0 +1,124 @@
+#include <shg/sieve.h>
+#include <shg/ifact.h>
+#include <shg/mzt.h>
+#include "tests.h"
+
+namespace TESTS {
+
+BOOST_AUTO_TEST_SUITE(sieve_test)
+
+using SHG::Prime_bits;
+using SHG::Prime_generator;
+using SHG::Segmented_sieve;
+using SHG::count_primes;
+
+/**
+ * Checks Prime_bits(lo, hi) against is_prime().
+ */
+void check_interval(std::uint64_t lo, std::uint64_t hi,
+                    unsigned nthreads) {
+     Prime_bits const b(lo, hi, nthreads);
+     BOOST_CHECK(b.lo() == lo && b.hi() == hi);
+     std::vector<std::uint64_t> v;
+     for (std::uint64_t n = lo; n < hi; n++) {
+          bool const p = SHG::is_prime(n);
+          BOOST_CHECK(b.is_prime(n) == p);
+          if (p)
+               v.push_back(n);
+     }
+     BOOST_CHECK(b.primes() == v);
+     BOOST_CHECK(b.count() == v.size());
+     BOOST_CHECK(count_primes(lo, hi, nthreads) == v.size());
+}
+
+BOOST_AUTO_TEST_CASE(small_intervals_test) {
+     for (std::uint64_t lo = 0; lo < 70; lo++)
+          for (std::uint64_t hi = lo; hi < 100; hi++)
+               check_interval(lo, hi, 1);
+     check_interval(0, 200000, 1);
+     check_interval(0, 200000, 3);
+}
+
+BOOST_AUTO_TEST_CASE(large_intervals_test) {
+     SHG::MZT g;
+     for (int i = 0; i < 20; i++) {
+          std::uint64_t const lo =
+               static_cast<std::uint64_t>(g.uni(1 << 30)) << 10 |
+               g.uni(1 << 10);
+          check_interval(lo, lo + 5000, 1);
+     }
+     std::uint64_t const e12 = 1000000000000;
+     check_interval(e12 - 3000, e12 + 3000, 2);
+     std::uint64_t const m = Segmented_sieve::max_hi;
+     check_interval(m - 2000, m, 1);
+}
+
+BOOST_AUTO_TEST_CASE(bytes_test) {
+     Prime_bits const b(100, 1000);
+     auto const& x = b.bytes();
+     BOOST_REQUIRE(x.size() == 31);
+     for (std::size_t k = 0; k < x.size(); k++)
+          for (int i = 0; i < 8; i++) {
+               std::uint64_t const n =
+                    90 + 30 * k + Prime_bits::wheel[i];
+               bool const p =
+                    n >= 100 && n < 1000 && SHG::is_prime(n);
+               BOOST_CHECK(((x[k] >> i & 1) != 0) == p);
+          }
+}
+
+BOOST_AUTO_TEST_CASE(count_primes_test) {
+     // pi(10^k), see https://oeis.org/A006880.
+     BOOST_CHECK(count_primes(0, 11) == 4);
+     BOOST_CHECK(count_primes(0, 1000001) == 78498);
+     BOOST_CHECK(count_primes(0, 100000001, 1) == 5761455);
+     BOOST_CHECK(count_primes(0, 100000001, 4) == 5761455);
+     BOOST_CHECK(count_primes(100, 100) == 0);
+}
+
+BOOST_AUTO_TEST_CASE(segmented_sieve_test) {
+     std::uint64_t const lo = 123456789, hi = 987654321;
+     Segmented_sieve s(lo, hi);
+     Prime_bits b;
+     std::uint64_t x = lo, c = 0;
+     while (s.next(b)) {
+          BOOST_CHECK(b.lo() == x);
+          x = b.hi();
+          c += b.count();
+     }
+     BOOST_CHECK(x == hi);
+     BOOST_CHECK(c == count_primes(lo, hi));
+}
+
+BOOST_AUTO_TEST_CASE(prime_generator_test) {
+     Prime_generator g;
+     for (std::uint64_t n = 0, p = g(); n < 100000; n++) {
+          BOOST_CHECK(SHG::is_prime(n) == (n == p));
+          if (n == p)
+               p = g();
+     }
+     // The first primes after 10^12, see https://oeis.org/A003617.
+     Prime_generator h(1000000000000);
+     BOOST_CHECK(h() == 1000000000039);
+     BOOST_CHECK(h() == 1000000000061);
+     Prime_generator k(1000000000039);
+     BOOST_CHECK(k() == 1000000000039);
+     Prime_generator l(4);
+     BOOST_CHECK(l() == 5);
+     BOOST_CHECK(l() == 7);
+}
+
+BOOST_AUTO_TEST_CASE(invalid_argument_test) {
+     std::uint64_t const m = Segmented_sieve::max_hi;
+     BOOST_CHECK_THROW(Prime_bits(2, 1), std::invalid_argument);
+     BOOST_CHECK_THROW(Prime_bits(0, m + 1), std::invalid_argument);
+     BOOST_CHECK_THROW(count_primes(2, 1), std::invalid_argument);
+     BOOST_CHECK_THROW(Prime_generator{m}, std::invalid_argument);
+     Prime_bits const b(10, 20);
+     BOOST_CHECK_THROW(b.is_prime(9), std::invalid_argument);
+     BOOST_CHECK_THROW(b.is_prime(20), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace TESTS
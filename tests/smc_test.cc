@@ -1,4 +1,8 @@
 #include <shg/smc.h>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include <shg/mstat.h>
 #include <shg/mzt.h>
 #include "tests.h"
 
@@ -29,6 +33,10 @@ BOOST_AUTO_TEST_CASE(std_test) {
      p[1] = 1.0 / 3.0;
      p[2] = 1.0 / 6.0;
 
+     BOOST_CHECK_THROW(SMC::Finite(x, Vecdouble(2, 0.5)),
+                       SHG::Assertion);
+     BOOST_CHECK_THROW(SMC::Finite(x, Vecdouble(3, 0.0)),
+                       SHG::Assertion);
      a.reset(new SMC::Finite(x, p));
      for (int i = 0; i < 1000; i++) {
           int const x = a->generate(g);
@@ -64,19 +72,19 @@ BOOST_AUTO_TEST_CASE(std_test) {
           s += x;
      }
 
-     BOOST_CHECK(s == 8134);
+     BOOST_CHECK(s == 8141);
 }
 
 BOOST_AUTO_TEST_CASE(smc_test) {
      struct Result {
           int x, s, j;
      };
-     Vector<Result> const ex1xsj{
-          {1, 0, 2}, {4, 1, 3}, {3, 5, 4}, {1, 8, 0}};
-     Vecint const ex1z{2, 3, 3, 3, 3, 4, 4, 4, 0};
-     Vector<Result> const ex2xsj{
-          {1, 0, 2}, {4, 1, 3}, {3, 5, 4}, {2, 8, 0}};
-     Vecint const ex2z{2, 3, 3, 3, 3, 4, 4, 4, 0, 0};
+     Vector<Result> const ex1xsj{{1, 0, 4}, {2, 1, 0}, {2, 3, 3},
+                                 {1, 5, 2}, {1, 6, 1}, {2, 7, 4}};
+     Vecint const ex1z{4, 0, 0, 3, 3, 2, 1, 4, 4};
+     Vector<Result> const ex2xsj{{1, 0, 4}, {2, 1, 0}, {2, 3, 3},
+                                 {1, 5, 2}, {1, 6, 1}, {3, 7, 4}};
+     Vecint const ex2z{4, 0, 0, 3, 3, 2, 1, 4, 4, 4};
 
      int const nstates = 5;
      SMC smc(nstates);
@@ -100,8 +108,8 @@ BOOST_AUTO_TEST_CASE(smc_test) {
 
      smc.g_ = new MZT;
      BOOST_CHECK(smc.generate(9, true) == 0);
-     BOOST_CHECK(smc.X.size() == 4 && smc.S.size() == 4 &&
-                 smc.J.size() == 4);
+     BOOST_CHECK(smc.X.size() == 6 && smc.S.size() == 6 &&
+                 smc.J.size() == 6);
      BOOST_CHECK(smc.Z.size() == 9);
      for (Vector<Result>::size_type i = 0; i < ex1xsj.size(); i++) {
           BOOST_CHECK(smc.X[i] == ex1xsj[i].x);
@@ -116,8 +124,8 @@ BOOST_AUTO_TEST_CASE(smc_test) {
 
      smc.g_ = new MZT;
      BOOST_CHECK(smc.generate(9, false) == 0);
-     BOOST_CHECK(smc.X.size() == 4 && smc.S.size() == 4 &&
-                 smc.J.size() == 4);
+     BOOST_CHECK(smc.X.size() == 6 && smc.S.size() == 6 &&
+                 smc.J.size() == 6);
      BOOST_CHECK(smc.Z.size() == 10);
      for (Vector<Result>::size_type i = 0; i < ex2xsj.size(); i++) {
           BOOST_CHECK(smc.X[i] == ex2xsj[i].x);
@@ -128,6 +136,93 @@ BOOST_AUTO_TEST_CASE(smc_test) {
           BOOST_CHECK(smc.Z[i] == ex2z[i]);
 }
 
+BOOST_AUTO_TEST_CASE(replicate_test) {
+     using Histogram = std::vector<std::uint64_t>;
+     auto const sum = [](Histogram const& h, bool weighted) {
+          std::uint64_t s = 0;
+          for (std::size_t i = 0; i < h.size(); i++)
+               s += weighted ? i * h[i] : h[i];
+          return s;
+     };
+     int const nstates = 5;
+     SMC smc(nstates);
+     for (int i = 0; i < nstates; i++) {
+          smc.alpha_[i] = 1.0 / nstates;
+          for (int j = 0; j < nstates; j++)
+               smc.P_(i, j) = 1.0 / (nstates - 1);
+          smc.P_(i, i) = 0.0;
+     }
+     Vecint const x{1, 2, 3, 4};
+     Vecdouble const p{0.4, 0.3, 0.2, 0.1};
+     SMC::Summary s1, s2;
+     BOOST_CHECK(smc.replicate(10, 10, true, 1, s1) == 4);
+     smc.std_ = new SMC::Finite(x, p);
+     BOOST_CHECK(smc.replicate(10, 0, true, 1, s1) == 6);
+     BOOST_CHECK(s1.paths == 0);
+
+     // The summary does not depend on the number of threads.
+     std::size_t const n = 3 * SMC::replication_chunk + 5;
+     int const T = 50;
+     BOOST_REQUIRE(smc.replicate(n, T, true, 1, s1, 1) == 0);
+     BOOST_REQUIRE(smc.replicate(n, T, true, 1, s2, 4) == 0);
+     BOOST_CHECK(s1.paths == n);
+     BOOST_CHECK(s1.runs == s2.runs);
+     BOOST_CHECK(s1.occupation == s2.occupation);
+     BOOST_CHECK(s1.longest == s2.longest);
+     BOOST_REQUIRE(s1.runs.size() == nstates);
+     BOOST_CHECK(sum(s1.longest, false) == n);
+     BOOST_CHECK(sum(s1.occupation, false) == n * T);
+     std::uint64_t t = 0;
+     for (int j = 0; j < nstates; j++) {
+          BOOST_CHECK(sum(s1.runs[j], true) == s1.occupation[j]);
+          t += s1.occupation[j];
+     }
+     BOOST_CHECK(t == n * T);
+
+     // Poisson and negative binomial sojourn times in many threads.
+     for (auto const d : std::initializer_list<SMC::STD*>{
+               new SMC::Poisson(30.0),
+               new SMC::Negative_binomial(20.0, 0.4)}) {
+          SMC::STD* const f = smc.std_;
+          smc.std_ = d;
+          BOOST_REQUIRE(smc.replicate(n, 500, true, 3, s1, 1) == 0);
+          BOOST_REQUIRE(smc.replicate(n, 500, true, 3, s2, 4) == 0);
+          BOOST_CHECK(s1.runs == s2.runs);
+          BOOST_CHECK(s1.longest == s2.longest);
+          BOOST_CHECK(sum(s1.occupation, false) == n * 500);
+          smc.std_ = f;
+          delete d;
+     }
+
+     // Without cutting, the runs have the sojourn time distribution.
+     BOOST_REQUIRE(smc.replicate(n, T, false, 2, s1) == 0);
+     Histogram h(x.size() + 1);
+     for (int j = 0; j < nstates; j++) {
+          BOOST_REQUIRE(s1.runs[j].size() <= h.size());
+          for (std::size_t l = 0; l < s1.runs[j].size(); l++)
+               h[l] += s1.runs[j][l];
+     }
+     double const m = sum(h, false);
+     BOOST_CHECK(h[0] == 0);
+     for (std::size_t i = 0; i < x.size(); i++) {
+          double const sd = std::sqrt(m * p[i] * (1.0 - p[i]));
+          BOOST_CHECK(std::abs(h[x[i]] - m * p[i]) < 4.0 * sd);
+     }
+     double const o = sum(s1.occupation, false);
+     for (int j = 0; j < nstates; j++)
+          BOOST_CHECK(std::abs(s1.occupation[j] / o - 0.2) < 0.01);
+
+     // The runs in Z are the sojourns, as counted by replicate().
+     smc.g_ = new MZT;
+     BOOST_REQUIRE(smc.generate(1000, true) == 0);
+     std::vector<int> const z(smc.Z.begin(), smc.Z.end());
+     auto const r = SHG::run_length_distribution(z, nstates);
+     std::vector<std::vector<int>> v(nstates);
+     for (std::size_t i = 0; i < smc.X.size(); i++)
+          v[smc.J[i]].push_back(smc.X[i]);
+     BOOST_CHECK(r == v);
+}
+
 BOOST_AUTO_TEST_CASE(unideggaumix_test) {
      MZT g;
      Unideggaumix u(5000, 5);
@@ -933,6 +933,29 @@ BOOST_AUTO_TEST_CASE(dehtml_test) {
      BOOST_CHECK(std::strcmp(oss.str().data(), html_result) == 0);
 }
 
+BOOST_AUTO_TEST_CASE(parallel_for_test) {
+     using SHG::parallel_for;
+     BOOST_CHECK(SHG::number_of_threads() >= 1);
+     BOOST_CHECK(SHG::number_of_threads(3) == 3);
+     for (unsigned nt = 1; nt <= 4; nt++) {
+          std::vector<int> v(1000, 0);
+          parallel_for(
+               v.size(), [&v](std::size_t i) { v[i] += i; }, nt);
+          for (std::size_t i = 0; i < v.size(); i++)
+               BOOST_CHECK(v[i] == static_cast<int>(i));
+          BOOST_CHECK_THROW(parallel_for(
+                                 v.size(),
+                                 [](std::size_t i) {
+                                      if (i == 500)
+                                           throw std::runtime_error(
+                                                "error");
+                                 },
+                                 nt),
+                            std::runtime_error);
+     }
+     parallel_for(0, [](std::size_t) { BOOST_CHECK(false); });
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 }  // namespace TESTS
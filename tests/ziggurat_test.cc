@@ -0,0 +1,99 @@
+#include <shg/ziggurat.h>
+#include <cmath>
+#include <shg/philox.h>
+#include "tests.h"
+
+namespace TESTS {
+
+BOOST_AUTO_TEST_SUITE(ziggurat_test)
+
+using SHG::Ziggurat;
+
+BOOST_AUTO_TEST_CASE(tables_test) {
+     struct Case {
+          Ziggurat const& z;
+          double (*f)(double);
+          double v;
+     };
+     Case const cases[]{
+          {Ziggurat::normal(),
+           [](double x) { return std::exp(-0.5 * x * x); },
+           9.91256303526217e-3},
+          {Ziggurat::exponential(),
+           [](double x) { return std::exp(-x); },
+           3.949659822581572e-3}};
+     for (auto const& c : cases) {
+          auto const& x = c.z.x;
+          std::size_t const n = c.z.mask + 1;
+          BOOST_REQUIRE(x.size() == n + 1);
+          BOOST_REQUIRE(c.z.q.size() == n);
+          BOOST_CHECK(x[1] == c.z.r);
+          BOOST_CHECK(x[n] == 0.0);
+          for (std::size_t i = 0; i < n; i++)
+               BOOST_CHECK(x[i] > x[i + 1]);
+          // Each rectangle has the area v.
+          for (std::size_t i = 1; i < n - 1; i++) {
+               double const a = x[i] * (c.f(x[i + 1]) - c.f(x[i]));
+               BOOST_CHECK(std::abs(a - c.v) < 1e-9);
+          }
+          BOOST_CHECK(std::abs(x[0] * c.f(x[1]) - c.v) < 1e-15);
+     }
+}
+
+BOOST_AUTO_TEST_CASE(normal_test) {
+     SHG::Philox g(1);
+     auto w = [&g]() { return g.bits(); };
+     int const n = 1000000;
+     // Frequencies of the intervals bounded by -3, -2, ..., 3.
+     std::vector<double> const b{-3, -2, -1, 0, 1, 2, 3};
+     std::vector<int> k(b.size() + 1);
+     double s = 0.0, s2 = 0.0;
+     for (int i = 0; i < n; i++) {
+          double const x = SHG::ziggurat_normal(w);
+          s += x;
+          s2 += x * x;
+          std::size_t j = 0;
+          while (j < b.size() && x >= b[j])
+               j++;
+          k[j]++;
+     }
+     BOOST_CHECK(std::abs(s / n) < 0.005);
+     BOOST_CHECK(std::abs(s2 / n - 1.0) < 0.005);
+     auto const cdf = [](double x) {
+          return 0.5 * std::erfc(-x / std::sqrt(2.0));
+     };
+     for (std::size_t j = 0; j <= b.size(); j++) {
+          double const p = (j < b.size() ? cdf(b[j]) : 1.0) -
+                           (j > 0 ? cdf(b[j - 1]) : 0.0);
+          double const sd = std::sqrt(n * p * (1.0 - p));
+          BOOST_CHECK(std::abs(k[j] - n * p) < 4.0 * sd);
+     }
+}
+
+BOOST_AUTO_TEST_CASE(exponential_test) {
+     SHG::Philox g(2);
+     auto w = [&g]() { return g.bits(); };
+     int const n = 1000000;
+     // Frequencies of the intervals bounded by 0.5, 1, ..., 8.
+     std::vector<int> k(17);
+     double s = 0.0, s2 = 0.0;
+     for (int i = 0; i < n; i++) {
+          double const x = SHG::ziggurat_exponential(w);
+          BOOST_REQUIRE(x >= 0.0);
+          s += x;
+          s2 += x * x;
+          k[std::min(16, static_cast<int>(2.0 * x))]++;
+     }
+     BOOST_CHECK(std::abs(s / n - 1.0) < 0.005);
+     BOOST_CHECK(std::abs(s2 / n - 2.0) < 0.02);
+     for (int j = 0; j <= 16; j++) {
+          double const p = std::exp(-0.5 * j) -
+                           (j < 16 ? std::exp(-0.5 * (j + 1)) : 0.0);
+          double const sd = std::sqrt(n * p * (1.0 - p));
+          BOOST_CHECK(std::abs(k[j] - n * p) < 4.0 * sd);
+     }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+}  // namespace TESTS
@@ -0,0 +1,84 @@
+/**
+ * \file tools/cnfbench.cc
+ * Measures the time of conversion of large random grammars to
+ * Chomsky normal form.
+ *
+ * Usage: cnfbench [number of productions ...]
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <string>
+#include <shg/cfg.h>
+#include <shg/mzt.h>
+
+namespace {
+
+using SHG::PLP::Vecprod;
+
+/**
+ * Generates a grammar with about np productions. Roughly one
+ * variable in twenty is nullable and one production in fifty is a
+ * unit production.
+ */
+Vecprod random_grammar(int np) {
+     int const nv = std::max(np / 15, 4), nt = 10;
+     auto const v = [](int i) { return "V" + std::to_string(i); };
+     auto const t = [](int i) { return "t" + std::to_string(i); };
+     SHG::MZT g;
+     Vecprod vp;
+     std::set<std::string> seen;
+     vp.push_back({v(0), {v(1), v(2)}});
+     for (int a = 1; a < nv; a++)
+          vp.push_back({v(a), {t(a % nt)}});
+     for (int a = nv - nv / 20; a < nv; a++)
+          vp.push_back({v(a), {}});
+     while (static_cast<int>(vp.size()) < np) {
+          int const a = 1 + g.uni(nv - 1);
+          std::vector<std::string> rhs;
+          if (g.uni(50) == 0) {
+               rhs.push_back(v(1 + g.uni(nv - 1)));
+               if (rhs[0] == v(a))
+                    continue;
+          } else {
+               rhs.resize(2 + g.uni(4));
+               for (auto& x : rhs)
+                    x = g.uni(4) == 0 ? t(g.uni(nt))
+                                      : v(1 + g.uni(nv - 1));
+          }
+          std::string key = v(a);
+          for (auto const& x : rhs)
+               key += " " + x;
+          if (seen.insert(key).second)
+               vp.push_back({v(a), rhs});
+     }
+     return vp;
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+     std::vector<int> sizes;
+     for (int i = 1; i < argc; i++)
+          sizes.push_back(std::atoi(argv[i]));
+     if (sizes.empty())
+          sizes = {1000, 2000, 4000, 8000, 16000};
+     SHG::PLP::Conversion_to_CNF conv;
+     std::cout << std::setw(10) << "input" << std::setw(10)
+               << "output" << std::setw(12) << "seconds\n";
+     for (int const np : sizes) {
+          Vecprod const vp = random_grammar(np);
+          auto const start = std::chrono::steady_clock::now();
+          conv.convert(vp);
+          std::chrono::duration<double> const d =
+               std::chrono::steady_clock::now() - start;
+          std::cout << std::setw(10) << vp.size() << std::setw(10)
+                    << conv.cfg().size() << std::setw(11)
+                    << std::fixed << std::setprecision(3)
+                    << d.count() << '\n';
+     }
+}
@@ -0,0 +1,120 @@
+/**
+ * \file tools/polymulbench.cc
+ * Measures the time of multiplication of dense and sparse
+ * multivariate polynomials over Z.
+ *
+ * Usage: polymulbench [number of threads ...]
+ */
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <shg/mzt.h>
+#include <shg/polynomial.h>
+
+namespace {
+
+using SHG::ALGEBRA::Monomial;
+using SHG::ALGEBRA::Polynomial;
+using SHG::ALGEBRA::Ring_Z;
+using SHG::ALGEBRA::Term;
+
+Ring_Z const Z;
+
+/**
+ * Returns \f$(1 + x_1 + \ldots + x_{dim})^k\f$.
+ */
+Polynomial dense(int dim, int k) {
+     Polynomial p(&Z, dim), q(&Z, dim);
+     q += Z.one();
+     for (int i = 0; i < dim; i++) {
+          std::vector<int> e(dim);
+          e[i] = 1;
+          q += Term(Z.one(), Monomial(e));
+     }
+     p += Z.one();
+     for (int i = 0; i < k; i++)
+          p = multiply(p, q);
+     return p;
+}
+
+/**
+ * Returns a random polynomial with n terms with exponents less than
+ * maxexp.
+ */
+Polynomial sparse(SHG::MZT& g, int dim, int n, int maxexp) {
+     Polynomial p(&Z, dim);
+     std::vector<int> e(dim);
+     for (int i = 0; i < n; i++) {
+          for (auto& ei : e)
+               ei = g.uni(maxexp);
+          p += Term(Z.element(g.uni(1, 1000)), Monomial(e));
+     }
+     return p;
+}
+
+/**
+ * Returns the product computed term by term.
+ */
+Polynomial naive(Polynomial const& x, Polynomial const& y) {
+     Polynomial z(&Z, x.dim());
+     for (auto const& [m, a] : y.terms())
+          z += x * Term(a, m);
+     return z;
+}
+
+template <typename F>
+double seconds(F f) {
+     auto const start = std::chrono::steady_clock::now();
+     f();
+     std::chrono::duration<double> const d =
+          std::chrono::steady_clock::now() - start;
+     return d.count();
+}
+
+void run(std::string const& name, Polynomial const& x,
+         Polynomial const& y, std::vector<unsigned> const& threads) {
+     Polynomial z;
+     std::cout << std::setw(16) << name << std::setw(8)
+               << x.terms().size() << std::setw(8)
+               << y.terms().size() << std::fixed
+               << std::setprecision(3) << std::setw(10)
+               << seconds([&]() { z = naive(x, y); });
+     for (unsigned const n : threads) {
+          Polynomial w;
+          std::cout << std::setw(10)
+                    << seconds([&]() { w = multiply(x, y, n); });
+          if (w != z)
+               std::cout << '!';
+     }
+     std::cout << std::setw(10) << z.terms().size() << '\n';
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+     std::vector<unsigned> threads;
+     for (int i = 1; i < argc; i++)
+          threads.push_back(std::atoi(argv[i]));
+     if (threads.empty())
+          threads = {1, 2, 4};
+     std::cout << std::setw(16) << "case" << std::setw(8) << "x"
+               << std::setw(8) << "y" << std::setw(10) << "naive";
+     for (unsigned const n : threads)
+          std::cout << std::setw(9) << "heap/" << n;
+     std::cout << std::setw(10) << "xy" << '\n';
+     for (int const k : {6, 8, 10}) {
+          Polynomial const f = dense(4, k);
+          run("dense 4 " + std::to_string(k), f, f + Z.one(),
+              threads);
+     }
+     SHG::MZT g;
+     for (int const n : {250, 500, 1000}) {
+          Polynomial const x = sparse(g, 5, n, 10);
+          Polynomial const y = sparse(g, 5, n, 10);
+          run("sparse 5 " + std::to_string(n), x, y, threads);
+     }
+}
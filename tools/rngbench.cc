@@ -0,0 +1,155 @@
+/**
+ * \file tools/rngbench.cc
+ * Compares the time of generation of random numbers by the ziggurat
+ * method, alias tables, BTPE and PTRS with the older methods.
+ *
+ * Usage: rngbench [number of numbers]
+ */
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <shg/mzt.h>
+#include <shg/philox.h>
+
+namespace {
+
+using SHG::RNG;
+
+/**
+ * The decomposition of binomial distribution into beta distributions
+ * used by RNG::binomial() before BTPE.
+ */
+unsigned int binomial_beta(RNG& g, double p, unsigned int n) {
+     unsigned int k = 0;
+     while (n > 10) {
+          unsigned int const a = 1 + n / 2;
+          unsigned int const b = 1 + n - a;
+          double const x = g.beta(a, b);
+          if (x >= p) {
+               n = a - 1;
+               p /= x;
+          } else {
+               k += a;
+               n = b - 1;
+               p = (p - x) / (1 - x);
+          }
+     }
+     for (unsigned int i = 0; i < n; i++)
+          if (g() < p)
+               k++;
+     return k;
+}
+
+/**
+ * The decomposition of Poisson distribution into gamma distributions
+ * used by RNG::poisson() before PTRS.
+ */
+unsigned int poisson_gamma(RNG& g, double mu) {
+     unsigned int k = 0;
+     while (mu > 10.0) {
+          auto const m = static_cast<unsigned int>(0.875 * mu);
+          double const x = g.gamma(m);
+          if (x < mu) {
+               k += m;
+               mu -= x;
+          } else {
+               return k + binomial_beta(g, mu / x, m - 1);
+          }
+     }
+     double const emu = std::exp(-mu);
+     double prod = 1.0;
+     do {
+          prod *= g();
+          k++;
+     } while (prod > emu);
+     return k - 1;
+}
+
+/**
+ * Calls f() ncalls times and prints the time per number in
+ * nanoseconds, assuming that each call generates n / ncalls numbers.
+ */
+template <typename F>
+void measure(std::string const& name, long ncalls, long n, F f) {
+     using Clock = std::chrono::steady_clock;
+     double volatile sink = 0.0;
+     auto const t0 = Clock::now();
+     double s = 0.0;
+     for (long i = 0; i < ncalls; i++)
+          s += f();
+     auto const t1 = Clock::now();
+     sink = s;
+     static_cast<void>(sink);
+     std::chrono::duration<double, std::nano> const d = t1 - t0;
+     std::cout << std::setw(40) << std::left << name << std::setw(10)
+               << std::right << std::fixed << std::setprecision(1)
+               << d.count() / n << " ns\n";
+}
+
+}  // anonymous namespace
+
+int main(int argc, char* argv[]) {
+     long const n = argc > 1 ? std::atol(argv[1]) : 1000000;
+     SHG::MZT mzt;
+     SHG::Philox philox;
+     RNG& g = mzt;
+     RNG& h = philox;
+     std::vector<double> x(n);
+
+     std::cout << "normal distribution\n";
+     measure("MZT normal()", n, n, [&g]() { return g.normal(); });
+     measure("MZT ziggurat_normal()", n, n,
+             [&g]() { return g.ziggurat_normal(); });
+     measure("Philox normal()", n, n, [&h]() { return h.normal(); });
+     measure("Philox ziggurat_normal()", n, n,
+             [&h]() { return h.ziggurat_normal(); });
+     measure("Philox normal(x, n)", 1, n, [&]() {
+          h.normal(x.data(), n);
+          return x[0];
+     });
+
+     std::cout << "exponential distribution\n";
+     measure("MZT exponential()", n, n,
+             [&g]() { return g.exponential(); });
+     measure("MZT ziggurat_exponential()", n, n,
+             [&g]() { return g.ziggurat_exponential(); });
+     measure("Philox exponential(x, n)", 1, n, [&]() {
+          h.exponential(x.data(), n);
+          return x[0];
+     });
+
+     std::cout << "finite distribution\n";
+     for (int const k : {4, 32, 1000}) {
+          SHG::Vecdouble p(k, 1.0 / k);
+          SHG::Alias_table const a(p);
+          std::string const s = std::to_string(k);
+          measure("MZT finite(), " + s + " values", n, n,
+                  [&]() { return g.finite(p); });
+          measure("MZT Alias_table, " + s + " values", n, n,
+                  [&]() { return a(g); });
+     }
+
+     long const n10 = n / 10;
+     std::cout << "binomial distribution\n";
+     for (unsigned int const m : {20u, 1000u, 1000000u}) {
+          std::string const s = std::to_string(m);
+          measure("beta decomposition, p = 0.3, n = " + s, n10, n10,
+                  [&]() { return binomial_beta(g, 0.3, m); });
+          measure("binomial(), p = 0.3, n = " + s, n10, n10,
+                  [&]() { return g.binomial(0.3, m); });
+     }
+
+     std::cout << "Poisson distribution\n";
+     for (double const mu : {15.0, 1000.0, 1000000.0}) {
+          std::string const s = std::to_string(static_cast<long>(mu));
+          measure("gamma decomposition, mu = " + s, n10, n10,
+                  [&]() { return poisson_gamma(g, mu); });
+          measure("poisson(), mu = " + s, n10, n10,
+                  [&]() { return g.poisson(mu); });
+     }
+}